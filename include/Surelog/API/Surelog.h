@@ -52,6 +52,11 @@ vpiHandle get_uhdm_design(scompiler* compiler);
 // use!
 void shutdown_compiler(scompiler* compiler);
 
+// Keep the preprocessor and parser caches in memory across the compiler
+// sessions of this process (compile server), so a new session only
+// re-processes the files that changed since the previous one.
+void keep_caches_in_memory(bool keep);
+
 }  // namespace SURELOG
 
 #endif  // SURELOG_SURELOG_H
@@ -28,13 +28,18 @@
 #include <Surelog/Cache/header_generated.h>
 #include <Surelog/Common/SymbolId.h>
 #include <Surelog/Design/VObject.h>
+#include <Surelog/Design/VObjectStore.h>
 #include <flatbuffers/flatbuffers.h>
 
+#include <cstddef>
 #include <filesystem>
 #include <memory>
+#include <set>
+#include <vector>
 
 namespace SURELOG {
 
+class CachePack;
 class ErrorContainer;
 class FileContent;
 class SymbolTable;
@@ -50,6 +55,26 @@ class SymbolTable;
 class Cache {
  public:
   static constexpr uint64_t Capacity = 0x000000000FFFFFFF;
+  // Bytes and number of cache files, and number of content hashes, kept in
+  // memory. Each cache file is a mapping, the count stays well below the
+  // usual limit of mappings per process.
+  static constexpr uint64_t InMemoryCapacity = 0x0000000040000000;
+  static constexpr uint64_t InMemoryFiles = 0x0000000000008000;
+  static constexpr uint64_t InMemoryStamps = 0x0000000000100000;
+
+  // Keeps the cache files, and the content hashes of the files they were
+  // validated against, in memory for the lifetime of the process. Used by
+  // the compile server (-server) which runs many compilations in a row, so
+  // only the files that changed since the last request are re-processed.
+  // The least recently used cache files are dropped past InMemoryCapacity
+  // or InMemoryFiles.
+  static void setInMemory(bool inMemory);
+
+  // Source files the compile server found unchanged, with all the files
+  // they include, since their preprocessor caches were last validated.
+  // Their caches are restored without being validated again.
+  static void setUpToDateInMemory(
+      const std::set<std::filesystem::path>& sourceFiles);
 
  protected:
   using VectorOffsetError =
@@ -57,19 +82,57 @@ class Cache {
   using VectorOffsetString =
       flatbuffers::Vector<flatbuffers::Offset<flatbuffers::String>>;
 
+  // Releases a buffer returned by openFlatBuffers(), which is either a
+  // read-only memory mapping of the cache file or a heap copy of it. It
+  // releases nothing when it shares a buffer kept in memory (m_owner).
+  struct BufferDeleter {
+    size_t m_size = 0;
+    bool m_mapped = false;
+    std::shared_ptr<const uint8_t> m_owner;
+    void operator()(const uint8_t* data) const;
+  };
+  using Buffer = std::unique_ptr<const uint8_t[], BufferDeleter>;
+
+  // Cache symbol id (index in the symbol vector stored in the cache file)
+  // to the id of the same symbol in the local symbol table.
+  using SymbolRemap = std::vector<SymbolId>;
+
   Cache() = default;
 
+  // Store the cache files in "pack" rather than on the file system, keyed by
+  // their path relative to "packRoot". nullptr goes back to plain files.
+  void usePack(CachePack* pack, const std::filesystem::path& packRoot) {
+    m_pack = pack;
+    m_packRoot = packRoot;
+  }
+
   time_t get_mtime(const std::filesystem::path& path);
 
   const std::string& getExecutableTimeStamp();
 
-  // Open file and read contents into a buffer.
-  std::unique_ptr<uint8_t[]> openFlatBuffers(
-      const std::filesystem::path& cacheFileName);
+  // Fingerprint of the grammars and cache schemas this tool was built with.
+  const std::string& getGrammarHash();
+
+  // Hash of the content of a file, false if the file cannot be read.
+  bool hashFileContent(const std::filesystem::path& path, uint64_t* hash);
+
+  // Open file and map its content read-only (read into a heap buffer where
+  // mapping is not available). Returns nullptr on failure.
+  Buffer openFlatBuffers(const std::filesystem::path& cacheFileName);
+
+  // The cache file kept in memory for "sourceFile" if it was given to
+  // setUpToDateInMemory(), nullptr otherwise.
+  Buffer openUpToDateInMemory(const std::filesystem::path& sourceFile,
+                              const std::filesystem::path& cacheFileName);
 
   bool saveFlatbuffers(flatbuffers::FlatBufferBuilder& builder,
                        const std::filesystem::path& cacheFileName);
 
+  // Warns that a cache file could not be written. The compilation goes on,
+  // the next run misses that cache.
+  void reportNotSaved(ErrorContainer* errors, SymbolTable* symbols,
+                      const std::filesystem::path& cacheFileName);
+
   bool checkIfCacheIsValid(const SURELOG::CACHE::Header* header,
                            std::string_view schemaVersion,
                            const std::filesystem::path& cacheFileName);
@@ -89,14 +152,21 @@ class Cache {
   flatbuffers::Offset<Cache::VectorOffsetString> createSymbolCache(
       flatbuffers::FlatBufferBuilder& builder, const SymbolTable& cacheSymbols);
 
-  // Restores errors and the cache symbol table (to be used in other restore
-  // operations).
-  // References in the error container to local symbols will be entered into
-  // the local symbol table.
+  // Registers each symbol of the cache file once in "localSymbols" and
+  // returns the cache id to local id table used by the other restore
+  // operations.
+  SymbolRemap restoreSymbols(const VectorOffsetString* symbolsBuf,
+                             SymbolTable* localSymbols);
+
+  // Local id of the symbol with the given cache id, BadSymbolId if the cache
+  // does not know it.
+  static SymbolId remapSymbol(const SymbolRemap& remap, RawSymbolId cacheId) {
+    return (cacheId < remap.size()) ? remap[cacheId] : BadSymbolId;
+  }
+
+  // Restores errors, with their locations translated through "remap".
   void restoreErrors(const VectorOffsetError* errorsBuf,
-                     const VectorOffsetString* symbolBuf,
-                     SymbolTable* cacheSymbols, ErrorContainer* errorContainer,
-                     SymbolTable* localSymbols);
+                     const SymbolRemap& remap, ErrorContainer* errorContainer);
 
   // Convert vobjects from "fcontent" into cachable VObjects.
   // Uses "localSymbols" and "cacheSymbols" to map symbols found in "fcontent"
@@ -107,21 +177,30 @@ class Cache {
                                             const SymbolTable& localSymbols,
                                             SymbolId fileId);
 
-  // Restore objects coming from the flatbuffer cache and with the corresponding
-  // "cacheSymbols" into "fileContent", with IDs relevant in the local
-  // symbol table "localSymbols" (which is updated).
+  // Restore objects coming from the flatbuffer cache into "fileContent",
+  // translating the cache symbol ids through "remap".
   void restoreVObjects(
       const flatbuffers::Vector<const SURELOG::CACHE::VObject*>* objects,
-      const SymbolTable& cacheSymbols, SymbolTable* localSymbols,
-      SymbolId fileId, FileContent* fileContent);
+      const SymbolRemap& remap, SymbolId fileId, FileContent* fileContent);
 
   void restoreVObjects(
       const flatbuffers::Vector<const SURELOG::CACHE::VObject*>* objects,
-      const SymbolTable& cacheSymbols, SymbolTable* localSymbols,
-      SymbolId fileId, std::vector<SURELOG::VObject>* result);
+      const SymbolRemap& remap, SymbolId fileId, VObjectStore* result);
 
  private:
   Cache(const Cache& orig) = delete;
+
+  std::string getPackKey_(const std::filesystem::path& cacheFileName) const;
+
+  Buffer openFlatBuffers_(const std::filesystem::path& cacheFileName);
+
+  // Keeps the cache file just saved in memory, mapped again from the file
+  // system if it was "saved" there.
+  void keepInMemory_(const std::filesystem::path& cacheFileName,
+                     const uint8_t* buf, size_t size, bool saved);
+
+  CachePack* m_pack = nullptr;
+  std::filesystem::path m_packRoot;
 };
 
 }  // namespace SURELOG
@@ -0,0 +1,151 @@
+/*
+ Copyright 2022 The Surelog Team.
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+/*
+ * File:   CachePack.h
+ * Author: surelog
+ *
+ * Single file store (.slpack) holding all the .slpp/.slpa caches of a
+ * library, so a warm run opens one file instead of one per source and
+ * include file.
+ *
+ * Layout: a fixed header, a hash index (open addressing on the 64 bit hash
+ * of the key), then records appended one after the other:
+ *   [key hash][key size][data size][key][data]
+ * Rewriting a key appends a new record and redirects its index slot; the
+ * superseded record stays in the file until compact() is run.
+ *
+ * Writers from several threads are serialized by a mutex, writers from
+ * several processes (-mp) by a lock on a companion .lock file. Each write
+ * bumps the generation of the header. Readers keep the pack open and
+ * mapped, with a copy of its index taken under a shared lock, and only
+ * take that lock again when the generation changed.
+ */
+
+#ifndef SURELOG_CACHEPACK_H
+#define SURELOG_CACHEPACK_H
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace SURELOG {
+
+class CachePack final {
+ public:
+  // Pack shared by all the users of the given pack file in this process.
+  static CachePack* getPack(const std::filesystem::path& packFileName);
+
+  // Name of the pack file of library "libName" in cache directory "cacheDir".
+  static std::filesystem::path getPackFileName(
+      const std::filesystem::path& cacheDir, std::string_view libName);
+
+  // Compacts all the pack files found in "cacheDir".
+  static bool compactAll(const std::filesystem::path& cacheDir);
+
+  explicit CachePack(const std::filesystem::path& packFileName);
+  ~CachePack();
+
+  const std::filesystem::path& getFileName() const { return m_fileName; }
+
+  // Latest data stored under "key". Returns false if the key is unknown.
+  bool read(std::string_view key, std::unique_ptr<uint8_t[]>* data,
+            uint64_t* size);
+
+  // Stores "data" under "key", superseding any previous version.
+  bool write(std::string_view key, const uint8_t* data, uint64_t size);
+
+  // Rewrites the pack without the superseded records. The index is sized
+  // for the live keys.
+  bool compact();
+
+  // Number of keys and total size of the records, live or superseded.
+  uint64_t getNbKeys();
+  uint64_t getDataSize();
+
+ private:
+  CachePack(const CachePack& orig) = delete;
+  CachePack& operator=(const CachePack&) = delete;
+
+  struct Header {
+    char m_magic[8];
+    uint64_t m_capacity;   // number of index slots
+    uint64_t m_nbKeys;     // used index slots
+    uint64_t m_end;        // end of the last record
+    uint64_t m_replaced;   // non-zero once compact() renamed a new pack over
+    uint64_t m_generation;  // bumped by each write
+  };
+
+  struct IndexEntry {
+    uint64_t m_hash;
+    uint64_t m_offset;  // 0 for an empty slot
+  };
+
+  struct RecordHeader {
+    uint64_t m_hash;
+    uint64_t m_keySize;
+    uint64_t m_dataSize;
+  };
+
+  class FileLock;
+
+  bool open_();
+  void close_();
+  // True for a pack file just created, with no header yet, or written by
+  // another version of the pack format.
+  bool isReplaceable_();
+  bool initialize_(uint64_t capacity);
+  bool readHeader_(Header* header);
+  bool writeHeader_(const Header& header);
+  // Slot of "key", or of the empty slot where it would go.
+  bool findSlot_(const Header& header, std::string_view key, uint64_t hash,
+                 uint64_t* slot, IndexEntry* entry);
+  bool rebuild_(uint64_t capacity);
+  bool readAt_(uint64_t offset, void* data, uint64_t size);
+  bool writeAt_(uint64_t offset, const void* data, uint64_t size);
+
+  // Maps the pack and copies its index, under a shared lock.
+  bool takeSnapshot_();
+  void dropSnapshot_();
+  // True while no write or compact() happened since the snapshot.
+  bool isSnapshotCurrent_();
+  // Reads from the mapping, or from the file where there is none.
+  bool readSnapshot_(uint64_t offset, void* data, uint64_t size);
+
+  static uint64_t indexOffset_(uint64_t slot) {
+    return sizeof(Header) + slot * sizeof(IndexEntry);
+  }
+
+  const std::filesystem::path m_fileName;
+  const std::filesystem::path m_lockFileName;
+  std::mutex m_mutex;
+  int m_fd = -1;
+
+  bool m_snapshot = false;
+  uint64_t m_generation = 0;
+  std::vector<IndexEntry> m_index;
+  const uint8_t* m_map = nullptr;
+  uint64_t m_mapSize = 0;
+};
+
+}  // namespace SURELOG
+
+#endif /* SURELOG_CACHEPACK_H */
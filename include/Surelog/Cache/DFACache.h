@@ -0,0 +1,74 @@
+/*
+ Copyright 2022 The Surelog Team.
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+/*
+ * File:   DFACache.h
+ * Author: surelog
+ *
+ * Warm start of the SystemVerilog and preprocessor parsers (-dfacache).
+ * ANTLR learns the prediction DFA of each grammar decision while parsing,
+ * and every process starts from an empty DFA. The learned states are saved
+ * in the cache directory at the end of a run and loaded back before the next
+ * one parses anything.
+ * The DFAs are shared by all the parsers of a grammar in the process, so
+ * restore() and save() must not run while parsing.
+ */
+
+#ifndef SURELOG_DFACACHE_H
+#define SURELOG_DFACACHE_H
+#pragma once
+
+#include <Surelog/Cache/Cache.h>
+
+#include <cstdint>
+#include <filesystem>
+
+namespace SURELOG {
+
+class CommandLineParser;
+
+class DFACache final : Cache {
+ public:
+  // Saves at most "maxStates" DFA states in "cacheFileName".
+  DFACache(const std::filesystem::path& cacheFileName, uint64_t maxStates);
+
+  // Cache file used by -dfacache.
+  static std::filesystem::path getCacheFileName(CommandLineParser* clp);
+
+  // Loads the cached states into the DFAs that are still empty. Returns
+  // false if the cache is missing or was written for other grammars.
+  bool restore();
+
+  // Saves the DFAs, if they learned new states since they were last loaded
+  // or saved in this process.
+  bool save();
+
+  // Current number of states in the DFAs of the parsers.
+  static uint64_t getNbStates();
+
+  // Drops all the learned states, back to a cold start.
+  static void clear();
+
+ private:
+  DFACache(const DFACache& orig) = delete;
+
+  const std::filesystem::path m_cacheFileName;
+  const uint64_t m_maxStates;
+};
+
+}  // namespace SURELOG
+
+#endif /* SURELOG_DFACACHE_H */
@@ -28,6 +28,7 @@
 #include <Surelog/Cache/Cache.h>
 
 #include <filesystem>
+#include <vector>
 
 namespace SURELOG {
 
@@ -40,6 +41,10 @@ class PPCache : Cache {
   bool restore(bool errorsOnly);
   bool save();
 
+  // Files included by the preprocessed file, directly or not, as listed in
+  // its cache. False if there is no cache.
+  bool getIncludedFiles(std::vector<std::filesystem::path>& files);
+
  private:
   PPCache(const PPCache& orig) = delete;
 
@@ -47,10 +52,10 @@ class PPCache : Cache {
       const std::filesystem::path& fileName = "");
   bool restore_(const std::filesystem::path& cacheFileName, bool errorsOnly);
   bool restore_(const std::filesystem::path& cacheFileName,
-                const std::unique_ptr<uint8_t[]>& buffer, bool errorsOnly);
+                const Buffer& buffer, bool errorsOnly);
   bool checkCacheIsValid_(const std::filesystem::path& cacheFileName);
   bool checkCacheIsValid_(const std::filesystem::path& cacheFileName,
-                          const std::unique_ptr<uint8_t[]>& buffer);
+                          const Buffer& buffer);
 
   PreprocessFile* m_pp;
   bool m_isPrecompiled;
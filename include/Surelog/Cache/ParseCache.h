@@ -47,12 +47,22 @@ class ParseCache : Cache {
   std::filesystem::path getCacheFileName_(
       const std::filesystem::path& fileName = "");
   bool restore_(const std::filesystem::path& cacheFileName,
-                const std::unique_ptr<uint8_t[]>& buffer);
+                const Buffer& buffer);
   bool checkCacheIsValid_(const std::filesystem::path& cacheFileName,
-                          const std::unique_ptr<uint8_t[]>& buffer);
+                          const Buffer& buffer);
+
+  // File chunks are cached under the hash of their content rather than their
+  // index, so a chunk keeps its cache when other chunks of the file change.
+  // The line number of the leading SLline directive is left out of the hash:
+  // a chunk that only moved within its file keeps its cache too.
+  std::filesystem::path getChunkFileName_(const std::filesystem::path& chunk);
 
   ParseFile* m_parse;
   bool m_isPrecompiled;
+  // File chunk only: number of lines and line shift to apply to the cached
+  // objects (the chunk moved within its file since it was cached).
+  unsigned int m_chunkNbLines = 0;
+  int m_lineDelta = 0;
 };
 
 }  // namespace SURELOG
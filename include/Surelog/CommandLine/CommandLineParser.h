@@ -96,6 +96,20 @@ class CommandLineParser final {
   void debugCache(bool on) { m_debugCache = on; }
   void noCacheHash(bool noCachePath) { m_noCacheHash = noCachePath; }
   bool noCacheHash() const { return m_noCacheHash; }
+  bool cachePack() const { return m_cachePack; }
+  void setCachePack(bool val) { m_cachePack = val; }
+  bool compactCachePack() const { return m_compactCachePack; }
+  bool dfaCache() const { return m_dfaCache; }
+  void setDfaCache(bool val) { m_dfaCache = val; }
+  unsigned int dfaCacheMaxStates() const { return m_dfaCacheMaxStates; }
+  bool typeIndex() const { return m_typeIndex; }
+  void setTypeIndex(bool val) { m_typeIndex = val; }
+  // Macro bodies that are a plain copy are expanded without the grammar
+  bool plainMacros() const { return m_plainMacros; }
+  void setPlainMacros(bool val) { m_plainMacros = val; }
+  // Include guards and preprocessed includes are reused (IncludeMemo)
+  bool includeMemo() const { return m_includeMemo; }
+  void setIncludeMemo(bool val) { m_includeMemo = val; }
   void setCacheAllowed(bool val) { m_cacheAllowed = val; }
   bool lineOffsetsAsComments() const { return m_lineOffsetsAsComments; }
   SymbolId getCacheDir() const { return m_cacheDirId; }
@@ -332,8 +346,15 @@ class CommandLineParser final {
   bool m_writeUhdm;
   bool m_nonSynthesizable;
   bool m_noCacheHash;
+  bool m_cachePack;
+  bool m_compactCachePack;
+  bool m_dfaCache;
+  unsigned int m_dfaCacheMaxStates;
+  bool m_typeIndex;
   bool m_sepComp;
   bool m_link;
+  bool m_plainMacros;
+  bool m_includeMemo;
 };
 
 }  // namespace SURELOG
@@ -28,7 +28,8 @@
 #include <Surelog/Common/SymbolId.h>
 #include <Surelog/Design/ClockingBlock.h>
 
-#include <map>
+#include <utility>
+#include <vector>
 
 namespace SURELOG {
 
@@ -36,8 +37,9 @@ class ClockingBlock;
 
 class ClockingBlockHolder {
  public:
-  typedef std::multimap<SymbolId, ClockingBlock, SymbolIdLessThanComparer>
-      ClockingBlockMap;
+  // In declaration order: the ids depend on the order the parallel jobs
+  // interned the names.
+  typedef std::vector<std::pair<SymbolId, ClockingBlock>> ClockingBlockMap;
 
   virtual ~ClockingBlockHolder() {}  // virtual as used as interface
 
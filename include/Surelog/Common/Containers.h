@@ -2,10 +2,13 @@
 #define SURELOG_CONTAINERS_H
 #pragma once
 
+#include <Surelog/Common/SymbolId.h>
+
 #include <cstdint>
 #include <map>
 #include <string>
 #include <string_view>
+#include <unordered_map>
 #include <vector>
 
 namespace SURELOG {
@@ -35,8 +38,12 @@ typedef std::multimap<std::string, ClassDefinition*, StringViewCompare>
     ClassNameClassDefinitionMultiMap;
 typedef std::map<std::string, ClassDefinition*> ClassNameClassDefinitionMap;
 
-typedef std::map<std::string, MacroInfo*, StringViewCompare> MacroStorage;
-typedef std::map<std::string, MacroInfo*, StringViewCompare> MacroStorageRef;
+// Macros by the id of their name in the SymbolTable of the compilation
+// unit, looked up on every macro reference.
+typedef std::unordered_map<SymbolId, MacroInfo*, SymbolIdHasher,
+                           SymbolIdEqualityComparer>
+    MacroStorage;
+typedef MacroStorage MacroStorageRef;
 
 }  // namespace SURELOG
 
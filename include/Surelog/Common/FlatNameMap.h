@@ -0,0 +1,118 @@
+/*
+ Copyright 2022 The Surelog Team.
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+/*
+ * File:   FlatNameMap.h
+ * Author: surelog
+ *
+ * Name keyed map stored as a vector sorted by name, the iteration order
+ * being the one of std::map<std::string, T>. The hashes of the names are
+ * kept alongside: small maps are searched by hash over contiguous memory,
+ * larger ones by binary search. Meant for the maps looked up far more often
+ * than modified (parameters of a scope). Inserting or erasing invalidates
+ * the iterators.
+ */
+
+#ifndef SURELOG_FLATNAMEMAP_H
+#define SURELOG_FLATNAMEMAP_H
+#pragma once
+
+#include <algorithm>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace SURELOG {
+
+template <typename T>
+class FlatNameMap final {
+ public:
+  using value_type = std::pair<std::string, T>;
+  using iterator = typename std::vector<value_type>::iterator;
+  using const_iterator = typename std::vector<value_type>::const_iterator;
+
+  iterator begin() { return m_entries.begin(); }
+  iterator end() { return m_entries.end(); }
+  const_iterator begin() const { return m_entries.begin(); }
+  const_iterator end() const { return m_entries.end(); }
+  size_t size() const { return m_entries.size(); }
+  bool empty() const { return m_entries.empty(); }
+  void clear() {
+    m_entries.clear();
+    m_hashes.clear();
+  }
+
+  // Hash of a name for find(name, hash), computed once for a lookup in
+  // several maps (a walk up the scopes).
+  static size_t hash(std::string_view name) {
+    return std::hash<std::string_view>()(name);
+  }
+
+  iterator find(std::string_view name) { return find(name, hash(name)); }
+  const_iterator find(std::string_view name) const {
+    return find(name, hash(name));
+  }
+  iterator find(std::string_view name, size_t nameHash) {
+    if (m_entries.size() <= kLinearSearchMax) {
+      // The hashes are contiguous, the names are only compared on a match.
+      for (size_t i = 0, n = m_hashes.size(); i < n; i++) {
+        if ((m_hashes[i] == nameHash) && (m_entries[i].first == name)) {
+          return m_entries.begin() + i;
+        }
+      }
+      return m_entries.end();
+    }
+    iterator it = lowerBound_(name);
+    return ((it != m_entries.end()) && (it->first == name)) ? it
+                                                            : m_entries.end();
+  }
+  const_iterator find(std::string_view name, size_t nameHash) const {
+    return const_cast<FlatNameMap*>(this)->find(name, nameHash);
+  }
+
+  // Same as std::map::emplace: an existing entry is kept.
+  std::pair<iterator, bool> emplace(std::string_view name, T value) {
+    iterator it = lowerBound_(name);
+    if ((it != m_entries.end()) && (it->first == name)) return {it, false};
+    m_hashes.insert(m_hashes.begin() + (it - m_entries.begin()), hash(name));
+    return {m_entries.emplace(it, std::string(name), std::move(value)), true};
+  }
+
+  iterator erase(const_iterator it) {
+    m_hashes.erase(m_hashes.begin() + (it - m_entries.cbegin()));
+    return m_entries.erase(it);
+  }
+
+ private:
+  static constexpr size_t kLinearSearchMax = 32;
+
+  iterator lowerBound_(std::string_view name) {
+    return std::lower_bound(
+        m_entries.begin(), m_entries.end(), name,
+        [](const value_type& entry, std::string_view key) {
+          return std::string_view(entry.first) < key;
+        });
+  }
+
+  std::vector<value_type> m_entries;
+  std::vector<size_t> m_hashes;  // Of the names of m_entries, same order
+};
+
+}  // namespace SURELOG
+
+#endif /* SURELOG_FLATNAMEMAP_H */
@@ -68,8 +68,6 @@ class DesignElement final {
   TimeInfo m_timeInfo;
   NodeId m_node;
   VObjectType m_defaultNetType = slNetType_Wire;
-  void* m_context;  // Not persisted field, only used to build the DesignElement
-                    // -> VNode relation
 };
 
 std::ostream& operator<<(std::ostream& os, DesignElement::ElemType type);
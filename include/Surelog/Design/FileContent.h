@@ -29,7 +29,10 @@
 #include <Surelog/Common/NodeId.h>
 #include <Surelog/Design/DesignComponent.h>
 #include <Surelog/Design/VObject.h>
+#include <Surelog/Design/VObjectStore.h>
+#include <Surelog/Design/VObjectTypeIndex.h>
 
+#include <memory>
 #include <unordered_map>
 #include <unordered_set>
 #include <vector>
@@ -95,6 +98,28 @@ class FileContent : public DesignComponent {
                                      bool first = false) const;
   // Recursively search for all items of types
   // and stops at types stopPoints
+
+  // Allocation free forms of sl_collect_all, appending to "objects".
+  void sl_collect_all(NodeId parent, VObjectType type,
+                      std::vector<NodeId>& objects, bool first = false) const;
+  void sl_collect_all(NodeId parent, const VObjectTypeBitset& types,
+                      std::vector<NodeId>& objects, bool first = false) const;
+  void sl_collect_all(NodeId parent, const VObjectTypeBitset& types,
+                      const VObjectTypeBitset& stopPoints,
+                      std::vector<NodeId>& objects, bool first = false) const;
+
+  // Calls visitor(id), in the order of sl_collect_all, on the items of types
+  // found under "parent", not going below types stopPoints. The walk stops
+  // when the visitor returns false.
+  template <typename Visitor>
+  void sl_visit(NodeId parent, const VObjectTypeBitset& types,
+                const VObjectTypeBitset& stopPoints, Visitor&& visitor) const;
+
+  // Index of the nodes by type, answering the sl_collect_all calls without
+  // stop points by range queries. Dropped when the tree is edited.
+  void buildTypeIndex();
+  const VObjectTypeIndex* getTypeIndex() const { return m_typeIndex.get(); }
+
   unsigned int getSize() const override { return m_objects.size(); }
   VObjectType getType() const override { return VObjectType::slNoType; }
   bool isInstance() const override { return false; }
@@ -111,7 +136,7 @@ class FileContent : public DesignComponent {
   SymbolTable* getSymbolTable() const { return m_symbolTable; }
   void setSymbolTable(SymbolTable* table) { m_symbolTable = table; }
   SymbolId getFileId(NodeId id) const;
-  SymbolId* getMutableFileId(NodeId id);
+  void setFileId(NodeId id, SymbolId fileId);
   Library* getLibrary() const { return m_library; }
   std::vector<DesignElement*>& getDesignElements() { return m_elements; }
   void addDesignElement(const std::string& name, DesignElement* elem);
@@ -124,8 +149,11 @@ class FileContent : public DesignComponent {
                    NodeId definition = InvalidNodeId,
                    NodeId child = InvalidNodeId,
                    NodeId sibling = InvalidNodeId);
-  const std::vector<VObject>& getVObjects() const { return m_objects; }
-  std::vector<VObject>* mutableVObjects() { return &m_objects; }
+  const VObjectStore& getVObjects() const { return m_objects; }
+  VObjectStore* mutableVObjects() {
+    m_typeIndex.reset();
+    return &m_objects;
+  }
   const NameIdMap& getObjectLookup() const { return m_objectLookup; }
   void insertObjectLookup(const std::string& name, NodeId id,
                           ErrorContainer* errors);
@@ -133,8 +161,8 @@ class FileContent : public DesignComponent {
     return m_referencedObjects;
   }
 
-  const VObject& Object(NodeId index) const;
-  VObject* MutableObject(NodeId index);
+  // Copy of the object, the fields are not stored together.
+  VObject Object(NodeId index) const;
 
   NodeId UniqueId(NodeId index) const;
 
@@ -145,6 +173,7 @@ class FileContent : public DesignComponent {
   NodeId Sibling(NodeId index) const;
 
   NodeId Definition(NodeId index) const;
+  void SetDefinition(NodeId index, NodeId def);
 
   void SetDefinitionFile(NodeId index, SymbolId def);
   SymbolId GetDefinitionFile(NodeId index) const;
@@ -152,8 +181,14 @@ class FileContent : public DesignComponent {
   NodeId Parent(NodeId index) const;
 
   VObjectType Type(NodeId index) const;
+  void SetType(NodeId index, VObjectType type);
+
+  void SetChild(NodeId index, NodeId child);
+  void SetSibling(NodeId index, NodeId sibling);
+  void SetParent(NodeId index, NodeId parent);
 
   unsigned int Line(NodeId index) const;
+  void SetLine(NodeId index, unsigned int line);
 
   unsigned short Column(NodeId index) const;
 
@@ -220,7 +255,8 @@ class FileContent : public DesignComponent {
  protected:
   std::vector<DesignElement*> m_elements;
   std::map<std::string, DesignElement*, StringViewCompare> m_elementMap;
-  std::vector<VObject> m_objects;
+  VObjectStore m_objects;
+  std::unique_ptr<VObjectTypeIndex> m_typeIndex;
   std::unordered_map<NodeId, SymbolId, NodeIdHasher, NodeIdEqualityComparer>
       m_definitionFiles;
 
@@ -243,8 +279,55 @@ class FileContent : public DesignComponent {
   SymbolTable* m_symbolTable;  // TODO: should be set in constructor *const
   FileContent* m_parentFile;   // for file chunks
   bool m_isLibraryCellFile = false;
+
+ private:
+  // False, with an error, if "index" is not an object of the file.
+  bool checkIndex_(NodeId index) const;
+
+  // Walk of sl_visit with the type tests given as predicates.
+  template <typename IsType, typename IsStopPoint, typename Visitor>
+  void walk_(NodeId parent, IsType isType, IsStopPoint isStopPoint,
+             Visitor&& visitor) const;
+
+  // Stack of the tree walks, shared by the walks of the thread. A walk
+  // only uses the entries it pushed, so walks can nest.
+  static std::vector<NodeId>& walkStack_();
 };
 
+template <typename Visitor>
+void FileContent::sl_visit(NodeId parent, const VObjectTypeBitset& types,
+                           const VObjectTypeBitset& stopPoints,
+                           Visitor&& visitor) const {
+  walk_(
+      parent, [&types](VObjectType type) { return types.contains(type); },
+      [&stopPoints](VObjectType type) { return stopPoints.contains(type); },
+      visitor);
+}
+
+template <typename IsType, typename IsStopPoint, typename Visitor>
+void FileContent::walk_(NodeId parent, IsType isType, IsStopPoint isStopPoint,
+                        Visitor&& visitor) const {
+  if (!parent) return;
+  if (m_objects.empty()) return;
+  if (parent >= m_objects.size()) return;
+  NodeId id = m_objects.child(parent);
+  if (!id) id = m_objects.sibling(parent);
+  if (!id) return;
+  std::vector<NodeId>& stack = walkStack_();
+  const size_t base = stack.size();
+  stack.push_back(id);
+  while (stack.size() > base) {
+    id = stack.back();
+    stack.pop_back();
+    const VObjectType current = m_objects.type(id);
+    if (isType(current) && !visitor(id)) break;
+    if (NodeId sibling = m_objects.sibling(id)) stack.push_back(sibling);
+    NodeId child = m_objects.child(id);
+    if (child && !isStopPoint(current)) stack.push_back(child);
+  }
+  stack.resize(base);
+}
+
 };  // namespace SURELOG
 
 #endif /* SURELOG_FILECONTENT_H */
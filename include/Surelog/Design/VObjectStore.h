@@ -0,0 +1,135 @@
+/*
+ Copyright 2022 The Surelog Team.
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+/*
+ * File:   VObjectStore.h
+ * Author: surelog
+ *
+ * Storage of the VObjects of a FileContent, one array per field.
+ * Tree walks only touch the type, child and sibling arrays. The rarely set
+ * or rarely large fields are packed:
+ * - the file is an index in the (small) table of the files of the content,
+ * - the end line is stored as an offset from the line,
+ * - the definition, mostly invalid, is flagged in a bitmap and lives in a
+ *   vector sorted by object.
+ * Values not fitting the packed form go to side tables as well.
+ */
+
+#ifndef SURELOG_VOBJECTSTORE_H
+#define SURELOG_VOBJECTSTORE_H
+#pragma once
+
+#include <Surelog/Common/NodeId.h>
+#include <Surelog/Common/SymbolId.h>
+#include <Surelog/Design/VObject.h>
+
+#include <cstdint>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace SURELOG {
+
+class VObjectStore final {
+ public:
+  size_t size() const { return m_types.size(); }
+  bool empty() const { return m_types.empty(); }
+  void clear();
+  void reserve(size_t size);
+
+  void emplace_back(SymbolId name, SymbolId fileId, VObjectType type,
+                    unsigned int line, unsigned short column,
+                    unsigned int endLine, unsigned short endColumn,
+                    NodeId parent, NodeId definition, NodeId child,
+                    NodeId sibling);
+  void push_back(const VObject& object);
+
+  // Copy of the object at "index", which must be in range.
+  VObject operator[](NodeId index) const;
+
+  // Field accessors, "index" must be in range.
+  VObjectType type(NodeId index) const { return m_types[(RawNodeId)index]; }
+  NodeId child(NodeId index) const { return m_children[(RawNodeId)index]; }
+  NodeId sibling(NodeId index) const { return m_siblings[(RawNodeId)index]; }
+  NodeId parent(NodeId index) const { return m_parents[(RawNodeId)index]; }
+  SymbolId name(NodeId index) const { return m_names[(RawNodeId)index]; }
+  unsigned int line(NodeId index) const { return m_lines[(RawNodeId)index]; }
+  unsigned short column(NodeId index) const {
+    return m_columns[(RawNodeId)index];
+  }
+  unsigned short endColumn(NodeId index) const {
+    return m_endColumns[(RawNodeId)index];
+  }
+  SymbolId fileId(NodeId index) const;
+  unsigned int endLine(NodeId index) const;
+  NodeId definition(NodeId index) const;
+
+  void setType(NodeId index, VObjectType type) {
+    m_types[(RawNodeId)index] = type;
+  }
+  void setChild(NodeId index, NodeId child) {
+    m_children[(RawNodeId)index] = child;
+  }
+  void setSibling(NodeId index, NodeId sibling) {
+    m_siblings[(RawNodeId)index] = sibling;
+  }
+  void setParent(NodeId index, NodeId parent) {
+    m_parents[(RawNodeId)index] = parent;
+  }
+  void setName(NodeId index, SymbolId name) {
+    m_names[(RawNodeId)index] = name;
+  }
+  void setFileId(NodeId index, SymbolId fileId);
+  // Keeps the end line where it is.
+  void setLine(NodeId index, unsigned int line);
+  void setEndLine(NodeId index, unsigned int endLine);
+  void setDefinition(NodeId index, NodeId definition);
+
+  // Bytes used by the objects, side tables included.
+  size_t memoryUsage() const;
+
+ private:
+  static constexpr uint16_t kOverflow = 0xFFFF;
+
+  uint16_t fileIndex_(SymbolId fileId);
+
+  using Definition = std::pair<RawNodeId, NodeId>;
+  std::vector<Definition>::iterator findDefinition_(NodeId index);
+
+  std::vector<VObjectType> m_types;
+  std::vector<NodeId> m_children;
+  std::vector<NodeId> m_siblings;
+  std::vector<NodeId> m_parents;
+  std::vector<SymbolId> m_names;
+  std::vector<unsigned int> m_lines;
+  std::vector<unsigned short> m_columns;
+  std::vector<unsigned short> m_endColumns;
+  std::vector<uint16_t> m_endLineOffsets;
+  std::vector<uint16_t> m_fileIndexes;
+
+  std::vector<SymbolId> m_files;
+  std::unordered_map<RawSymbolId, uint16_t> m_fileIndexMap;
+  uint16_t m_lastFileIndex = kOverflow;
+  std::unordered_map<RawNodeId, SymbolId> m_fileOverflow;
+  std::unordered_map<RawNodeId, unsigned int> m_endLineOverflow;
+  std::vector<bool> m_hasDefinition;
+  // Sorted by object, mostly set in object order.
+  std::vector<Definition> m_definitions;
+};
+
+}  // namespace SURELOG
+
+#endif /* SURELOG_VOBJECTSTORE_H */
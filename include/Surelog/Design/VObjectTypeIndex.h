@@ -0,0 +1,106 @@
+/*
+ Copyright 2022 The Surelog Team.
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+/*
+ * File:   VObjectTypeIndex.h
+ * Author: surelog
+ *
+ * VObjectTypeBitset: set of VObjectTypes tested with one bit lookup, used
+ * by the FileContent tree queries instead of hashing the type of every
+ * visited node.
+ *
+ * VObjectTypeIndex: preorder numbering of the tree of a VObjectStore and,
+ * per type, the preorder numbers of the nodes of that type. The
+ * descendants of a node are the preorder interval following it, so "all
+ * nodes of type T under X" is a binary search in the list of T.
+ */
+
+#ifndef SURELOG_VOBJECTTYPEINDEX_H
+#define SURELOG_VOBJECTTYPEINDEX_H
+#pragma once
+
+#include <Surelog/Common/NodeId.h>
+#include <Surelog/SourceCompile/VObjectTypes.h>
+
+#include <bitset>
+#include <cstdint>
+#include <initializer_list>
+#include <utility>
+#include <vector>
+
+namespace SURELOG {
+
+class VObjectStore;
+
+class VObjectTypeBitset final {
+ public:
+  VObjectTypeBitset() = default;
+  VObjectTypeBitset(std::initializer_list<VObjectType> types) {
+    for (VObjectType type : types) m_bits.set(type);
+  }
+  explicit VObjectTypeBitset(const VObjectTypeUnorderedSet& types) {
+    for (VObjectType type : types) m_bits.set(type);
+  }
+
+  bool contains(VObjectType type) const { return m_bits.test(type); }
+  void insert(VObjectType type) { m_bits.set(type); }
+  bool empty() const { return m_bits.none(); }
+
+ private:
+  std::bitset<VObjectTypeCount> m_bits;
+};
+
+class VObjectTypeIndex final {
+ public:
+  // Numbers the trees rooted at the objects that are neither the child nor
+  // the sibling of another object.
+  explicit VObjectTypeIndex(const VObjectStore& objects);
+
+  bool isIndexed(NodeId id) const {
+    return ((RawNodeId)id < m_preorder.size()) &&
+           (m_preorder[(RawNodeId)id] != kNotIndexed);
+  }
+
+  // Appends to "out", in preorder, the descendants of "parent" (itself
+  // excluded) whose type is in "types"; only the first one if "first".
+  // "parent" must be indexed.
+  void collect(NodeId parent, const VObjectTypeBitset& types, bool first,
+               std::vector<NodeId>& out) const;
+  void collect(NodeId parent, VObjectType type, bool first,
+               std::vector<NodeId>& out) const;
+
+  // Bytes used by the index.
+  size_t memoryUsage() const;
+
+ private:
+  static constexpr uint32_t kNotIndexed = UINT32_MAX;
+
+  // Preorder interval of the descendants of "parent" in the list of "type".
+  std::pair<const uint32_t*, const uint32_t*> range_(NodeId parent,
+                                                     VObjectType type) const;
+
+  std::vector<uint32_t> m_preorder;     // NodeId -> preorder number
+  std::vector<uint32_t> m_subtreeEnd;   // NodeId -> last descendant + 1
+  std::vector<NodeId> m_nodes;          // preorder number -> NodeId
+  std::vector<uint32_t> m_byType;       // preorder numbers sorted by type
+  // Types present in the tree with the start of their list in m_byType,
+  // sorted by type.
+  std::vector<std::pair<VObjectType, uint32_t>> m_typeStarts;
+};
+
+}  // namespace SURELOG
+
+#endif /* SURELOG_VOBJECTTYPEINDEX_H */
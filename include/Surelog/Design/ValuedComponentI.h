@@ -27,6 +27,7 @@
 
 #include <Surelog/Common/RTTI.h>
 #include <Surelog/Common/Containers.h>
+#include <Surelog/Common/FlatNameMap.h>
 
 // UHDM
 #include <uhdm/uhdm_forward_decl.h>
@@ -43,8 +44,8 @@ class Value;
 class ValuedComponentI : public RTTI {
   SURELOG_IMPLEMENT_RTTI(ValuedComponentI, RTTI)
  public:
-  using ParamMap = std::map<std::string, std::pair<Value*, int>, StringViewCompare>;
-  using ComplexValueMap = std::map<std::string, UHDM::expr*, StringViewCompare>;
+  using ParamMap = FlatNameMap<std::pair<Value*, int>>;
+  using ComplexValueMap = FlatNameMap<UHDM::expr*>;
 
   ValuedComponentI(const ValuedComponentI* parentScope,
                    ValuedComponentI* definition)
@@ -30,6 +30,7 @@ namespace SURELOG {
 class CompileDesign;
 class Design;
 class CompilationUnit;
+class SymbolTable;
 
 // TODO: this looks like it should probably be more a
 // function ? Something like
@@ -38,7 +39,9 @@ class Builtin final {
  public:
   Builtin(CompileDesign* compiler, Design* design)
       : m_compiler(compiler), m_design(design) {}
-  void addBuiltinMacros(CompilationUnit* compUnit);
+  // "symbols" is the table the compilation unit is preprocessed with, the
+  // macros are registered by the id of their name in it.
+  void addBuiltinMacros(CompilationUnit* compUnit, SymbolTable* symbols);
   void addBuiltinTypes();
   void addBuiltinClasses();
 
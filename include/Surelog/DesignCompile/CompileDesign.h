@@ -26,12 +26,15 @@
 #pragma once
 
 #include <Surelog/Design/Design.h>
+#include <Surelog/DesignCompile/EvalFuncVM.h>
+#include <Surelog/DesignCompile/ReduceExprMemo.h>
 
 // UHDM
 #include <uhdm/Serializer.h>
 #include <uhdm/sv_vpi_user.h>
 
 #include <mutex>
+#include <string>
 
 namespace SURELOG {
 
@@ -56,6 +59,13 @@ class CompileDesign {
   void lockSerializer() { m_serializerMutex.lock(); }
   void unlockSerializer() { m_serializerMutex.unlock(); }
 
+  ReduceExprMemo* getReduceExprMemo() { return &m_reduceExprMemo; }
+  EvalFuncVM* getEvalFuncVM() { return &m_evalFuncVM; }
+
+  // Statistics of the elaboration steps, for -profile.
+  void addProfileInfo(const std::string& info) { m_profileInfo += info; }
+  const std::string& getProfileInfo() const { return m_profileInfo; }
+
  private:
   CompileDesign(const CompileDesign& orig) = delete;
 
@@ -68,11 +78,13 @@ class CompileDesign {
   bool elaboration_();
 
   Compiler* const m_compiler;
-  std::vector<SymbolTable*> m_symbolTables;
   std::vector<ErrorContainer*> m_errorContainers;
 
   std::mutex m_serializerMutex;
   UHDM::Serializer m_serializer;
+  ReduceExprMemo m_reduceExprMemo;
+  EvalFuncVM m_evalFuncVM;
+  std::string m_profileInfo;
 };
 
 }  // namespace SURELOG
@@ -25,9 +25,16 @@
 #define SURELOG_DESIGNELABORATION_H
 #pragma once
 
+#include <Surelog/Common/NodeId.h>
 #include <Surelog/Config/Config.h>
 #include <Surelog/DesignCompile/TestbenchElaboration.h>
 
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
 namespace SURELOG {
 
 class BindStmt;
@@ -88,6 +95,26 @@ class DesignElaboration : public TestbenchElaboration {
   void createFileList_();
   Config* getInstConfig(const std::string& name);
   Config* getCellConfig(const std::string& name);
+
+  // Parameter independent scans of a definition body (the sub instances and
+  // generate constructs, the defparams), done once per body instead of once
+  // per instance. The trees are not edited during elaboration.
+  const std::vector<NodeId>& collectSubInstances_(const FileContent* fC,
+                                                  NodeId nodeId);
+  const std::vector<NodeId>& collectDefParams_(const FileContent* fC,
+                                               NodeId nodeId);
+  std::string reportProfile_() const;
+
+  using BodyScanKey = std::pair<const FileContent*, NodeId>;
+  struct BodyScanKeyHasher final {
+    size_t operator()(const BodyScanKey& key) const {
+      return std::hash<const FileContent*>()(key.first) ^
+             (NodeIdHasher()(key.second) << 1);
+    }
+  };
+  using BodyScans =
+      std::unordered_map<BodyScanKey, std::vector<NodeId>, BodyScanKeyHasher>;
+
   std::vector<std::pair<std::string, const FileContent*>> m_topLevelModules;
   std::set<std::string> m_uniqueTopLevelModules;
   ModuleDefinitionFactory* m_moduleDefFactory;
@@ -97,6 +124,10 @@ class DesignElaboration : public TestbenchElaboration {
   std::map<std::string, Config> m_cellConfig;
   std::map<std::string, UseClause> m_instUseClause;
   std::map<std::string, UseClause> m_cellUseClause;
+  BodyScans m_subInstanceScans;
+  BodyScans m_defParamScans;
+  uint64_t m_bodyScans = 0;
+  uint64_t m_bodyScanHits = 0;
 };
 
 };  // namespace SURELOG
@@ -0,0 +1,150 @@
+/*
+ Copyright 2022 The Surelog Team.
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+/*
+ * File:   EvalFuncVM.h
+ * Author: surelog
+ *
+ * Evaluator of the constant functions called by CompileHelper::EvalFunc.
+ * The body of a function is compiled once into a bytecode where arguments
+ * and locals are frame slots, then run on a stack machine over 64 bits
+ * integers. A function using a construct or a type the machine does not
+ * model (wider than 64 bits, calls to other functions, selects, ...) is
+ * rejected when compiled and always evaluated by UHDM::ExprEval. A call of
+ * a compiled function also goes to ExprEval when a value leaves what the
+ * machine computes exactly (x/z, overflow, out of the declared width, ...).
+ * The result is a constant of the declared return type of the function.
+ */
+
+#ifndef SURELOG_EVALFUNCVM_H
+#define SURELOG_EVALFUNCVM_H
+#pragma once
+
+// UHDM
+#include <uhdm/uhdm_forward_decl.h>
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace UHDM {
+class Serializer;
+}
+
+namespace SURELOG {
+
+class EvalFuncVM final {
+ public:
+  enum class OpCode : uint8_t {
+    PushConst,     // m_constants[arg]
+    Reset,         // Slot arg is unassigned again (declaration)
+    Load,          // Slot arg, must have been assigned
+    Store,         // Pops into slot arg, must fit its width
+    LoadExternal,  // Value of m_externals[arg], looked up once per call
+    Neg,
+    LogNot,
+    Add,
+    Sub,
+    Mul,
+    Div,
+    Mod,
+    Pow,
+    Shl,
+    Shr,
+    BitAnd,
+    BitOr,
+    BitXor,
+    Eq,
+    Neq,
+    Lt,
+    Le,
+    Gt,
+    Ge,
+    LogAnd,
+    LogOr,
+    Clog2,
+    Jump,        // To arg
+    JumpIfZero,  // Pops, to arg
+    Return
+  };
+
+  struct Instruction final {
+    OpCode m_op;
+    int32_t m_arg;
+  };
+
+  struct Slot final {
+    std::string m_name;
+    uint16_t m_width;
+    bool m_signed;
+  };
+
+  struct Program final {
+    std::vector<Instruction> m_code;
+    std::vector<int64_t> m_constants;
+    // The inputs first, in the order of the arguments, then the function
+    // name (return value), then the locals.
+    std::vector<Slot> m_slots;
+    std::vector<std::string> m_externals;
+    uint32_t m_inputCount = 0;
+    uint32_t m_returnSlot = 0;
+    // Of the return value, given to the result constant.
+    const UHDM::typespec* m_returnTypespec = nullptr;
+  };
+
+  // Value of a name the function reads but does not declare (a parameter).
+  using ValueLookup = std::function<UHDM::any*(const std::string& name)>;
+
+  // Jumps taken in a call before giving up (runaway loop).
+  static constexpr uint64_t kMaxJumps = 1 << 24;
+
+  EvalFuncVM() = default;
+  EvalFuncVM(const EvalFuncVM&) = delete;
+  EvalFuncVM& operator=(const EvalFuncVM&) = delete;
+
+  // nullptr if the body uses a construct the machine does not model.
+  static std::unique_ptr<Program> compile(const UHDM::function* func);
+  // False when the call has to be evaluated by ExprEval.
+  static bool run(const Program& program, const std::vector<UHDM::any*>* args,
+                  const ValueLookup& lookup, int64_t& result);
+
+  // The constant of the call, nullptr if it has to be evaluated by ExprEval.
+  UHDM::constant* evaluate(const UHDM::function* func,
+                           const std::vector<UHDM::any*>* args,
+                           const ValueLookup& lookup, UHDM::Serializer& s);
+  // Constant of the return type of the program holding "value".
+  static UHDM::constant* makeResult(const Program& program, int64_t value,
+                                    UHDM::Serializer& s);
+
+  uint64_t getCallCount() const { return m_calls; }
+  uint64_t getVMCallCount() const { return m_vmCalls; }
+  // For -profile.
+  std::string reportProfile() const;
+
+ private:
+  // nullptr for the functions left to ExprEval.
+  std::unordered_map<const UHDM::function*, std::unique_ptr<Program>>
+      m_programs;
+  uint64_t m_calls = 0;
+  uint64_t m_vmCalls = 0;
+};
+
+}  // namespace SURELOG
+
+#endif /* SURELOG_EVALFUNCVM_H */
@@ -0,0 +1,118 @@
+/*
+ Copyright 2022 The Surelog Team.
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+/*
+ * File:   ReduceExprMemo.h
+ * Author: surelog
+ *
+ * Memo of CompileHelper::reduceExpr for the expressions reduced to a
+ * constant, shared by the whole compilation. An entry is keyed by the UHDM
+ * ids of the expression and of its parent expression, which the serializer
+ * never gives to another object, even once they are erased. It holds the
+ * lookups (parameter values, objects, functions) its reduction made, with a
+ * fingerprint of what each returned.
+ * The entry is reused, for another instance or another reference, when the
+ * same lookups return the same things again: the result only depends on
+ * the parameters the expression actually read. The diagnostics of the
+ * reduction are reported again on reuse. The lookups are replayed with the
+ * parent expressions they were given, the memo is cleared wherever UHDM
+ * objects are erased.
+ */
+
+#ifndef SURELOG_REDUCEEXPRMEMO_H
+#define SURELOG_REDUCEEXPRMEMO_H
+#pragma once
+
+#include <Surelog/ErrorReporting/Error.h>
+
+// UHDM
+#include <uhdm/uhdm_forward_decl.h>
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace SURELOG {
+
+class ReduceExprMemo final {
+ public:
+  struct Dependency final {
+    enum class Kind { Value, Object, TaskFunc };
+    Kind m_kind;
+    std::string m_name;
+    const UHDM::any* m_pexpr;  // As given to the lookup
+    std::string m_fingerprint;
+  };
+
+  struct Entry final {
+    std::vector<Dependency> m_dependencies;
+    const UHDM::constant* m_result = nullptr;  // Private copy, never handed
+    // Reported by the reduction itself, not by the lookups that are run
+    // again to find the entry.
+    std::vector<Error> m_errors;
+  };
+
+  static constexpr size_t kMaxVariants = 8;
+
+  ReduceExprMemo() = default;
+  ReduceExprMemo(const ReduceExprMemo&) = delete;
+  ReduceExprMemo& operator=(const ReduceExprMemo&) = delete;
+
+  // Worth memoizing: operations and function calls, not the leaves.
+  static bool isMemoizable(const UHDM::any* expr);
+  // What identifies a lookup result: the value of a constant, the UHDM id
+  // of the object otherwise.
+  static std::string fingerprint(const UHDM::any* object);
+
+  // Entries of "expr" reduced under "pexpr", the oldest first.
+  const std::vector<Entry>* find(const UHDM::any* expr,
+                                 const UHDM::any* pexpr) const;
+  // Ignored beyond kMaxVariants entries for the expression.
+  void add(const UHDM::any* expr, const UHDM::any* pexpr, Entry entry);
+  // Forgets all the entries, when objects they refer to are erased or
+  // retyped, or before the serializer is purged.
+  void clear() { m_entries.clear(); }
+
+  void countLookup(bool hit) {
+    m_lookups++;
+    if (hit) m_hits++;
+  }
+  uint64_t getLookupCount() const { return m_lookups; }
+  uint64_t getHitCount() const { return m_hits; }
+  // For -profile.
+  std::string reportProfile() const;
+
+ private:
+  // UHDM ids of the expression and of the parent expression, 0 for none.
+  using Key = std::pair<uint64_t, uint64_t>;
+  struct KeyHasher final {
+    size_t operator()(const Key& key) const {
+      return std::hash<uint64_t>()(key.first) ^
+             (std::hash<uint64_t>()(key.second) << 1);
+    }
+  };
+  static Key key(const UHDM::any* expr, const UHDM::any* pexpr);
+
+  std::unordered_map<Key, std::vector<Entry>, KeyHasher> m_entries;
+  uint64_t m_lookups = 0;
+  uint64_t m_hits = 0;
+};
+
+}  // namespace SURELOG
+
+#endif /* SURELOG_REDUCEEXPRMEMO_H */
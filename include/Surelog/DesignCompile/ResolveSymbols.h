@@ -87,7 +87,6 @@ class ResolveSymbols : public CompileStep {
   bool resolve();
 
   VObject Object(NodeId index) const override;
-  VObject* MutableObject(NodeId index);
 
   NodeId UniqueId(NodeId index) const override;
 
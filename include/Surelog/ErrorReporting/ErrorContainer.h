@@ -72,6 +72,7 @@ class ErrorContainer final {
   bool printMessages(bool muteStdout = false);
   bool printMessage(Error& error, bool muteStdout = false);
   bool printStats(Stats stats, bool muteStdout = false);
+  static std::string createStatsReport(const Stats& stats);
   bool printToLogFile(const std::string& report);
   bool hasFatalErrors() const;
   Stats getErrorStats() const;
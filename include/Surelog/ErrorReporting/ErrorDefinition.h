@@ -81,6 +81,8 @@ class ErrorDefinition {
     CMD_UNDEFINED_CONFIG = 28,
     CMD_USING_GLOBAL_TIMESCALE = 29,
     CMD_CACHE_CAPACITY_EXCEEDED = 30,
+    CMD_DFA_CACHE_MISSING_SIZE = 31,
+    CMD_CACHE_NOT_SAVED = 32,
     PP_CANNOT_OPEN_FILE = 100,
     PP_CANNOT_OPEN_INCLUDE_FILE = 101,
     PP_UNKOWN_MACRO = 102,
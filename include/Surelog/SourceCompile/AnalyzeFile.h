@@ -27,6 +27,8 @@
 
 #include <filesystem>
 #include <stack>
+#include <string>
+#include <string_view>
 #include <vector>
 
 #include <Surelog/Common/SymbolId.h>
@@ -61,16 +63,18 @@ class AnalyzeFile {
     unsigned long m_endChar;
   };
 
+  // "content" is the preprocessed content when still in memory, it must
+  // outlive the analysis. The .pp file is read otherwise.
   AnalyzeFile(CommandLineParser* clp, Design* design,
               const std::filesystem::path& ppFileName,
               const std::filesystem::path& fileName, int nbChunks,
-              const std::string& text = "")
+              std::string_view content = "")
       : m_clp(clp),
         m_design(design),
         m_ppFileName(ppFileName),
         m_fileName(fileName),
         m_nbChunks(nbChunks),
-        m_text(text) {}
+        m_content(content) {}
 
   void analyze();
   std::vector<std::filesystem::path>& getSplitFiles() { return m_splitFiles; }
@@ -80,7 +84,7 @@ class AnalyzeFile {
   virtual ~AnalyzeFile() {}
 
  private:
-  void checkSLlineDirective_(const std::string& line, unsigned int lineNb);
+  void checkSLlineDirective_(std::string_view line, unsigned int lineNb);
   std::string setSLlineDirective_(unsigned int lineNb,
                                   unsigned int& origFromLine,
                                   std::filesystem::path& origFile);
@@ -93,7 +97,7 @@ class AnalyzeFile {
   std::vector<unsigned int> m_lineOffsets;
   int m_nbChunks;
   std::stack<IncludeFileInfo> m_includeFileInfo;
-  std::string m_text;  // unit test
+  std::string_view m_content;
 };
 
 };  // namespace SURELOG
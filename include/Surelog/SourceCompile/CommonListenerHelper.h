@@ -28,8 +28,8 @@
 #include <Surelog/Common/NodeId.h>
 #include <Surelog/SourceCompile/VObjectTypes.h>
 
-#include <map>
 #include <string>
+#include <unordered_map>
 
 namespace antlr4 {
 class CommonTokenStream;
@@ -41,6 +41,7 @@ class ParseTree;
 
 namespace SURELOG {
 
+class DesignElement;
 class FileContent;
 class SymbolId;
 class VObject;
@@ -55,7 +56,7 @@ class CommonListenerHelper {
 
   NodeId NodeIdFromContext(const antlr4::tree::ParseTree* ctx) const;
 
-  const VObject& Object(NodeId index);
+  VObject Object(NodeId index);
 
   NodeId UniqueId(NodeId index) const;
 
@@ -84,10 +85,6 @@ class CommonListenerHelper {
   getFileLine(antlr4::ParserRuleContext* ctx, SymbolId& fileId) = 0;
 
  private:
-  NodeId& MutableChild(NodeId index);
-  NodeId& MutableSibling(NodeId index);
-  NodeId& MutableParent(NodeId index);
-
   int addVObject(antlr4::ParserRuleContext* ctx, SymbolId sym,
                  VObjectType objtype);
 
@@ -101,8 +98,15 @@ class CommonListenerHelper {
   FileContent* m_fileContent;
   antlr4::CommonTokenStream* const m_tokens;
 
-  typedef std::map<const antlr4::tree::ParseTree*, NodeId> ContextToObjectMap;
+  typedef std::unordered_map<const antlr4::tree::ParseTree*, NodeId>
+      ContextToObjectMap;
   ContextToObjectMap m_contextToObjectMap;
+
+  // Design element created on entering a context, the object built when
+  // leaving it becomes the node of the element.
+  typedef std::unordered_map<const antlr4::tree::ParseTree*, DesignElement*>
+      ContextToDesignElementMap;
+  ContextToDesignElementMap m_contextToDesignElementMap;
 };
 
 }  // namespace SURELOG
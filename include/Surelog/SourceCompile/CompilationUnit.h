@@ -28,6 +28,10 @@
 #include <Surelog/Common/Containers.h>
 #include <Surelog/Common/NodeId.h>
 #include <Surelog/Design/TimeInfo.h>
+#include <Surelog/SourceCompile/FileLineIndex.h>
+#include <Surelog/SourceCompile/IncludeMemo.h>
+
+#include <vector>
 
 namespace SURELOG {
 
@@ -45,21 +49,33 @@ class CompilationUnit {
   bool isInDesignElement() const { return m_inDesignElement; }
   bool isFileUnit() const { return m_fileunit; }
 
-  void registerMacroInfo(const std::string& macroName, MacroInfo* macro);
-  MacroInfo* getMacroInfo(const std::string& macroName);
+  // Macro names are ids in the SymbolTable of the preprocessed files.
+  void registerMacroInfo(SymbolId macroId, MacroInfo* macro);
+  MacroInfo* getMacroInfo(SymbolId macroId);
 
   const MacroStorageRef& getMacros() const { return m_macros; }
-  void deleteMacro(const std::string& macroName);
-  void deleteAllMacros() { m_macros.clear(); }
+  void deleteMacro(SymbolId macroId);
+  void deleteAllMacros();
+
+  // While an include is preprocessed, its macro accesses go to a recording
+  // for the IncludeMemo. Nested includes stack their recordings.
+  void startMacroRecording(IncludeMemo::Recording* recording) {
+    m_macroRecordings.push_back(recording);
+  }
+  void stopMacroRecording() { m_macroRecordings.pop_back(); }
+  void abortMacroRecordings();
+  void recordInclude(const std::string& fileName);
 
   /* Following methods deal with `timescale */
   void setCurrentTimeInfo(SymbolId fileId);
-  std::vector<TimeInfo>& getTimeInfo() { return m_timeInfo; }
+  const std::vector<TimeInfo>& getTimeInfo() const { return m_timeInfo; }
   void recordTimeInfo(TimeInfo& info);
   TimeInfo& getTimeInfo(SymbolId fileId, unsigned int line);
 
   /* Following methods deal with `default_nettype */
-  std::vector<NetTypeInfo>& getDefaultNetType() { return m_defaultNetTypes; }
+  const std::vector<NetTypeInfo>& getDefaultNetType() const {
+    return m_defaultNetTypes;
+  }
   void recordDefaultNetType(NetTypeInfo& info);
   VObjectType getDefaultNetType(SymbolId fileId, unsigned int line);
 
@@ -77,9 +93,12 @@ class CompilationUnit {
   bool m_inDesignElement;
 
   MacroStorageRef m_macros;
+  std::vector<IncludeMemo::Recording*> m_macroRecordings;
 
   std::vector<TimeInfo> m_timeInfo;
+  FileLineIndex m_timeInfoIndex;
   std::vector<NetTypeInfo> m_defaultNetTypes;
+  FileLineIndex m_defaultNetTypeIndex;
   TimeInfo m_noTimeInfo;
 
   /* Design Info helper data */
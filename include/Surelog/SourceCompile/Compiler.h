@@ -28,6 +28,8 @@ limitations under the License.
 #include <Surelog/Common/SymbolId.h>
 #include <Surelog/ErrorReporting/ErrorContainer.h>
 #include <Surelog/SourceCompile/CompileSourceFile.h>
+#include <Surelog/SourceCompile/IncludeMemo.h>
+#include <Surelog/SourceCompile/IncludeResolver.h>
 #include <Surelog/SourceCompile/PreprocessFile.h>
 #include <uhdm/vpi_user.h>
 
@@ -40,6 +42,7 @@ limitations under the License.
 #include <map>
 #include <set>
 #include <string>
+#include <string_view>
 #include <vector>
 
 namespace SURELOG {
@@ -53,6 +56,8 @@ class FileContent;
 class LibrarySet;
 class PreprocessFile;
 class SymbolTable;
+class ProcessPool;
+class ThreadPool;
 
 class Compiler {
  public:
@@ -79,6 +84,10 @@ class Compiler {
   void registerAntlrPpHandlerForId(SymbolId id,
                                    PreprocessFile::AntlrParserHandler* pp);
   PreprocessFile::AntlrParserHandler* getAntlrPpHandlerForId(SymbolId);
+  // Include guards and preprocessed includes, shared by the compilation units
+  IncludeMemo* getIncludeMemo() { return &m_includeMemo; }
+  // Include file lookups, shared by the compilation units
+  IncludeResolver* getIncludeResolver() { return &m_includeResolver; }
 
   // TODO: this should return a const Design, but can't be because
   // of Design having a bunch of non-const accessors. Address
@@ -90,6 +99,8 @@ class Compiler {
 
   vpiHandle getUhdmDesign() const { return m_uhdmDesign; }
   CompileDesign* getCompileDesign() const { return m_compileDesign; }
+  // Worker pool sized by -mt, lives for the whole run
+  ThreadPool* getThreadPool();
   ErrorContainer::Stats getErrorStats() const;
   bool isLibraryFile(SymbolId id) const;
   const std::map<std::filesystem::path, std::vector<std::filesystem::path>>&
@@ -108,6 +119,8 @@ class Compiler {
   bool createFileList_();
   bool createMultiProcessPreProcessor_();
   bool createMultiProcessParser_();
+  // Runs the jobs queued in "pool" (-mp) and reports the failed ones.
+  bool runChildProcesses_(ProcessPool& pool, std::string_view stage);
   bool parseinit_();
   bool pythoninit_();
   bool compileFileSet_(CompileSourceFile::Action action, bool allowMultithread,
@@ -123,11 +136,12 @@ class Compiler {
   std::map<SymbolId, PreprocessFile::AntlrParserHandler*,
            SymbolIdLessThanComparer>
       m_antlrPpMap;
+  IncludeMemo m_includeMemo;
+  IncludeResolver m_includeResolver;
   std::vector<CompileSourceFile*> m_compilers;
   std::vector<CompileSourceFile*> m_compilersChunkFiles;
   std::vector<CompileSourceFile*> m_compilersParentFiles;
   std::vector<CompilationUnit*> m_compilationUnits;
-  std::vector<SymbolTable*> m_symbolTables;
   std::vector<ErrorContainer*> m_errorContainers;
   LibrarySet* const m_librarySet;
   ConfigSet* const m_configSet;
@@ -136,6 +150,7 @@ class Compiler {
   SymbolIdSet m_libraryFiles;  // -v <file>
   std::string m_text;          // unit tests
   CompileDesign* m_compileDesign;
+  ThreadPool* m_threadPool;
   std::map<std::filesystem::path, std::vector<std::filesystem::path>> ppFileMap;
 #ifdef USETBB
   tbb::task_group m_taskGroup;
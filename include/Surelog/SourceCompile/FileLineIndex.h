@@ -0,0 +1,68 @@
+/*
+ Copyright 2022 The Surelog Team.
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+/*
+ * File:   FileLineIndex.h
+ * Author: surelog
+ *
+ * Index of a list of records made at a (file, line) position, such as the
+ * `timescale, `default_nettype or `line directives, finding the last
+ * record of a file at or before a line. Records of a file normally come in
+ * line order and are found by binary search; out of order records fall back
+ * to a backward scan of the records of that file.
+ */
+
+#ifndef SURELOG_FILELINEINDEX_H
+#define SURELOG_FILELINEINDEX_H
+#pragma once
+
+#include <Surelog/Common/SymbolId.h>
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace SURELOG {
+
+class FileLineIndex final {
+ public:
+  static constexpr int32_t kNotFound = -1;
+
+  void clear();
+
+  // Indexes the next record, numbered size().
+  void add(SymbolId fileId, unsigned int line);
+
+  // Number of the last record of "fileId" with a line <= "line",
+  // kNotFound if none.
+  int32_t find(SymbolId fileId, unsigned int line) const;
+
+  uint32_t size() const { return m_size; }
+
+ private:
+  struct FileRecords {
+    std::vector<unsigned int> m_lines;
+    std::vector<uint32_t> m_records;
+    bool m_sorted = true;
+  };
+
+  std::unordered_map<RawSymbolId, FileRecords> m_files;
+  uint32_t m_size = 0;
+};
+
+}  // namespace SURELOG
+
+#endif /* SURELOG_FILELINEINDEX_H */
@@ -0,0 +1,162 @@
+/*
+ Copyright 2022 The Surelog Team.
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+/*
+ * File:   IncludeMemo.h
+ * Author: surelog
+ *
+ * Per run memory of the included files, shared by all the compilation units
+ * and the preprocessing threads:
+ * - the include guard of a file, the macro of an `ifndef wrapping all its
+ *   content. Once that macro is defined, including the file again produces
+ *   nothing and the file is not even lexed;
+ * - the preprocessed content of a file and its macro definitions, keyed by
+ *   the values of the macros it read from its includer. Including the file
+ *   again where these macros have the same values replays the memo instead
+ *   of preprocessing the file.
+ *
+ * Everything is stored as text, the compilation units of -fileunit having
+ * their own symbol tables.
+ */
+
+#ifndef SURELOG_INCLUDEMEMO_H
+#define SURELOG_INCLUDEMEMO_H
+#pragma once
+
+#include <Surelog/Common/SymbolId.h>
+#include <Surelog/SourceCompile/IncludeFileInfo.h>
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace SURELOG {
+
+class MacroInfo;
+class SymbolTable;
+
+class IncludeMemo final {
+ public:
+  // Above that many variants of a file, new ones are not memoized.
+  static constexpr size_t kMaxVariants = 8;
+
+  struct MacroDefinition final {
+    std::string m_name;
+    int m_type = 0;
+    std::string m_file;
+    unsigned int m_startLine = 0;
+    unsigned short int m_startColumn = 0;
+    unsigned int m_endLine = 0;
+    unsigned short int m_endColumn = 0;
+    std::vector<std::string> m_arguments;
+    std::vector<std::string> m_tokens;
+  };
+
+  // IncludeFileInfo with its lines relative to the line before the include
+  // and its indexes relative to the index of the include.
+  struct IncludeRecord final {
+    IncludeFileInfo::Context m_context = IncludeFileInfo::Context::NONE;
+    unsigned int m_sectionStartLine = 0;
+    std::string m_sectionFile;
+    int m_originalStartLine = 0;
+    unsigned int m_originalStartColumn = 0;
+    int m_originalEndLine = 0;
+    unsigned int m_originalEndColumn = 0;
+    IncludeFileInfo::Action m_action = IncludeFileInfo::Action::NONE;
+    int m_indexOpening = 0;
+    int m_indexClosing = 0;
+  };
+
+  struct Entry final {
+    // Macros read before being changed by the file, with their value then
+    // (see macroValue()).
+    std::vector<std::pair<std::string, std::string>> m_reads;
+    // Definitions (true) and undefinitions (false, only the name is set),
+    // in order.
+    std::vector<std::pair<bool, MacroDefinition>> m_macroChanges;
+    std::vector<IncludeRecord> m_includeInfo;
+    // Files included by the file, directly or not.
+    std::vector<std::string> m_includedFiles;
+    std::string m_content;
+  };
+
+  // Collects the macro accesses of the preprocessing of one include, fed by
+  // the CompilationUnit. Recordings of nested includes run together. Macro
+  // names are ids in "symbols".
+  class Recording final {
+   public:
+    explicit Recording(const SymbolTable* symbols) : m_symbols(symbols) {}
+
+    void read(SymbolId name, const MacroInfo* info);
+    void define(SymbolId name, const MacroInfo* info);
+    // "info" is the definition removed, if any.
+    void undefine(SymbolId name, const MacroInfo* info);
+    void include(const std::string& fileName);
+
+    // The preprocessing did something the memo cannot replay.
+    void abort() { m_aborted = true; }
+    bool aborted() const { return m_aborted; }
+
+    Entry& entry() { return m_entry; }
+
+   private:
+    const SymbolTable* const m_symbols;
+    // Macros read or changed already
+    std::set<SymbolId, SymbolIdLessThanComparer> m_seen;
+    Entry m_entry;
+    bool m_aborted = false;
+  };
+
+  IncludeMemo() = default;
+  IncludeMemo(const IncludeMemo&) = delete;
+  IncludeMemo& operator=(const IncludeMemo&) = delete;
+
+  // Text of a macro definition that differs when the macro expands or is
+  // located differently, empty for an undefined macro.
+  static std::string macroValue(const MacroInfo* info,
+                                const SymbolTable& symbols);
+
+  void setGuard(const std::string& fileName, const std::string& macroName);
+  // Empty if the file has no known include guard.
+  std::string getGuard(const std::string& fileName) const;
+
+  // "key" is the file name and whatever else changes the preprocessed
+  // content, like the special instructions of the includer.
+  void add(const std::string& key, std::shared_ptr<const Entry> entry);
+  std::vector<std::shared_ptr<const Entry>> find(const std::string& key) const;
+
+  void countSkipped() { m_skipped++; }
+  void countReplayed() { m_replayed++; }
+  // For -profile.
+  std::string reportProfile() const;
+
+ private:
+  mutable std::mutex m_mutex;
+  std::map<std::string, std::string> m_guards;
+  std::map<std::string, std::vector<std::shared_ptr<const Entry>>> m_entries;
+  std::atomic<uint32_t> m_skipped{0};
+  std::atomic<uint32_t> m_replayed{0};
+};
+
+}  // namespace SURELOG
+
+#endif /* SURELOG_INCLUDEMEMO_H */
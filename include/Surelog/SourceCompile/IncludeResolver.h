@@ -0,0 +1,87 @@
+/*
+ Copyright 2022 The Surelog Team.
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+/*
+ * File:   IncludeResolver.h
+ * Author: surelog
+ *
+ * Per run resolution of the `include file names against the include
+ * paths, shared by all the compilation units and the preprocessing
+ * threads. Same result as FileUtils::locateFile, but each include
+ * directory is listed once instead of being probed for every include, and
+ * each file name is resolved once. The file system is assumed not to
+ * change during the run.
+ */
+
+#ifndef SURELOG_INCLUDERESOLVER_H
+#define SURELOG_INCLUDERESOLVER_H
+#pragma once
+
+#include <Surelog/Common/SymbolId.h>
+
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace SURELOG {
+
+class SymbolTable;
+
+class IncludeResolver final {
+ public:
+  IncludeResolver() = default;
+  IncludeResolver(const IncludeResolver&) = delete;
+  IncludeResolver& operator=(const IncludeResolver&) = delete;
+
+  // See FileUtils::locateFile. The ids in "paths" are only compared to the
+  // ones of the previous call: a different list empties the resolver.
+  SymbolId locateFile(SymbolId file, SymbolTable* symbols,
+                      const std::vector<SymbolId>& paths);
+
+  // File system calls made so far: existence checks and directory listings.
+  uint64_t getProbeCount() const { return m_probes; }
+  // For -profile.
+  std::string reportProfile() const;
+
+ private:
+  struct Directory final {
+    std::filesystem::path m_path;
+    enum class State { NotListed, Listed, Missing, Unreadable };
+    State m_state = State::NotListed;
+    std::unordered_set<std::string> m_entries;
+  };
+
+  // Empty if not found.
+  std::string resolve_(const std::string& fileName);
+  bool contains_(Directory& directory, const std::filesystem::path& name);
+  bool exists_(const std::filesystem::path& path);
+
+  std::mutex m_mutex;
+  std::vector<SymbolId> m_pathIds;
+  std::vector<Directory> m_directories;
+  std::unordered_map<std::string, std::string> m_resolved;
+  std::atomic<uint64_t> m_lookups{0};
+  std::atomic<uint64_t> m_probes{0};
+};
+
+}  // namespace SURELOG
+
+#endif /* SURELOG_INCLUDERESOLVER_H */
@@ -29,6 +29,12 @@
 
 #include <filesystem>
 #include <string>
+#include <vector>
+
+namespace antlr4 {
+class BailErrorStrategy;
+class ParserRuleContext;
+}  // namespace antlr4
 
 namespace SURELOG {
 
@@ -81,6 +87,14 @@ class ParseFile final {
   SymbolId getPpFileId() const { return m_ppFileId; }
   unsigned int getLineNb(unsigned int line);
 
+  // File chunk (see AnalyzeFile)
+  bool isChunk() const { return m_parent != nullptr; }
+  // Fingerprint of how the first "nbLines" lines of this chunk map to source
+  // file lines, relative to "firstLine", the first line of the chunk in the
+  // file being parsed. Two chunks with the same fingerprint only differ by a
+  // shift of their lines in that file (see ParseCache).
+  uint64_t getLineMapSignature(unsigned int nbLines, unsigned int* firstLine);
+
   class LineTranslationInfo {
    public:
     LineTranslationInfo(SymbolId pretendFileId, unsigned int originalLine,
@@ -109,6 +123,10 @@ class ParseFile final {
   FileContent* getFileContent() { return m_fileContent; }
   void setFileContent(FileContent* content) { m_fileContent = content; }
   void setDebugAstModel() { debug_AstModel = true; }
+  // For unit tests: skips the SLL parse, or makes it fail in the design
+  // element starting on "line" as if SLL could not predict it.
+  void setLLOnly() { m_llOnly = true; }
+  void setSllFailureLine(unsigned int line) { m_sllFailureLine = line; }
   std::string getProfileInfo() const;
   void profileParser();
 
@@ -125,9 +143,22 @@ class ParseFile final {
   bool m_keepParserHandler;
   FileContent* m_fileContent = nullptr;
   bool debug_AstModel;
+  bool m_llOnly = false;
+  unsigned int m_sllFailureLine = 0;
 
   bool parseOneFile_(const std::string& fileName, unsigned int lineOffset);
+  // After the SLL parse failed in "failed", reparses in LL only the design
+  // element (description) around it, then goes on in SLL with the following
+  // ones. Lines of the elements parsed in LL go to "llLines". Returns false
+  // if the whole file has to be reparsed in LL.
+  bool parseDescriptionsLL_(antlr4::ParserRuleContext* failed,
+                            std::vector<unsigned int>* llLines);
+  // Unit tests: throws as the SLL parse does when it fails in the design
+  // element on line m_sllFailureLine.
+  void failSll_(antlr4::BailErrorStrategy* strategy);
   void buildLineInfoCache_();
+  // Per-line scan of the include records, for records out of line order.
+  void buildLineInfoCacheScan_();
   // For file chunk:
   std::vector<ParseFile*> m_children;
   ParseFile* const m_parent;
@@ -31,6 +31,7 @@
 namespace SURELOG {
 
 class Compiler;
+class ErrorContainer;
 class FileContent;
 
 class ParserHarness {
@@ -39,6 +40,14 @@ class ParserHarness {
   // be parsed.
   // Unit test
   std::unique_ptr<FileContent> parse(const std::string& content);
+  // Same, with the whole file parsed in LL.
+  std::unique_ptr<FileContent> parseLL(const std::string& content);
+  // Same, with the SLL parse failing in the design element starting on
+  // line "sllFailureLine".
+  std::unique_ptr<FileContent> parseWithSllFailure(
+      const std::string& content, unsigned int sllFailureLine);
+  // Errors of the last unit test parse.
+  ErrorContainer* getErrorContainer() const;
 
   // Builtin
   FileContent* parse(const std::string& content, Compiler* compiler,
@@ -47,6 +56,8 @@ class ParserHarness {
 
  private:
   struct Holder;
+  std::unique_ptr<FileContent> parse_(const std::string& content, bool llOnly,
+                                      unsigned int sllFailureLine);
   Holder* m_h = nullptr;
 };
 
@@ -27,11 +27,14 @@
 
 #include <Surelog/Common/Containers.h>
 #include <Surelog/Common/SymbolId.h>
+#include <Surelog/SourceCompile/FileLineIndex.h>
 #include <Surelog/SourceCompile/IncludeFileInfo.h>
 #include <Surelog/SourceCompile/LoopCheck.h>
 
 #include <filesystem>
 #include <set>
+#include <string>
+#include <string_view>
 #include <vector>
 
 namespace antlr4 {
@@ -88,7 +91,8 @@ class PreprocessFile {
 
   /* Main function */
   bool preprocess();
-  std::string getPreProcessedFileContent();
+  // Stays valid as long as this PreprocessFile, the parser reads it there.
+  const std::string& getPreProcessedFileContent();
 
   /* Macro manipulations */
   void recordMacro(const std::string& name, unsigned int startLine,
@@ -101,6 +105,8 @@ class PreprocessFile {
                    unsigned short int endColumn,
                    const std::vector<std::string>& formal_arguments,
                    const std::vector<std::string>& body);
+  // Defines a macro replayed from the IncludeMemo.
+  void recordMacro(MacroInfo* macroInfo);
   std::string getMacro(const std::string& name,
                        std::vector<std::string>& actual_arguments,
                        PreprocessFile* callingFile, unsigned int callingLine,
@@ -121,6 +127,17 @@ class PreprocessFile {
 
   std::string reportIncludeInfo() const;
 
+  // Macro of the `ifndef wrapping all the file, empty if there is none.
+  std::string findIncludeGuard() const;
+  // Includes skipped by their guard or replayed from the IncludeMemo, which
+  // have no PreprocessFile but still are dependencies of the cache.
+  void addMemoizedInclude(SymbolId fileId) {
+    m_memoizedIncludes.push_back(fileId);
+  }
+  const std::vector<SymbolId>& getMemoizedIncludes() const {
+    return m_memoizedIncludes;
+  }
+
   CompileSourceFile* getCompileSourceFile() const {
     return m_compileSourceFile;
   }
@@ -174,6 +191,7 @@ class PreprocessFile {
   PreprocessFile* m_includer = nullptr;
   unsigned int m_includerLine = 0;
   std::vector<PreprocessFile*> m_includes;
+  std::vector<SymbolId> m_memoizedIncludes;
   CompileSourceFile* m_compileSourceFile = nullptr;
   size_t m_lineCount = 0;
   static IncludeFileInfo s_badIncludeFileInfo;
@@ -293,6 +311,8 @@ class PreprocessFile {
 
   void addLineTranslationInfo(LineTranslationInfo& info) {
     m_lineTranslationVec.push_back(info);
+    // All the records are made in this file, one key is enough.
+    m_lineTranslationIndex.add(BadSymbolId, info.m_originalLine);
   }
 
   /* Shorthand for logging an error */
@@ -318,11 +338,30 @@ class PreprocessFile {
   void collectIncludedFiles(std::set<PreprocessFile*>& included);
   bool usingCachedVersion() { return m_usingCachedVersion; }
   std::string getProfileInfo() { return m_profileInfo; }
-  std::vector<LineTranslationInfo>& getLineTranslationInfo() {
+  const std::vector<LineTranslationInfo>& getLineTranslationInfo() const {
     return m_lineTranslationVec;
   }
 
  private:
+  // Macro body (formal arguments already substituted) that expands without
+  // the preprocessor grammar: its text, and the macro instances without
+  // arguments cut out of it.
+  struct PlainMacroBody final {
+    struct Reference final {
+      size_t m_offset;  // In m_text
+      std::string m_name;
+      unsigned int m_line;    // In the body, from 1
+      unsigned int m_column;  // From 1
+    };
+    std::string m_text;
+    std::vector<Reference> m_references;
+  };
+  static bool scanPlainMacroBody_(std::string_view body,
+                                  PlainMacroBody& result);
+  // Appends the body to this macro body preprocessor, expanding the
+  // references as the preprocessor listener does.
+  void appendPlainMacroBody_(const PlainMacroBody& body);
+
   std::pair<bool, std::string> evaluateMacro_(
       const std::string& name, std::vector<std::string>& arguments,
       PreprocessFile* callingFile, unsigned int callingLine,
@@ -343,6 +382,7 @@ class PreprocessFile {
 
   CompilationUnit* m_compilationUnit = nullptr;
   std::vector<LineTranslationInfo> m_lineTranslationVec;
+  FileLineIndex m_lineTranslationIndex;
   bool m_pauseAppend = false;
   bool m_usingCachedVersion = false;
   std::vector<IncludeFileInfo> m_includeFileInfo;
@@ -25,6 +25,7 @@
 #define SURELOG_PREPROCESSHARNESS_H
 #pragma once
 
+#include <Surelog/CommandLine/CommandLineParser.h>
 #include <Surelog/ErrorReporting/ErrorContainer.h>
 #include <Surelog/SourceCompile/SymbolTable.h>
 #include <Surelog/SourceCompile/CompilationUnit.h>
@@ -34,13 +35,20 @@ namespace SURELOG {
 class PreprocessHarness {
  public:
   PreprocessHarness();
+  // Preprocesses with the given symbol table, for instance to register
+  // macros in a compilation unit that is then used with that table.
+  explicit PreprocessHarness(SymbolTable* symbols);
   std::string preprocess(std::string_view content, CompilationUnit* compUnit = nullptr);
 
   const ErrorContainer &collected_errors() const { return m_errors; }
+  // Options the content is preprocessed with
+  CommandLineParser* getCommandLineParser() { return &m_clp; }
 
  private:
-  SymbolTable m_symbols;
+  SymbolTable m_ownSymbols;
+  SymbolTable* const m_symbols;
   ErrorContainer m_errors;
+  CommandLineParser m_clp;
 };
 
 };  // namespace SURELOG
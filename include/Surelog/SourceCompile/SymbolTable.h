@@ -28,7 +28,10 @@
 
 #include <Surelog/Common/SymbolId.h>
 
-#include <deque>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
 #include <string>
 #include <string_view>
 #include <unordered_map>
@@ -36,6 +39,9 @@
 
 namespace SURELOG {
 
+// All the methods are thread safe: threads can intern into the same table
+// concurrently. Symbols are hashed into independently locked shards, and
+// the id to string lookup does not take any lock.
 class SymbolTable final {
  public:
   SymbolTable();
@@ -44,6 +50,9 @@ class SymbolTable final {
   // Create a snapshot of this symbol table. The returned SymbolTable contains
   // all the symbols this table has and allows to then continue using the new
   // copy without changing the original. Essentially a fork.
+  // The parallel jobs do not use snapshots, they all intern into the
+  // shared table: no remap of their symbols is needed afterwards (see
+  // symboltable-bench).
   // TODO: at some point, return std::unique_ptr<>
   SymbolTable* CreateSnapshot() const;
 
@@ -71,22 +80,46 @@ class SymbolTable final {
  private:
   // Create a snapshot of the current symbol table. Private, as this
   // functionality should be explicitly accessed through CreateSnapshot().
-  SymbolTable(const SymbolTable& parent)
-      : m_parent(&parent), m_idOffset(parent.m_idCounter + parent.m_idOffset) {}
-
+  // Snapshots are mostly used by a single thread and get a single shard.
+  explicit SymbolTable(const SymbolTable& parent);
+
+  struct Shard {
+    mutable std::shared_mutex m_mutex;
+    // The key string_views point to the stable strings of the chunks.
+    std::unordered_map<std::string_view, RawSymbolId> m_symbol2IdMap;
+  };
+
+  // Strings are stored in fixed size chunks that are never moved, so a
+  // string address is stable and an id resolves with two indexations.
+  static constexpr RawSymbolId kChunkBits = 8;
+  static constexpr RawSymbolId kChunkSize = 1 << kChunkBits;
+  struct Directory {
+    explicit Directory(size_t capacity)
+        : m_capacity(capacity),
+          m_chunks(new std::atomic<std::string*>[capacity]) {
+      for (size_t i = 0; i < capacity; i++) m_chunks[i] = nullptr;
+    }
+    const size_t m_capacity;
+    std::unique_ptr<std::atomic<std::string*>[]> m_chunks;
+  };
+
+  Shard& getShard_(std::string_view symbol) const;
+  std::string* getSlot_(RawSymbolId localId);
   void AppendSymbols(int64_t up_to, std::vector<std::string_view>* dest) const;
 
   const SymbolTable *const m_parent;
   const RawSymbolId m_idOffset;
 
-  RawSymbolId m_idCounter = 0;
+  std::atomic<RawSymbolId> m_idCounter{0};
 
-  // Stable strings whose address doesn't change with reallocations.
-  std::deque<std::string> m_id2SymbolMap;
+  const unsigned int m_nbShards;
+  std::unique_ptr<Shard[]> m_shards;
 
-  // The key string_views point to the stable backing buffer provided in
-  // m_id2SymbolMap
-  std::unordered_map<std::string_view, RawSymbolId> m_symbol2IdMap;
+  std::atomic<Directory*> m_directory{nullptr};
+  // Guards the allocation of chunks and directories. Directories replaced by
+  // a larger one are kept alive for concurrent readers.
+  std::mutex m_growMutex;
+  std::vector<std::unique_ptr<Directory>> m_directories;
 };
 
 };  // namespace SURELOG
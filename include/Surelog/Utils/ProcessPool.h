@@ -0,0 +1,87 @@
+/*
+ Copyright 2022 The Surelog Team.
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+/*
+ * File:   ProcessPool.h
+ * Author: surelog
+ *
+ * Pool of long-lived child processes (surelog -server) used by -mp.
+ * Each job is one command line written to an idle child's stdin, the child
+ * answers with its output followed by a done line carrying the job's return
+ * code. Jobs are dispatched largest first. A child dying in the middle of
+ * a job is replaced and the job is run once more.
+ */
+
+#ifndef SURELOG_PROCESSPOOL_H
+#define SURELOG_PROCESSPOOL_H
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace SURELOG {
+
+class ProcessPool final {
+ public:
+  // Line ending the answer of a child, followed by the job return code.
+  static constexpr std::string_view kDoneMarker = "@@SURELOG_DONE";
+  // Line asking a child to exit.
+  static constexpr std::string_view kQuitCommand = "quit";
+
+  struct JobResult {
+    std::string m_commandLine;
+    int m_returnCode = 0;
+    std::string m_output;  // what the child printed while running the job
+    bool m_retried = false;  // a child died running it, see m_output
+  };
+
+  // "workerCommand" is the program and arguments starting a child.
+  ProcessPool(const std::vector<std::string>& workerCommand,
+              unsigned int nbProcesses);
+
+  // Queue a job with its estimated cost. Jobs are only started by run().
+  void addJob(uint64_t size, const std::string& commandLine);
+
+  // Runs all queued jobs and waits for all the children to exit. Returns
+  // false if a job failed, or killed its child twice. The jobs left when no
+  // child can be started are run by runSequential_.
+  bool run();
+
+  // Results of the last run(), in the order the jobs were queued.
+  const std::vector<JobResult>& getResults() const { return m_results; }
+
+ private:
+  ProcessPool(const ProcessPool&) = delete;
+  ProcessPool& operator=(const ProcessPool&) = delete;
+
+  struct Job {
+    uint64_t m_size;
+    size_t m_index;  // in m_results
+  };
+
+  bool runSequential_(const std::vector<Job>& jobs);
+
+  const std::vector<std::string> m_workerCommand;
+  const unsigned int m_nbProcesses;
+  std::vector<Job> m_jobs;
+  std::vector<JobResult> m_results;
+};
+
+}  // namespace SURELOG
+
+#endif /* SURELOG_PROCESSPOOL_H */
@@ -25,6 +25,7 @@
 #define SURELOG_STRINGUTILS_H
 #pragma once
 
+#include <cstdint>
 #include <map>
 #include <string>
 #include <string_view>
@@ -156,6 +157,10 @@ class StringUtils final {
 
   static std::string unquoted(const std::string& text);
 
+  // Fast non-cryptographic 64 bit hash of "text" (XXH64). Stable across
+  // platforms and runs, so it can be persisted in caches.
+  static uint64_t hash64(std::string_view text, uint64_t seed = 0);
+
  private:
   StringUtils() = delete;
   StringUtils(const StringUtils& orig) = delete;
@@ -0,0 +1,103 @@
+/*
+ Copyright 2022 The Surelog Team.
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+/*
+ * File:   ThreadPool.h
+ * Author: surelog
+ *
+ * Work-stealing pool of worker threads, created once per run and shared by
+ * the preprocessing, parsing, python listener and design compilation stages.
+ */
+
+#ifndef SURELOG_THREADPOOL_H
+#define SURELOG_THREADPOOL_H
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace SURELOG {
+
+class ThreadPool final {
+ public:
+  // A job receives the index of the worker running it, so callers can keep
+  // per-worker state (SymbolTable, ErrorContainer...) in a plain vector.
+  typedef std::function<void(unsigned int workerIndex)> Job;
+
+  struct WorkerStats {
+    uint64_t m_jobs = 0;
+    uint64_t m_steals = 0;
+    double m_busy = 0.0;  // seconds spent running jobs
+    double m_idle = 0.0;  // seconds spent waiting inside a batch
+  };
+
+  explicit ThreadPool(unsigned int nbWorkers);
+  ~ThreadPool();
+
+  unsigned int getNbWorkers() const { return m_workers.size(); }
+
+  // Queue a job with its estimated cost. Jobs are only started by run().
+  void addJob(uint64_t size, Job job);
+
+  // Runs all queued jobs, largest first, and blocks until they all finished.
+  // Jobs are first spread over the workers like the former static split
+  // (least loaded worker first), then idle workers steal from the busy ones.
+  void run();
+
+  const std::vector<WorkerStats>& getStats() const { return m_stats; }
+  std::string getProfileInfo() const;
+
+ private:
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  struct Task {
+    uint64_t m_size;
+    Job m_job;
+  };
+
+  struct Queue {
+    std::mutex m_mutex;
+    std::deque<Task> m_tasks;
+  };
+
+  void workerLoop_(unsigned int index);
+  bool popTask_(unsigned int index, Task& task, bool& stolen);
+
+  std::vector<std::thread> m_workers;
+  std::vector<Queue> m_queues;
+  std::vector<WorkerStats> m_stats;
+  std::vector<Task> m_pending;
+
+  std::mutex m_mutex;
+  std::condition_variable m_startCond;
+  std::condition_variable m_doneCond;
+  uint64_t m_batch = 0;
+  unsigned int m_running = 0;
+  std::atomic<uint64_t> m_remaining{0};
+  bool m_shutdown = false;
+};
+
+}  // namespace SURELOG
+
+#endif /* SURELOG_THREADPOOL_H */
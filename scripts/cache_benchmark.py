@@ -0,0 +1,112 @@
+#!/usr/bin/env python3
+
+"""Warm-cache load benchmark.
+
+Runs surelog once to populate the preprocessor and parser caches, then
+several times again on the warm cache, and reports wall time and peak
+resident memory of the warm runs. With --baseline, the same measurement is
+done with a second surelog binary (e.g. a build before a cache change) and
+both are printed side by side.
+
+Example:
+  python3 scripts/cache_benchmark.py --surelog build/bin/surelog \\
+      --baseline old-build/bin/surelog -- -f design.f -parse
+"""
+
+import argparse
+import os
+import platform
+import psutil
+import shutil
+import statistics
+import subprocess
+import sys
+import time
+
+_this_filepath = os.path.realpath(__file__)
+_default_workspace_dirpath = os.path.dirname(os.path.dirname(_this_filepath))
+_default_surelog_filename = 'surelog.exe' if platform.system() == 'Windows' else 'surelog'
+_default_surelog_filepath = os.path.join(_default_workspace_dirpath, 'build', 'bin', _default_surelog_filename)
+
+
+def _run(cmdline, cwd):
+  start = time.perf_counter()
+  process = psutil.Popen(cmdline, cwd=cwd, stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL)
+  max_rss_memory = 0
+  while process.poll() is None:
+    try:
+      max_rss_memory = max(max_rss_memory, process.memory_info().rss)
+    except (psutil.NoSuchProcess, psutil.AccessDenied):
+      pass
+    time.sleep(0.01)
+  wall_time = time.perf_counter() - start
+  return process.returncode, wall_time, max_rss_memory
+
+
+def _benchmark(name, surelog_filepath, args):
+  output_dirpath = os.path.join(args.output_dirpath, name)
+  shutil.rmtree(output_dirpath, ignore_errors=True)
+  os.makedirs(output_dirpath)
+  cmdline = [surelog_filepath, '-o', output_dirpath] + args.surelog_args
+
+  returncode, cold_time, cold_rss = _run(cmdline, args.cwd)
+  if returncode != 0:
+    print(f'{surelog_filepath} failed with exit code {returncode}: {" ".join(cmdline)}')
+
+  warm_times = []
+  warm_rss = []
+  for _ in range(args.repeat):
+    _, wall_time, rss = _run(cmdline, args.cwd)
+    warm_times.append(wall_time)
+    warm_rss.append(rss)
+
+  return {
+    'cold-time': cold_time,
+    'cold-rss': cold_rss,
+    'warm-time': statistics.median(warm_times),
+    'warm-rss': max(warm_rss),
+  }
+
+
+def _print_results(results):
+  names = list(results.keys())
+  print(f'{"":12}' + ''.join(f'{name:>24}' for name in names))
+  for key in ['cold-time', 'warm-time']:
+    print(f'{key:12}' + ''.join(f'{results[name][key]:>23.3f}s' for name in names))
+  for key in ['cold-rss', 'warm-rss']:
+    print(f'{key:12}' + ''.join(f'{results[name][key] / (1024 * 1024):>21.1f}MiB' for name in names))
+
+
+def _main():
+  parser = argparse.ArgumentParser()
+  parser.add_argument(
+      '--surelog', dest='surelog_filepath', default=_default_surelog_filepath, type=str,
+      help='Surelog binary to measure.')
+  parser.add_argument(
+      '--baseline', dest='baseline_filepath', default=None, type=str,
+      help='Optional second surelog binary to compare against.')
+  parser.add_argument(
+      '--repeat', dest='repeat', default=3, type=int,
+      help='Number of warm-cache runs, the median time is reported.')
+  parser.add_argument(
+      '--output-dirpath', dest='output_dirpath', default=os.path.join(os.getcwd(), 'cache_benchmark'), type=str,
+      help='Directory receiving the surelog outputs and caches.')
+  parser.add_argument(
+      '--cwd', dest='cwd', default=os.getcwd(), type=str,
+      help='Directory surelog is run from.')
+  parser.add_argument('surelog_args', nargs=argparse.REMAINDER, help='Surelog command line, after --')
+  args = parser.parse_args()
+  if args.surelog_args and args.surelog_args[0] == '--':
+    args.surelog_args = args.surelog_args[1:]
+  args.output_dirpath = os.path.abspath(args.output_dirpath)
+
+  results = {}
+  if args.baseline_filepath:
+    results['baseline'] = _benchmark('baseline', os.path.abspath(args.baseline_filepath), args)
+  results['surelog'] = _benchmark('surelog', os.path.abspath(args.surelog_filepath), args)
+  _print_results(results)
+  return 0
+
+
+if __name__ == '__main__':
+  sys.exit(_main())
@@ -463,6 +463,9 @@ def _generate_VObjectTypes_h(filepath):
   content.extend([
     '};',
     '',
+    '// One past the largest VObjectType value.',
+    f'constexpr uint16_t VObjectTypeCount = {index};',
+    '',
     'typedef std::set<VObjectType> VObjectTypeSet;',
     'typedef std::unordered_set<VObjectType> VObjectTypeUnorderedSet;',
     '',
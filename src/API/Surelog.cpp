@@ -15,6 +15,7 @@
  */
 
 #include <Surelog/API/Surelog.h>
+#include <Surelog/Cache/Cache.h>
 #include <Surelog/CommandLine/CommandLineParser.h>
 #include <Surelog/Design/Design.h>
 #include <Surelog/DesignCompile/CompileDesign.h>
@@ -39,11 +40,14 @@ void shutdown_compiler(scompiler* the_compiler) {
   if (the_compiler == nullptr) return;
   Compiler* compiler = (Compiler*)the_compiler;
   if (CompileDesign* comp = compiler->getCompileDesign()) {
+    comp->getReduceExprMemo()->clear();
     comp->getSerializer().Purge();
   }
   delete (Compiler*)the_compiler;
 }
 
+void keep_caches_in_memory(bool keep) { Cache::setInMemory(keep); }
+
 vpiHandle get_uhdm_design(scompiler* compiler) {
   vpiHandle design_handle = 0;
   Compiler* the_compiler = (Compiler*)compiler;
@@ -22,25 +22,200 @@
  */
 
 #include <Surelog/Cache/Cache.h>
+#include <Surelog/Cache/CachePack.h>
 #include <Surelog/CommandLine/CommandLineParser.h>
 #include <Surelog/Design/FileContent.h>
 #include <Surelog/ErrorReporting/ErrorContainer.h>
 #include <Surelog/SourceCompile/SymbolTable.h>
+#include <Surelog/Utils/FileUtils.h>
+#include <Surelog/Utils/StringUtils.h>
 #include <flatbuffers/util.h>
 #include <sys/stat.h>
 #include <sys/types.h>
 
+#if defined(_MSC_VER)
+#include <process.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
 #include <ctime>
 #include <iostream>
+#include <list>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+// Computed by cmake from the grammars and the cache schemas.
+#ifndef SURELOG_GRAMMAR_HASH
+#define SURELOG_GRAMMAR_HASH __DATE__ "-" __TIME__
+#endif
 
 namespace SURELOG {
 namespace fs = std::filesystem;
 
+namespace {
+// Process wide cache files and source content hashes, only filled once
+// Cache::setInMemory(true) was called.
+struct MemoryStore {
+  struct FileStamp {
+    fs::file_time_type m_mtime;
+    uintmax_t m_size = 0;
+    uint64_t m_hash = 0;
+  };
+  // The mapping of the cache file, or a heap copy where there is none.
+  using Content = std::shared_ptr<const uint8_t>;
+  struct Entry {
+    Content m_content;
+    size_t m_size = 0;
+    std::list<std::string>::iterator m_lru;
+  };
+
+  std::mutex m_mutex;
+  std::atomic<bool> m_enabled{false};
+  // Least recently used first evicted once over Cache::InMemoryCapacity or
+  // Cache::InMemoryFiles
+  std::unordered_map<std::string, Entry> m_buffers;
+  std::list<std::string> m_lru;
+  uint64_t m_bytes = 0;
+  std::unordered_map<std::string, FileStamp> m_stamps;
+  std::set<fs::path> m_upToDate;
+
+  static MemoryStore& get() {
+    static MemoryStore store;
+    return store;
+  }
+
+  // All the accessors below expect m_mutex to be held.
+  const Entry* find(const std::string& key) {
+    auto found = m_buffers.find(key);
+    if (found == m_buffers.end()) return nullptr;
+    m_lru.splice(m_lru.begin(), m_lru, found->second.m_lru);
+    return &found->second;
+  }
+
+  void insert(const std::string& key, const Content& content, size_t size) {
+    auto found = m_buffers.find(key);
+    if (found != m_buffers.end()) {
+      m_bytes -= found->second.m_size;
+      m_lru.erase(found->second.m_lru);
+      m_buffers.erase(found);
+    }
+    if (size > Cache::InMemoryCapacity) return;
+    m_lru.push_front(key);
+    m_buffers.emplace(key, Entry{content, size, m_lru.begin()});
+    m_bytes += size;
+    while ((m_bytes > Cache::InMemoryCapacity) ||
+           (m_buffers.size() > Cache::InMemoryFiles)) {
+      auto oldest = m_buffers.find(m_lru.back());
+      m_bytes -= oldest->second.m_size;
+      m_buffers.erase(oldest);
+      m_lru.pop_back();
+    }
+  }
+
+  void stamp(const std::string& key, const FileStamp& stamp) {
+    // Only a shortcut to the content hash, simply started over when full
+    if ((m_stamps.size() >= Cache::InMemoryStamps) &&
+        (m_stamps.find(key) == m_stamps.end())) {
+      m_stamps.clear();
+    }
+    m_stamps[key] = stamp;
+  }
+
+  void clear() {
+    m_buffers.clear();
+    m_lru.clear();
+    m_bytes = 0;
+    m_stamps.clear();
+    m_upToDate.clear();
+  }
+};
+
+fs::path normalizedPath(const fs::path& path) {
+  std::error_code ec;
+  const fs::path absolute = fs::absolute(path, ec);
+  return ec ? path.lexically_normal() : absolute.lexically_normal();
+}
+
+// Name of the file a cache file is written to before being renamed over it,
+// unique among the processes and threads writing the same cache.
+fs::path uniqueTmpName(const fs::path& cacheFileName) {
+  static std::atomic<uint64_t> counter{0};
+#if defined(_MSC_VER)
+  const int pid = _getpid();
+#else
+  const int pid = getpid();
+#endif
+  const size_t tid = std::hash<std::thread::id>()(std::this_thread::get_id());
+  return cacheFileName.string() + "." + std::to_string(pid) + "." +
+         std::to_string(tid) + "." + std::to_string(counter++) + ".tmp";
+}
+}  // namespace
+
+void Cache::setInMemory(bool inMemory) {
+  MemoryStore& store = MemoryStore::get();
+  std::lock_guard<std::mutex> guard(store.m_mutex);
+  store.m_enabled = inMemory;
+  if (!inMemory) store.clear();
+}
+
+void Cache::setUpToDateInMemory(const std::set<fs::path>& sourceFiles) {
+  MemoryStore& store = MemoryStore::get();
+  std::lock_guard<std::mutex> guard(store.m_mutex);
+  store.m_upToDate.clear();
+  for (const fs::path& sourceFile : sourceFiles) {
+    store.m_upToDate.insert(normalizedPath(sourceFile));
+  }
+}
+
 const std::string& Cache::getExecutableTimeStamp() {
   static const std::string sExecTstamp(__DATE__ "-" __TIME__);
   return sExecTstamp;
 }
 
+const std::string& Cache::getGrammarHash() {
+  static const std::string sGrammarHash(SURELOG_GRAMMAR_HASH);
+  return sGrammarHash;
+}
+
+bool Cache::hashFileContent(const fs::path& path, uint64_t* hash) {
+  if (!FileUtils::fileIsRegular(path)) return false;
+  MemoryStore& store = MemoryStore::get();
+  if (!store.m_enabled) {
+    *hash = StringUtils::hash64(FileUtils::getFileContent(path));
+    return true;
+  }
+  // Only re-read the files whose modification time or size changed since
+  // they were last hashed.
+  std::error_code ec;
+  const fs::file_time_type mtime = fs::last_write_time(path, ec);
+  const uintmax_t size = fs::file_size(path, ec);
+  const std::string key = path.string();
+  {
+    std::lock_guard<std::mutex> guard(store.m_mutex);
+    auto found = store.m_stamps.find(key);
+    if (!ec && (found != store.m_stamps.end()) &&
+        (found->second.m_mtime == mtime) && (found->second.m_size == size)) {
+      *hash = found->second.m_hash;
+      return true;
+    }
+  }
+  *hash = StringUtils::hash64(FileUtils::getFileContent(path));
+  if (!ec) {
+    std::lock_guard<std::mutex> guard(store.m_mutex);
+    store.stamp(key, {mtime, size, *hash});
+  }
+  return true;
+}
+
 time_t Cache::get_mtime(const fs::path& path) {
   std::string cpath = path.string();
   struct stat statbuf;
@@ -50,21 +225,106 @@ time_t Cache::get_mtime(const fs::path& path) {
   return statbuf.st_mtime;
 }
 
-std::unique_ptr<uint8_t[]> Cache::openFlatBuffers(
-    const fs::path& cacheFileName) {
+void Cache::BufferDeleter::operator()(const uint8_t* data) const {
+  if ((data == nullptr) || (m_owner != nullptr)) return;
+#if !defined(_MSC_VER)
+  if (m_mapped) {
+    munmap(const_cast<uint8_t*>(data), m_size);
+    return;
+  }
+#endif
+  delete[] data;
+}
+
+std::string Cache::getPackKey_(const fs::path& cacheFileName) const {
+  return cacheFileName.lexically_relative(m_packRoot).generic_string();
+}
+
+Cache::Buffer Cache::openFlatBuffers(const fs::path& cacheFileName) {
+  MemoryStore& store = MemoryStore::get();
+  if (!store.m_enabled) return openFlatBuffers_(cacheFileName);
+  const std::string key = cacheFileName.string();
+  MemoryStore::Content content;
+  size_t size = 0;
+  {
+    std::lock_guard<std::mutex> guard(store.m_mutex);
+    if (const MemoryStore::Entry* entry = store.find(key)) {
+      content = entry->m_content;
+      size = entry->m_size;
+    }
+  }
+  if (content == nullptr) {
+    Buffer buffer = openFlatBuffers_(cacheFileName);
+    if (buffer == nullptr) return nullptr;
+    size = buffer.get_deleter().m_size;
+    content = MemoryStore::Content(buffer.release(), buffer.get_deleter());
+    std::lock_guard<std::mutex> guard(store.m_mutex);
+    store.insert(key, content, size);
+  }
+  // Shares the mapping, caches are renamed in place when rewritten so it
+  // stays valid for the restores still using it.
+  const uint8_t* data = content.get();
+  return Buffer(data, BufferDeleter{size, false, std::move(content)});
+}
+
+Cache::Buffer Cache::openUpToDateInMemory(const fs::path& sourceFile,
+                                          const fs::path& cacheFileName) {
+  MemoryStore& store = MemoryStore::get();
+  if (!store.m_enabled) return nullptr;
+  const fs::path path = normalizedPath(sourceFile);
+  std::lock_guard<std::mutex> guard(store.m_mutex);
+  if (store.m_upToDate.find(path) == store.m_upToDate.end()) return nullptr;
+  const MemoryStore::Entry* entry = store.find(cacheFileName.string());
+  if (entry == nullptr) return nullptr;
+  return Buffer(entry->m_content.get(),
+                BufferDeleter{entry->m_size, false, entry->m_content});
+}
+
+Cache::Buffer Cache::openFlatBuffers_(const fs::path& cacheFileName) {
+  if (m_pack != nullptr) {
+    std::unique_ptr<uint8_t[]> data;
+    uint64_t size = 0;
+    if (!m_pack->read(getPackKey_(cacheFileName), &data, &size)) {
+      return nullptr;
+    }
+    return Buffer(data.release(), BufferDeleter{size, false});
+  }
   const std::string filename = cacheFileName.string();
+#if !defined(_MSC_VER)
+  // Caches are written to a temporary file and renamed in place, so a
+  // mapping stays valid even if another thread or process rewrites the
+  // cache while it is being restored.
+  int fd = open(filename.c_str(), O_RDONLY);
+  if (fd == -1) return nullptr;
+  struct stat statbuf;
+  if ((fstat(fd, &statbuf) == -1) || (statbuf.st_size <= 0)) {
+    close(fd);
+    return nullptr;
+  }
+  const size_t length = statbuf.st_size;
+  void* data = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (data != MAP_FAILED) {
+    return Buffer((const uint8_t*)data, BufferDeleter{length, true});
+  }
+#endif
   FILE* file = fopen(filename.c_str(), "rb");
   if (file == nullptr) return nullptr;
   fseek(file, 0L, SEEK_END);
-  unsigned int length = ftell(file);
+  long length = ftell(file);
   fseek(file, 0L, SEEK_SET);
-  std::unique_ptr<uint8_t[]> data(new uint8_t[length]);
-  size_t l = fread(data.get(), sizeof(uint8_t), length, file);
+  if (length <= 0) {
+    fclose(file);
+    return nullptr;
+  }
+  uint8_t* data = new uint8_t[length];
+  size_t l = fread(data, sizeof(uint8_t), length, file);
   fclose(file);
-  if (length != l) {
+  Buffer buffer(data, BufferDeleter{(size_t)length, false});
+  if ((size_t)length != l) {
     return nullptr;
   }
-  return data;
+  return buffer;
 }
 
 bool Cache::checkIfCacheIsValid(const SURELOG::CACHE::Header* header,
@@ -80,23 +340,19 @@ bool Cache::checkIfCacheIsValid(const SURELOG::CACHE::Header* header,
     return false;
   }
 
-  /* Timestamp Tool that created Cache vs tool date */
-  if (getExecutableTimeStamp() != header->sl_date_compiled()->c_str()) {
+  /* Grammar and schemas the tool was built with */
+  if ((header->grammar_hash() == nullptr) ||
+      (getGrammarHash() != header->grammar_hash()->c_str())) {
     return false;
   }
 
-  /* Timestamp Cache vs Orig File */
+  /* Content of the file the cache was created from */
   if (!cacheFileName.empty()) {
-    time_t ct = get_mtime(cacheFileName);
-    std::string fileName = header->file_deprecated()->c_str();
-    time_t ft = get_mtime(fileName.c_str());
-    if (ft == -1) {
+    uint64_t hash = 0;
+    if (!hashFileContent(header->file_deprecated()->c_str(), &hash)) {
       return false;
     }
-    if (ct == -1) {
-      return false;
-    }
-    if (ct < ft) {
+    if (hash != header->content_hash()) {
       return false;
     }
   }
@@ -110,26 +366,64 @@ flatbuffers::Offset<SURELOG::CACHE::Header> Cache::createHeader(
   auto sl_version = builder.CreateString(CommandLineParser::getVersionNumber());
   auto sl_build_date = builder.CreateString(getExecutableTimeStamp());
   auto sl_flb_version = builder.CreateString(schemaVersion);
-  auto header = CACHE::CreateHeader(builder, sl_version, sl_flb_version,
-                                    sl_build_date, fName);
+  auto grammar_hash = builder.CreateString(getGrammarHash());
+  uint64_t content_hash = 0;
+  hashFileContent(origFileName, &content_hash);
+  auto header =
+      CACHE::CreateHeader(builder, sl_version, sl_flb_version, sl_build_date,
+                          fName, grammar_hash, content_hash);
   return header;
 }
 
 bool Cache::saveFlatbuffers(flatbuffers::FlatBufferBuilder& builder,
                             const fs::path& cacheFileName) {
-  const std::string tmp_name = cacheFileName.string() + ".tmp";
   const unsigned char* buf = builder.GetBufferPointer();
   const int size = builder.GetSize();
-  bool success =
-      flatbuffers::SaveFile(tmp_name.c_str(), (const char*)buf, size, true);
+  if (m_pack != nullptr) {
+    const bool success = m_pack->write(getPackKey_(cacheFileName), buf, size);
+    keepInMemory_(cacheFileName, buf, size, false);
+    return success;
+  }
+  // Concurrent writers of the same cache file each write their own temporary
+  // file, the last rename wins. Any failure only means no cache next time.
+  const fs::path tmp_name = uniqueTmpName(cacheFileName);
+  std::error_code ec;
+  bool success = flatbuffers::SaveFile(tmp_name.string().c_str(),
+                                       (const char*)buf, size, true);
   if (success) {
-    std::filesystem::rename(tmp_name, cacheFileName);
-  } else {
-    std::filesystem::remove(tmp_name);
+    fs::rename(tmp_name, cacheFileName, ec);
+    if (ec) success = false;
   }
+  if (!success) fs::remove(tmp_name, ec);
+  keepInMemory_(cacheFileName, buf, size, success);
   return success;
 }
 
+void Cache::keepInMemory_(const fs::path& cacheFileName, const uint8_t* buf,
+                          size_t size, bool saved) {
+  MemoryStore& store = MemoryStore::get();
+  if (!store.m_enabled) return;
+  // Maps the file just written, the builder buffer is only copied when it
+  // could not be saved.
+  Buffer buffer;
+  if (saved) buffer = openFlatBuffers_(cacheFileName);
+  if (buffer == nullptr) {
+    uint8_t* data = new uint8_t[size];
+    std::copy(buf, buf + size, data);
+    buffer = Buffer(data, BufferDeleter{size, false});
+  }
+  MemoryStore::Content content(buffer.release(), buffer.get_deleter());
+  std::lock_guard<std::mutex> guard(store.m_mutex);
+  store.insert(cacheFileName.string(), content, size);
+}
+
+void Cache::reportNotSaved(ErrorContainer* errors, SymbolTable* symbols,
+                           const fs::path& cacheFileName) {
+  Location loc(symbols->registerSymbol(cacheFileName.string()));
+  Error err(ErrorDefinition::CMD_CACHE_NOT_SAVED, loc);
+  errors->addError(err);
+}
+
 flatbuffers::Offset<Cache::VectorOffsetError> Cache::cacheErrors(
     flatbuffers::FlatBufferBuilder& builder, SymbolTable* cacheSymbols,
     const ErrorContainer* errorContainer, const SymbolTable& localSymbols,
@@ -173,27 +467,25 @@ flatbuffers::Offset<Cache::VectorOffsetString> Cache::createSymbolCache(
   return builder.CreateVectorOfStrings(cacheSymbols.getSymbols());
 }
 
-void Cache::restoreErrors(const VectorOffsetError* errorsBuf,
-                          const VectorOffsetString* symbolsBuf,
-                          SymbolTable* cacheSymbols,
-                          ErrorContainer* errorContainer,
-                          SymbolTable* localSymbols) {
-  for (unsigned int i = 0; i < symbolsBuf->size(); i++) {
-    const std::string symbol = symbolsBuf->Get(i)->c_str();
-    cacheSymbols->registerSymbol(symbol);
+Cache::SymbolRemap Cache::restoreSymbols(const VectorOffsetString* symbolsBuf,
+                                         SymbolTable* localSymbols) {
+  SymbolRemap remap;
+  remap.reserve(symbolsBuf->size());
+  for (const auto* symbol : *symbolsBuf) {
+    remap.push_back(localSymbols->registerSymbol(symbol->string_view()));
   }
-  for (unsigned int i = 0; i < errorsBuf->size(); i++) {
-    auto errorFlb = errorsBuf->Get(i);
+  return remap;
+}
+
+void Cache::restoreErrors(const VectorOffsetError* errorsBuf,
+                          const SymbolRemap& remap,
+                          ErrorContainer* errorContainer) {
+  for (const auto* errorFlb : *errorsBuf) {
     std::vector<Location> locs;
-    for (unsigned int j = 0; j < errorFlb->locations()->size(); j++) {
-      auto locFlb = errorFlb->locations()->Get(j);
-      SymbolId translFileId = localSymbols->registerSymbol(
-          cacheSymbols->getSymbol(SymbolId(locFlb->file_id(), "<unknown>")));
-      SymbolId translObjectId = localSymbols->registerSymbol(
-          cacheSymbols->getSymbol(SymbolId(locFlb->object(), "<unknown>")));
-      Location loc(translFileId, locFlb->line(), locFlb->column(),
-                   translObjectId);
-      locs.push_back(loc);
+    locs.reserve(errorFlb->locations()->size());
+    for (const auto* locFlb : *errorFlb->locations()) {
+      locs.emplace_back(remapSymbol(remap, locFlb->file_id()), locFlb->line(),
+                        locFlb->column(), remapSymbol(remap, locFlb->object()));
     }
     Error err((ErrorDefinition::ErrorType)errorFlb->error_id(), locs);
     errorContainer->addError(err, false);
@@ -218,7 +510,9 @@ std::vector<CACHE::VObject> Cache::cacheVObjects(
         localSymbols.getSymbol(id));
   };
 
-  for (const VObject& object : fcontent->getVObjects()) {
+  const VObjectStore& objects = fcontent->getVObjects();
+  for (NodeId id(0); id < objects.size(); ++id) {
+    const VObject object = objects[id];
     // Lets compress this struct into 20 and 16 bits fields:
     //  object_vec.push_back(PARSECACHE::CreateVObject(builder,
     //                                              toCacheSym(object.m_name),
@@ -261,16 +555,13 @@ std::vector<CACHE::VObject> Cache::cacheVObjects(
 
 void Cache::restoreVObjects(
     const flatbuffers::Vector<const SURELOG::CACHE::VObject*>* objects,
-    const SymbolTable& cacheSymbols, SymbolTable* localSymbols, SymbolId fileId,
-    FileContent* fileContent) {
-  restoreVObjects(objects, cacheSymbols, localSymbols, fileId,
-                  fileContent->mutableVObjects());
+    const SymbolRemap& remap, SymbolId fileId, FileContent* fileContent) {
+  restoreVObjects(objects, remap, fileId, fileContent->mutableVObjects());
 }
 
 void Cache::restoreVObjects(
     const flatbuffers::Vector<const SURELOG::CACHE::VObject*>* objects,
-    const SymbolTable& cacheSymbols, SymbolTable* localSymbols, SymbolId fileId,
-    std::vector<VObject>* result) {
+    const SymbolRemap& remap, SymbolId fileId, VObjectStore* result) {
   /* Restore design objects */
   result->clear();
   result->reserve(objects->size());
@@ -305,10 +596,7 @@ void Cache::restoreVObjects(
     // clang-format on
 
     result->emplace_back(
-        localSymbols->registerSymbol(
-            cacheSymbols.getSymbol(SymbolId(name, "<unknown>"))),
-        localSymbols->registerSymbol(
-            cacheSymbols.getSymbol(SymbolId(fileId, "<unknown>"))),
+        remapSymbol(remap, name), remapSymbol(remap, fileId),
         (VObjectType)type, line, column, endLine, endColumn, NodeId(parent),
         NodeId(definition), NodeId(child), NodeId(sibling));
   }
@@ -0,0 +1,486 @@
+/*
+ Copyright 2022 The Surelog Team.
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+/*
+ * File:   CachePack.cpp
+ * Author: surelog
+ */
+
+#include <Surelog/Cache/CachePack.h>
+#include <Surelog/Utils/StringUtils.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#if defined(_MSC_VER)
+#include <io.h>
+#else
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <map>
+#include <vector>
+
+namespace SURELOG {
+namespace fs = std::filesystem;
+
+static constexpr char kPackMagic[8] = {'S', 'L', 'P', 'A', 'C', 'K', '2', 0};
+static constexpr uint64_t kDefaultCapacity = 1 << 14;
+
+// Cross-process lock on the companion lock file of a pack. The lock file is
+// never replaced, unlike the pack itself which compact() renames over.
+// Threads of a process share one CachePack (see getPack()) and are
+// serialized by its mutex. There is no inter-process locking on Windows.
+class CachePack::FileLock final {
+ public:
+  FileLock(const fs::path& lockFileName, bool exclusive) {
+#if !defined(_MSC_VER)
+    m_fd = ::open(lockFileName.c_str(), O_RDWR | O_CREAT, 0644);
+    if (m_fd == -1) return;
+    while (flock(m_fd, exclusive ? LOCK_EX : LOCK_SH) == -1) {
+      if (errno != EINTR) break;
+    }
+#endif
+  }
+  ~FileLock() {
+#if !defined(_MSC_VER)
+    if (m_fd != -1) ::close(m_fd);  // Releases the lock
+#endif
+  }
+
+ private:
+  int m_fd = -1;
+};
+
+CachePack* CachePack::getPack(const fs::path& packFileName) {
+  static std::mutex packsMutex;
+  static std::map<std::string, std::unique_ptr<CachePack>> packs;
+  std::lock_guard<std::mutex> guard(packsMutex);
+  std::unique_ptr<CachePack>& pack = packs[packFileName.string()];
+  if (pack == nullptr) pack.reset(new CachePack(packFileName));
+  return pack.get();
+}
+
+fs::path CachePack::getPackFileName(const fs::path& cacheDir,
+                                    std::string_view libName) {
+  std::string name = libName.empty() ? "work" : std::string(libName);
+  return cacheDir / (name + ".slpack");
+}
+
+bool CachePack::compactAll(const fs::path& cacheDir) {
+  std::error_code ec;
+  if (!fs::is_directory(cacheDir, ec)) return true;
+  bool ok = true;
+  for (const fs::directory_entry& entry :
+       fs::directory_iterator(cacheDir, ec)) {
+    if (entry.path().extension() != ".slpack") continue;
+    ok &= getPack(entry.path())->compact();
+  }
+  return ok;
+}
+
+CachePack::CachePack(const fs::path& packFileName)
+    : m_fileName(packFileName),
+      m_lockFileName(packFileName.string() + ".lock") {}
+
+CachePack::~CachePack() { close_(); }
+
+bool CachePack::open_() {
+  if (m_fd != -1) return true;
+#if defined(_MSC_VER)
+  m_fd = ::_open(m_fileName.string().c_str(), _O_RDWR | _O_CREAT | _O_BINARY,
+                 _S_IREAD | _S_IWRITE);
+#else
+  m_fd = ::open(m_fileName.c_str(), O_RDWR | O_CREAT, 0644);
+#endif
+  return m_fd != -1;
+}
+
+void CachePack::close_() {
+  dropSnapshot_();
+  if (m_fd == -1) return;
+#if defined(_MSC_VER)
+  ::_close(m_fd);
+#else
+  ::close(m_fd);
+#endif
+  m_fd = -1;
+}
+
+bool CachePack::readAt_(uint64_t offset, void* data, uint64_t size) {
+  char* out = (char*)data;
+  while (size > 0) {
+#if defined(_MSC_VER)
+    if (::_lseeki64(m_fd, offset, SEEK_SET) == -1) return false;
+    int chunk = (size > (1u << 30)) ? (1 << 30) : (int)size;
+    int l = ::_read(m_fd, out, chunk);
+#else
+    ssize_t l = ::pread(m_fd, out, size, offset);
+#endif
+    if (l <= 0) return false;
+    out += l;
+    offset += l;
+    size -= l;
+  }
+  return true;
+}
+
+bool CachePack::writeAt_(uint64_t offset, const void* data, uint64_t size) {
+  const char* in = (const char*)data;
+  while (size > 0) {
+#if defined(_MSC_VER)
+    if (::_lseeki64(m_fd, offset, SEEK_SET) == -1) return false;
+    int chunk = (size > (1u << 30)) ? (1 << 30) : (int)size;
+    int l = ::_write(m_fd, in, chunk);
+#else
+    ssize_t l = ::pwrite(m_fd, in, size, offset);
+#endif
+    if (l <= 0) return false;
+    in += l;
+    offset += l;
+    size -= l;
+  }
+  return true;
+}
+
+bool CachePack::isReplaceable_() {
+  if (!open_()) return false;
+  std::error_code ec;
+  const uintmax_t size = fs::file_size(m_fileName, ec);
+  if (ec) return false;
+  if (size == 0) return true;
+  // Same magic up to the format version
+  char magic[sizeof(kPackMagic)];
+  if ((size < sizeof(magic)) || !readAt_(0, magic, sizeof(magic)) ||
+      (memcmp(magic, kPackMagic, sizeof(magic) - 2) != 0) ||
+      (magic[sizeof(magic) - 2] == kPackMagic[sizeof(magic) - 2])) {
+    return false;
+  }
+#if defined(_MSC_VER)
+  return ::_chsize_s(m_fd, 0) == 0;
+#else
+  return ::ftruncate(m_fd, 0) == 0;
+#endif
+}
+
+bool CachePack::readHeader_(Header* header) {
+  // A pack replaced by compact() in another process is reopened.
+  for (int retry = 0; retry < 2; retry++) {
+    if (!open_()) return false;
+    if (!readAt_(0, header, sizeof(Header))) return false;
+    if (memcmp(header->m_magic, kPackMagic, sizeof(kPackMagic)) != 0) {
+      return false;
+    }
+    if (header->m_replaced == 0) return header->m_capacity != 0;
+    close_();
+  }
+  return false;
+}
+
+bool CachePack::writeHeader_(const Header& header) {
+  return writeAt_(0, &header, sizeof(Header));
+}
+
+bool CachePack::initialize_(uint64_t capacity) {
+  Header header;
+  memcpy(header.m_magic, kPackMagic, sizeof(kPackMagic));
+  header.m_capacity = capacity;
+  header.m_nbKeys = 0;
+  header.m_end = indexOffset_(capacity);
+  header.m_replaced = 0;
+  header.m_generation = 0;
+  const std::vector<IndexEntry> index(capacity, IndexEntry{0, 0});
+  return writeAt_(indexOffset_(0), index.data(),
+                  capacity * sizeof(IndexEntry)) &&
+         writeHeader_(header);
+}
+
+bool CachePack::findSlot_(const Header& header, std::string_view key,
+                          uint64_t hash, uint64_t* slot, IndexEntry* entry) {
+  uint64_t index = hash % header.m_capacity;
+  std::string storedKey;
+  for (uint64_t probe = 0; probe < header.m_capacity; probe++) {
+    if (!readAt_(indexOffset_(index), entry, sizeof(IndexEntry))) {
+      return false;
+    }
+    if (entry->m_offset == 0) {
+      *slot = index;
+      return true;
+    }
+    if (entry->m_hash == hash) {
+      RecordHeader record;
+      if (!readAt_(entry->m_offset, &record, sizeof(RecordHeader))) {
+        return false;
+      }
+      if (record.m_keySize == key.size()) {
+        storedKey.resize(record.m_keySize);
+        if (!readAt_(entry->m_offset + sizeof(RecordHeader), storedKey.data(),
+                     record.m_keySize)) {
+          return false;
+        }
+        if (storedKey == key) {
+          *slot = index;
+          return true;
+        }
+      }
+    }
+    index = (index + 1) % header.m_capacity;
+  }
+  return false;
+}
+
+bool CachePack::takeSnapshot_() {
+  dropSnapshot_();
+  FileLock lock(m_lockFileName, false);
+  Header header;
+  if (!readHeader_(&header)) return false;
+  // The whole index in one read
+  m_index.resize(header.m_capacity);
+  if (!readAt_(indexOffset_(0), m_index.data(),
+               header.m_capacity * sizeof(IndexEntry))) {
+    m_index.clear();
+    return false;
+  }
+#if !defined(_MSC_VER)
+  // Records are only appended, the mapping stays valid for the ones the
+  // index copy points to. compact() renames a new file over this one.
+  void* map = mmap(nullptr, header.m_end, PROT_READ, MAP_SHARED, m_fd, 0);
+  if (map != MAP_FAILED) {
+    m_map = (const uint8_t*)map;
+    m_mapSize = header.m_end;
+  }
+#endif
+  m_generation = header.m_generation;
+  m_snapshot = true;
+  return true;
+}
+
+void CachePack::dropSnapshot_() {
+#if !defined(_MSC_VER)
+  if (m_map != nullptr) munmap(const_cast<uint8_t*>(m_map), m_mapSize);
+#endif
+  m_map = nullptr;
+  m_mapSize = 0;
+  m_index.clear();
+  m_snapshot = false;
+}
+
+bool CachePack::isSnapshotCurrent_() {
+  if (!m_snapshot) return false;
+  Header header;
+  if (m_map != nullptr) {
+    // Writers of other processes update the header through the page cache
+    memcpy(&header, m_map, sizeof(Header));
+    std::atomic_thread_fence(std::memory_order_acquire);
+  } else if (!readAt_(0, &header, sizeof(Header))) {
+    return false;
+  }
+  return (header.m_replaced == 0) && (header.m_generation == m_generation);
+}
+
+bool CachePack::readSnapshot_(uint64_t offset, void* data, uint64_t size) {
+  if (m_map == nullptr) return readAt_(offset, data, size);
+  if ((offset > m_mapSize) || (size > m_mapSize - offset)) return false;
+  memcpy(data, m_map + offset, size);
+  return true;
+}
+
+bool CachePack::read(std::string_view key, std::unique_ptr<uint8_t[]>* data,
+                     uint64_t* size) {
+  std::lock_guard<std::mutex> guard(m_mutex);
+  if (!isSnapshotCurrent_() && !takeSnapshot_()) return false;
+  const uint64_t hash = StringUtils::hash64(key);
+  const uint64_t capacity = m_index.size();
+  std::string storedKey;
+  for (uint64_t probe = 0, slot = hash % capacity; probe < capacity;
+       probe++, slot = (slot + 1) % capacity) {
+    const IndexEntry& entry = m_index[slot];
+    if (entry.m_offset == 0) return false;
+    if (entry.m_hash != hash) continue;
+    RecordHeader record;
+    if (!readSnapshot_(entry.m_offset, &record, sizeof(RecordHeader))) {
+      return false;
+    }
+    if (record.m_keySize != key.size()) continue;
+    storedKey.resize(record.m_keySize);
+    if (!readSnapshot_(entry.m_offset + sizeof(RecordHeader),
+                       storedKey.data(), record.m_keySize)) {
+      return false;
+    }
+    if (storedKey != key) continue;
+    if (record.m_dataSize == 0) return false;
+    data->reset(new uint8_t[record.m_dataSize]);
+    if (!readSnapshot_(entry.m_offset + sizeof(RecordHeader) + key.size(),
+                       data->get(), record.m_dataSize)) {
+      data->reset();
+      return false;
+    }
+    *size = record.m_dataSize;
+    return true;
+  }
+  return false;
+}
+
+bool CachePack::write(std::string_view key, const uint8_t* data,
+                      uint64_t size) {
+  std::lock_guard<std::mutex> guard(m_mutex);
+  FileLock lock(m_lockFileName, true);
+  Header header;
+  if (!readHeader_(&header)) {
+    // Only a new pack, or one of another format version, is initialized.
+    // One with a bad header keeps its content and nothing is cached in it.
+    if (!isReplaceable_() || !initialize_(kDefaultCapacity) ||
+        !readHeader_(&header)) {
+      return false;
+    }
+  }
+  // Keep the index at most 3/4 full so probing stays short.
+  if ((header.m_nbKeys + 1) * 4 > header.m_capacity * 3) {
+    if (!rebuild_(header.m_capacity * 2) || !readHeader_(&header)) {
+      return false;
+    }
+  }
+
+  const uint64_t hash = StringUtils::hash64(key);
+  uint64_t slot = 0;
+  IndexEntry entry;
+  if (!findSlot_(header, key, hash, &slot, &entry)) return false;
+  const bool newKey = (entry.m_offset == 0);
+
+  // The record is fully written before the index points to it.
+  RecordHeader record{hash, key.size(), size};
+  const uint64_t offset = header.m_end;
+  if (!writeAt_(offset, &record, sizeof(RecordHeader)) ||
+      !writeAt_(offset + sizeof(RecordHeader), key.data(), key.size()) ||
+      !writeAt_(offset + sizeof(RecordHeader) + key.size(), data, size)) {
+    return false;
+  }
+  entry.m_hash = hash;
+  entry.m_offset = offset;
+  if (!writeAt_(indexOffset_(slot), &entry, sizeof(IndexEntry))) return false;
+  if (newKey) header.m_nbKeys++;
+  header.m_end = offset + sizeof(RecordHeader) + key.size() + size;
+  header.m_generation++;
+  return writeHeader_(header);
+}
+
+// Copies the live records into a new pack with "capacity" index slots and
+// renames it over this one. Must be called with both locks held.
+bool CachePack::rebuild_(uint64_t capacity) {
+  Header header;
+  if (!readHeader_(&header)) return false;
+
+  const fs::path tmpFileName = m_fileName.string() + ".tmp";
+  CachePack tmp(tmpFileName);
+  std::error_code ec;
+  fs::remove(tmpFileName, ec);
+  if (!tmp.open_() || !tmp.initialize_(capacity)) {
+    tmp.close_();
+    fs::remove(tmpFileName, ec);
+    return false;
+  }
+
+  std::vector<IndexEntry> index(capacity, IndexEntry{0, 0});
+  uint64_t end = indexOffset_(capacity);
+  uint64_t nbKeys = 0;
+  std::vector<char> buffer;
+  bool ok = true;
+  for (uint64_t slot = 0; ok && (slot < header.m_capacity); slot++) {
+    IndexEntry entry;
+    if (!readAt_(indexOffset_(slot), &entry, sizeof(IndexEntry))) {
+      ok = false;
+      break;
+    }
+    if (entry.m_offset == 0) continue;
+    RecordHeader record;
+    if (!readAt_(entry.m_offset, &record, sizeof(RecordHeader))) {
+      ok = false;
+      break;
+    }
+    const uint64_t recordSize =
+        sizeof(RecordHeader) + record.m_keySize + record.m_dataSize;
+    buffer.resize(recordSize);
+    ok = readAt_(entry.m_offset, buffer.data(), recordSize) &&
+         tmp.writeAt_(end, buffer.data(), recordSize);
+    uint64_t newSlot = entry.m_hash % capacity;
+    while (index[newSlot].m_offset != 0) newSlot = (newSlot + 1) % capacity;
+    index[newSlot] = IndexEntry{entry.m_hash, end};
+    end += recordSize;
+    nbKeys++;
+  }
+
+  Header newHeader = header;
+  newHeader.m_capacity = capacity;
+  newHeader.m_nbKeys = nbKeys;
+  newHeader.m_end = end;
+  newHeader.m_replaced = 0;
+  newHeader.m_generation = header.m_generation + 1;
+  ok = ok &&
+       tmp.writeAt_(indexOffset_(0), index.data(),
+                    capacity * sizeof(IndexEntry)) &&
+       tmp.writeHeader_(newHeader);
+  tmp.close_();
+  if (!ok) {
+    fs::remove(tmpFileName, ec);
+    return false;
+  }
+
+  fs::rename(tmpFileName, m_fileName, ec);
+  if (ec) {
+    // The old pack is still the one in use
+    fs::remove(tmpFileName, ec);
+    return false;
+  }
+  // Processes that still have the old pack open see it as replaced and
+  // reopen the new one.
+  header.m_replaced = 1;
+  writeHeader_(header);
+  close_();
+  return open_();
+}
+
+bool CachePack::compact() {
+  std::lock_guard<std::mutex> guard(m_mutex);
+  FileLock lock(m_lockFileName, true);
+  Header header;
+  if (!readHeader_(&header)) return false;
+  uint64_t capacity = kDefaultCapacity;
+  while (header.m_nbKeys * 4 > capacity * 3) capacity *= 2;
+  return rebuild_(capacity);
+}
+
+uint64_t CachePack::getNbKeys() {
+  std::lock_guard<std::mutex> guard(m_mutex);
+  FileLock lock(m_lockFileName, false);
+  Header header;
+  if (!readHeader_(&header)) return 0;
+  return header.m_nbKeys;
+}
+
+uint64_t CachePack::getDataSize() {
+  std::lock_guard<std::mutex> guard(m_mutex);
+  FileLock lock(m_lockFileName, false);
+  Header header;
+  if (!readHeader_(&header)) return 0;
+  return header.m_end - indexOffset_(header.m_capacity);
+}
+
+}  // namespace SURELOG
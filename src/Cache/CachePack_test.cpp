@@ -0,0 +1,224 @@
+/*
+ Copyright 2022 The Surelog Team.
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+*/
+
+#include <Surelog/Cache/CachePack.h>
+#include <gtest/gtest.h>
+
+#if !defined(_MSC_VER)
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace SURELOG {
+namespace fs = std::filesystem;
+
+namespace {
+std::string readKey(CachePack* pack, std::string_view key) {
+  std::unique_ptr<uint8_t[]> data;
+  uint64_t size = 0;
+  if (!pack->read(key, &data, &size)) return "<missing>";
+  return std::string((const char*)data.get(), size);
+}
+
+bool writeKey(CachePack* pack, std::string_view key, std::string_view data) {
+  return pack->write(key, (const uint8_t*)data.data(), data.size());
+}
+
+class CachePackTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    m_dir = fs::temp_directory_path() /
+            ("surelog-cachepack-" +
+             std::string(::testing::UnitTest::GetInstance()
+                             ->current_test_info()
+                             ->name()));
+    fs::remove_all(m_dir);
+    fs::create_directories(m_dir);
+  }
+  void TearDown() override { fs::remove_all(m_dir); }
+
+  fs::path m_dir;
+};
+
+TEST_F(CachePackTest, ReadWrite) {
+  CachePack pack(CachePack::getPackFileName(m_dir, "work"));
+  EXPECT_EQ("<missing>", readKey(&pack, "a.sv.slpp"));
+  EXPECT_TRUE(writeKey(&pack, "a.sv.slpp", "first"));
+  EXPECT_TRUE(writeKey(&pack, "b.sv.slpp", "second"));
+  EXPECT_EQ("first", readKey(&pack, "a.sv.slpp"));
+  EXPECT_EQ("second", readKey(&pack, "b.sv.slpp"));
+
+  // Rewriting a key supersedes the previous version.
+  EXPECT_TRUE(writeKey(&pack, "a.sv.slpp", "third"));
+  EXPECT_EQ("third", readKey(&pack, "a.sv.slpp"));
+  EXPECT_EQ(2u, pack.getNbKeys());
+
+  // Another user of the same file sees the same content.
+  CachePack other(pack.getFileName());
+  EXPECT_EQ("third", readKey(&other, "a.sv.slpp"));
+}
+
+TEST_F(CachePackTest, CompactDropsSupersededRecords) {
+  CachePack pack(CachePack::getPackFileName(m_dir, "work"));
+  const std::string payload(1000, 'x');
+  for (int i = 0; i < 10; i++) {
+    EXPECT_TRUE(writeKey(&pack, "a", payload + std::to_string(i)));
+  }
+  EXPECT_TRUE(writeKey(&pack, "b", "b"));
+  const uint64_t before = pack.getDataSize();
+
+  // A second pack object on the same file keeps working after the rename.
+  CachePack other(pack.getFileName());
+  EXPECT_EQ("b", readKey(&other, "b"));
+
+  EXPECT_TRUE(pack.compact());
+  EXPECT_LT(pack.getDataSize(), before);
+  EXPECT_EQ(payload + "9", readKey(&pack, "a"));
+  EXPECT_EQ("b", readKey(&other, "b"));
+  EXPECT_TRUE(writeKey(&other, "c", "c"));
+  EXPECT_EQ("c", readKey(&pack, "c"));
+}
+
+TEST_F(CachePackTest, BadHeaderIsKept) {
+  const fs::path packFileName = CachePack::getPackFileName(m_dir, "work");
+  {
+    CachePack pack(packFileName);
+    EXPECT_TRUE(writeKey(&pack, "a", "a"));
+  }
+  {
+    std::fstream file(packFileName,
+                      std::ios::in | std::ios::out | std::ios::binary);
+    file.write("NOTAPACK", 8);
+  }
+  const uintmax_t size = fs::file_size(packFileName);
+
+  // Nothing is cached, the pack is not reinitialized over its content.
+  CachePack pack(packFileName);
+  EXPECT_FALSE(writeKey(&pack, "b", "b"));
+  EXPECT_EQ("<missing>", readKey(&pack, "a"));
+  EXPECT_EQ(size, fs::file_size(packFileName));
+}
+
+TEST_F(CachePackTest, OlderFormatIsReinitialized) {
+  const fs::path packFileName = CachePack::getPackFileName(m_dir, "work");
+  {
+    CachePack pack(packFileName);
+    EXPECT_TRUE(writeKey(&pack, "a", "a"));
+  }
+  {
+    std::fstream file(packFileName,
+                      std::ios::in | std::ios::out | std::ios::binary);
+    file.write("SLPACK1", 8);
+  }
+
+  CachePack pack(packFileName);
+  EXPECT_EQ("<missing>", readKey(&pack, "a"));
+  EXPECT_TRUE(writeKey(&pack, "b", "b"));
+  EXPECT_EQ("<missing>", readKey(&pack, "a"));
+  EXPECT_EQ("b", readKey(&pack, "b"));
+}
+
+TEST_F(CachePackTest, ReaderSeesLaterWrites) {
+  const fs::path packFileName = CachePack::getPackFileName(m_dir, "work");
+  CachePack writer(packFileName);
+  CachePack reader(packFileName);
+  EXPECT_TRUE(writeKey(&writer, "a", "first"));
+  EXPECT_EQ("first", readKey(&reader, "a"));
+  EXPECT_EQ("<missing>", readKey(&reader, "b"));
+
+  // New records, past the end of the reader mapping
+  EXPECT_TRUE(writeKey(&writer, "a", std::string(10000, 'x')));
+  EXPECT_TRUE(writeKey(&writer, "b", "b"));
+  EXPECT_EQ(std::string(10000, 'x'), readKey(&reader, "a"));
+  EXPECT_EQ("b", readKey(&reader, "b"));
+
+  // The index rebuilt in a new file renamed over the mapped one
+  const int nbKeys = 13000;
+  for (int i = 0; i < nbKeys; i++) {
+    ASSERT_TRUE(
+        writeKey(&writer, "key" + std::to_string(i), std::to_string(i)));
+  }
+  EXPECT_EQ("12999", readKey(&reader, "key12999"));
+  EXPECT_EQ("b", readKey(&reader, "b"));
+}
+
+TEST_F(CachePackTest, IndexGrows) {
+  CachePack pack(CachePack::getPackFileName(m_dir, "work"));
+  const int nbKeys = 13000;  // More than 3/4 of the default index
+  for (int i = 0; i < nbKeys; i++) {
+    ASSERT_TRUE(writeKey(&pack, "key" + std::to_string(i), std::to_string(i)));
+  }
+  EXPECT_EQ((uint64_t)nbKeys, pack.getNbKeys());
+  for (int i = 0; i < nbKeys; i += 97) {
+    EXPECT_EQ(std::to_string(i), readKey(&pack, "key" + std::to_string(i)));
+  }
+}
+
+TEST_F(CachePackTest, ConcurrentThreads) {
+  const fs::path packFileName = CachePack::getPackFileName(m_dir, "work");
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; t++) {
+    threads.emplace_back([t, &packFileName] {
+      CachePack* pack = CachePack::getPack(packFileName);
+      for (int i = 0; i < 200; i++) {
+        const std::string key = std::to_string(t) + "_" + std::to_string(i);
+        writeKey(pack, key, key);
+      }
+    });
+  }
+  for (std::thread& thread : threads) thread.join();
+  CachePack* pack = CachePack::getPack(packFileName);
+  EXPECT_EQ(800u, pack->getNbKeys());
+  EXPECT_EQ("3_199", readKey(pack, "3_199"));
+}
+
+#if !defined(_MSC_VER)
+TEST_F(CachePackTest, ConcurrentProcesses) {
+  const fs::path packFileName = CachePack::getPackFileName(m_dir, "work");
+  std::vector<pid_t> children;
+  for (int p = 0; p < 4; p++) {
+    pid_t pid = fork();
+    if (pid == 0) {
+      CachePack pack(packFileName);
+      for (int i = 0; i < 200; i++) {
+        const std::string key = std::to_string(p) + "_" + std::to_string(i);
+        if (!writeKey(&pack, key, key)) _exit(1);
+      }
+      _exit(0);
+    }
+    children.push_back(pid);
+  }
+  for (pid_t pid : children) {
+    int status = 0;
+    waitpid(pid, &status, 0);
+    EXPECT_EQ(0, status);
+  }
+  CachePack pack(packFileName);
+  EXPECT_EQ(800u, pack.getNbKeys());
+  for (int p = 0; p < 4; p++) {
+    const std::string key = std::to_string(p) + "_199";
+    EXPECT_EQ(key, readKey(&pack, key));
+  }
+}
+#endif
+}  // namespace
+}  // namespace SURELOG
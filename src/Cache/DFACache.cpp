@@ -0,0 +1,450 @@
+/*
+ Copyright 2022 The Surelog Team.
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+/*
+ * File:   DFACache.cpp
+ * Author: surelog
+ */
+
+#include <Surelog/Cache/DFACache.h>
+#include <Surelog/Cache/dfa_generated.h>
+#include <Surelog/CommandLine/CommandLineParser.h>
+#include <Surelog/SourceCompile/SymbolTable.h>
+#include <Surelog/Utils/FileUtils.h>
+#include <Surelog/Utils/StringUtils.h>
+#include <antlr4-runtime.h>
+#include <parser/SV3_1aLexer.h>
+#include <parser/SV3_1aParser.h>
+#include <parser/SV3_1aPpLexer.h>
+#include <parser/SV3_1aPpParser.h>
+
+#include <memory>
+#include <mutex>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+namespace SURELOG {
+namespace fs = std::filesystem;
+
+static constexpr char FlbSchemaVersion[] = "1.0";
+
+namespace {
+using antlr4::atn::ATN;
+using antlr4::atn::ATNConfig;
+using antlr4::atn::ATNConfigSet;
+using antlr4::atn::PredictionContext;
+using antlr4::dfa::DFA;
+using antlr4::dfa::DFAState;
+
+// Reference to a prediction context, const or not depending on the runtime.
+using ContextRef = std::remove_const_t<decltype(ATNConfig::context)>;
+
+// ATN and DFAs of a grammar, shared by all its parsers.
+struct GrammarDFAs {
+  std::string_view m_name;
+  const ATN* m_atn;
+  std::vector<DFA>* m_dfas;
+  uint64_t m_atnHash;
+};
+
+// Fingerprint of the ATN states and transitions the DFA configs refer to.
+uint64_t hashATN(const ATN& atn) {
+  std::string shape;
+  shape.reserve(atn.states.size() * 16);
+  StrAppend(&shape, atn.getNumberOfDecisions(), "\n");
+  for (const antlr4::atn::ATNState* state : atn.states) {
+    if (state == nullptr) {
+      shape += "-\n";
+      continue;
+    }
+    StrAppend(&shape, static_cast<int>(state->getStateType()), ":");
+    for (size_t i = 0; i < state->getNumberOfTransitions(); i++) {
+      StrAppend(&shape, state->transition(i)->target->stateNumber, ",");
+    }
+    shape += "\n";
+  }
+  return StringUtils::hash64(shape);
+}
+
+template <typename Lexer, typename Parser>
+GrammarDFAs getGrammar(std::string_view name) {
+  // The ATN and DFAs are static data of the generated parser, any instance
+  // leads to them.
+  antlr4::ANTLRInputStream input("");
+  Lexer lexer(&input);
+  antlr4::CommonTokenStream tokens(&lexer);
+  Parser parser(&tokens);
+  auto* simulator =
+      parser.template getInterpreter<antlr4::atn::ParserATNSimulator>();
+  return GrammarDFAs{name, &parser.getATN(), &simulator->decisionToDFA,
+                     hashATN(parser.getATN())};
+}
+
+std::vector<GrammarDFAs>& getGrammars() {
+  static std::vector<GrammarDFAs> grammars = {
+      getGrammar<SV3_1aLexer, SV3_1aParser>("SV3_1aParser"),
+      getGrammar<SV3_1aPpLexer, SV3_1aPpParser>("SV3_1aPpParser")};
+  return grammars;
+}
+
+// Number of states the DFAs had when last loaded or saved by this process.
+std::mutex sMutex;
+uint64_t sNbStatesKnown = 0;
+
+// Indexes the prediction contexts of a grammar's configs as they are saved.
+class ContextWriter final {
+ public:
+  explicit ContextWriter(flatbuffers::FlatBufferBuilder& builder)
+      : m_builder(builder) {
+    // No context and empty context
+    m_contexts.push_back(DFACACHE::CreateContext(m_builder));
+    m_contexts.push_back(DFACACHE::CreateContext(m_builder));
+  }
+
+  uint32_t add(const PredictionContext* context) {
+    if (context == nullptr) return 0;
+    if (context->isEmpty()) return 1;
+    auto found = m_index.find(context);
+    if (found != m_index.end()) return found->second;
+    std::vector<uint32_t> parents;
+    std::vector<uint64_t> returnStates;
+    for (size_t i = 0; i < context->size(); i++) {
+      parents.push_back(add(context->getParent(i).get()));
+      returnStates.push_back(context->getReturnState(i));
+    }
+    auto parentsOffset = m_builder.CreateVector(parents);
+    auto returnStatesOffset = m_builder.CreateVector(returnStates);
+    const uint32_t index = m_contexts.size();
+    m_contexts.push_back(
+        DFACACHE::CreateContext(m_builder, parentsOffset, returnStatesOffset));
+    m_index.emplace(context, index);
+    return index;
+  }
+
+  flatbuffers::Offset<
+      flatbuffers::Vector<flatbuffers::Offset<DFACACHE::Context>>>
+  finish() {
+    return m_builder.CreateVector(m_contexts);
+  }
+
+ private:
+  flatbuffers::FlatBufferBuilder& m_builder;
+  std::unordered_map<const PredictionContext*, uint32_t> m_index;
+  std::vector<flatbuffers::Offset<DFACACHE::Context>> m_contexts;
+};
+
+flatbuffers::Offset<DFACACHE::DFA> saveDFA(
+    flatbuffers::FlatBufferBuilder& builder, ContextWriter& contexts,
+    const DFA& dfa, uint32_t decision, uint64_t* budget) {
+  // States with predicates are left to be learned again, their prediction
+  // depends on the parser state.
+  std::vector<const DFAState*> states;
+  std::unordered_map<const DFAState*, uint32_t> stateIndex;
+  for (const DFAState* state : dfa.states) {
+    if (*budget == 0) break;
+    if ((state->configs == nullptr) || state->configs->hasSemanticContext ||
+        !state->predicates.empty()) {
+      continue;
+    }
+    stateIndex.emplace(state, states.size());
+    states.push_back(state);
+    (*budget)--;
+  }
+
+  std::vector<flatbuffers::Offset<DFACACHE::State>> stateOffsets;
+  for (const DFAState* state : states) {
+    const ATNConfigSet& configSet = *state->configs;
+    std::vector<DFACACHE::Config> configs;
+    for (const auto& config : configSet.configs) {
+      configs.emplace_back(config->state->stateNumber, config->alt,
+                           contexts.add(config->context.get()),
+                           config->reachesIntoOuterContext);
+    }
+    std::vector<uint32_t> conflictingAlts;
+    for (size_t alt = 0; alt < configSet.conflictingAlts.size(); alt++) {
+      if (configSet.conflictingAlts.test(alt)) conflictingAlts.push_back(alt);
+    }
+    std::vector<DFACACHE::Edge> edges;
+    for (const auto& [symbol, target] : state->edges) {
+      auto found = stateIndex.find(target);
+      if (found != stateIndex.end()) edges.emplace_back(symbol, found->second);
+    }
+    stateOffsets.push_back(DFACACHE::CreateState(
+        builder, builder.CreateVectorOfStructs(configs), configSet.fullCtx,
+        configSet.uniqueAlt, builder.CreateVector(conflictingAlts),
+        configSet.dipsIntoOuterContext, state->isAcceptState,
+        state->prediction, state->requiresFullContext,
+        builder.CreateVectorOfStructs(edges)));
+  }
+
+  int32_t start = -1;
+  std::vector<DFACACHE::Edge> precedenceStarts;
+  if (dfa.s0 != nullptr) {
+    if (dfa.isPrecedenceDfa()) {
+      for (const auto& [precedence, target] : dfa.s0->edges) {
+        auto found = stateIndex.find(target);
+        if (found != stateIndex.end()) {
+          precedenceStarts.emplace_back(precedence, found->second);
+        }
+      }
+    } else {
+      auto found = stateIndex.find(dfa.s0);
+      if (found != stateIndex.end()) start = found->second;
+    }
+  }
+  return DFACACHE::CreateDFA(builder, decision, start,
+                             builder.CreateVectorOfStructs(precedenceStarts),
+                             builder.CreateVector(stateOffsets));
+}
+
+// The cache is only trusted once all the indexes it holds are in range.
+bool checkDFA(const DFACACHE::DFA* dfac, const GrammarDFAs& grammar,
+              size_t nbContexts) {
+  if ((dfac->decision() >= grammar.m_dfas->size()) ||
+      (dfac->states() == nullptr)) {
+    return false;
+  }
+  const size_t nbStates = dfac->states()->size();
+  if (dfac->start() >= (int32_t)nbStates) return false;
+  if (dfac->precedence_starts() != nullptr) {
+    for (const DFACACHE::Edge* edge : *dfac->precedence_starts()) {
+      if (edge->target() >= nbStates) return false;
+    }
+  }
+  for (const DFACACHE::State* statec : *dfac->states()) {
+    if ((statec->configs() == nullptr) || (statec->edges() == nullptr)) {
+      return false;
+    }
+    for (const DFACACHE::Config* configc : *statec->configs()) {
+      if ((configc->state() >= grammar.m_atn->states.size()) ||
+          (grammar.m_atn->states[configc->state()] == nullptr) ||
+          (configc->context() >= nbContexts)) {
+        return false;
+      }
+    }
+    for (const DFACACHE::Edge* edge : *statec->edges()) {
+      if (edge->target() >= nbStates) return false;
+    }
+  }
+  return true;
+}
+
+void restoreDFA(const DFACACHE::DFA* dfac, const GrammarDFAs& grammar,
+                const std::vector<ContextRef>& contexts) {
+  DFA& dfa = (*grammar.m_dfas)[dfac->decision()];
+  std::vector<DFAState*> states;
+  states.reserve(dfac->states()->size());
+  for (const DFACACHE::State* statec : *dfac->states()) {
+    auto configSet = std::make_unique<ATNConfigSet>(statec->full_context());
+    for (const DFACACHE::Config* configc : *statec->configs()) {
+      auto config = std::make_shared<ATNConfig>(
+          grammar.m_atn->states[configc->state()], configc->alt(),
+          contexts[configc->context()]);
+      config->reachesIntoOuterContext = configc->reaches_into_outer_context();
+      configSet->add(config);
+    }
+    configSet->uniqueAlt = statec->unique_alt();
+    if (statec->conflicting_alts() != nullptr) {
+      for (uint32_t alt : *statec->conflicting_alts()) {
+        if (alt < configSet->conflictingAlts.size()) {
+          configSet->conflictingAlts.set(alt);
+        }
+      }
+    }
+    configSet->dipsIntoOuterContext = statec->dips_into_outer_context();
+    configSet->setReadonly(true);
+
+    DFAState* state = new DFAState(std::move(configSet));
+    state->isAcceptState = statec->accept();
+    state->prediction = statec->prediction();
+    state->requiresFullContext = statec->requires_full_context();
+    state->stateNumber = dfa.states.size();
+    auto inserted = dfa.states.insert(state);
+    if (!inserted.second) {
+      delete state;
+      state = *inserted.first;
+    }
+    states.push_back(state);
+  }
+
+  for (uint32_t i = 0; i < states.size(); i++) {
+    for (const DFACACHE::Edge* edge : *dfac->states()->Get(i)->edges()) {
+      states[i]->edges[edge->symbol()] = states[edge->target()];
+    }
+  }
+  if (dfa.isPrecedenceDfa()) {
+    if (dfac->precedence_starts() != nullptr) {
+      for (const DFACACHE::Edge* edge : *dfac->precedence_starts()) {
+        dfa.setPrecedenceStartState((int)edge->symbol(),
+                                     states[edge->target()]);
+      }
+    }
+  } else if (dfac->start() >= 0) {
+    dfa.s0 = states[dfac->start()];
+  }
+}
+
+bool restoreGrammar(const DFACACHE::Grammar* grammarc,
+                    const GrammarDFAs& grammar) {
+  if ((grammarc->atn_hash() != grammar.m_atnHash) ||
+      (grammarc->contexts() == nullptr) || (grammarc->dfas() == nullptr)) {
+    return false;
+  }
+  // Contexts, parents first
+  const auto* contextsc = grammarc->contexts();
+  std::vector<ContextRef> contexts;
+  contexts.reserve(contextsc->size());
+  for (uint32_t i = 0; i < contextsc->size(); i++) {
+    if (i == 0) {
+      contexts.emplace_back(nullptr);
+      continue;
+    }
+    if (i == 1) {
+      contexts.emplace_back(PredictionContext::EMPTY);
+      continue;
+    }
+    const DFACACHE::Context* contextc = contextsc->Get(i);
+    if ((contextc->parents() == nullptr) ||
+        (contextc->return_states() == nullptr) ||
+        (contextc->parents()->size() != contextc->return_states()->size()) ||
+        (contextc->parents()->size() == 0)) {
+      return false;
+    }
+    std::vector<ContextRef> parents;
+    std::vector<size_t> returnStates;
+    for (uint32_t j = 0; j < contextc->parents()->size(); j++) {
+      const uint32_t parent = contextc->parents()->Get(j);
+      if (parent >= i) return false;
+      parents.push_back(contexts[parent]);
+      returnStates.push_back(contextc->return_states()->Get(j));
+    }
+    if (parents.size() == 1) {
+      contexts.emplace_back(antlr4::atn::SingletonPredictionContext::create(
+          parents[0], returnStates[0]));
+    } else {
+      contexts.emplace_back(
+          std::make_shared<antlr4::atn::ArrayPredictionContext>(
+              std::move(parents), std::move(returnStates)));
+    }
+  }
+
+  for (const DFACACHE::DFA* dfac : *grammarc->dfas()) {
+    if (!checkDFA(dfac, grammar, contexts.size())) return false;
+  }
+  for (const DFACACHE::DFA* dfac : *grammarc->dfas()) {
+    // Keep what this process already learned
+    if (!(*grammar.m_dfas)[dfac->decision()].states.empty()) continue;
+    restoreDFA(dfac, grammar, contexts);
+  }
+  return true;
+}
+}  // namespace
+
+DFACache::DFACache(const fs::path& cacheFileName, uint64_t maxStates)
+    : m_cacheFileName(cacheFileName), m_maxStates(maxStates) {}
+
+fs::path DFACache::getCacheFileName(CommandLineParser* clp) {
+  const fs::path cacheDir =
+      clp->getSymbolTable().getSymbol(clp->getCacheDir());
+  return cacheDir / "surelog.sldfa";
+}
+
+uint64_t DFACache::getNbStates() {
+  uint64_t nbStates = 0;
+  for (const GrammarDFAs& grammar : getGrammars()) {
+    for (const DFA& dfa : *grammar.m_dfas) nbStates += dfa.states.size();
+  }
+  return nbStates;
+}
+
+void DFACache::clear() {
+  std::lock_guard<std::mutex> guard(sMutex);
+  for (GrammarDFAs& grammar : getGrammars()) {
+    const size_t nbDecisions = grammar.m_dfas->size();
+    grammar.m_dfas->clear();
+    for (size_t decision = 0; decision < nbDecisions; decision++) {
+      grammar.m_dfas->emplace_back(grammar.m_atn->getDecisionState(decision),
+                                   decision);
+    }
+  }
+  sNbStatesKnown = 0;
+}
+
+bool DFACache::restore() {
+  std::lock_guard<std::mutex> guard(sMutex);
+  // Once the parsers learned states, the cache has nothing more to give
+  // to this process.
+  if (getNbStates() != 0) return true;
+
+  Buffer buffer = openFlatBuffers(m_cacheFileName);
+  if (buffer == nullptr) return false;
+  flatbuffers::Verifier verifier(buffer.get(), buffer.get_deleter().m_size,
+                                 64, 100000000);
+  if (!DFACACHE::VerifyDFACacheBuffer(verifier)) return false;
+  const DFACACHE::DFACache* dfacache = DFACACHE::GetDFACache(buffer.get());
+  if (!checkIfCacheIsValid(dfacache->header(), FlbSchemaVersion, "")) {
+    return false;
+  }
+  if (dfacache->grammars() == nullptr) return false;
+
+  bool restored = true;
+  for (const DFACACHE::Grammar* grammarc : *dfacache->grammars()) {
+    if (grammarc->name() == nullptr) continue;
+    for (const GrammarDFAs& grammar : getGrammars()) {
+      if (grammar.m_name != grammarc->name()->c_str()) continue;
+      if (!restoreGrammar(grammarc, grammar)) restored = false;
+    }
+  }
+  sNbStatesKnown = getNbStates();
+  return restored;
+}
+
+bool DFACache::save() {
+  std::lock_guard<std::mutex> guard(sMutex);
+  const uint64_t nbStates = getNbStates();
+  if (nbStates == sNbStatesKnown) return true;
+
+  flatbuffers::FlatBufferBuilder builder(1024 * 1024);
+  auto header = createHeader(builder, FlbSchemaVersion, "");
+  uint64_t budget = m_maxStates;
+  std::vector<flatbuffers::Offset<DFACACHE::Grammar>> grammars;
+  for (const GrammarDFAs& grammar : getGrammars()) {
+    ContextWriter contexts(builder);
+    std::vector<flatbuffers::Offset<DFACACHE::DFA>> dfas;
+    for (uint32_t decision = 0; decision < grammar.m_dfas->size();
+         decision++) {
+      const DFA& dfa = (*grammar.m_dfas)[decision];
+      if (dfa.states.empty()) continue;
+      dfas.push_back(saveDFA(builder, contexts, dfa, decision, &budget));
+    }
+    auto contextsOffset = contexts.finish();
+    auto dfasOffset = builder.CreateVector(dfas);
+    grammars.push_back(DFACACHE::CreateGrammar(
+        builder, builder.CreateString(grammar.m_name), grammar.m_atnHash,
+        contextsOffset, dfasOffset));
+  }
+  auto dfacache = DFACACHE::CreateDFACache(builder, header,
+                                           builder.CreateVector(grammars));
+  FinishDFACacheBuffer(builder, dfacache);
+
+  FileUtils::mkDirs(m_cacheFileName.parent_path());
+  if (!saveFlatbuffers(builder, m_cacheFileName)) return false;
+  sNbStatesKnown = nbStates;
+  return true;
+}
+
+}  // namespace SURELOG
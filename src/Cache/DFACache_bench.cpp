@@ -0,0 +1,131 @@
+/*
+ Copyright 2022 The Surelog Team.
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+/*
+ * File:   DFACache_bench.cpp
+ * Author: surelog
+ *
+ * Parse time of the SystemVerilog parser starting from empty DFAs (cold),
+ * versus starting from the DFAs saved by a previous run (warm, -dfacache).
+ * Reports the time of the first file, dominated by the DFA warm-up, and of
+ * the whole set.
+ *
+ * Usage: dfacache-bench <preprocessed file>...
+ *        (files written with -writepp, under slpp_all/ or slpp_unit/)
+ */
+
+#include <Surelog/Cache/DFACache.h>
+#include <antlr4-runtime.h>
+#include <parser/SV3_1aLexer.h>
+#include <parser/SV3_1aParser.h>
+
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace SURELOG;
+
+// Parses like ParseFile: SLL first, LL if SLL fails.
+static void parse(const std::string& text) {
+  antlr4::ANTLRInputStream input(text);
+  SV3_1aLexer lexer(&input);
+  lexer.removeErrorListeners();
+  antlr4::CommonTokenStream tokens(&lexer);
+  tokens.fill();
+  SV3_1aParser parser(&tokens);
+  parser.removeErrorListeners();
+  parser.getInterpreter<antlr4::atn::ParserATNSimulator>()->setPredictionMode(
+      antlr4::atn::PredictionMode::SLL);
+  parser.setErrorHandler(std::make_shared<antlr4::BailErrorStrategy>());
+  try {
+    parser.top_level_rule();
+  } catch (antlr4::ParseCancellationException&) {
+    tokens.reset();
+    parser.reset();
+    parser.setErrorHandler(std::make_shared<antlr4::DefaultErrorStrategy>());
+    parser.getInterpreter<antlr4::atn::ParserATNSimulator>()
+        ->setPredictionMode(antlr4::atn::PredictionMode::LL);
+    parser.top_level_rule();
+  }
+}
+
+static void parseAll(const char* label,
+                     const std::vector<std::string>& texts) {
+  double first = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (const std::string& text : texts) {
+    parse(text);
+    if (first == 0) {
+      first = std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                            start)
+                  .count();
+    }
+  }
+  double total =
+      std::chrono::duration<double>(std::chrono::steady_clock::now() - start)
+          .count();
+  printf("%-6s first file %8.3fs  total %8.3fs  %10llu DFA states\n", label,
+         first, total, (unsigned long long)DFACache::getNbStates());
+}
+
+int main(int argc, char** argv) {
+  if (argc < 2) {
+    fprintf(stderr, "Usage: %s <preprocessed file>...\n", argv[0]);
+    return 1;
+  }
+  std::vector<std::string> texts;
+  for (int i = 1; i < argc; i++) {
+    std::ifstream stream(argv[i]);
+    if (!stream.good()) {
+      fprintf(stderr, "Cannot read %s\n", argv[i]);
+      return 1;
+    }
+    std::stringstream buffer;
+    buffer << stream.rdbuf();
+    texts.push_back(buffer.str());
+  }
+
+  const std::filesystem::path cacheFileName =
+      std::filesystem::temp_directory_path() / "dfacache-bench.sldfa";
+  DFACache cache(cacheFileName, ~0ULL);
+
+  DFACache::clear();
+  parseAll("cold", texts);
+  if (!cache.save()) {
+    fprintf(stderr, "Cannot save %s\n", cacheFileName.string().c_str());
+    return 1;
+  }
+
+  DFACache::clear();
+  auto start = std::chrono::steady_clock::now();
+  if (!cache.restore()) {
+    fprintf(stderr, "Cannot restore %s\n", cacheFileName.string().c_str());
+    return 1;
+  }
+  printf("load   %8.3fs\n",
+         std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                       start)
+             .count());
+  parseAll("warm", texts);
+
+  std::filesystem::remove(cacheFileName);
+  return 0;
+}
@@ -0,0 +1,72 @@
+/*
+ Copyright 2022 The Surelog Team.
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+*/
+
+#include <Surelog/Cache/DFACache.h>
+#include <Surelog/Design/FileContent.h>
+#include <Surelog/SourceCompile/ParserHarness.h>
+#include <gtest/gtest.h>
+
+#include <filesystem>
+
+namespace SURELOG {
+namespace fs = std::filesystem;
+
+namespace {
+constexpr char kSource[] =
+    "module top(input a, output b);\n"
+    "  logic [3:0] c;\n"
+    "  assign b = a & c[0];\n"
+    "  always_ff @(posedge a) c <= c + 1;\n"
+    "endmodule\n";
+
+TEST(DFACacheTest, SaveRestore) {
+  const fs::path cacheFileName =
+      fs::temp_directory_path() / "surelog-dfacache-test.sldfa";
+  fs::remove(cacheFileName);
+  DFACache cache(cacheFileName, ~0ULL);
+
+  // Cold
+  DFACache::clear();
+  EXPECT_EQ(DFACache::getNbStates(), 0U);
+  ParserHarness harness;
+  EXPECT_NE(harness.parse(kSource), nullptr);
+  const uint64_t nbStates = DFACache::getNbStates();
+  EXPECT_GT(nbStates, 0U);
+  EXPECT_TRUE(cache.save());
+
+  // Warm, states depending on predicates are not saved and get learned again
+  DFACache::clear();
+  EXPECT_TRUE(cache.restore());
+  EXPECT_GT(DFACache::getNbStates(), 0U);
+  EXPECT_LE(DFACache::getNbStates(), nbStates);
+  std::unique_ptr<FileContent> fC = harness.parse(kSource);
+  ASSERT_NE(fC, nullptr);
+  EXPECT_TRUE(fC->sl_collect(fC->getRootNode(), slContinuous_assign));
+  EXPECT_EQ(DFACache::getNbStates(), nbStates);
+
+  // Size cap
+  DFACache small(cacheFileName, 10);
+  DFACache::clear();
+  EXPECT_NE(harness.parse(kSource), nullptr);
+  EXPECT_TRUE(small.save());
+  DFACache::clear();
+  EXPECT_TRUE(small.restore());
+  EXPECT_LE(DFACache::getNbStates(), 10U);
+
+  fs::remove(cacheFileName);
+}
+}  // namespace
+}  // namespace SURELOG
@@ -21,6 +21,7 @@
  * Created on April 23, 2017, 8:49 PM
  */
 
+#include <Surelog/Cache/CachePack.h>
 #include <Surelog/Cache/PPCache.h>
 #include <Surelog/Cache/preproc_generated.h>
 #include <Surelog/CommandLine/CommandLineParser.h>
@@ -37,12 +38,14 @@
 #include <Surelog/SourceCompile/SymbolTable.h>
 #include <Surelog/Utils/FileUtils.h>
 
+#include <algorithm>
+
 namespace SURELOG {
 namespace fs = std::filesystem;
 
 PPCache::PPCache(PreprocessFile* pp) : m_pp(pp), m_isPrecompiled(false) {}
 
-static const char FlbSchemaVersion[] = "1.2";
+static const char FlbSchemaVersion[] = "1.3";
 
 // TODO(hzeller): this should come from a function cacheFileResolver() or
 // something that can be passed to the cache. That way, we can leave the
@@ -85,7 +88,14 @@ fs::path PPCache::getCacheFileName_(const fs::path& requested_file) {
   }
   fs::path cacheFileName =
       cacheDirName / libName / (fileName.string() + ".slpp");
-  FileUtils::mkDirs(cacheDirName / libName / hashedPath);
+  if (clp->cachePack() && !m_isPrecompiled) {
+    usePack(CachePack::getPack(
+                CachePack::getPackFileName(cacheDirName, libName)),
+            cacheDirName);
+  } else {
+    usePack(nullptr, "");
+    FileUtils::mkDirs(cacheDirName / libName / hashedPath);
+  }
   return cacheFileName;
 }
 
@@ -97,7 +107,7 @@ static bool compareVectors(std::vector<T> a, std::vector<T> b) {
 }
 
 bool PPCache::restore_(const fs::path& cacheFileName,
-                       const std::unique_ptr<uint8_t[]>& buffer,
+                       const Buffer& buffer,
                        bool errorsOnly) {
   if (buffer == nullptr) return false;
 
@@ -120,20 +130,17 @@ bool PPCache::restore_(const fs::path& cacheFileName,
                       macro->end_column(), args, tokens);
   }
 
-  SymbolTable cacheSymbols;
-  restoreErrors(ppcache->errors(), ppcache->symbols(), &cacheSymbols,
-                m_pp->getCompileSourceFile()->getErrorContainer(),
-                m_pp->getCompileSourceFile()->getSymbolTable());
+  const SymbolRemap remap = restoreSymbols(
+      ppcache->symbols(), m_pp->getCompileSourceFile()->getSymbolTable());
+  restoreErrors(ppcache->errors(), remap,
+                m_pp->getCompileSourceFile()->getErrorContainer());
 
   /* Restore `timescale directives */
   if (!errorsOnly) {
     for (const CACHE::TimeInfo* fbtimeinfo : *ppcache->time_info()) {
       TimeInfo timeInfo;
       timeInfo.m_type = (TimeInfo::Type)fbtimeinfo->type();
-      timeInfo.m_fileId =
-          m_pp->getCompileSourceFile()->getSymbolTable()->registerSymbol(
-              cacheSymbols.getSymbol(
-                  SymbolId(fbtimeinfo->file_id(), "<unknown>")));
+      timeInfo.m_fileId = remapSymbol(remap, fbtimeinfo->file_id());
       timeInfo.m_line = fbtimeinfo->line();
       timeInfo.m_timeUnit = (TimeInfo::Unit)fbtimeinfo->time_unit();
       timeInfo.m_timeUnitValue = fbtimeinfo->time_unit_value();
@@ -197,9 +204,7 @@ bool PPCache::restore_(const fs::path& cacheFileName,
   }
   if (!errorsOnly) {
     auto objects = ppcache->objects();
-    restoreVObjects(objects, cacheSymbols,
-                    m_pp->getCompileSourceFile()->getSymbolTable(),
-                    m_pp->getFileId(0), fileContent);
+    restoreVObjects(objects, remap, m_pp->getFileId(0), fileContent);
   }
 
   return true;
@@ -210,7 +215,7 @@ bool PPCache::restore_(const fs::path& cacheFileName, bool errorsOnly) {
 }
 
 bool PPCache::checkCacheIsValid_(const fs::path& cacheFileName,
-                                 const std::unique_ptr<uint8_t[]>& buffer) {
+                                 const Buffer& buffer) {
   if (buffer == nullptr) return false;
 
   CommandLineParser* clp = m_pp->getCompileSourceFile()->getCommandLineParser();
@@ -302,6 +307,12 @@ bool PPCache::restore(bool errorsOnly) {
   if (m_pp->isMacroBody()) return false;
 
   fs::path cacheFileName = getCacheFileName_();
+  // Kept by the compile server which found the file and its includes
+  // unchanged since the cache was validated
+  if (auto buffer =
+          openUpToDateInMemory(m_pp->getFileName(LINE1), cacheFileName)) {
+    return restore_(cacheFileName, buffer, errorsOnly);
+  }
   auto buffer = openFlatBuffers(cacheFileName);
   if (buffer == nullptr) return false;
 
@@ -309,6 +320,26 @@ bool PPCache::restore(bool errorsOnly) {
          restore_(cacheFileName, buffer, errorsOnly);
 }
 
+bool PPCache::getIncludedFiles(std::vector<fs::path>& files) {
+  bool cacheAllowed =
+      m_pp->getCompileSourceFile()->getCommandLineParser()->cacheAllowed();
+  if (!cacheAllowed) return false;
+  if (m_pp->isMacroBody()) return false;
+
+  auto buffer = openFlatBuffers(getCacheFileName_());
+  if ((buffer == nullptr) ||
+      !MACROCACHE::PPCacheBufferHasIdentifier(buffer.get())) {
+    return false;
+  }
+  const MACROCACHE::PPCache* ppcache = MACROCACHE::GetPPCache(buffer.get());
+  if (auto includes = ppcache->includes()) {
+    for (const auto* include : *includes) {
+      files.emplace_back(include->str());
+    }
+  }
+  return true;
+}
+
 bool PPCache::save() {
   bool cacheAllowed =
       m_pp->getCompileSourceFile()->getCommandLineParser()->cacheAllowed();
@@ -335,10 +366,17 @@ bool PPCache::save() {
   auto header = createHeader(builder, FlbSchemaVersion, origFileName);
 
   /* Cache the macro definitions */
-  const MacroStorage& macros = m_pp->getMacros();
+  // In name order, for the cache to not depend on the hashing.
+  std::vector<const MacroInfo*> macros;
+  macros.reserve(m_pp->getMacros().size());
+  for (const auto& [macroId, info] : m_pp->getMacros()) macros.push_back(info);
+  std::sort(macros.begin(), macros.end(),
+            [](const MacroInfo* lhs, const MacroInfo* rhs) {
+              return lhs->m_name < rhs->m_name;
+            });
   std::vector<flatbuffers::Offset<MACROCACHE::Macro>> macro_vec;
-  for (const auto& [macroName, info] : macros) {
-    auto name = builder.CreateString(macroName);
+  for (const MacroInfo* info : macros) {
+    auto name = builder.CreateString(info->m_name);
     MACROCACHE::MacroType type = (info->m_type == MacroInfo::WITH_ARGS)
                                      ? MACROCACHE::MacroType_WITH_ARGS
                                      : MACROCACHE::MacroType_NO_ARGS;
@@ -369,6 +407,12 @@ bool PPCache::save() {
     fs::path svFileName = m_pp->getSymbol(pp->getRawFileId());
     include_vec.push_back(svFileName.string());
   }
+  included.insert(m_pp);
+  for (PreprocessFile* pp : included) {
+    for (SymbolId fileId : pp->getMemoizedIncludes()) {
+      include_vec.push_back(m_pp->getSymbol(fileId));
+    }
+  }
   auto includeList = builder.CreateVectorOfStrings(include_vec);
 
   /* Cache the body of the file */
@@ -473,6 +517,11 @@ bool PPCache::save() {
 
   /* Save Flatbuffer */
   bool status = saveFlatbuffers(builder, cacheFileName);
+  if (!status) {
+    reportNotSaved(errorContainer,
+                   m_pp->getCompileSourceFile()->getSymbolTable(),
+                   cacheFileName);
+  }
 
   return status;
 }
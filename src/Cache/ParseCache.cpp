@@ -21,12 +21,14 @@
  * Created on April 29, 2017, 4:20 PM
  */
 
+#include <Surelog/Cache/CachePack.h>
 #include <Surelog/Cache/ParseCache.h>
 #include <Surelog/Cache/parser_generated.h>
 #include <Surelog/CommandLine/CommandLineParser.h>
 #include <Surelog/Design/Design.h>
 #include <Surelog/Design/DesignElement.h>
 #include <Surelog/Design/FileContent.h>
+#include <Surelog/ErrorReporting/ErrorContainer.h>
 #include <Surelog/Library/Library.h>
 #include <Surelog/Package/Precompiled.h>
 #include <Surelog/SourceCompile/CompileSourceFile.h>
@@ -34,6 +36,12 @@
 #include <Surelog/SourceCompile/ParseFile.h>
 #include <Surelog/SourceCompile/SymbolTable.h>
 #include <Surelog/Utils/FileUtils.h>
+#include <Surelog/Utils/StringUtils.h>
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <string_view>
 
 namespace SURELOG {
 namespace fs = std::filesystem;
@@ -41,7 +49,28 @@ namespace fs = std::filesystem;
 ParseCache::ParseCache(ParseFile* parser)
     : m_parse(parser), m_isPrecompiled(false) {}
 
-static constexpr char FlbSchemaVersion[] = "1.2";
+static constexpr char FlbSchemaVersion[] = "1.4";
+
+fs::path ParseCache::getChunkFileName_(const fs::path& chunk) {
+  const std::string content = FileUtils::getFileContent(chunk);
+  m_chunkNbLines = std::count(content.begin(), content.end(), '\n') + 1;
+  // <file>.ck<index> -> <file>.ck<content hash>
+  std::string name = chunk.string();
+  const size_t pos = name.rfind(".ck");
+  if (pos == std::string::npos) return chunk;
+  std::string key = content;
+  static constexpr std::string_view kSLline = "SLline ";
+  if (key.compare(0, kSLline.size(), kSLline) == 0) {
+    const size_t end = key.find_first_not_of("0123456789", kSLline.size());
+    if (end != std::string::npos) {
+      key.erase(kSLline.size(), end - kSLline.size());
+    }
+  }
+  char hash[24];
+  snprintf(hash, sizeof(hash), "%016" PRIx64, StringUtils::hash64(key));
+  name.replace(pos + 3, std::string::npos, hash);
+  return name;
+}
 
 // TODO(hzeller): this should come from a function cacheFileResolver() or
 // something that can be passed to the cache. That way, we can leave the
@@ -52,7 +81,10 @@ fs::path ParseCache::getCacheFileName_(const fs::path& svFileNameIn) {
       m_parse->getCompileSourceFile()->getCommandLineParser();
   Precompiled* prec = Precompiled::getSingleton();
   SymbolId cacheDirId = clp->getCacheDir();
-  if (svFileName.empty()) svFileName = m_parse->getPpFileName();
+  if (svFileName.empty()) {
+    svFileName = m_parse->getPpFileName();
+    if (m_parse->isChunk()) svFileName = getChunkFileName_(svFileName);
+  }
   fs::path baseFileName = FileUtils::basename(svFileName);
   fs::path cacheFileName;
   if (prec->isFilePrecompiled(baseFileName)) {
@@ -89,22 +121,48 @@ fs::path ParseCache::getCacheFileName_(const fs::path& svFileNameIn) {
     cacheFileName = cacheDirName / libName / (svFileName.string() + ".slpa");
   }
 
-  FileUtils::mkDirs(cacheDirName / libName);
+  if (clp->cachePack() && !m_isPrecompiled) {
+    usePack(CachePack::getPack(
+                CachePack::getPackFileName(cacheDirName, libName)),
+            cacheDirName);
+  } else {
+    usePack(nullptr, "");
+    FileUtils::mkDirs(cacheDirName / libName);
+  }
   return cacheFileName;
 }
 
 bool ParseCache::restore_(const fs::path& cacheFileName,
-                          const std::unique_ptr<uint8_t[]>& buffer) {
+                          const Buffer& buffer) {
   if (buffer == nullptr) return false;
 
   /* Restore Errors */
   const PARSECACHE::ParseCache* ppcache =
       PARSECACHE::GetParseCache(buffer.get());
 
-  SymbolTable cacheSymbols;
-  restoreErrors(ppcache->errors(), ppcache->symbols(), &cacheSymbols,
-                m_parse->getCompileSourceFile()->getErrorContainer(),
-                m_parse->getCompileSourceFile()->getSymbolTable());
+  SymbolTable* symbols = m_parse->getCompileSourceFile()->getSymbolTable();
+  const SymbolRemap remap = restoreSymbols(ppcache->symbols(), symbols);
+  // Lines of the file being parsed move with the chunk, lines of the files
+  // it includes do not.
+  const SymbolId movedFileId = m_parse->getRawFileId();
+  auto moveLine = [this, movedFileId](SymbolId fileId, unsigned int line) {
+    return (fileId == movedFileId) ? line + m_lineDelta : line;
+  };
+  ErrorContainer* errors = m_parse->getCompileSourceFile()->getErrorContainer();
+  if (m_lineDelta == 0) {
+    restoreErrors(ppcache->errors(), remap, errors);
+  } else {
+    ErrorContainer chunkErrors(symbols);
+    restoreErrors(ppcache->errors(), remap, &chunkErrors);
+    for (const Error& error : chunkErrors.getErrors()) {
+      std::vector<Location> locations = error.getLocations();
+      for (Location& loc : locations) {
+        loc.m_line = moveLine(loc.m_fileId, loc.m_line);
+      }
+      Error moved(error.getType(), locations);
+      errors->addError(moved, false);
+    }
+  }
 
   /* Restore design content (Verilog Design Elements) */
   FileContent* fileContent = m_parse->getFileContent();
@@ -119,24 +177,21 @@ bool ParseCache::restore_(const fs::path& cacheFileName,
         m_parse->getFileId(0), fileContent);
   }
   for (const auto* elemc : *ppcache->elements()) {
-    const std::string& elemName =
-        cacheSymbols.getSymbol(SymbolId(elemc->name(), "<unknown>"));
+    const SymbolId elemId = remapSymbol(remap, elemc->name());
+    const std::string& elemName = symbols->getSymbol(elemId);
+    const SymbolId elemFileId = remapSymbol(remap, elemc->file_id());
     DesignElement* elem = new DesignElement(
-        m_parse->getCompileSourceFile()->getSymbolTable()->registerSymbol(
-            elemName),
-        m_parse->getCompileSourceFile()->getSymbolTable()->registerSymbol(
-            cacheSymbols.getSymbol(SymbolId(elemc->file_id(), "<unknown>"))),
-        (DesignElement::ElemType)elemc->type(), NodeId(elemc->unique_id()),
-        elemc->line(), elemc->column(), elemc->end_line(), elemc->end_column(),
-        NodeId(elemc->parent()));
+        elemId, elemFileId, (DesignElement::ElemType)elemc->type(),
+        NodeId(elemc->unique_id()), moveLine(elemFileId, elemc->line()),
+        elemc->column(), moveLine(elemFileId, elemc->end_line()),
+        elemc->end_column(), NodeId(elemc->parent()));
     elem->m_node = NodeId(elemc->node());
     elem->m_defaultNetType = (VObjectType)elemc->default_net_type();
     elem->m_timeInfo.m_type = (TimeInfo::Type)elemc->time_info()->type();
     elem->m_timeInfo.m_fileId =
-        m_parse->getCompileSourceFile()->getSymbolTable()->registerSymbol(
-            cacheSymbols.getSymbol(
-                SymbolId(elemc->time_info()->file_id(), "<unknown>")));
-    elem->m_timeInfo.m_line = elemc->time_info()->line();
+        remapSymbol(remap, elemc->time_info()->file_id());
+    elem->m_timeInfo.m_line =
+        moveLine(elem->m_timeInfo.m_fileId, elemc->time_info()->line());
     elem->m_timeInfo.m_timeUnit =
         (TimeInfo::Unit)elemc->time_info()->time_unit();
     elem->m_timeInfo.m_timeUnitValue = elemc->time_info()->time_unit_value();
@@ -151,15 +206,22 @@ bool ParseCache::restore_(const fs::path& cacheFileName,
 
   /* Restore design objects */
   auto objects = ppcache->objects();
-  restoreVObjects(objects, cacheSymbols,
-                  m_parse->getCompileSourceFile()->getSymbolTable(),
-                  m_parse->getFileId(0), fileContent);
+  restoreVObjects(objects, remap, m_parse->getFileId(0), fileContent);
+  if (m_lineDelta != 0) {
+    VObjectStore* objects = fileContent->mutableVObjects();
+    for (NodeId id(0); id < objects->size(); ++id) {
+      const SymbolId objectFileId = objects->fileId(id);
+      const unsigned int endLine = objects->endLine(id);
+      objects->setLine(id, moveLine(objectFileId, objects->line(id)));
+      objects->setEndLine(id, moveLine(objectFileId, endLine));
+    }
+  }
 
   return true;
 }
 
 bool ParseCache::checkCacheIsValid_(const fs::path& cacheFileName,
-                                    const std::unique_ptr<uint8_t[]>& buffer) {
+                                    const Buffer& buffer) {
   if (buffer == nullptr) return false;
 
   CommandLineParser* clp =
@@ -169,15 +231,31 @@ bool ParseCache::checkCacheIsValid_(const fs::path& cacheFileName,
     return false;
   }
 
+  const PARSECACHE::ParseCache* ppcache =
+      PARSECACHE::GetParseCache(buffer.get());
+  if (m_parse->isChunk()) {
+    // Same content, possibly elsewhere in the file: usable if its lines map
+    // the same way, shifted.
+    unsigned int firstLine = 0;
+    if (m_parse->getLineMapSignature(m_chunkNbLines, &firstLine) !=
+        ppcache->line_map()) {
+      return false;
+    }
+    m_lineDelta = (int)firstLine - (int)ppcache->line_base();
+  }
+
   if (clp->noCacheHash()) {
     return true;
   }
 
-  const PARSECACHE::ParseCache* ppcache =
-      PARSECACHE::GetParseCache(buffer.get());
+  // The header of a chunk cache describes the <file>.ck<index> file it was
+  // saved from, which may hold another chunk by now. The content it was
+  // parsed from is the one hashed in the cache file name, only the versions
+  // are left to check.
   auto header = ppcache->header();
   if (!m_isPrecompiled &&
-      !checkIfCacheIsValid(header, FlbSchemaVersion, cacheFileName)) {
+      !checkIfCacheIsValid(header, FlbSchemaVersion,
+                           m_parse->isChunk() ? fs::path() : cacheFileName)) {
     return false;
   }
 
@@ -291,12 +369,23 @@ bool ParseCache::save() {
 
   auto symbolVec = createSymbolCache(builder, cacheSymbols);
   /* Create Flatbuffers */
-  auto ppcache = PARSECACHE::CreateParseCache(
-      builder, header, errorCache, symbolVec, elementList, objectList);
+  unsigned int lineBase = 0;
+  uint64_t lineMap = 0;
+  if (m_parse->isChunk()) {
+    lineMap = m_parse->getLineMapSignature(m_chunkNbLines, &lineBase);
+  }
+  auto ppcache =
+      PARSECACHE::CreateParseCache(builder, header, errorCache, symbolVec,
+                                   elementList, objectList, lineBase, lineMap);
   FinishParseCacheBuffer(builder, ppcache);
 
   /* Save Flatbuffer */
   bool status = saveFlatbuffers(builder, cacheFileName);
+  if (!status) {
+    reportNotSaved(errorContainer,
+                   m_parse->getCompileSourceFile()->getSymbolTable(),
+                   cacheFileName);
+  }
 
   return status;
 }
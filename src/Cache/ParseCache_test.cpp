@@ -0,0 +1,127 @@
+/*
+ Copyright 2022 The Surelog Team.
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+*/
+
+#include <Surelog/API/Surelog.h>
+#include <Surelog/CommandLine/CommandLineParser.h>
+#include <Surelog/Design/Design.h>
+#include <Surelog/Design/DesignElement.h>
+#include <Surelog/Design/FileContent.h>
+#include <Surelog/ErrorReporting/ErrorContainer.h>
+#include <Surelog/SourceCompile/SymbolTable.h>
+#include <Surelog/Utils/FileUtils.h>
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <string>
+
+namespace SURELOG {
+namespace fs = std::filesystem;
+
+namespace {
+std::string moduleText(int index) {
+  const std::string name = "m" + std::to_string(index);
+  return "module " + name + "(input a, output b);\n" +
+         "  assign b = a;\n" + "endmodule\n";
+}
+
+void writeFile(const fs::path& fileName, const std::string& content) {
+  std::ofstream ofs(fileName);
+  ofs << content;
+}
+
+// Parses "source" split in one chunk per module, returns the line of each
+// module.
+std::map<std::string, unsigned int> parse(const fs::path& source,
+                                          const fs::path& outputDir) {
+  SymbolTable symbols;
+  ErrorContainer errors(&symbols);
+  CommandLineParser clp(&errors, &symbols, false, false);
+  clp.noPython();
+  const std::string sourceName = source.string();
+  const std::string outputDirName = outputDir.string();
+  const char* argv[] = {"surelog",  "-parse", "-nobuiltin", "-nouhdm",
+                        "-nostdout", "-mt",    "2",          "-split",
+                        "10",        "-o",     outputDirName.c_str(),
+                        sourceName.c_str()};
+  EXPECT_TRUE(clp.parseCommandLine(sizeof(argv) / sizeof(argv[0]), argv));
+
+  std::map<std::string, unsigned int> lines;
+  scompiler* compiler = start_compiler(&clp);
+  Design* design = get_design(compiler);
+  for (const auto& [fileId, fC] : design->getAllFileContents()) {
+    for (const DesignElement* elem : fC->getDesignElements()) {
+      std::string name = fC->getSymbolTable()->getSymbol(elem->m_name);
+      name = name.substr(name.rfind('@') + 1);
+      lines[name] = elem->m_line;
+    }
+  }
+  shutdown_compiler(compiler);
+  return lines;
+}
+
+// Content of the chunk parse caches, by file name.
+std::map<std::string, std::string> chunkCaches(const fs::path& outputDir) {
+  std::map<std::string, std::string> caches;
+  for (const auto& entry : fs::recursive_directory_iterator(outputDir)) {
+    const fs::path& path = entry.path();
+    if ((path.extension() == ".slpa") &&
+        (path.filename().string().find(".ck") != std::string::npos)) {
+      caches[path.filename().string()] = FileUtils::getFileContent(path);
+    }
+  }
+  return caches;
+}
+
+TEST(ParseCacheTest, MovedChunksAreReused) {
+  const fs::path dir = fs::temp_directory_path() / "surelog-parsecache-test";
+  const fs::path source = dir / "top.sv";
+  const fs::path outputDir = dir / "out";
+  fs::remove_all(dir);
+  fs::create_directories(dir);
+
+  std::string text;
+  for (int i = 1; i <= 4; i++) text += moduleText(i);
+  writeFile(source, text);
+  std::map<std::string, unsigned int> lines = parse(source, outputDir);
+  EXPECT_EQ(lines["m3"], 7);
+  const std::map<std::string, std::string> before = chunkCaches(outputDir);
+  ASSERT_EQ(before.size(), 4);
+
+  // Moves the other modules 3 lines down
+  writeFile(source, moduleText(0) + text);
+  lines = parse(source, outputDir);
+  const std::map<std::string, std::string> after = chunkCaches(outputDir);
+
+  // Only the new chunk was parsed and cached, the others were restored from
+  // their caches (a chunk parsed again would have been saved with its new
+  // first line)
+  EXPECT_EQ(after.size(), before.size() + 1);
+  for (const auto& [name, content] : before) {
+    auto itr = after.find(name);
+    ASSERT_NE(itr, after.end());
+    EXPECT_EQ(itr->second, content);
+  }
+  // With their new lines
+  for (int i = 0; i <= 4; i++) {
+    EXPECT_EQ(lines["m" + std::to_string(i)], 1 + 3 * i);
+  }
+
+  fs::remove_all(dir);
+}
+}  // namespace
+}  // namespace SURELOG
@@ -75,10 +75,11 @@ bool PythonAPICache::restore_(const std::filesystem::path& cacheFileName) {
 
   const PYTHONAPICACHE::PythonAPICache* ppcache =
       PYTHONAPICACHE::GetPythonAPICache(buffer.get());
-  SymbolTable canonicalSymbols;
-  restoreErrors(ppcache->m_errors(), ppcache->m_symbols(), &canonicalSymbols,
-                m_listener->getCompileSourceFile()->getErrorContainer(),
-                m_listener->getCompileSourceFile()->getSymbolTable());
+  const SymbolRemap remap =
+      restoreSymbols(ppcache->m_symbols(),
+                     m_listener->getCompileSourceFile()->getSymbolTable());
+  restoreErrors(ppcache->m_errors(), remap,
+                m_listener->getCompileSourceFile()->getErrorContainer());
 
   return true;
 }
@@ -169,6 +170,11 @@ bool PythonAPICache::save() {
 
   /* Save Flatbuffer */
   bool status = saveFlatbuffers(builder, cacheFileName.string());
+  if (!status) {
+    reportNotSaved(errorContainer,
+                   m_listener->getCompileSourceFile()->getSymbolTable(),
+                   cacheFileName);
+  }
 
   return status;
 }
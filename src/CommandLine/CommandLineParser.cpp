@@ -22,6 +22,7 @@
  */
 
 #include <Surelog/API/PythonAPI.h>
+#include <Surelog/Cache/CachePack.h>
 #include <Surelog/CommandLine/CommandLineParser.h>
 #include <Surelog/ErrorReporting/ErrorContainer.h>
 #include <Surelog/SourceCompile/SymbolTable.h>
@@ -139,6 +140,13 @@ static const std::initializer_list<std::string_view> helpText = {
     "mode",
     "                        Tests are expressed as one full command line per "
     "line.",
+    "  -server               Compile server, reads one full command line per "
+    "line",
+    "                        on stdin and answers each with its output followed "
+    "by",
+    "                        \"@@SURELOG_DONE <code>\". Caches stay in memory "
+    "between",
+    "                        requests, only changed files are re-processed.",
     "  --enable-feature=<feature>",
     "  --disable-feature=<feature>",
     "    Features: parametersubstitution Enables substitution of assignment "
@@ -160,13 +168,22 @@ static const std::initializer_list<std::string_view> helpText = {
     "single "
     "threaded,",
     "                        if \"max\" is given, the program will use one ",
-    "                        thread per core on the host",
+    "                        thread per core on the host. Used by the",
+    "                        preprocessing and parsing stages, the design",
+    "                        compilation and the elaboration are single",
+    "                        threaded",
     "  -mp <mb_max_process>  0 up to 512 max processes, 0 or 1 being single "
     "process",
     "  -lowmem               Minimizes memory high water mark (uses multiple "
     "staggered processes for preproc, parsing and elaboration)",
     "  -split <line number>  Split files or modules larger than specified line "
     "number for multi thread compilation",
+    "  -typeindex            Indexes the parse tree nodes by type to speed "
+    "up the compilation queries (uses more memory)",
+    "  -noplainmacro         Expands all the macro bodies with the "
+    "preprocessor grammar, not only the ones that are not a plain copy",
+    "  -noincludememo        Preprocesses every include, even the ones "
+    "already seen with the same macros or behind their include guard",
     "  -timescale=<timescale> Specifies the overall timescale",
     "  -nobuiltin            Do not parse SV builtin classes (array...)",
     "",
@@ -196,6 +213,14 @@ static const std::initializer_list<std::string_view> helpText = {
     "slpp_all/cache or slpp_unit/cache",
     "  -nohash               Don't use hash mechanism for cache file path, "
     "always treat cache as valid (no timestamp/dependancy check)",
+    "  -cachepack            Stores the caches of each library in a single "
+    "packed file (.slpack)",
+    "  -compactcache         Compacts the packed cache files, dropping stale "
+    "entries",
+    "  -dfacache             Saves the parsers' prediction state (DFA) in the "
+    "cache directory and preloads it on the next run",
+    "  -dfacachemax <n>      Maximum number of DFA states saved by -dfacache, "
+    "default 200000",
     "  -createcache          Create cache for precompiled packages",
     "  -filterdirectives     Filters out simple directives like",
     "                        `default_nettype in pre-processor's output",
@@ -360,8 +385,15 @@ CommandLineParser::CommandLineParser(ErrorContainer* errors,
       m_writeUhdm(true),
       m_nonSynthesizable(false),
       m_noCacheHash(false),
+      m_cachePack(false),
+      m_compactCachePack(false),
+      m_dfaCache(false),
+      m_dfaCacheMaxStates(200000),
+      m_typeIndex(false),
       m_sepComp(false),
-      m_link(false) {
+      m_link(false),
+      m_plainMacros(true),
+      m_includeMemo(true) {
   m_errors->registerCmdLine(this);
   m_logFileId = m_symbolTable->registerSymbol(defaultLogFileName);
   m_compileUnitDirectory =
@@ -969,6 +1001,26 @@ bool CommandLineParser::parseCommandLine(int argc, const char** argv) {
           FileUtils::getPreferredPath(all_arguments[i]).string());
     } else if (all_arguments[i] == "-nohash") {
       m_noCacheHash = true;
+    } else if (all_arguments[i] == "-noplainmacro") {
+      m_plainMacros = false;
+    } else if (all_arguments[i] == "-noincludememo") {
+      m_includeMemo = false;
+    } else if (all_arguments[i] == "-cachepack") {
+      m_cachePack = true;
+    } else if (all_arguments[i] == "-compactcache") {
+      m_compactCachePack = true;
+    } else if (all_arguments[i] == "-dfacache") {
+      m_dfaCache = true;
+    } else if (all_arguments[i] == "-dfacachemax") {
+      if (i == all_arguments.size() - 1) {
+        Location loc(mutableSymbolTable()->registerSymbol(all_arguments[i]));
+        Error err(ErrorDefinition::CMD_DFA_CACHE_MISSING_SIZE, loc);
+        m_errors->addError(err);
+        break;
+      }
+      i++;
+      m_dfaCache = true;
+      m_dfaCacheMaxStates = std::stoi(all_arguments[i]);
     } else if (all_arguments[i] == "-cache") {
       if (i == all_arguments.size() - 1) {
         Location loc(mutableSymbolTable()->registerSymbol(all_arguments[i]));
@@ -993,6 +1045,8 @@ bool CommandLineParser::parseCommandLine(int argc, const char** argv) {
       m_nonSynthesizable = true;
     } else if (all_arguments[i] == "-profile") {
       m_profile = true;
+    } else if (all_arguments[i] == "-typeindex") {
+      m_typeIndex = true;
     } else if (all_arguments[i] == "-nobuiltin") {
       m_parseBuiltIn = false;
     } else if (all_arguments[i] == "-outputlineinfo") {
@@ -1302,6 +1356,10 @@ bool CommandLineParser::setupCache_() {
       m_errors->addError(err);
       noError = false;
     }
+    if (m_compactCachePack && !CachePack::compactAll(cachedir)) {
+      std::cerr << "ERROR: Cannot compact the cache packs in " << cachedir
+                << std::endl;
+    }
   } else {
     FileUtils::rmDirRecursively(cachedir);
   }
@@ -0,0 +1,89 @@
+/*
+ Copyright 2022 The Surelog Team.
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+*/
+
+#include <Surelog/Common/FlatNameMap.h>
+#include <gtest/gtest.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+namespace SURELOG {
+
+namespace {
+TEST(FlatNameMapTest, FindEmplaceErase) {
+  FlatNameMap<int> map;
+  EXPECT_TRUE(map.empty());
+  EXPECT_EQ(map.find("A"), map.end());
+
+  EXPECT_TRUE(map.emplace("WIDTH", 8).second);
+  EXPECT_TRUE(map.emplace("DEPTH", 16).second);
+  const auto [existing, inserted] = map.emplace("WIDTH", 32);
+  EXPECT_FALSE(inserted);
+  EXPECT_EQ(existing->second, 8);
+  EXPECT_EQ(map.size(), 2);
+
+  std::string_view name = "DEPTH";
+  ASSERT_NE(map.find(name), map.end());
+  EXPECT_EQ(map.find(name)->second, 16);
+  EXPECT_EQ(map.find("DEP"), map.end());
+  EXPECT_EQ(map.find("DEPTH_"), map.end());
+
+  map.find("WIDTH")->second = 4;
+  EXPECT_EQ(map.find("WIDTH")->second, 4);
+
+  map.erase(map.find("DEPTH"));
+  EXPECT_EQ(map.find("DEPTH"), map.end());
+  EXPECT_EQ(map.size(), 1);
+  map.clear();
+  EXPECT_TRUE(map.empty());
+}
+
+TEST(FlatNameMapTest, SameOrderAsMap) {
+  const std::vector<std::string> names = {"b", "a", "B", "ab", "", "a_1",
+                                          "A", "b", "aa", "a0", "ba"};
+  FlatNameMap<int> flat;
+  std::map<std::string, int> reference;
+  for (size_t i = 0; i < names.size(); i++) {
+    flat.emplace(names[i], i);
+    reference.emplace(names[i], i);
+  }
+  ASSERT_EQ(flat.size(), reference.size());
+  auto it = flat.begin();
+  for (const auto& [name, value] : reference) {
+    EXPECT_EQ(it->first, name);
+    EXPECT_EQ(it->second, value);
+    ++it;
+  }
+}
+
+TEST(FlatNameMapTest, LargeMap) {
+  FlatNameMap<int> map;
+  for (int i = 99; i >= 0; i--) {
+    map.emplace("P" + std::to_string(i), i);
+  }
+  for (int i = 0; i < 100; i++) {
+    const std::string name = "P" + std::to_string(i);
+    ASSERT_NE(map.find(name), map.end()) << name;
+    EXPECT_EQ(map.find(name, FlatNameMap<int>::hash(name))->second, i);
+  }
+  EXPECT_EQ(map.find("P100"), map.end());
+  map.erase(map.find("P50"));
+  EXPECT_EQ(map.find("P50"), map.end());
+  EXPECT_EQ(map.find("P51")->second, 51);
+}
+}  // namespace
+}  // namespace SURELOG
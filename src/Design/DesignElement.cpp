@@ -36,8 +36,7 @@ DesignElement::DesignElement(SymbolId name, SymbolId fileId, ElemType type,
       m_column(column),
       m_endLine(endLine),
       m_endColumn(endColumn),
-      m_parent(parent),
-      m_context(nullptr) {}
+      m_parent(parent) {}
 
 std::ostream& operator<<(std::ostream& os, DesignElement::ElemType type) {
   switch (type) {
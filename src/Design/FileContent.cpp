@@ -68,19 +68,19 @@ std::filesystem::path FileContent::getFileName() const {
 }
 
 NodeId FileContent::getRootNode() const {
-  return m_objects.empty() ? InvalidNodeId : m_objects[1].m_sibling;
+  return m_objects.empty() ? InvalidNodeId : m_objects.sibling(NodeId(1));
 }
 
 SymbolId FileContent::getFileId(NodeId id) const {
-  return m_objects[id].m_fileId;
+  return m_objects.fileId(id);
 }
 
-SymbolId* FileContent::getMutableFileId(NodeId id) {
-  return &m_objects[id].m_fileId;
+void FileContent::setFileId(NodeId id, SymbolId fileId) {
+  m_objects.setFileId(id, fileId);
 }
 
 std::filesystem::path FileContent::getFileName(NodeId id) const {
-  SymbolId fileId = m_objects[id].m_fileId;
+  SymbolId fileId = m_objects.fileId(id);
   return m_symbolTable->getSymbol(fileId);
 }
 
@@ -91,11 +91,10 @@ std::string FileContent::printObjects() const {
   if (m_library) text += "LIB:  " + m_library->getName() + "\n";
   const std::filesystem::path fileName = m_symbolTable->getSymbol(m_fileId);
   text += "FILE: " + fileName.string() + "\n";
-  for (auto& object : m_objects) {
-    text +=
-        object.print(m_symbolTable, index, GetDefinitionFile(index), m_fileId);
+  for (; index < m_objects.size(); index++) {
+    text += m_objects[index].print(m_symbolTable, index,
+                                   GetDefinitionFile(index), m_fileId);
     text += "\n";
-    index++;
   }
   return text;
 }
@@ -190,14 +189,14 @@ std::vector<std::string> FileContent::collectSubTree(NodeId index) const {
   text.push_back(m_objects[index].print(m_symbolTable, index,
                                         GetDefinitionFile(index), m_fileId));
 
-  if (m_objects[index].m_child) {
-    for (const auto& s : collectSubTree(m_objects[index].m_child)) {
+  if (m_objects.child(index)) {
+    for (const auto& s : collectSubTree(m_objects.child(index))) {
       text.push_back("    " + s);
     }
   }
 
-  if (m_objects[index].m_sibling) {
-    for (const auto& s : collectSubTree(m_objects[index].m_sibling)) {
+  if (m_objects.sibling(index)) {
+    for (const auto& s : collectSubTree(m_objects.sibling(index))) {
       text.push_back(s);
     }
   }
@@ -222,33 +221,27 @@ NodeId FileContent::addObject(SymbolId name, SymbolId fileId, VObjectType type,
                               NodeId child /* = InvalidNodeId */,
                               NodeId sibling /* = InvalidNodeId */) {
   RawNodeId index = m_objects.size();
+  m_typeIndex.reset();
   m_objects.emplace_back(name, fileId, type, line, column, endLine, endColumn,
                          parent, definition, child, sibling);
   return NodeId(index);
 }
 
-const VObject& FileContent::Object(NodeId index) const {
-  if (!index) return m_objects[0];
+bool FileContent::checkIndex_(NodeId index) const {
+  if (!index) return false;
   if (index >= m_objects.size()) {
     Location loc(m_fileId);
     Error err(ErrorDefinition::COMP_INTERNAL_ERROR_OUT_OF_BOUND, loc);
     m_errors->addError(err);
     std::cerr << "\nINTERNAL OUT OF BOUND ERROR\n\n";
-    return m_objects[0];
+    return false;
   }
-  return m_objects[index];
+  return true;
 }
 
-VObject* FileContent::MutableObject(NodeId index) {
-  if (!index) return &m_objects[0];
-  if (index >= m_objects.size()) {
-    Location loc(m_fileId);
-    Error err(ErrorDefinition::COMP_INTERNAL_ERROR_OUT_OF_BOUND, loc);
-    m_errors->addError(err);
-    std::cerr << "\nINTERNAL OUT OF BOUND ERROR\n\n";
-    return &m_objects[0];
-  }
-  return &m_objects[index];
+VObject FileContent::Object(NodeId index) const {
+  if (!checkIndex_(index)) return m_objects[NodeId(0)];
+  return m_objects[index];
 }
 
 NodeId FileContent::UniqueId(NodeId index) const {
@@ -272,7 +265,7 @@ SymbolId FileContent::Name(NodeId index) const {
     std::cerr << "\nINTERNAL OUT OF BOUND ERROR\n\n";
     return BadSymbolId;
   }
-  return m_objects[index].m_name;
+  return m_objects.name(index);
 }
 
 NodeId FileContent::Child(NodeId index) const {
@@ -284,7 +277,7 @@ NodeId FileContent::Child(NodeId index) const {
     std::cerr << "\nINTERNAL OUT OF BOUND ERROR\n\n";
     return InvalidNodeId;
   }
-  return m_objects[index].m_child;
+  return m_objects.child(index);
 }
 
 NodeId FileContent::Sibling(NodeId index) const {
@@ -296,7 +289,7 @@ NodeId FileContent::Sibling(NodeId index) const {
     std::cout << "\nINTERNAL OUT OF BOUND ERROR\n\n";
     return InvalidNodeId;
   }
-  return m_objects[index].m_sibling;
+  return m_objects.sibling(index);
 }
 
 NodeId FileContent::Definition(NodeId index) const {
@@ -308,7 +301,11 @@ NodeId FileContent::Definition(NodeId index) const {
     std::cerr << "\nINTERNAL OUT OF BOUND ERROR\n\n";
     return InvalidNodeId;
   }
-  return m_objects[index].m_definition;
+  return m_objects.definition(index);
+}
+
+void FileContent::SetDefinition(NodeId index, NodeId def) {
+  if (checkIndex_(index)) m_objects.setDefinition(index, def);
 }
 
 NodeId FileContent::Parent(NodeId index) const {
@@ -320,7 +317,25 @@ NodeId FileContent::Parent(NodeId index) const {
     std::cerr << "\nINTERNAL OUT OF BOUND ERROR\n\n";
     return InvalidNodeId;
   }
-  return m_objects[index].m_parent;
+  return m_objects.parent(index);
+}
+
+void FileContent::SetParent(NodeId index, NodeId parent) {
+  if (!checkIndex_(index)) return;
+  m_objects.setParent(index, parent);
+  m_typeIndex.reset();
+}
+
+void FileContent::SetChild(NodeId index, NodeId child) {
+  if (!checkIndex_(index)) return;
+  m_objects.setChild(index, child);
+  m_typeIndex.reset();
+}
+
+void FileContent::SetSibling(NodeId index, NodeId sibling) {
+  if (!checkIndex_(index)) return;
+  m_objects.setSibling(index, sibling);
+  m_typeIndex.reset();
 }
 
 VObjectType FileContent::Type(NodeId index) const {
@@ -332,7 +347,13 @@ VObjectType FileContent::Type(NodeId index) const {
     std::cerr << "\nINTERNAL OUT OF BOUND ERROR\n\n";
     return sl_INVALID_;
   }
-  return (VObjectType)m_objects[index].m_type;
+  return m_objects.type(index);
+}
+
+void FileContent::SetType(NodeId index, VObjectType type) {
+  if (!checkIndex_(index)) return;
+  m_objects.setType(index, type);
+  m_typeIndex.reset();
 }
 
 unsigned int FileContent::Line(NodeId index) const {
@@ -344,7 +365,11 @@ unsigned int FileContent::Line(NodeId index) const {
     std::cerr << "\nINTERNAL OUT OF BOUND ERROR\n\n";
     return 0;
   }
-  return m_objects[index].m_line;
+  return m_objects.line(index);
+}
+
+void FileContent::SetLine(NodeId index, unsigned int line) {
+  if (checkIndex_(index)) m_objects.setLine(index, line);
 }
 
 unsigned short FileContent::Column(NodeId index) const {
@@ -356,7 +381,7 @@ unsigned short FileContent::Column(NodeId index) const {
     std::cerr << "\nINTERNAL OUT OF BOUND ERROR\n\n";
     return 0;
   }
-  return m_objects[index].m_column;
+  return m_objects.column(index);
 }
 
 unsigned int FileContent::EndLine(NodeId index) const {
@@ -368,7 +393,7 @@ unsigned int FileContent::EndLine(NodeId index) const {
     std::cerr << "\nINTERNAL OUT OF BOUND ERROR\n\n";
     return 0;
   }
-  return m_objects[index].m_endLine;
+  return m_objects.endLine(index);
 }
 
 unsigned short FileContent::EndColumn(NodeId index) const {
@@ -380,22 +405,20 @@ unsigned short FileContent::EndColumn(NodeId index) const {
     std::cerr << "\nINTERNAL OUT OF BOUND ERROR\n\n";
     return 0;
   }
-  return m_objects[index].m_endColumn;
+  return m_objects.endColumn(index);
 }
 
 NodeId FileContent::sl_get(NodeId parent, VObjectType type) const {
   if (!parent) return InvalidNodeId;
   if (m_objects.empty()) return InvalidNodeId;
   if (parent >= m_objects.size()) return InvalidNodeId;
-  const VObject& current = Object(parent);
-  if (current.m_type == type) return parent;
-  NodeId id = current.m_child;
+  if (m_objects.type(parent) == type) return parent;
+  NodeId id = m_objects.child(parent);
   while (id) {
-    const VObject& current = Object(id);
-    if (current.m_type == type) {
+    if (m_objects.type(id) == type) {
       return id;
     }
-    id = current.m_sibling;
+    id = m_objects.sibling(id);
   }
   return InvalidNodeId;
 }
@@ -408,12 +431,12 @@ NodeId FileContent::sl_parent(NodeId parent,
   if (parent >= m_objects.size()) return InvalidNodeId;
   NodeId id = parent;
   while (id) {
-    const VObject& current = Object(id);
-    if (types.find(current.m_type) != types.end()) {
-      actualType = current.m_type;
+    const VObjectType type = m_objects.type(id);
+    if (types.find(type) != types.end()) {
+      actualType = type;
       return id;
     }
-    id = current.m_parent;
+    id = m_objects.parent(id);
   }
   return InvalidNodeId;
 }
@@ -424,11 +447,10 @@ NodeId FileContent::sl_parent(NodeId parent, VObjectType type) const {
   if (parent >= m_objects.size()) return InvalidNodeId;
   NodeId id = parent;
   while (id) {
-    const VObject& current = Object(id);
-    if (current.m_type == type) {
+    if (m_objects.type(id) == type) {
       return id;
     }
-    id = current.m_parent;
+    id = m_objects.parent(id);
   }
   return InvalidNodeId;
 }
@@ -439,15 +461,13 @@ std::vector<NodeId> FileContent::sl_get_all(NodeId parent,
   if (!parent) return objects;
   if (m_objects.empty()) return objects;
   if (parent >= m_objects.size()) return objects;
-  const VObject& current = Object(parent);
-  if (current.m_type == type) objects.push_back(parent);
-  NodeId id = current.m_child;
+  if (m_objects.type(parent) == type) objects.push_back(parent);
+  NodeId id = m_objects.child(parent);
   while (id) {
-    const VObject& current = Object(id);
-    if (current.m_type == type) {
+    if (m_objects.type(id) == type) {
       objects.push_back(id);
     }
-    id = current.m_sibling;
+    id = m_objects.sibling(id);
   }
   return objects;
 }
@@ -458,18 +478,16 @@ std::vector<NodeId> FileContent::sl_get_all(
   if (!parent) return objects;
   if (m_objects.empty()) return objects;
   if (parent >= m_objects.size()) return objects;
-  const VObject& current = Object(parent);
-  if (types.find(current.m_type) != types.end()) {
+  if (types.find(m_objects.type(parent)) != types.end()) {
     objects.push_back(parent);
   }
 
-  NodeId id = current.m_child;
+  NodeId id = m_objects.child(parent);
   while (id) {
-    const VObject& current = Object(id);
-    if (types.find(current.m_type) != types.end()) {
+    if (types.find(m_objects.type(id)) != types.end()) {
       objects.push_back(id);
     }
-    id = current.m_sibling;
+    id = m_objects.sibling(id);
   }
   return objects;
 }
@@ -478,18 +496,27 @@ NodeId FileContent::sl_collect(NodeId parent, VObjectType type) const {
   if (!parent) return InvalidNodeId;
   if (m_objects.empty()) return InvalidNodeId;
   if (parent >= m_objects.size()) return InvalidNodeId;
-  const VObject& current = Object(parent);
-  if (current.m_type == type) return parent;
-  NodeId id = current.m_child;
+  if (m_objects.type(parent) == type) return parent;
+  if (m_typeIndex && m_typeIndex->isIndexed(parent)) {
+    // The recursion below returns the first descendant in preorder. The
+    // walk stack is free scratch space for the result.
+    std::vector<NodeId>& objects = walkStack_();
+    const size_t base = objects.size();
+    m_typeIndex->collect(parent, type, true, objects);
+    const NodeId found =
+        (objects.size() > base) ? objects.back() : InvalidNodeId;
+    objects.resize(base);
+    return found;
+  }
+  NodeId id = m_objects.child(parent);
   while (id) {
     NodeId idsub = sl_collect(id, type);
     if (idsub) return idsub;
 
-    const VObject& current = Object(id);
-    if (current.m_type == type) {
+    if (m_objects.type(id) == type) {
       return id;
     }
-    id = current.m_sibling;
+    id = m_objects.sibling(id);
   }
   return InvalidNodeId;
 }
@@ -497,124 +524,102 @@ NodeId FileContent::sl_collect(NodeId parent, VObjectType type) const {
 std::vector<NodeId> FileContent::sl_collect_all(NodeId parent, VObjectType type,
                                                 bool first) const {
   std::vector<NodeId> objects;
-  if (!parent) return objects;
-  if (m_objects.empty()) return objects;
-  if (parent >= m_objects.size()) return objects;
-  const VObject& current = Object(parent);
-  NodeId id = current.m_child;
-  if (!id) id = current.m_sibling;
-  if (!id) return objects;
-  std::stack<NodeId> stack;
-  stack.push(id);
-  while (!stack.empty()) {
-    id = stack.top();
-    stack.pop();
-    const VObject& current = Object(id);
-    if (current.m_type == type) {
-      objects.push_back(id);
-      if (first) return objects;
-    }
-    if (current.m_sibling) stack.push(current.m_sibling);
-    if (current.m_child) stack.push(current.m_child);
-  }
+  sl_collect_all(parent, type, objects, first);
   return objects;
 }
 
 std::vector<NodeId> FileContent::sl_collect_all(
     NodeId parent, const VObjectTypeUnorderedSet& types, bool first) const {
   std::vector<NodeId> objects;
-  if (!parent) return objects;
-  if (m_objects.empty()) return objects;
-  if (parent >= m_objects.size()) return objects;
-  const VObject& current = Object(parent);
-  NodeId id = current.m_child;
-  if (!id) id = current.m_sibling;
-  if (!id) return objects;
-  std::stack<NodeId> stack;
-  stack.push(id);
-  while (!stack.empty()) {
-    id = stack.top();
-    stack.pop();
-    const VObject& current = Object(id);
-    // std::cout << "COLLECT:" << current.print (m_symbolTable, id,
-    // GetDefinitionFile(id)) << std::endl;
-    if (types.find(current.m_type) != types.end()) {
-      objects.push_back(id);
-      if (first) return objects;
-    }
-    if (current.m_sibling) stack.push(current.m_sibling);
-    if (current.m_child) stack.push(current.m_child);
-  }
+  sl_collect_all(parent, VObjectTypeBitset(types), objects, first);
   return objects;
 }
 
 NodeId FileContent::sl_collect(NodeId parent, VObjectType type,
                                VObjectType stopPoint) const {
-  if (!parent) return InvalidNodeId;
-  if (m_objects.empty()) return InvalidNodeId;
-  if (parent >= m_objects.size()) return InvalidNodeId;
-  const VObject& current = Object(parent);
-  NodeId id = current.m_child;
-  if (!id) id = current.m_sibling;
-  if (!id) return InvalidNodeId;
-  std::stack<NodeId> stack;
-  stack.push(id);
-  while (!stack.empty()) {
-    id = stack.top();
-    stack.pop();
-    const VObject& current = Object(id);
-    if (current.m_type == type) return id;
-    if (current.m_sibling) stack.push(current.m_sibling);
-    if (current.m_child && (stopPoint != current.m_type)) {
-      stack.push(current.m_child);
-    }
-  }
-  return InvalidNodeId;
+  NodeId found;
+  walk_(
+      parent, [type](VObjectType current) { return current == type; },
+      [stopPoint](VObjectType current) { return current == stopPoint; },
+      [&found](NodeId id) {
+        found = id;
+        return false;
+      });
+  return found;
 }
 
 std::vector<NodeId> FileContent::sl_collect_all(
     NodeId parent, const VObjectTypeUnorderedSet& types,
     const VObjectTypeUnorderedSet& stopPoints, bool first) const {
   std::vector<NodeId> objects;
-  if (!parent) return objects;
-  if (m_objects.empty()) return objects;
-  if (parent >= m_objects.size()) return objects;
-  const VObject& current = Object(parent);
-  NodeId id = current.m_child;
-  if (!id) id = current.m_sibling;
-  if (!id) return objects;
-  std::stack<NodeId> stack;
-  stack.push(id);
-  while (!stack.empty()) {
-    id = stack.top();
-    stack.pop();
-    const VObject& current = Object(id);
-    // std::cout << "COLLECT:" << current.print (m_symbolTable, id,
-    // GetDefinitionFile(id)) << std::endl;
-    if (types.find(current.m_type) != types.end()) {
-      objects.push_back(id);
-      if (first) return objects;
-    }
-    if (current.m_sibling) stack.push(current.m_sibling);
-    if (current.m_child &&
-        (stopPoints.find(current.m_type) == stopPoints.end())) {
-      stack.push(current.m_child);
-    }
-  }
+  sl_collect_all(parent, VObjectTypeBitset(types),
+                 VObjectTypeBitset(stopPoints), objects, first);
   return objects;
 }
 
+void FileContent::sl_collect_all(NodeId parent, VObjectType type,
+                                 std::vector<NodeId>& objects,
+                                 bool first) const {
+  if (m_typeIndex && parent && (parent < m_objects.size()) &&
+      m_objects.child(parent) && m_typeIndex->isIndexed(parent)) {
+    // With a child, the walk covers exactly the descendants of parent.
+    m_typeIndex->collect(parent, type, first, objects);
+    return;
+  }
+  walk_(
+      parent, [type](VObjectType current) { return current == type; },
+      [](VObjectType) { return false; },
+      [&objects, first](NodeId id) {
+        objects.push_back(id);
+        return !first;
+      });
+}
+
+void FileContent::sl_collect_all(NodeId parent, const VObjectTypeBitset& types,
+                                 std::vector<NodeId>& objects,
+                                 bool first) const {
+  if (m_typeIndex && parent && (parent < m_objects.size()) &&
+      m_objects.child(parent) && m_typeIndex->isIndexed(parent)) {
+    m_typeIndex->collect(parent, types, first, objects);
+    return;
+  }
+  walk_(
+      parent, [&types](VObjectType current) { return types.contains(current); },
+      [](VObjectType) { return false; },
+      [&objects, first](NodeId id) {
+        objects.push_back(id);
+        return !first;
+      });
+}
+
+void FileContent::sl_collect_all(NodeId parent, const VObjectTypeBitset& types,
+                                 const VObjectTypeBitset& stopPoints,
+                                 std::vector<NodeId>& objects,
+                                 bool first) const {
+  sl_visit(parent, types, stopPoints, [&objects, first](NodeId id) {
+    objects.push_back(id);
+    return !first;
+  });
+}
+
+std::vector<NodeId>& FileContent::walkStack_() {
+  static thread_local std::vector<NodeId> stack;
+  return stack;
+}
+
+void FileContent::buildTypeIndex() {
+  m_typeIndex = std::make_unique<VObjectTypeIndex>(m_objects);
+}
+
 bool FileContent::diffTree(NodeId root, const FileContent* oFc, NodeId oroot,
                            std::string* diff_out) const {
   diff_out->clear();
 
-  const VObject& current1 = Object(root);
-  NodeId id1 = current1.m_child;
-  if (!id1) id1 = current1.m_sibling;
+  NodeId id1 = Child(root);
+  if (!id1) id1 = Sibling(root);
 
-  const VObject& current2 = oFc->Object(oroot);
-  NodeId id2 = current2.m_child;
-  if (!id2) id2 = current2.m_sibling;
+  NodeId id2 = oFc->Child(oroot);
+  if (!id2) id2 = oFc->Sibling(oroot);
 
   if ((id1 && (!id2)) || ((!id1) && id2)) return true;
 
@@ -629,18 +634,13 @@ bool FileContent::diffTree(NodeId root, const FileContent* oFc, NodeId oroot,
     stack1.pop();
     stack2.pop();
 
-    const VObject& current1 = Object(id1);
-    const VObject& current2 = oFc->Object(id2);
-
-    if (current1.m_type != current2.m_type) return true;
-    if ((current1.m_name || current2.m_name) && (Name(id1) != oFc->Name(id2))) {
-      return true;
-    }
+    if (Type(id1) != oFc->Type(id2)) return true;
+    if (Name(id1) != oFc->Name(id2)) return true;
 
-    if (current1.m_sibling) stack1.push(current1.m_sibling);
-    if (current1.m_child) stack1.push(current1.m_child);
-    if (current2.m_sibling) stack2.push(current2.m_sibling);
-    if (current2.m_child) stack2.push(current2.m_child);
+    if (NodeId sibling = Sibling(id1)) stack1.push(sibling);
+    if (NodeId child = Child(id1)) stack1.push(child);
+    if (NodeId sibling = oFc->Sibling(id2)) stack2.push(sibling);
+    if (NodeId child = oFc->Child(id2)) stack2.push(child);
   }
   return !stack2.empty();
 }
@@ -665,9 +665,8 @@ void FileContent::populateCoreMembers(NodeId startIndex, NodeId endIndex,
   if (!startIndex && !endIndex) return;
   if (startIndex) {
     if (startIndex < m_objects.size()) {
-      const VObject& object = m_objects[startIndex];
-      instance->VpiLineNo(object.m_line);
-      instance->VpiColumnNo(object.m_column);
+      instance->VpiLineNo(m_objects.line(startIndex));
+      instance->VpiColumnNo(m_objects.column(startIndex));
     } else {
       Location loc(m_fileId);
       Error err(ErrorDefinition::COMP_INTERNAL_ERROR_OUT_OF_BOUND, loc);
@@ -678,9 +677,8 @@ void FileContent::populateCoreMembers(NodeId startIndex, NodeId endIndex,
 
   if (endIndex) {
     if (endIndex < m_objects.size()) {
-      const VObject& object = m_objects[endIndex];
-      instance->VpiEndLineNo(object.m_endLine);
-      instance->VpiEndColumnNo(object.m_endColumn);
+      instance->VpiEndLineNo(m_objects.endLine(endIndex));
+      instance->VpiEndColumnNo(m_objects.endColumn(endIndex));
     } else {
       Location loc(m_fileId);
       Error err(ErrorDefinition::COMP_INTERNAL_ERROR_OUT_OF_BOUND, loc);
@@ -691,10 +689,9 @@ void FileContent::populateCoreMembers(NodeId startIndex, NodeId endIndex,
 
   SymbolId fileId;
   if (startIndex && endIndex) {
-    const VObject& startObject = m_objects[startIndex];
-    const VObject& endObject = m_objects[endIndex];
-    if (startObject.m_fileId == endObject.m_fileId) {
-      fileId = startObject.m_fileId;
+    const SymbolId startFileId = m_objects.fileId(startIndex);
+    if (startFileId == m_objects.fileId(endIndex)) {
+      fileId = startFileId;
     } else {
       Location loc(m_fileId);
       Error err(ErrorDefinition::COMP_INTERNAL_ERROR_OUT_OF_BOUND, loc);
@@ -702,11 +699,9 @@ void FileContent::populateCoreMembers(NodeId startIndex, NodeId endIndex,
       std::cerr << "\nFILE INDEX MISMATCH\n\n";
     }
   } else if (startIndex) {
-    const VObject& object = m_objects[startIndex];
-    fileId = object.m_fileId;
+    fileId = m_objects.fileId(startIndex);
   } else if (endIndex) {
-    const VObject& object = m_objects[endIndex];
-    fileId = object.m_fileId;
+    fileId = m_objects.fileId(endIndex);
   } else {
     fileId = m_fileId;
   }
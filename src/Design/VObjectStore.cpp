@@ -0,0 +1,221 @@
+/*
+ Copyright 2022 The Surelog Team.
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+/*
+ * File:   VObjectStore.cpp
+ * Author: surelog
+ */
+
+#include <Surelog/Design/VObjectStore.h>
+
+#include <algorithm>
+
+namespace SURELOG {
+
+namespace {
+// Hash tables: a node per entry plus the buckets.
+template <typename Table>
+size_t tableMemoryUsage(const Table& table) {
+  return table.size() *
+             (sizeof(typename Table::value_type) + 2 * sizeof(void*)) +
+         table.bucket_count() * sizeof(void*);
+}
+
+bool definitionLess(const std::pair<RawNodeId, NodeId>& definition,
+                    RawNodeId index) {
+  return definition.first < index;
+}
+}  // namespace
+
+void VObjectStore::clear() {
+  m_types.clear();
+  m_children.clear();
+  m_siblings.clear();
+  m_parents.clear();
+  m_names.clear();
+  m_lines.clear();
+  m_columns.clear();
+  m_endColumns.clear();
+  m_endLineOffsets.clear();
+  m_fileIndexes.clear();
+  m_files.clear();
+  m_fileIndexMap.clear();
+  m_lastFileIndex = kOverflow;
+  m_fileOverflow.clear();
+  m_endLineOverflow.clear();
+  m_hasDefinition.clear();
+  m_definitions.clear();
+}
+
+void VObjectStore::reserve(size_t size) {
+  m_types.reserve(size);
+  m_children.reserve(size);
+  m_siblings.reserve(size);
+  m_parents.reserve(size);
+  m_names.reserve(size);
+  m_lines.reserve(size);
+  m_columns.reserve(size);
+  m_endColumns.reserve(size);
+  m_endLineOffsets.reserve(size);
+  m_fileIndexes.reserve(size);
+  m_hasDefinition.reserve(size);
+}
+
+void VObjectStore::emplace_back(SymbolId name, SymbolId fileId,
+                                VObjectType type, unsigned int line,
+                                unsigned short column, unsigned int endLine,
+                                unsigned short endColumn, NodeId parent,
+                                NodeId definition, NodeId child,
+                                NodeId sibling) {
+  const NodeId index(m_types.size());
+  m_types.push_back(type);
+  m_children.push_back(child);
+  m_siblings.push_back(sibling);
+  m_parents.push_back(parent);
+  m_names.push_back(name);
+  m_lines.push_back(line);
+  m_columns.push_back(column);
+  m_endColumns.push_back(endColumn);
+  m_endLineOffsets.push_back(0);
+  m_fileIndexes.push_back(0);
+  m_hasDefinition.push_back(false);
+  setFileId(index, fileId);
+  setEndLine(index, endLine);
+  if (definition) setDefinition(index, definition);
+}
+
+void VObjectStore::push_back(const VObject& object) {
+  emplace_back(object.m_name, object.m_fileId, object.m_type, object.m_line,
+               object.m_column, object.m_endLine, object.m_endColumn,
+               object.m_parent, object.m_definition, object.m_child,
+               object.m_sibling);
+}
+
+VObject VObjectStore::operator[](NodeId index) const {
+  return VObject(name(index), fileId(index), type(index), line(index),
+                 column(index), endLine(index), endColumn(index),
+                 parent(index), definition(index), child(index),
+                 sibling(index));
+}
+
+SymbolId VObjectStore::fileId(NodeId index) const {
+  const uint16_t fileIndex = m_fileIndexes[(RawNodeId)index];
+  if (fileIndex != kOverflow) return m_files[fileIndex];
+  return m_fileOverflow.find((RawNodeId)index)->second;
+}
+
+unsigned int VObjectStore::endLine(NodeId index) const {
+  const uint16_t offset = m_endLineOffsets[(RawNodeId)index];
+  if (offset != kOverflow) return m_lines[(RawNodeId)index] + offset;
+  return m_endLineOverflow.find((RawNodeId)index)->second;
+}
+
+NodeId VObjectStore::definition(NodeId index) const {
+  if (!m_hasDefinition[(RawNodeId)index]) return InvalidNodeId;
+  return std::lower_bound(m_definitions.begin(), m_definitions.end(),
+                          (RawNodeId)index, definitionLess)
+      ->second;
+}
+
+std::vector<VObjectStore::Definition>::iterator VObjectStore::findDefinition_(
+    NodeId index) {
+  // Appending is the common case
+  if (m_definitions.empty() ||
+      (m_definitions.back().first < (RawNodeId)index)) {
+    return m_definitions.end();
+  }
+  return std::lower_bound(m_definitions.begin(), m_definitions.end(),
+                          (RawNodeId)index, definitionLess);
+}
+
+uint16_t VObjectStore::fileIndex_(SymbolId fileId) {
+  // Objects come in runs of the same file
+  if ((m_lastFileIndex != kOverflow) && (m_files[m_lastFileIndex] == fileId)) {
+    return m_lastFileIndex;
+  }
+  auto found = m_fileIndexMap.find((RawSymbolId)fileId);
+  if (found != m_fileIndexMap.end()) {
+    m_lastFileIndex = found->second;
+    return m_lastFileIndex;
+  }
+  if (m_files.size() == kOverflow) return kOverflow;
+  m_lastFileIndex = m_files.size();
+  m_files.push_back(fileId);
+  m_fileIndexMap.emplace((RawSymbolId)fileId, m_lastFileIndex);
+  return m_lastFileIndex;
+}
+
+void VObjectStore::setFileId(NodeId index, SymbolId fileId) {
+  const uint16_t fileIndex = fileIndex_(fileId);
+  m_fileIndexes[(RawNodeId)index] = fileIndex;
+  if (fileIndex == kOverflow) {
+    m_fileOverflow[(RawNodeId)index] = fileId;
+  } else {
+    m_fileOverflow.erase((RawNodeId)index);
+  }
+}
+
+void VObjectStore::setLine(NodeId index, unsigned int line) {
+  const unsigned int end = endLine(index);
+  m_lines[(RawNodeId)index] = line;
+  setEndLine(index, end);
+}
+
+void VObjectStore::setEndLine(NodeId index, unsigned int endLine) {
+  const unsigned int line = m_lines[(RawNodeId)index];
+  // Empty rules end before they start
+  if ((endLine >= line) && (endLine - line < kOverflow)) {
+    m_endLineOffsets[(RawNodeId)index] = endLine - line;
+    m_endLineOverflow.erase((RawNodeId)index);
+  } else {
+    m_endLineOffsets[(RawNodeId)index] = kOverflow;
+    m_endLineOverflow[(RawNodeId)index] = endLine;
+  }
+}
+
+void VObjectStore::setDefinition(NodeId index, NodeId definition) {
+  const bool hasDefinition = m_hasDefinition[(RawNodeId)index];
+  if (!definition && !hasDefinition) return;
+  auto found = findDefinition_(index);
+  if (!definition) {
+    m_definitions.erase(found);
+  } else if (hasDefinition) {
+    found->second = definition;
+  } else {
+    m_definitions.emplace(found, (RawNodeId)index, definition);
+  }
+  m_hasDefinition[(RawNodeId)index] = (bool)definition;
+}
+
+size_t VObjectStore::memoryUsage() const {
+  return m_types.capacity() * sizeof(VObjectType) +
+         (m_children.capacity() + m_siblings.capacity() +
+          m_parents.capacity()) *
+             sizeof(NodeId) +
+         m_names.capacity() * sizeof(SymbolId) +
+         m_lines.capacity() * sizeof(unsigned int) +
+         (m_columns.capacity() + m_endColumns.capacity()) *
+             sizeof(unsigned short) +
+         (m_endLineOffsets.capacity() + m_fileIndexes.capacity()) *
+             sizeof(uint16_t) +
+         m_files.capacity() * sizeof(SymbolId) +
+         m_hasDefinition.capacity() / 8 +
+         m_definitions.capacity() * sizeof(Definition) +
+         tableMemoryUsage(m_fileIndexMap) + tableMemoryUsage(m_fileOverflow) +
+         tableMemoryUsage(m_endLineOverflow);
+}
+
+}  // namespace SURELOG
@@ -0,0 +1,152 @@
+/*
+ Copyright 2022 The Surelog Team.
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+/*
+ * File:   VObjectStore_bench.cpp
+ * Author: surelog
+ *
+ * Memory used by the parse trees of a set of files, and time of a full tree
+ * walk looking for one object type (what sl_collect_all does), with the
+ * objects stored per field (VObjectStore) versus one VObject after the other.
+ *
+ * Usage: vobjectstore-bench <preprocessed file>...
+ *        (files written with -writepp, under slpp_all/ or slpp_unit/)
+ */
+
+#include <Surelog/Design/FileContent.h>
+#include <Surelog/SourceCompile/ParserHarness.h>
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace SURELOG;
+
+static constexpr int kRounds = 20;
+static constexpr VObjectType kSearched = VObjectType::slModule_instantiation;
+
+static size_t countAoS(const std::vector<VObject>& objects, NodeId root) {
+  size_t count = 0;
+  std::vector<NodeId> stack;
+  stack.push_back(root);
+  while (!stack.empty()) {
+    const VObject& current = objects[stack.back()];
+    stack.pop_back();
+    if (current.m_type == kSearched) count++;
+    if (current.m_sibling) stack.push_back(current.m_sibling);
+    if (current.m_child) stack.push_back(current.m_child);
+  }
+  return count;
+}
+
+static size_t countSoA(const VObjectStore& objects, NodeId root) {
+  size_t count = 0;
+  std::vector<NodeId> stack;
+  stack.push_back(root);
+  while (!stack.empty()) {
+    const NodeId id = stack.back();
+    stack.pop_back();
+    if (objects.type(id) == kSearched) count++;
+    if (NodeId sibling = objects.sibling(id)) stack.push_back(sibling);
+    if (NodeId child = objects.child(id)) stack.push_back(child);
+  }
+  return count;
+}
+
+template <typename Function>
+static double timeIt(Function function) {
+  auto start = std::chrono::steady_clock::now();
+  function();
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                       start)
+      .count();
+}
+
+int main(int argc, char** argv) {
+  if (argc < 2) {
+    fprintf(stderr, "Usage: %s <preprocessed file>...\n", argv[0]);
+    return 1;
+  }
+  // The harness owns the symbols of what it parsed, one per file.
+  std::vector<std::unique_ptr<ParserHarness>> harnesses;
+  std::vector<std::unique_ptr<FileContent>> files;
+  for (int i = 1; i < argc; i++) {
+    std::ifstream stream(argv[i]);
+    if (!stream.good()) {
+      fprintf(stderr, "Cannot read %s\n", argv[i]);
+      return 1;
+    }
+    std::stringstream buffer;
+    buffer << stream.rdbuf();
+    harnesses.push_back(std::make_unique<ParserHarness>());
+    std::unique_ptr<FileContent> fC = harnesses.back()->parse(buffer.str());
+    if (fC == nullptr) {
+      fprintf(stderr, "Cannot parse %s\n", argv[i]);
+      continue;
+    }
+    files.push_back(std::move(fC));
+  }
+
+  // Both grown object by object, as the parser listener does.
+  size_t nbObjects = 0;
+  size_t soaBytes = 0;
+  size_t aosBytes = 0;
+  std::vector<std::vector<VObject>> aosFiles;
+  for (const auto& fC : files) {
+    const VObjectStore& objects = fC->getVObjects();
+    nbObjects += objects.size();
+    soaBytes += objects.memoryUsage();
+    std::vector<VObject>& aos = aosFiles.emplace_back();
+    for (NodeId id(0); id < objects.size(); ++id) aos.push_back(objects[id]);
+    aosBytes += aos.capacity() * sizeof(VObject);
+  }
+  if (nbObjects == 0) return 1;
+
+  size_t aosCount = 0;
+  size_t soaCount = 0;
+  const double aosTime = timeIt([&]() {
+    for (int round = 0; round < kRounds; round++) {
+      for (size_t i = 0; i < files.size(); i++) {
+        aosCount += countAoS(aosFiles[i], files[i]->getRootNode());
+      }
+    }
+  });
+  const double soaTime = timeIt([&]() {
+    for (int round = 0; round < kRounds; round++) {
+      for (const auto& fC : files) {
+        soaCount += countSoA(fC->getVObjects(), fC->getRootNode());
+      }
+    }
+  });
+  if (aosCount != soaCount) {
+    fprintf(stderr, "Mismatch: %zu vs %zu objects found\n", aosCount,
+            soaCount);
+    return 1;
+  }
+
+  printf("%zu files, %zu objects\n", files.size(), nbObjects);
+  printf("memory  VObject vector %10.2f MB (%5.1f B/object)\n",
+         aosBytes / 1e6, (double)aosBytes / nbObjects);
+  printf("        VObjectStore   %10.2f MB (%5.1f B/object)\n",
+         soaBytes / 1e6, (double)soaBytes / nbObjects);
+  printf("walk    VObject vector %10.3fs\n", aosTime);
+  printf("        VObjectStore   %10.3fs\n", soaTime);
+  return 0;
+}
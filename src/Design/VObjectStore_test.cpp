@@ -0,0 +1,130 @@
+/*
+ Copyright 2022 The Surelog Team.
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+*/
+
+#include <Surelog/Design/VObjectStore.h>
+#include <gtest/gtest.h>
+
+namespace SURELOG {
+
+TEST(VObjectStoreTest, RoundTrip) {
+  VObjectStore store;
+  store.emplace_back(SymbolId(3, "a"), SymbolId(7, "f.sv"),
+                     VObjectType::slModule_declaration, 10, 4, 12, 9,
+                     NodeId(2), NodeId(5), NodeId(6), NodeId(8));
+  store.emplace_back(BadSymbolId, SymbolId(7, "f.sv"),
+                     VObjectType::slStringConst, 11, 1, 11, 3, NodeId(0),
+                     InvalidNodeId, InvalidNodeId, InvalidNodeId);
+  ASSERT_EQ(store.size(), 2U);
+
+  const VObject object = store[NodeId(0)];
+  EXPECT_EQ(object.m_name, SymbolId(3, "a"));
+  EXPECT_EQ(object.m_fileId, SymbolId(7, "f.sv"));
+  EXPECT_EQ(object.m_type, VObjectType::slModule_declaration);
+  EXPECT_EQ(object.m_line, 10U);
+  EXPECT_EQ(object.m_column, 4);
+  EXPECT_EQ(object.m_endLine, 12U);
+  EXPECT_EQ(object.m_endColumn, 9);
+  EXPECT_EQ(object.m_parent, NodeId(2));
+  EXPECT_EQ(object.m_definition, NodeId(5));
+  EXPECT_EQ(object.m_child, NodeId(6));
+  EXPECT_EQ(object.m_sibling, NodeId(8));
+
+  EXPECT_EQ(store.type(NodeId(1)), VObjectType::slStringConst);
+  EXPECT_EQ(store.definition(NodeId(1)), InvalidNodeId);
+  EXPECT_EQ(store.parent(NodeId(1)), NodeId(0));
+}
+
+TEST(VObjectStoreTest, Setters) {
+  VObjectStore store;
+  store.emplace_back(BadSymbolId, SymbolId(1, "a.sv"),
+                     VObjectType::slModule_declaration, 10, 1, 20, 1,
+                     InvalidNodeId, InvalidNodeId, InvalidNodeId,
+                     InvalidNodeId);
+  const NodeId id(0);
+  store.setLine(id, 15);
+  EXPECT_EQ(store.line(id), 15U);
+  EXPECT_EQ(store.endLine(id), 20U);
+  store.setFileId(id, SymbolId(2, "b.sv"));
+  EXPECT_EQ(store.fileId(id), SymbolId(2, "b.sv"));
+  store.setDefinition(id, NodeId(4));
+  EXPECT_EQ(store.definition(id), NodeId(4));
+  store.setDefinition(id, InvalidNodeId);
+  EXPECT_EQ(store.definition(id), InvalidNodeId);
+  store.setType(id, VObjectType::slStringConst);
+  store.setChild(id, NodeId(1));
+  store.setSibling(id, NodeId(2));
+  store.setParent(id, NodeId(3));
+  EXPECT_EQ(store.type(id), VObjectType::slStringConst);
+  EXPECT_EQ(store.child(id), NodeId(1));
+  EXPECT_EQ(store.sibling(id), NodeId(2));
+  EXPECT_EQ(store.parent(id), NodeId(3));
+}
+
+TEST(VObjectStoreTest, Definitions) {
+  VObjectStore store;
+  for (RawNodeId id = 0; id < 10; id++) {
+    store.emplace_back(BadSymbolId, SymbolId(1, "a.sv"),
+                       VObjectType::slStringConst, 1, 1, 1, 1, InvalidNodeId,
+                       (id == 5) ? NodeId(50) : InvalidNodeId, InvalidNodeId,
+                       InvalidNodeId);
+  }
+  // Out of object order
+  store.setDefinition(NodeId(8), NodeId(80));
+  store.setDefinition(NodeId(2), NodeId(20));
+  store.setDefinition(NodeId(5), NodeId(51));
+  store.setDefinition(NodeId(8), InvalidNodeId);
+  store.setDefinition(NodeId(9), InvalidNodeId);
+  for (RawNodeId id = 0; id < store.size(); id++) {
+    const NodeId expected = (id == 2)   ? NodeId(20)
+                            : (id == 5) ? NodeId(51)
+                                        : InvalidNodeId;
+    EXPECT_EQ(store.definition(NodeId(id)), expected);
+  }
+  store.clear();
+  EXPECT_TRUE(store.empty());
+}
+
+TEST(VObjectStoreTest, Overflow) {
+  VObjectStore store;
+  // Empty rule, ending before it starts
+  store.emplace_back(BadSymbolId, SymbolId(1, "a.sv"),
+                     VObjectType::slModule_declaration, 10, 1, 9, 1,
+                     InvalidNodeId, InvalidNodeId, InvalidNodeId,
+                     InvalidNodeId);
+  EXPECT_EQ(store.endLine(NodeId(0)), 9U);
+  // Very long construct
+  store.emplace_back(BadSymbolId, SymbolId(1, "a.sv"),
+                     VObjectType::slModule_declaration, 1, 1, 1000000, 1,
+                     InvalidNodeId, InvalidNodeId, InvalidNodeId,
+                     InvalidNodeId);
+  EXPECT_EQ(store.endLine(NodeId(1)), 1000000U);
+  store.setEndLine(NodeId(1), 2);
+  EXPECT_EQ(store.endLine(NodeId(1)), 2U);
+
+  // More files than the packed file index can number
+  for (RawSymbolId file = 2; file < 70000; file++) {
+    store.emplace_back(BadSymbolId, SymbolId(file, "x.sv"),
+                       VObjectType::slStringConst, file, 1, file, 1,
+                       InvalidNodeId, InvalidNodeId, InvalidNodeId,
+                       InvalidNodeId);
+  }
+  for (RawNodeId id = 0; id < store.size(); id++) {
+    const RawSymbolId file = (id < 2) ? 1 : id;
+    EXPECT_EQ(store.fileId(NodeId(id)), SymbolId(file, "x.sv"));
+  }
+}
+
+}  // namespace SURELOG
@@ -0,0 +1,160 @@
+/*
+ Copyright 2022 The Surelog Team.
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+/*
+ * File:   VObjectTypeIndex.cpp
+ * Author: surelog
+ */
+
+#include <Surelog/Design/VObjectStore.h>
+#include <Surelog/Design/VObjectTypeIndex.h>
+
+#include <algorithm>
+
+namespace SURELOG {
+
+VObjectTypeIndex::VObjectTypeIndex(const VObjectStore& objects) {
+  const RawNodeId size = objects.size();
+  m_preorder.assign(size, kNotIndexed);
+  m_nodes.reserve(size);
+
+  std::vector<bool> referenced(size, false);
+  for (NodeId id(0); id < size; ++id) {
+    const NodeId child = objects.child(id);
+    if (child && (child < size)) referenced[(RawNodeId)child] = true;
+    const NodeId sibling = objects.sibling(id);
+    if (sibling && (sibling < size)) referenced[(RawNodeId)sibling] = true;
+  }
+
+  // Walks in the order of sl_collect_all: child before sibling. The
+  // subtree of a node is closed by its parent in the walk, the object
+  // whose child list it is in.
+  std::vector<NodeId> walkParents(size, InvalidNodeId);
+  std::vector<std::pair<NodeId, NodeId>> stack;
+  for (NodeId root(0); root < size; ++root) {
+    if (referenced[(RawNodeId)root]) continue;
+    stack.emplace_back(root, InvalidNodeId);
+    while (!stack.empty()) {
+      const auto [id, walkParent] = stack.back();
+      stack.pop_back();
+      if (((RawNodeId)id >= size) ||
+          (m_preorder[(RawNodeId)id] != kNotIndexed)) {
+        continue;
+      }
+      m_preorder[(RawNodeId)id] = m_nodes.size();
+      m_nodes.push_back(id);
+      walkParents[(RawNodeId)id] = walkParent;
+      if (NodeId sibling = objects.sibling(id)) {
+        stack.emplace_back(sibling, walkParent);
+      }
+      if (NodeId child = objects.child(id)) stack.emplace_back(child, id);
+    }
+  }
+
+  m_subtreeEnd.assign(size, 0);
+  for (uint32_t i = m_nodes.size(); i-- > 0;) {
+    const RawNodeId id = m_nodes[i];
+    m_subtreeEnd[id] = std::max(m_subtreeEnd[id], i + 1);
+    if (NodeId walkParent = walkParents[id]) {
+      m_subtreeEnd[(RawNodeId)walkParent] =
+          std::max(m_subtreeEnd[(RawNodeId)walkParent], m_subtreeEnd[id]);
+    }
+  }
+
+  // Counting sort by type, each list stays in preorder.
+  std::vector<uint32_t> counts(VObjectTypeCount, 0);
+  for (NodeId id : m_nodes) ++counts[objects.type(id)];
+  std::vector<uint32_t> offsets(VObjectTypeCount, 0);
+  uint32_t start = 0;
+  for (uint16_t type = 0; type < VObjectTypeCount; ++type) {
+    if (counts[type] == 0) continue;
+    m_typeStarts.emplace_back((VObjectType)type, start);
+    offsets[type] = start;
+    start += counts[type];
+  }
+  m_byType.resize(m_nodes.size());
+  for (uint32_t i = 0; i < m_nodes.size(); ++i) {
+    m_byType[offsets[objects.type(m_nodes[i])]++] = i;
+  }
+}
+
+std::pair<const uint32_t*, const uint32_t*> VObjectTypeIndex::range_(
+    NodeId parent, VObjectType type) const {
+  auto it = std::lower_bound(
+      m_typeStarts.begin(), m_typeStarts.end(), type,
+      [](const std::pair<VObjectType, uint32_t>& entry, VObjectType value) {
+        return entry.first < value;
+      });
+  if ((it == m_typeStarts.end()) || (it->first != type)) {
+    return {nullptr, nullptr};
+  }
+  const uint32_t* begin = m_byType.data() + it->second;
+  const uint32_t* end = m_byType.data() + ((it + 1 == m_typeStarts.end())
+                                               ? m_byType.size()
+                                               : (it + 1)->second);
+  const uint32_t first = m_preorder[(RawNodeId)parent] + 1;
+  const uint32_t last = m_subtreeEnd[(RawNodeId)parent];
+  begin = std::lower_bound(begin, end, first);
+  end = std::lower_bound(begin, end, last);
+  return {begin, end};
+}
+
+void VObjectTypeIndex::collect(NodeId parent, VObjectType type, bool first,
+                               std::vector<NodeId>& out) const {
+  const auto [begin, end] = range_(parent, type);
+  for (const uint32_t* it = begin; it != end; ++it) {
+    out.push_back(m_nodes[*it]);
+    if (first) return;
+  }
+}
+
+void VObjectTypeIndex::collect(NodeId parent, const VObjectTypeBitset& types,
+                               bool first, std::vector<NodeId>& out) const {
+  const size_t outStart = out.size();
+  uint32_t firstFound = kNotIndexed;
+  int rangeCount = 0;
+  for (const auto& entry : m_typeStarts) {
+    if (!types.contains(entry.first)) continue;
+    const auto [begin, end] = range_(parent, entry.first);
+    if (begin == end) continue;
+    if (first) {
+      firstFound = std::min(firstFound, *begin);
+      continue;
+    }
+    for (const uint32_t* it = begin; it != end; ++it) {
+      out.push_back(m_nodes[*it]);
+    }
+    ++rangeCount;
+  }
+  if (first) {
+    if (firstFound != kNotIndexed) out.push_back(m_nodes[firstFound]);
+  } else if (rangeCount > 1) {
+    std::sort(out.begin() + outStart, out.end(),
+              [this](NodeId lhs, NodeId rhs) {
+                return m_preorder[(RawNodeId)lhs] < m_preorder[(RawNodeId)rhs];
+              });
+  }
+}
+
+size_t VObjectTypeIndex::memoryUsage() const {
+  return m_preorder.capacity() * sizeof(uint32_t) +
+         m_subtreeEnd.capacity() * sizeof(uint32_t) +
+         m_nodes.capacity() * sizeof(NodeId) +
+         m_byType.capacity() * sizeof(uint32_t) +
+         m_typeStarts.capacity() * sizeof(std::pair<VObjectType, uint32_t>);
+}
+
+}  // namespace SURELOG
@@ -0,0 +1,129 @@
+/*
+ Copyright 2022 The Surelog Team.
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+*/
+
+#include <Surelog/Design/FileContent.h>
+#include <Surelog/Design/VObjectStore.h>
+#include <Surelog/Design/VObjectTypeIndex.h>
+#include <Surelog/SourceCompile/ParserHarness.h>
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+namespace SURELOG {
+
+using ::testing::ElementsAre;
+
+namespace {
+// 1: module, children 2 and 4; 2: param, child 3; 4: param, child 5.
+// As in FileContent, object 0 is a placeholder, NodeId(0) being invalid.
+VObjectStore makeTree() {
+  VObjectStore store;
+  auto add = [&store](VObjectType type, RawNodeId parent, RawNodeId child,
+                      RawNodeId sibling) {
+    store.emplace_back(BadSymbolId, BadSymbolId, type, 1, 1, 1, 1,
+                       NodeId(parent), InvalidNodeId, NodeId(child),
+                       NodeId(sibling));
+  };
+  add(sl_INVALID_, 0, 0, 0);
+  add(slModule_declaration, 0, 2, 0);
+  add(slParam_assignment, 1, 3, 4);
+  add(slStringConst, 2, 0, 0);
+  add(slParam_assignment, 1, 5, 0);
+  add(slStringConst, 4, 0, 0);
+  return store;
+}
+
+TEST(VObjectTypeIndexTest, Collect) {
+  const VObjectStore store = makeTree();
+  VObjectTypeIndex index(store);
+  for (RawNodeId id = 1; id < store.size(); ++id) {
+    EXPECT_TRUE(index.isIndexed(NodeId(id)));
+  }
+
+  std::vector<NodeId> found;
+  index.collect(NodeId(1), slStringConst, false, found);
+  EXPECT_THAT(found, ElementsAre(NodeId(3), NodeId(5)));
+
+  found.clear();
+  index.collect(NodeId(4), slStringConst, false, found);
+  EXPECT_THAT(found, ElementsAre(NodeId(5)));
+
+  found.clear();
+  index.collect(NodeId(1), {slStringConst, slParam_assignment}, false, found);
+  EXPECT_THAT(found, ElementsAre(NodeId(2), NodeId(3), NodeId(4), NodeId(5)));
+
+  found.clear();
+  index.collect(NodeId(1), {slStringConst, slParam_assignment}, true, found);
+  EXPECT_THAT(found, ElementsAre(NodeId(2)));
+
+  found.clear();
+  index.collect(NodeId(3), slStringConst, false, found);
+  EXPECT_TRUE(found.empty());
+}
+
+TEST(VObjectTypeIndexTest, SameAsTreeWalk) {
+  ParserHarness harness;
+  auto fC = harness.parse(
+      "module top();"
+      "parameter p1 = 1;"
+      "sub s1(.a(p1));"
+      "generate if (p1) begin : g sub s2(.a(p1)); end endgenerate "
+      "endmodule "
+      "module sub(input a); assign b = a; endmodule");
+  ASSERT_NE(fC, nullptr);
+
+  const std::vector<VObjectType> types = {
+      slStringConst, slParam_assignment, slModule_declaration,
+      slHierarchical_instance, slPrimary_literal};
+  std::vector<std::vector<NodeId>> walked;
+  for (NodeId id(1); id < fC->getSize(); ++id) {
+    for (VObjectType type : types) {
+      walked.push_back(fC->sl_collect_all(id, type));
+      walked.push_back(fC->sl_collect_all(id, type, true));
+    }
+    walked.push_back(
+        fC->sl_collect_all(id, {slStringConst, slParam_assignment}));
+  }
+
+  fC->buildTypeIndex();
+  ASSERT_NE(fC->getTypeIndex(), nullptr);
+  size_t i = 0;
+  for (NodeId id(1); id < fC->getSize(); ++id) {
+    for (VObjectType type : types) {
+      EXPECT_EQ(fC->sl_collect_all(id, type), walked[i++]);
+      EXPECT_EQ(fC->sl_collect_all(id, type, true), walked[i++]);
+    }
+    EXPECT_EQ(fC->sl_collect_all(id, {slStringConst, slParam_assignment}),
+              walked[i++]);
+  }
+}
+
+TEST(VObjectTypeIndexTest, VisitStops) {
+  ParserHarness harness;
+  auto fC = harness.parse(
+      "module top(); parameter p1 = 1; parameter p2 = 2; endmodule");
+  ASSERT_NE(fC, nullptr);
+  std::vector<NodeId> visited;
+  fC->sl_visit(fC->getRootNode(), {slParam_assignment}, {},
+               [&visited](NodeId id) {
+                 visited.push_back(id);
+                 return false;
+               });
+  EXPECT_EQ(visited.size(), 1);
+  EXPECT_EQ(visited,
+            fC->sl_collect_all(fC->getRootNode(), slParam_assignment, true));
+}
+}  // namespace
+}  // namespace SURELOG
@@ -27,27 +27,26 @@
 
 namespace SURELOG {
 Value* ValuedComponentI::getValue(std::string_view name) const {
-  auto itr = m_paramMap.find(name);
-  if (itr == m_paramMap.end()) {
-    if (m_definition) {
-      itr = m_definition->m_paramMap.find(name);
-      if (itr != m_definition->m_paramMap.end()) {
+  // Walks up the scopes until a module instance boundary, the name being
+  // hashed once.
+  const size_t nameHash = ParamMap::hash(name);
+  const ValuedComponentI* scope = this;
+  while (scope) {
+    auto itr = scope->m_paramMap.find(name, nameHash);
+    if (itr != scope->m_paramMap.end()) {
+      return (*itr).second.first;
+    }
+    if (scope->m_definition) {
+      itr = scope->m_definition->m_paramMap.find(name, nameHash);
+      if (itr != scope->m_definition->m_paramMap.end()) {
         return (*itr).second.first;
       }
     }
-
-    if (m_parentScope) {
-      if (const ModuleInstance* inst =
-              valuedcomponenti_cast<ModuleInstance*>(this)) {
-        if (inst->getType() != slModule_instantiation) {
-          return m_parentScope->getValue(name);
-        }
-      } else {
-        return m_parentScope->getValue(name);
-      }
+    if (const ModuleInstance* inst =
+            valuedcomponenti_cast<const ModuleInstance*>(scope)) {
+      if (inst->getType() == slModule_instantiation) break;
     }
-  } else {
-    return (*itr).second.first;
+    scope = scope->m_parentScope;
   }
   return nullptr;
 }
@@ -59,8 +58,7 @@ Value* ValuedComponentI::getValue(std::string_view name,
 
 void ValuedComponentI::deleteValue(std::string_view name,
                                    ExprBuilder& exprBuilder) {
-  std::map<std::string, std::pair<Value*, int>>::iterator itr =
-      m_paramMap.find(name);
+  auto itr = m_paramMap.find(name);
   if (itr != m_paramMap.end()) {
     exprBuilder.deleteValue((*itr).second.first);
     m_paramMap.erase(itr);
@@ -68,8 +66,7 @@ void ValuedComponentI::deleteValue(std::string_view name,
 }
 
 void ValuedComponentI::forgetValue(std::string_view name) {
-  std::map<std::string, std::pair<Value*, int>>::iterator itr =
-      m_paramMap.find(name);
+  auto itr = m_paramMap.find(name);
   if (itr != m_paramMap.end()) {
     m_paramMap.erase(itr);
   }
@@ -78,15 +75,17 @@ void ValuedComponentI::forgetValue(std::string_view name) {
 void ValuedComponentI::setValue(std::string_view name, Value* val,  // NOLINT
                                 ExprBuilder& exprBuilder, int lineNb) {
   deleteValue(name, exprBuilder);
-  m_paramMap.insert(
-      std::make_pair(name, std::make_pair(exprBuilder.clone(val), lineNb)));
+  m_paramMap.emplace(name, std::make_pair(exprBuilder.clone(val), lineNb));
   forgetComplexValue(name);
 }
 
 void ValuedComponentI::setComplexValue(std::string_view name, UHDM::expr* val) {
   auto itr = m_complexValues.find(name);
-  if (itr != m_complexValues.end()) m_complexValues.erase(itr);
-  m_complexValues.insert(std::make_pair(name, val));
+  if (itr != m_complexValues.end()) {
+    (*itr).second = val;
+  } else {
+    m_complexValues.emplace(name, val);
+  }
   forgetValue(name);
 }
 
@@ -0,0 +1,118 @@
+/*
+ Copyright 2022 The Surelog Team.
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+/*
+ * File:   ValuedComponentI_bench.cpp
+ * Author: surelog
+ *
+ * Parameter lookups from the innermost scope of a nested generate
+ * hierarchy, each scope holding a few parameters and the searched ones
+ * being at every depth: the former std::map per scope with a recursive
+ * walk of the parent scopes, versus ValuedComponentI.
+ *
+ * Usage: valuedcomponent-bench [depth, default 16]
+ *                              [parameters per scope, default 12]
+ *                              [lookups, default 2000000]
+ */
+
+#include <Surelog/Common/Containers.h>
+#include <Surelog/Design/ValuedComponentI.h>
+#include <Surelog/Expression/ExprBuilder.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace SURELOG;
+
+namespace {
+// The former ValuedComponentI::getValue.
+struct MapScope final {
+  std::map<std::string, std::pair<Value*, int>, StringViewCompare> m_params;
+  const MapScope* m_parent = nullptr;
+
+  Value* getValue(std::string_view name) const {
+    auto itr = m_params.find(name);
+    if (itr != m_params.end()) return itr->second.first;
+    if (m_parent) return m_parent->getValue(name);
+    return nullptr;
+  }
+};
+}  // namespace
+
+int main(int argc, char** argv) {
+  const int depth = (argc > 1) ? std::atoi(argv[1]) : 16;
+  const int nbParams = (argc > 2) ? std::atoi(argv[2]) : 12;
+  const int nbLookups = (argc > 3) ? std::atoi(argv[3]) : 2000000;
+  if ((depth <= 0) || (nbParams <= 0) || (nbLookups <= 0)) {
+    fprintf(stderr, "Usage: %s [depth] [parameters per scope] [lookups]\n",
+            argv[0]);
+    return 1;
+  }
+
+  ExprBuilder exprBuilder;
+  Value* value = exprBuilder.fromVpiValue("UINT:8", 32);
+  std::vector<std::unique_ptr<MapScope>> mapScopes;
+  std::vector<std::unique_ptr<ValuedComponentI>> scopes;
+  std::vector<std::string> names;
+  for (int d = 0; d < depth; d++) {
+    auto mapScope = std::make_unique<MapScope>();
+    mapScope->m_parent = mapScopes.empty() ? nullptr : mapScopes.back().get();
+    auto scope = std::make_unique<ValuedComponentI>(
+        scopes.empty() ? nullptr : scopes.back().get(), nullptr);
+    for (int p = 0; p < nbParams; p++) {
+      const std::string name =
+          "PARAM_" + std::to_string(d) + "_" + std::to_string(p);
+      mapScope->m_params.emplace(name, std::make_pair(value, 0));
+      scope->setValue(name, value, exprBuilder);
+      names.push_back(name);
+    }
+    mapScopes.push_back(std::move(mapScope));
+    scopes.push_back(std::move(scope));
+  }
+  const MapScope* mapInnermost = mapScopes.back().get();
+  const ValuedComponentI* innermost = scopes.back().get();
+
+  size_t mapFound = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < nbLookups; i++) {
+    if (mapInnermost->getValue(names[i % names.size()])) mapFound++;
+  }
+  const double mapSeconds =
+      std::chrono::duration<double>(std::chrono::steady_clock::now() - start)
+          .count();
+
+  size_t found = 0;
+  start = std::chrono::steady_clock::now();
+  for (int i = 0; i < nbLookups; i++) {
+    if (innermost->getValue(names[i % names.size()])) found++;
+  }
+  const double seconds =
+      std::chrono::duration<double>(std::chrono::steady_clock::now() - start)
+          .count();
+  if ((found != mapFound) || (found != (size_t)nbLookups)) return 1;
+
+  printf("%d scopes, %d parameters per scope, %d lookups\n", depth, nbParams,
+         nbLookups);
+  printf("%-28s %12s\n", "", "time (s)");
+  printf("%-28s %12.3f\n", "std::map, recursive walk", mapSeconds);
+  printf("%-28s %12.3f\n", "ValuedComponentI", seconds);
+  return 0;
+}
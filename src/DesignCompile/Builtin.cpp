@@ -245,8 +245,9 @@ void Builtin::addBuiltinTypes() {
   }
 }
 
-void Builtin::addBuiltinMacros(CompilationUnit* compUnit) {
-  PreprocessHarness ppharness;
+void Builtin::addBuiltinMacros(CompilationUnit* compUnit,
+                               SymbolTable* symbols) {
+  PreprocessHarness ppharness(symbols);
   ppharness.preprocess(R"(
 `define SV_COV_START 0
 `define SV_COV_STOP 1
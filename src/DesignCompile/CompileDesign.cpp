@@ -46,13 +46,13 @@
 #include <Surelog/SourceCompile/SymbolTable.h>
 #include <Surelog/Testbench/ClassDefinition.h>
 #include <Surelog/Testbench/Program.h>
+#include <Surelog/Utils/ThreadPool.h>
 
 // UHDM
 #include <uhdm/param_assign.h>
 #include <uhdm/vpi_visitor.h>
 
 #include <climits>
-#include <thread>
 
 #ifdef USETBB
 #include <tbb/task.h>
@@ -68,6 +68,7 @@ CompileDesign::CompileDesign(Compiler* compiler) : m_compiler(compiler) {}
 CompileDesign::~CompileDesign() {
   // TODO: ownership not clear.
   // delete m_compiler;
+  m_reduceExprMemo.clear();
   m_serializer.Purge();
 }
 
@@ -115,60 +116,25 @@ void CompileDesign::compileMT_(ObjectMapType& objects, int maxThreadCount) {
   if (maxThreadCount == 0) {
     for (const auto& itr : objects) {
       FunctorType funct(this, itr.second, m_compiler->getDesign(),
-                        m_symbolTables[0], m_errorContainers[0]);
+                        m_compiler->getSymbolTable(), m_errorContainers[0]);
       funct.operator()();
     }
   } else {
-    // Optimize the load balance, try to even out the work in each thread by the
-    // number of VObjects
-    std::vector<unsigned long> jobSize(maxThreadCount);
-    for (int i = 0; i < maxThreadCount; i++) {
-      jobSize[i] = 0;
-    }
-    std::vector<std::vector<ObjectType*>> jobArray(maxThreadCount);
+    // Balance the work by the number of VObjects, largest objects first;
+    // per-worker error containers are indexed by worker.
+    ThreadPool* pool = m_compiler->getThreadPool();
     for (const auto& mod : objects) {
       unsigned int size = mod.second->getSize();
       if (size == 0) size = 100;
-      unsigned int newJobIndex = 0;
-      unsigned long long minJobQueue = ULLONG_MAX;
-      for (int ii = 0; ii < maxThreadCount; ii++) {
-        if (jobSize[ii] < minJobQueue) {
-          newJobIndex = ii;
-          minJobQueue = jobSize[ii];
-        }
-      }
-      jobSize[newJobIndex] += size;
-      jobArray[newJobIndex].push_back(mod.second);
-    }
-
-    if (getCompiler()->getCommandLineParser()->profile()) {
-      std::cout << "Compilation Task\n";
-      for (int i = 0; i < maxThreadCount; i++) {
-        std::cout << "Thread " << i << " : \n";
-        for (unsigned int j = 0; j < jobArray[i].size(); j++) {
-          std::cout << jobArray[i][j]->getName() << "\n";
-        }
-      }
-    }
-
-    // Create the threads with their respective workloads
-    std::vector<std::thread*> threads;
-    for (int i = 0; i < maxThreadCount; i++) {
-      std::thread* th = new std::thread([=] {
-        for (unsigned int j = 0; j < jobArray[i].size(); j++) {
-          FunctorType funct(this, jobArray[i][j], m_compiler->getDesign(),
-                            m_symbolTables[i], m_errorContainers[i]);
-          funct.operator()();
-        }
+      ObjectType* object = mod.second;
+      pool->addJob(size, [=](unsigned int workerIndex) {
+        FunctorType funct(this, object, m_compiler->getDesign(),
+                          m_compiler->getSymbolTable(),
+                          m_errorContainers[workerIndex]);
+        funct.operator()();
       });
-      threads.push_back(th);
-    }
-    for (auto* thread : threads) {  // sync
-      thread->join();
-    }
-    for (auto* thread : threads) {  // delete
-      delete thread;
     }
+    pool->run();
   }
 }
 
@@ -292,10 +258,7 @@ bool CompileDesign::compilation_() {
 
   int index = 0;
   do {
-    SymbolTable* symbols =
-        m_compiler->getCommandLineParser()->getSymbolTable().CreateSnapshot();
-    m_symbolTables.push_back(symbols);
-    ErrorContainer* errors = new ErrorContainer(symbols);
+    ErrorContainer* errors = new ErrorContainer(m_compiler->getSymbolTable());
     errors->registerCmdLine(m_compiler->getCommandLineParser());
     m_errorContainers.push_back(errors);
     index++;
@@ -321,7 +284,8 @@ bool CompileDesign::compilation_() {
   // Compile packages in strict order
   for (auto itr : m_compiler->getDesign()->getOrderedPackageDefinitions()) {
     FunctorCompilePackage funct(this, itr, m_compiler->getDesign(),
-                                m_symbolTables[0], m_errorContainers[0]);
+                                m_compiler->getSymbolTable(),
+                                m_errorContainers[0]);
     funct.operator()();
   }
 
@@ -353,11 +317,9 @@ bool CompileDesign::compilation_() {
 
   m_compiler->getDesign()->orderPackages();
 
-  unsigned int size = m_symbolTables.size();
-  for (unsigned int i = 0; i < size; i++) {
-    m_compiler->getErrorContainer()->appendErrors(*m_errorContainers[i]);
-    delete m_symbolTables[i];
-    delete m_errorContainers[i];
+  for (ErrorContainer* errors : m_errorContainers) {
+    m_compiler->getErrorContainer()->appendErrors(*errors);
+    delete errors;
   }
   return true;
 }
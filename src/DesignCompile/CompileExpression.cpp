@@ -742,21 +742,89 @@ expr *CompileHelper::reduceExpr(any *result, bool &invalidValue,
                                 ValuedComponentI *instance,
                                 const fs::path &fileName, int lineNumber,
                                 any *pexpr, bool muteErrors) {
+  using Dependency = ReduceExprMemo::Dependency;
+  ReduceExprMemo *memo = compileDesign->getReduceExprMemo();
+  const bool memoize = ReduceExprMemo::isMemoizable(result);
+  ErrorContainer *errors = compileDesign->getCompiler()->getErrorContainer();
+  // Lookups made by this reduction, not by the nested ones.
+  std::vector<Dependency> dependencies;
+  // Errors reported by this reduction, not by the lookups.
+  std::vector<Error> reported;
+  size_t nbErrors = errors->getErrors().size();
+  auto collectErrors = [&]() {
+    const std::vector<Error> &all = errors->getErrors();
+    reported.insert(reported.end(), all.begin() + nbErrors, all.end());
+    nbErrors = all.size();
+  };
+  auto lookup = [&](Dependency::Kind kind, const std::string &name,
+                    const any *lookupExpr) -> any * {
+    switch (kind) {
+      case Dependency::Kind::Object:
+        return getObject(name, component, compileDesign, instance,
+                         lookupExpr);
+      case Dependency::Kind::Value:
+        return (expr *)getValue(name, component, compileDesign, instance,
+                                fileName, lineNumber, (any *)lookupExpr, true,
+                                muteErrors);
+      case Dependency::Kind::TaskFunc:
+        return getTaskFunc(name, component, compileDesign, instance, pexpr)
+            .first;
+    }
+    return nullptr;
+  };
+  auto record = [&](Dependency::Kind kind, const std::string &name,
+                    const any *lookupExpr) -> any * {
+    if (memoize) collectErrors();
+    any *found = lookup(kind, name, lookupExpr);
+    if (memoize) {
+      nbErrors = errors->getErrors().size();
+      dependencies.push_back(
+          {kind, name, lookupExpr, ReduceExprMemo::fingerprint(found)});
+    }
+    return found;
+  };
+
+  if (memoize) {
+    // Same lookups, same answers: same result.
+    if (const auto *entries = memo->find(result, pexpr)) {
+      for (const ReduceExprMemo::Entry &entry : *entries) {
+        bool match = true;
+        for (const Dependency &dep : entry.m_dependencies) {
+          any *found = lookup(dep.m_kind, dep.m_name, dep.m_pexpr);
+          if (m_unwind) return nullptr;
+          if (ReduceExprMemo::fingerprint(found) != dep.m_fingerprint) {
+            match = false;
+            break;
+          }
+        }
+        if (match) {
+          memo->countLookup(true);
+          for (Error err : entry.m_errors) errors->addError(err);
+          ElaboratorListener listener(&compileDesign->getSerializer(), false,
+                                      true);
+          return (expr *)UHDM::clone_tree((any *)entry.m_result,
+                                          compileDesign->getSerializer(),
+                                          &listener);
+        }
+      }
+    }
+    memo->countLookup(false);
+    nbErrors = errors->getErrors().size();
+  }
+
   UHDM::GetObjectFunctor getObjectFunctor =
       [&](const std::string &name, const any *inst,
           const any *pexpr) -> UHDM::any * {
-    return getObject(name, component, compileDesign, instance, pexpr);
+    return record(Dependency::Kind::Object, name, pexpr);
   };
   UHDM::GetObjectFunctor getValueFunctor =
       [&](const std::string &name, const any *inst,
           const any *pexpr) -> UHDM::any * {
-    return (expr *)getValue(name, component, compileDesign, instance, fileName,
-                            lineNumber, (any *)pexpr, true, muteErrors);
+    return record(Dependency::Kind::Value, name, pexpr);
   };
   UHDM::GetTaskFuncFunctor getTaskFuncFunctor =
       [&](const std::string &name, const any *inst) -> UHDM::task_func * {
-    auto ret = getTaskFunc(name, component, compileDesign, instance, pexpr);
-    return ret.first;
+    return (task_func *)record(Dependency::Kind::TaskFunc, name, nullptr);
   };
   UHDM::ExprEval eval;
   eval.setGetObjectFunctor(getObjectFunctor);
@@ -774,7 +842,19 @@ expr *CompileHelper::reduceExpr(any *result, bool &invalidValue,
   expr *res =
       eval.reduceExpr(result, invalidValue, m_exprEvalPlaceHolder, pexpr);
   // If loop was detected, drop the partially constructed new value!
-  return m_unwind ? nullptr : res;
+  if (m_unwind) return nullptr;
+  if (memoize && res && !invalidValue && (res->UhdmType() == uhdmconstant)) {
+    // The caller may still edit "res": the memo keeps its own copy.
+    ElaboratorListener listener(&compileDesign->getSerializer(), false, true);
+    collectErrors();
+    ReduceExprMemo::Entry entry;
+    entry.m_dependencies = std::move(dependencies);
+    entry.m_errors = std::move(reported);
+    entry.m_result = (constant *)UHDM::clone_tree(
+        res, compileDesign->getSerializer(), &listener);
+    memo->add(result, pexpr, std::move(entry));
+  }
+  return res;
 }
 
 any *CompileHelper::getValue(const std::string &name,
@@ -42,6 +42,7 @@
 #include <Surelog/Testbench/Program.h>
 #include <Surelog/Utils/StringUtils.h>
 
+#include <cstdint>
 #include <cstring>
 
 // UHDM
@@ -66,6 +67,34 @@ namespace SURELOG {
 
 namespace fs = std::filesystem;
 
+// Regular instances and generate blocks of a definition body.
+static const VObjectTypeBitset kSubInstanceTypes = {
+    VObjectType::slUdp_instantiation, VObjectType::slModule_instantiation,
+    VObjectType::slInterface_instantiation,
+    VObjectType::slProgram_instantiation, VObjectType::slGate_instantiation,
+    VObjectType::slConditional_generate_construct,  // Generate construct are
+                                                    // a kind of instantiation
+    VObjectType::slGenerate_module_conditional_statement,
+    VObjectType::slGenerate_interface_conditional_statement,
+    VObjectType::slLoop_generate_construct,
+    VObjectType::slGenerate_module_loop_statement,
+    VObjectType::slGenerate_interface_loop_statement,
+    VObjectType::slPar_block, VObjectType::slSeq_block,
+    VObjectType::slGenerate_region};
+
+static const VObjectTypeBitset kSubInstanceStopPoints = {
+    VObjectType::slConditional_generate_construct,
+    VObjectType::slGenerate_module_conditional_statement,
+    VObjectType::slGenerate_interface_conditional_statement,
+    VObjectType::slLoop_generate_construct,
+    VObjectType::slGenerate_module_loop_statement,
+    VObjectType::slGenerate_interface_loop_statement,
+    VObjectType::slPar_block,
+    VObjectType::slSeq_block,
+    VObjectType::slModule_declaration,
+    VObjectType::slBind_directive,
+    VObjectType::slGenerate_region};
+
 DesignElaboration::DesignElaboration(CompileDesign* compileDesign)
     : TestbenchElaboration(compileDesign) {
   m_moduleDefFactory = nullptr;
@@ -90,6 +119,9 @@ bool DesignElaboration::elaborate() {
   checkElaboration_();
   reportElaboration_();
   createFileList_();
+  if (m_compileDesign->getCompiler()->getCommandLineParser()->profile()) {
+    m_compileDesign->addProfileInfo(reportProfile_());
+  }
   return true;
 }
 
@@ -803,35 +835,7 @@ void DesignElaboration::elaborateInstance_(
   bindDataTypes_(parent, parent->getDefinition());
 
   // Scan for regular instances and generate blocks
-  VObjectTypeUnorderedSet types = {
-      VObjectType::slUdp_instantiation, VObjectType::slModule_instantiation,
-      VObjectType::slInterface_instantiation,
-      VObjectType::slProgram_instantiation, VObjectType::slGate_instantiation,
-      VObjectType::slConditional_generate_construct,  // Generate construct are
-                                                      // a kind of instantiation
-      VObjectType::slGenerate_module_conditional_statement,
-      VObjectType::slGenerate_interface_conditional_statement,
-      VObjectType::slLoop_generate_construct,
-      VObjectType::slGenerate_module_loop_statement,
-      VObjectType::slGenerate_interface_loop_statement,
-      VObjectType::slPar_block, VObjectType::slSeq_block,
-      VObjectType::slGenerate_region};
-
-  VObjectTypeUnorderedSet stopPoints = {
-      VObjectType::slConditional_generate_construct,
-      VObjectType::slGenerate_module_conditional_statement,
-      VObjectType::slGenerate_interface_conditional_statement,
-      VObjectType::slLoop_generate_construct,
-      VObjectType::slGenerate_module_loop_statement,
-      VObjectType::slGenerate_interface_loop_statement,
-      VObjectType::slPar_block,
-      VObjectType::slSeq_block,
-      VObjectType::slModule_declaration,
-      VObjectType::slBind_directive,
-      VObjectType::slGenerate_region};
-
-  std::vector<NodeId> subInstances =
-      fC->sl_collect_all(nodeId, types, stopPoints);
+  const std::vector<NodeId>& subInstances = collectSubInstances_(fC, nodeId);
   bool elaborated = false;
   for (auto subInstanceId : subInstances) {
     VObjectType type = fC->Type(subInstanceId);
@@ -848,13 +852,10 @@ void DesignElaboration::elaborateInstance_(
         subSubInstances.push_back(subInstanceId);
       } else {
         while (Generate_block) {
-          std::vector<NodeId> subIds =
-              fC->sl_collect_all(Generate_block, types, stopPoints);
-          if (!subIds.empty()) {
-            for (auto id : subIds) {
-              subSubInstances.push_back(id);
-            }
-          } else {
+          const size_t subCount = subSubInstances.size();
+          fC->sl_collect_all(Generate_block, kSubInstanceTypes,
+                             kSubInstanceStopPoints, subSubInstances);
+          if (subSubInstances.size() == subCount) {
             if (DesignComponent* def = parent->getDefinition()) {
               // Compile generate block
               ((ModuleDefinition*)def)->setGenBlockId(Generate_block);
@@ -2019,20 +2020,7 @@ void DesignElaboration::collectParams_(std::vector<std::string>& params,
   }
 
   // Defparams
-  VObjectTypeUnorderedSet types = {VObjectType::slDefparam_assignment};
-  VObjectTypeUnorderedSet stopPoints = {
-      VObjectType::slConditional_generate_construct,
-      VObjectType::slGenerate_module_conditional_statement,
-      VObjectType::slGenerate_interface_conditional_statement,
-      VObjectType::slLoop_generate_construct,
-      VObjectType::slGenerate_module_loop_statement,
-      VObjectType::slGenerate_interface_loop_statement,
-      VObjectType::slPar_block,
-      VObjectType::slSeq_block,
-      VObjectType::slModule_declaration};
-
-  std::vector<NodeId> defParams = fC->sl_collect_all(nodeId, types, stopPoints);
-  for (auto defParam : defParams) {
+  for (auto defParam : collectDefParams_(fC, nodeId)) {
     NodeId hIdent = fC->Child(defParam);
     NodeId var;
     fC->Child(hIdent);
@@ -2168,6 +2156,49 @@ void DesignElaboration::collectParams_(std::vector<std::string>& params,
   }
 }
 
+const std::vector<NodeId>& DesignElaboration::collectSubInstances_(
+    const FileContent* fC, NodeId nodeId) {
+  m_bodyScans++;
+  auto [it, inserted] =
+      m_subInstanceScans.emplace(BodyScanKey(fC, nodeId), std::vector<NodeId>());
+  if (inserted) {
+    fC->sl_collect_all(nodeId, kSubInstanceTypes, kSubInstanceStopPoints,
+                       it->second);
+  } else {
+    m_bodyScanHits++;
+  }
+  return it->second;
+}
+
+const std::vector<NodeId>& DesignElaboration::collectDefParams_(
+    const FileContent* fC, NodeId nodeId) {
+  static const VObjectTypeBitset types = {VObjectType::slDefparam_assignment};
+  static const VObjectTypeBitset stopPoints = {
+      VObjectType::slConditional_generate_construct,
+      VObjectType::slGenerate_module_conditional_statement,
+      VObjectType::slGenerate_interface_conditional_statement,
+      VObjectType::slLoop_generate_construct,
+      VObjectType::slGenerate_module_loop_statement,
+      VObjectType::slGenerate_interface_loop_statement,
+      VObjectType::slPar_block,
+      VObjectType::slSeq_block,
+      VObjectType::slModule_declaration};
+  m_bodyScans++;
+  auto [it, inserted] =
+      m_defParamScans.emplace(BodyScanKey(fC, nodeId), std::vector<NodeId>());
+  if (inserted) {
+    fC->sl_collect_all(nodeId, types, stopPoints, it->second);
+  } else {
+    m_bodyScanHits++;
+  }
+  return it->second;
+}
+
+std::string DesignElaboration::reportProfile_() const {
+  return "Definition body scans: " + std::to_string(m_bodyScans) +
+         ", reused: " + std::to_string(m_bodyScanHits) + "\n";
+}
+
 void DesignElaboration::checkElaboration_() {
   Design* design = m_compileDesign->getCompiler()->getDesign();
   design->checkDefParamUsage();
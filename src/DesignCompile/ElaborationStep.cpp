@@ -286,6 +286,7 @@ bool ElaborationStep::bindTypedefs_() {
           const std::string& need = orig->VpiName();
           if (need == tps->VpiName()) {
             s.unsupported_typespecMaker.Erase((unsupported_typespec*)orig);
+            m_compileDesign->getReduceExprMemo()->clear();
             if (expr* ex = any_cast<expr*>(var)) {
               ex->Typespec(tps);
             } else if (typespec_member* ex = any_cast<typespec_member*>(var)) {
@@ -327,6 +328,7 @@ bool ElaborationStep::bindTypedefs_() {
           if (itr != specs.end()) {
             typespec* tps = (*itr).second;
             s.unsupported_typespecMaker.Erase((unsupported_typespec*)orig);
+            m_compileDesign->getReduceExprMemo()->clear();
             if (expr* ex = any_cast<expr*>(var)) {
               ex->Typespec(tps);
             } else if (typespec_member* ex = any_cast<typespec_member*>(var)) {
@@ -365,6 +367,7 @@ bool ElaborationStep::bindTypedefs_() {
         if (itr != specs.end()) {
           typespec* tps = (*itr).second;
           s.unsupported_typespecMaker.Erase((unsupported_typespec*)orig);
+          m_compileDesign->getReduceExprMemo()->clear();
           if (expr* ex = any_cast<expr*>(var)) {
             ex->Typespec(tps);
           } else if (typespec_member* ex = any_cast<typespec_member*>(var)) {
@@ -401,6 +404,7 @@ bool ElaborationStep::bindTypedefs_() {
         if (itr != specs.end()) {
           typespec* tps = (*itr).second;
           s.unsupported_typespecMaker.Erase((unsupported_typespec*)orig);
+          m_compileDesign->getReduceExprMemo()->clear();
           if (expr* ex = any_cast<expr*>(var)) {
             ex->Typespec(tps);
           } else if (typespec_member* ex = any_cast<typespec_member*>(var)) {
@@ -24,6 +24,7 @@
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
+#include <map>
 #include <string>
 #include <string_view>
 #include <tuple>
@@ -31,6 +32,7 @@
 
 // UHDM
 #include <uhdm/ExprEval.h>
+#include <uhdm/constant.h>
 #include <uhdm/design.h>
 #include <uhdm/expr.h>
 #include <uhdm/module.h>
@@ -402,5 +404,239 @@ endmodule
   }
 }
 
+// Values of the parameters of the top modules.
+void expectParamValues(CompileDesign* compileDesign,
+                       const std::map<std::string, int64_t>& expected) {
+  Compiler* compiler = compileDesign->getCompiler();
+  vpiHandle hdesign = compiler->getUhdmDesign();
+  UHDM::design* udesign = UhdmDesignFromVpiHandle(hdesign);
+  for (auto topMod : *udesign->TopModules()) {
+    for (auto passign : *topMod->Param_assigns()) {
+      const std::string& name = passign->Lhs()->VpiName();
+      UHDM::expr* rhs = (UHDM::expr*)passign->Rhs();
+      EXPECT_EQ(rhs->UhdmType(), UHDM::uhdmconstant) << name;
+      bool invalidValue = false;
+      UHDM::ExprEval eval;
+      EXPECT_EQ(eval.get_value(invalidValue, rhs), expected.at(name)) << name;
+    }
+  }
+}
+
+TEST(Elaboration, ConstantFunctionOnVM) {
+  ElaboratorHarness eharness;
+  Design* design;
+  FileContent* fC;
+  CompileDesign* compileDesign;
+  // Preprocess, Parse, Compile, Elaborate
+  std::tie(design, fC, compileDesign) = eharness.elaborate(R"(
+module top();
+  function integer log2;
+    input integer value;
+    reg [31:0] shifted;
+    integer res;
+    begin
+      if (value < 2)
+        log2 = value;
+      else begin
+        shifted = value - 1;
+        for (res = 0; shifted > 0; res = res + 1)
+          shifted = shifted >> 1;
+        log2 = res;
+      end
+    end
+  endfunction
+  localparam P0 = log2(3);
+  localparam P1 = log2(5);
+  localparam P2 = log2(9);
+  localparam P3 = log2(17);
+  localparam P4 = log2(30);
+  localparam P5 = log2(33);
+  localparam P6 = log2(100);
+  localparam P7 = log2(1000);
+endmodule
+)");
+  const std::map<std::string, int64_t> expected = {
+      {"P0", 2}, {"P1", 3}, {"P2", 4}, {"P3", 5},
+      {"P4", 5}, {"P5", 6}, {"P6", 7}, {"P7", 10}};
+  expectParamValues(compileDesign, expected);
+  // Every call runs on the machine alone.
+  EvalFuncVM* vm = compileDesign->getEvalFuncVM();
+  EXPECT_GT(vm->getVMCallCount(), 0);
+  EXPECT_EQ(vm->getVMCallCount(), vm->getCallCount());
+}
+
+TEST(Elaboration, ConstantFunctionReturnType) {
+  ElaboratorHarness eharness;
+  Design* design;
+  FileContent* fC;
+  CompileDesign* compileDesign;
+  // The result has the width and sign of the return type
+  std::tie(design, fC, compileDesign) = eharness.elaborate(R"(
+module top();
+  function automatic logic [7:0] low_byte(int n);
+    low_byte = n % 256;
+  endfunction
+  localparam P0 = low_byte(200);
+endmodule
+)");
+  expectParamValues(compileDesign, {{"P0", 200}});
+  vpiHandle hdesign = compileDesign->getCompiler()->getUhdmDesign();
+  UHDM::design* udesign = UhdmDesignFromVpiHandle(hdesign);
+  for (auto topMod : *udesign->TopModules()) {
+    for (auto passign : *topMod->Param_assigns()) {
+      const UHDM::constant* c = (const UHDM::constant*)passign->Rhs();
+      EXPECT_EQ(c->VpiSize(), 8);
+      EXPECT_EQ(c->VpiValue(), "UINT:200");
+    }
+  }
+  EXPECT_EQ(compileDesign->getEvalFuncVM()->getVMCallCount(), 1);
+}
+
+TEST(Elaboration, ConstantFunctionLeftToExprEval) {
+  ElaboratorHarness eharness;
+  Design* design;
+  FileContent* fC;
+  CompileDesign* compileDesign;
+  // Calls to other functions are not compiled, ExprEval evaluates quad
+  std::tie(design, fC, compileDesign) = eharness.elaborate(R"(
+module top();
+  function automatic int twice(int n);
+    twice = 2 * n;
+  endfunction
+  function automatic int quad(int n);
+    quad = twice(twice(n));
+  endfunction
+  localparam P0 = quad(3);
+  localparam P1 = quad(5);
+endmodule
+)");
+  expectParamValues(compileDesign, {{"P0", 12}, {"P1", 20}});
+  EXPECT_EQ(compileDesign->getEvalFuncVM()->getVMCallCount(), 0);
+}
+
+TEST(Elaboration, ConstantFunctionShadowedLocal) {
+  ElaboratorHarness eharness;
+  Design* design;
+  FileContent* fC;
+  CompileDesign* compileDesign;
+  // The block local x is another variable than the function local x
+  std::tie(design, fC, compileDesign) = eharness.elaborate(R"(
+module top();
+  function automatic int shadow(int n);
+    int x;
+    x = n;
+    begin
+      int x = 2 * n;
+      shadow = x;
+    end
+    shadow = shadow + x;
+  endfunction
+  localparam P0 = shadow(6);
+  localparam P1 = shadow(7);
+  localparam P2 = shadow(8);
+  localparam P3 = shadow(9);
+  localparam P4 = shadow(10);
+endmodule
+)");
+  expectParamValues(compileDesign, {{"P0", 18},
+                                    {"P1", 21},
+                                    {"P2", 24},
+                                    {"P3", 27},
+                                    {"P4", 30}});
+  EXPECT_GT(compileDesign->getEvalFuncVM()->getVMCallCount(), 0);
+}
+
+TEST(Elaboration, ConstantFunctionBlockLocalReentry) {
+  ElaboratorHarness eharness;
+  Design* design;
+  FileContent* fC;
+  CompileDesign* compileDesign;
+  // seen is a new variable on each iteration, it does not keep the value
+  // of the first one
+  std::tie(design, fC, compileDesign) = eharness.elaborate(R"(
+module top();
+  function automatic int first_only(int n);
+    first_only = 0;
+    for (int i = 0; i < n; i++) begin
+      int seen;
+      if (i == 0) seen = 10;
+      first_only = first_only + seen;
+    end
+  endfunction
+  localparam P0 = first_only(1);
+  localparam P1 = first_only(2);
+  localparam P2 = first_only(3);
+endmodule
+)");
+  expectParamValues(compileDesign, {{"P0", 10}, {"P1", 10}, {"P2", 10}});
+}
+
+TEST(Elaboration, ConstantFunctionMixedSignEquality) {
+  ElaboratorHarness eharness;
+  Design* design;
+  FileContent* fC;
+  CompileDesign* compileDesign;
+  // Compared as 32 bits unsigned values, -1 is 32'hFFFFFFFF
+  std::tie(design, fC, compileDesign) = eharness.elaborate(R"(
+module top();
+  function automatic int all_ones(int a);
+    all_ones = (a == 32'hFFFFFFFF);
+  endfunction
+  localparam P0 = all_ones(5);
+  localparam P1 = all_ones(6);
+  localparam P2 = all_ones(7);
+  localparam P3 = all_ones(-1);
+endmodule
+)");
+  expectParamValues(compileDesign,
+                    {{"P0", 0}, {"P1", 0}, {"P2", 0}, {"P3", 1}});
+}
+
+TEST(Elaboration, ReducedExpressionsPerInstance) {
+  ElaboratorHarness eharness;
+  Design* design;
+  FileContent* fC;
+  CompileDesign* compileDesign;
+  // The expressions of sub are reduced for each instance, u3 reads the same
+  // parameter values as u1
+  std::tie(design, fC, compileDesign) = eharness.elaborate(R"(
+module sub #(parameter W = 1, parameter D = 0) ();
+  localparam P0 = W * 2 + 1;
+  localparam P1 = (W << 2) - D;
+endmodule
+module top();
+  sub #(.W(4)) u1();
+  sub #(.W(8), .D(3)) u2();
+  sub #(.W(4)) u3();
+endmodule
+)");
+  const std::map<std::string, std::map<std::string, int64_t>> expected = {
+      {"u1", {{"P0", 9}, {"P1", 16}}},
+      {"u2", {{"P0", 17}, {"P1", 29}}},
+      {"u3", {{"P0", 9}, {"P1", 16}}}};
+  vpiHandle hdesign = compileDesign->getCompiler()->getUhdmDesign();
+  UHDM::design* udesign = UhdmDesignFromVpiHandle(hdesign);
+  std::map<std::string, std::map<std::string, int64_t>> values;
+  for (auto topMod : *udesign->TopModules()) {
+    if (topMod->Modules() == nullptr) continue;
+    for (auto sub : *topMod->Modules()) {
+      if (sub->Param_assigns() == nullptr) continue;
+      for (auto passign : *sub->Param_assigns()) {
+        const std::string& name = passign->Lhs()->VpiName();
+        if (name.front() != 'P') continue;
+        UHDM::expr* rhs = (UHDM::expr*)passign->Rhs();
+        EXPECT_EQ(rhs->UhdmType(), UHDM::uhdmconstant) << name;
+        bool invalidValue = false;
+        UHDM::ExprEval eval;
+        values[sub->VpiName()][name] = eval.get_value(invalidValue, rhs);
+      }
+    }
+  }
+  EXPECT_EQ(values, expected);
+  const ReduceExprMemo* memo = compileDesign->getReduceExprMemo();
+  EXPECT_GT(memo->getHitCount(), 0);
+  EXPECT_LT(memo->getHitCount(), memo->getLookupCount());
+}
+
 }  // namespace
 }  // namespace SURELOG
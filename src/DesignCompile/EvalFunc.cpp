@@ -50,6 +50,17 @@ expr* CompileHelper::EvalFunc(UHDM::function* func, std::vector<any*>* args,
                               ValuedComponentI* instance,
                               const fs::path& fileName, int lineNumber,
                               any* pexpr) {
+  EvalFuncVM* vm = compileDesign->getEvalFuncVM();
+  EvalFuncVM::ValueLookup lookup = [&](const std::string& name) -> any* {
+    // Muted, ExprEval reports the errors when the call falls back to it
+    return getValue(name, component, compileDesign, instance, fileName,
+                    lineNumber, pexpr, true, true);
+  };
+  if (constant* result =
+          vm->evaluate(func, args, lookup, compileDesign->getSerializer())) {
+    return result;
+  }
+
   UHDM::GetObjectFunctor getObjectFunctor =
       [&](const std::string& name, const any* inst,
           const any* pexpr) -> UHDM::any* {
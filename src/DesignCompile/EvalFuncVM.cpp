@@ -0,0 +1,902 @@
+/*
+ Copyright 2022 The Surelog Team.
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+/*
+ * File:   EvalFuncVM.cpp
+ * Author: surelog
+ */
+
+#include <Surelog/DesignCompile/EvalFuncVM.h>
+
+// UHDM
+#include <uhdm/ExprEval.h>
+#include <uhdm/uhdm.h>
+
+#include <limits>
+
+namespace SURELOG {
+
+using namespace UHDM;  // NOLINT (using a bunch of them)
+
+using OpCode = EvalFuncVM::OpCode;
+
+namespace {
+// Integral value of a constant, when 64 bits hold it exactly.
+bool constantValue(const any* object, int64_t& value) {
+  if ((object == nullptr) || (object->UhdmType() != uhdmconstant)) {
+    return false;
+  }
+  const constant* c = (const constant*)object;
+  const int constType = c->VpiConstType();
+  switch (constType) {
+    case vpiIntConst:
+    case vpiUIntConst:
+    case vpiDecConst:
+    case vpiBinaryConst:
+    case vpiHexConst:
+    case vpiOctConst:
+      break;
+    default:
+      return false;
+  }
+  if (c->VpiSize() > 64) return false;
+  bool invalidValue = false;
+  ExprEval eval;
+  value = eval.get_value(invalidValue, c);
+  if (invalidValue) return false;
+  // Only INT: is negative, the other forms would be a wrapped 64 bits value.
+  return (value >= 0) || (constType == vpiIntConst);
+}
+
+bool rangesWidth(const VectorOfrange* ranges, uint16_t& width) {
+  if ((ranges == nullptr) || ranges->empty()) {
+    width = 1;
+    return true;
+  }
+  if (ranges->size() != 1) return false;
+  const range* r = ranges->front();
+  int64_t left = 0;
+  int64_t right = 0;
+  if (!constantValue(r->Left_expr(), left) ||
+      !constantValue(r->Right_expr(), right)) {
+    return false;
+  }
+  const int64_t size = ((left > right) ? left - right : right - left) + 1;
+  if (size > 64) return false;
+  width = (uint16_t)size;
+  return true;
+}
+
+// Integral types up to 64 bits.
+bool typespecType(const typespec* tps, uint16_t& width, bool& isSigned) {
+  if (tps == nullptr) return false;
+  switch (tps->UhdmType()) {
+    case uhdmbyte_typespec:
+      width = 8;
+      isSigned = ((const byte_typespec*)tps)->VpiSigned();
+      return true;
+    case uhdmshort_int_typespec:
+      width = 16;
+      isSigned = ((const short_int_typespec*)tps)->VpiSigned();
+      return true;
+    case uhdmint_typespec:
+      width = 32;
+      isSigned = ((const int_typespec*)tps)->VpiSigned();
+      return true;
+    case uhdminteger_typespec:
+      width = 32;
+      isSigned = ((const integer_typespec*)tps)->VpiSigned();
+      return true;
+    case uhdmlong_int_typespec:
+      width = 64;
+      isSigned = ((const long_int_typespec*)tps)->VpiSigned();
+      return true;
+    case uhdmlogic_typespec: {
+      const logic_typespec* lts = (const logic_typespec*)tps;
+      isSigned = lts->VpiSigned();
+      return rangesWidth(lts->Ranges(), width);
+    }
+    case uhdmbit_typespec: {
+      const bit_typespec* bts = (const bit_typespec*)tps;
+      isSigned = bts->VpiSigned();
+      return rangesWidth(bts->Ranges(), width);
+    }
+    default:
+      return false;
+  }
+}
+
+bool variableType(const any* object, uint16_t& width, bool& isSigned) {
+  if (object == nullptr) return false;
+  const UHDM_OBJECT_TYPE type = object->UhdmType();
+  switch (type) {
+    case uhdmbyte_var:
+    case uhdmshort_int_var:
+    case uhdmint_var:
+    case uhdminteger_var:
+    case uhdmlong_int_var:
+    case uhdmlogic_var:
+    case uhdmbit_var:
+      break;
+    default:
+      return false;
+  }
+  const variables* var = (const variables*)object;
+  if (var->Expr() != nullptr) return false;
+  if (const typespec* tps = var->Typespec()) {
+    return typespecType(tps, width, isSigned);
+  }
+  isSigned = var->VpiSigned();
+  switch (type) {
+    case uhdmbyte_var:
+      width = 8;
+      return true;
+    case uhdmshort_int_var:
+      width = 16;
+      return true;
+    case uhdmint_var:
+    case uhdminteger_var:
+      width = 32;
+      return true;
+    case uhdmlong_int_var:
+      width = 64;
+      return true;
+    case uhdmlogic_var:
+      return rangesWidth(((const logic_var*)var)->Ranges(), width);
+    default:
+      return false;
+  }
+}
+
+bool fits(const EvalFuncVM::Slot& slot, int64_t value) {
+  if (slot.m_width >= 64) return slot.m_signed || (value >= 0);
+  if (slot.m_signed) {
+    const int64_t bound = int64_t(1) << (slot.m_width - 1);
+    return (value >= -bound) && (value < bound);
+  }
+  return (value >= 0) && (value < (int64_t(1) << slot.m_width));
+}
+
+bool binaryOpCode(int opType, OpCode& op) {
+  switch (opType) {
+    case vpiAddOp:
+      op = OpCode::Add;
+      return true;
+    case vpiSubOp:
+      op = OpCode::Sub;
+      return true;
+    case vpiMultOp:
+      op = OpCode::Mul;
+      return true;
+    case vpiDivOp:
+      op = OpCode::Div;
+      return true;
+    case vpiModOp:
+      op = OpCode::Mod;
+      return true;
+    case vpiPowerOp:
+      op = OpCode::Pow;
+      return true;
+    case vpiLShiftOp:
+    case vpiArithLShiftOp:
+      op = OpCode::Shl;
+      return true;
+    case vpiRShiftOp:
+    case vpiArithRShiftOp:
+      op = OpCode::Shr;
+      return true;
+    case vpiBitAndOp:
+      op = OpCode::BitAnd;
+      return true;
+    case vpiBitOrOp:
+      op = OpCode::BitOr;
+      return true;
+    case vpiBitXorOp:
+      op = OpCode::BitXor;
+      return true;
+    case vpiEqOp:
+    case vpiCaseEqOp:
+      op = OpCode::Eq;
+      return true;
+    case vpiNeqOp:
+    case vpiCaseNeqOp:
+      op = OpCode::Neq;
+      return true;
+    case vpiLtOp:
+      op = OpCode::Lt;
+      return true;
+    case vpiLeOp:
+      op = OpCode::Le;
+      return true;
+    case vpiGtOp:
+      op = OpCode::Gt;
+      return true;
+    case vpiGeOp:
+      op = OpCode::Ge;
+      return true;
+    case vpiLogAndOp:
+      op = OpCode::LogAnd;
+      return true;
+    case vpiLogOrOp:
+      op = OpCode::LogOr;
+      return true;
+    default:
+      return false;
+  }
+}
+
+// False when the 64 bits result is not the one of ExprEval, or of the
+// language: overflow, division by zero, negative operands (the signedness
+// of the operands would matter, -1 == 32'hFFFFFFFF is true).
+bool binary(OpCode op, int64_t a, int64_t b, int64_t& result) {
+  constexpr int64_t kMax = std::numeric_limits<int64_t>::max();
+  constexpr int64_t kMin = std::numeric_limits<int64_t>::min();
+  switch (op) {
+    case OpCode::Add:
+      if ((b > 0) ? (a > kMax - b) : (a < kMin - b)) return false;
+      result = a + b;
+      return true;
+    case OpCode::Sub:
+      if ((b < 0) ? (a > kMax + b) : (a < kMin + b)) return false;
+      result = a - b;
+      return true;
+    case OpCode::Mul:
+      if ((a < 0) || (b < 0)) return false;
+      if ((a != 0) && (b > kMax / a)) return false;
+      result = a * b;
+      return true;
+    case OpCode::Div:
+      if ((a < 0) || (b <= 0)) return false;
+      result = a / b;
+      return true;
+    case OpCode::Mod:
+      if ((a < 0) || (b <= 0)) return false;
+      result = a % b;
+      return true;
+    case OpCode::Pow: {
+      if ((a < 0) || (b < 0)) return false;
+      int64_t power = 1;
+      for (int64_t i = 0; i < b; i++) {
+        if ((a != 0) && (power > kMax / a)) return false;
+        power *= a;
+        if (power <= 1) break;  // 0 or 1 from now on
+      }
+      result = power;
+      return true;
+    }
+    case OpCode::Shl:
+      if ((a < 0) || (b < 0) || (b > 62)) return false;
+      if (a > (kMax >> b)) return false;
+      result = a << b;
+      return true;
+    case OpCode::Shr:
+      if ((a < 0) || (b < 0)) return false;
+      result = (b > 62) ? 0 : (a >> b);
+      return true;
+    case OpCode::BitAnd:
+      if ((a < 0) || (b < 0)) return false;
+      result = a & b;
+      return true;
+    case OpCode::BitOr:
+      if ((a < 0) || (b < 0)) return false;
+      result = a | b;
+      return true;
+    case OpCode::BitXor:
+      if ((a < 0) || (b < 0)) return false;
+      result = a ^ b;
+      return true;
+    case OpCode::Eq:
+      if ((a < 0) || (b < 0)) return false;
+      result = (a == b);
+      return true;
+    case OpCode::Neq:
+      if ((a < 0) || (b < 0)) return false;
+      result = (a != b);
+      return true;
+    case OpCode::Lt:
+      if ((a < 0) || (b < 0)) return false;
+      result = (a < b);
+      return true;
+    case OpCode::Le:
+      if ((a < 0) || (b < 0)) return false;
+      result = (a <= b);
+      return true;
+    case OpCode::Gt:
+      if ((a < 0) || (b < 0)) return false;
+      result = (a > b);
+      return true;
+    case OpCode::Ge:
+      if ((a < 0) || (b < 0)) return false;
+      result = (a >= b);
+      return true;
+    case OpCode::LogAnd:
+      result = (a != 0) && (b != 0);
+      return true;
+    case OpCode::LogOr:
+      result = (a != 0) || (b != 0);
+      return true;
+    default:
+      return false;
+  }
+}
+
+class ProgramBuilder final {
+ public:
+  explicit ProgramBuilder(EvalFuncVM::Program* program) : m_program(program) {}
+
+  bool build(const function* func) {
+    m_scopes.emplace_back();
+    if ((func->Parameters() && !func->Parameters()->empty()) ||
+        (func->Param_assigns() && !func->Param_assigns()->empty())) {
+      return false;
+    }
+    if (const VectorOfio_decl* ios = func->Io_decls()) {
+      for (const io_decl* io : *ios) {
+        if (io->VpiDirection() != vpiInput) return false;
+        if (io->Ranges() && !io->Ranges()->empty()) return false;
+        uint16_t width = 0;
+        bool isSigned = false;
+        if (!typespecType(io->Typespec(), width, isSigned)) return false;
+        if (declare(io->VpiName(), width, isSigned) < 0) return false;
+      }
+    }
+    m_program->m_inputCount = m_program->m_slots.size();
+    uint16_t width = 0;
+    bool isSigned = false;
+    if (!variableType(func->Return(), width, isSigned)) return false;
+    const int32_t returnSlot = declare(func->VpiName(), width, isSigned);
+    if (returnSlot < 0) return false;
+    m_program->m_returnSlot = returnSlot;
+    m_program->m_returnTypespec =
+        ((const variables*)func->Return())->Typespec();
+    if (const VectorOfvariables* vars = func->Variables()) {
+      for (const variables* var : *vars) {
+        if (!variableType(var, width, isSigned)) return false;
+        if (declare(var->VpiName(), width, isSigned) < 0) return false;
+      }
+    }
+    if (const any* body = func->Stmt()) {
+      if (!compileStmt(body)) return false;
+    }
+    emit(OpCode::Return);
+    return true;
+  }
+
+ private:
+  struct Loop final {
+    std::vector<size_t> m_breaks;
+    std::vector<size_t> m_continues;
+  };
+
+  // Index of the new slot, -1 if the name is taken in the current scope.
+  // Each declaration has its own slot, also when it shadows another one.
+  int32_t declare(const std::string& name, uint16_t width, bool isSigned) {
+    if (name.empty() || (m_scopes.back().find(name) != m_scopes.back().end())) {
+      return -1;
+    }
+    return addSlot(name, width, isSigned);
+  }
+
+  int32_t addSlot(const std::string& name, uint16_t width, bool isSigned) {
+    const int32_t index = m_program->m_slots.size();
+    m_program->m_slots.push_back({name, width, isSigned});
+    if (!name.empty()) m_scopes.back().emplace(name, index);
+    return index;
+  }
+
+  // Innermost declaration of the name.
+  int32_t findSlot(const std::string& name) const {
+    for (auto scope = m_scopes.rbegin(); scope != m_scopes.rend(); ++scope) {
+      auto found = scope->find(name);
+      if (found != scope->end()) return found->second;
+    }
+    return -1;
+  }
+
+  // Locals of a block, unassigned again each time the block is entered:
+  // reading them before an assignment leaves the call to ExprEval.
+  bool compileBlock(const VectorOfvariables* vars, const VectorOfany* stmts) {
+    m_scopes.emplace_back();
+    if (vars != nullptr) {
+      for (const variables* var : *vars) {
+        uint16_t width = 0;
+        bool isSigned = false;
+        if (!variableType(var, width, isSigned)) return false;
+        const int32_t slot = declare(var->VpiName(), width, isSigned);
+        if (slot < 0) return false;
+        emit(OpCode::Reset, slot);
+      }
+    }
+    if (!compileStmts(stmts)) return false;
+    m_scopes.pop_back();
+    return true;
+  }
+
+  size_t emit(OpCode op, int32_t arg = 0) {
+    m_program->m_code.push_back({op, arg});
+    return m_program->m_code.size() - 1;
+  }
+
+  size_t here() const { return m_program->m_code.size(); }
+
+  void patch(size_t at, size_t target) {
+    m_program->m_code[at].m_arg = target;
+  }
+
+  void pushConstant(int64_t value) {
+    emit(OpCode::PushConst, m_program->m_constants.size());
+    m_program->m_constants.push_back(value);
+  }
+
+  // Target of an assignment: a declared name.
+  int32_t lvalueSlot(const any* lhs) const {
+    if ((lhs == nullptr) || (lhs->UhdmType() != uhdmref_obj)) return -1;
+    return findSlot(((const ref_obj*)lhs)->VpiName());
+  }
+
+  bool compileStmts(const VectorOfany* stmts) {
+    if (stmts == nullptr) return true;
+    for (const any* stmt : *stmts) {
+      if (!compileStmt(stmt)) return false;
+    }
+    return true;
+  }
+
+  bool compileAssignment(const any* lhs, const any* rhs, int opType) {
+    const int32_t slot = lvalueSlot(lhs);
+    if (slot < 0) return false;
+    if (opType == vpiAssignmentOp) {
+      if (!compileExpr(rhs)) return false;
+    } else {
+      OpCode op;
+      if (!binaryOpCode(opType, op)) return false;
+      emit(OpCode::Load, slot);
+      if (!compileExpr(rhs)) return false;
+      emit(op);
+    }
+    emit(OpCode::Store, slot);
+    return true;
+  }
+
+  // Condition, body and loop back for while and for loops.
+  bool compileLoop(const any* condition, const any* body,
+                   const VectorOfany* increments) {
+    const size_t top = here();
+    size_t exit = 0;
+    if (condition != nullptr) {
+      if (!compileExpr(condition)) return false;
+      exit = emit(OpCode::JumpIfZero);
+    }
+    m_loops.emplace_back();
+    if ((body != nullptr) && !compileStmt(body)) return false;
+    const size_t next = here();
+    if (!compileStmts(increments)) return false;
+    emit(OpCode::Jump, top);
+    if (condition != nullptr) patch(exit, here());
+    closeLoop(next);
+    return true;
+  }
+
+  void closeLoop(size_t next) {
+    for (size_t at : m_loops.back().m_breaks) patch(at, here());
+    for (size_t at : m_loops.back().m_continues) patch(at, next);
+    m_loops.pop_back();
+  }
+
+  bool compileStmt(const any* stmt) {
+    if (stmt == nullptr) return false;
+    switch (stmt->UhdmType()) {
+      case uhdmbegin: {
+        const begin* block = (const begin*)stmt;
+        return compileBlock(block->Variables(), block->Stmts());
+      }
+      case uhdmnamed_begin: {
+        const named_begin* block = (const named_begin*)stmt;
+        return compileBlock(block->Variables(), block->Stmts());
+      }
+      case uhdmnull_stmt:
+        return true;
+      case uhdmassignment: {
+        const assignment* assign = (const assignment*)stmt;
+        if (assign->Delay_control() != nullptr) return false;
+        return compileAssignment(assign->Lhs(), assign->Rhs(),
+                                 assign->VpiOpType());
+      }
+      case uhdmassign_stmt: {
+        const assign_stmt* assign = (const assign_stmt*)stmt;
+        const any* lhs = assign->Lhs();
+        if ((lhs == nullptr) || (lhs->UhdmType() == uhdmref_obj)) {
+          return compileAssignment(lhs, assign->Rhs(), vpiAssignmentOp);
+        }
+        // Declaration, of a for loop variable or in a block. A variable of
+        // the block is already declared if also listed in its variables.
+        uint16_t width = 0;
+        bool isSigned = false;
+        if (!variableType(lhs, width, isSigned)) return false;
+        const std::string& name = ((const variables*)lhs)->VpiName();
+        int32_t slot = -1;
+        auto found = m_scopes.back().find(name);
+        if (found == m_scopes.back().end()) {
+          slot = declare(name, width, isSigned);
+          if (slot < 0) return false;
+          emit(OpCode::Reset, slot);
+        } else {
+          slot = found->second;
+          const EvalFuncVM::Slot& existing = m_program->m_slots[slot];
+          if ((slot <= (int32_t)m_program->m_returnSlot) ||
+              (existing.m_width != width) || (existing.m_signed != isSigned)) {
+            return false;
+          }
+        }
+        if (assign->Rhs() == nullptr) return true;
+        if (!compileExpr(assign->Rhs())) return false;
+        emit(OpCode::Store, slot);
+        return true;
+      }
+      case uhdmif_stmt: {
+        const if_stmt* ifst = (const if_stmt*)stmt;
+        if (!compileExpr(ifst->VpiCondition())) return false;
+        const size_t skip = emit(OpCode::JumpIfZero);
+        if (!compileStmt(ifst->VpiStmt())) return false;
+        patch(skip, here());
+        return true;
+      }
+      case uhdmif_else: {
+        const if_else* ifst = (const if_else*)stmt;
+        if (!compileExpr(ifst->VpiCondition())) return false;
+        const size_t toElse = emit(OpCode::JumpIfZero);
+        if (!compileStmt(ifst->VpiStmt())) return false;
+        const size_t toEnd = emit(OpCode::Jump);
+        patch(toElse, here());
+        if (!compileStmt(ifst->VpiElseStmt())) return false;
+        patch(toEnd, here());
+        return true;
+      }
+      case uhdmfor_stmt: {
+        // The loop variables are only visible in the loop.
+        const for_stmt* forst = (const for_stmt*)stmt;
+        m_scopes.emplace_back();
+        if (!compileStmts(forst->VpiForInitStmts()) ||
+            !compileLoop(forst->VpiCondition(), forst->VpiStmt(),
+                         forst->VpiForIncStmts())) {
+          return false;
+        }
+        m_scopes.pop_back();
+        return true;
+      }
+      case uhdmwhile_stmt: {
+        const while_stmt* whilest = (const while_stmt*)stmt;
+        if (whilest->VpiCondition() == nullptr) return false;
+        return compileLoop(whilest->VpiCondition(), whilest->VpiStmt(),
+                           nullptr);
+      }
+      case uhdmdo_while: {
+        const do_while* dowhile = (const do_while*)stmt;
+        const size_t top = here();
+        m_loops.emplace_back();
+        if ((dowhile->VpiStmt() != nullptr) &&
+            !compileStmt(dowhile->VpiStmt())) {
+          return false;
+        }
+        const size_t next = here();
+        if (!compileExpr(dowhile->VpiCondition())) return false;
+        emit(OpCode::LogNot);
+        emit(OpCode::JumpIfZero, top);
+        closeLoop(next);
+        return true;
+      }
+      case uhdmrepeat: {
+        const repeat* rep = (const repeat*)stmt;
+        // Hidden down counter.
+        const int32_t counter = addSlot("", 64, true);
+        if (!compileExpr(rep->VpiCondition())) return false;
+        emit(OpCode::Store, counter);
+        const size_t top = here();
+        emit(OpCode::Load, counter);
+        pushConstant(0);
+        emit(OpCode::Gt);
+        const size_t exit = emit(OpCode::JumpIfZero);
+        m_loops.emplace_back();
+        if ((rep->VpiStmt() != nullptr) && !compileStmt(rep->VpiStmt())) {
+          return false;
+        }
+        const size_t next = here();
+        emit(OpCode::Load, counter);
+        pushConstant(1);
+        emit(OpCode::Sub);
+        emit(OpCode::Store, counter);
+        emit(OpCode::Jump, top);
+        patch(exit, here());
+        closeLoop(next);
+        return true;
+      }
+      case uhdmreturn_stmt: {
+        const return_stmt* ret = (const return_stmt*)stmt;
+        if (const any* value = ret->VpiCondition()) {
+          if (!compileExpr(value)) return false;
+          emit(OpCode::Store, m_program->m_returnSlot);
+        }
+        emit(OpCode::Return);
+        return true;
+      }
+      case uhdmbreak_stmt:
+        if (m_loops.empty()) return false;
+        m_loops.back().m_breaks.push_back(emit(OpCode::Jump));
+        return true;
+      case uhdmcontinue_stmt:
+        if (m_loops.empty()) return false;
+        m_loops.back().m_continues.push_back(emit(OpCode::Jump));
+        return true;
+      case uhdmoperation: {
+        // i++, --i, ... as a statement.
+        const operation* op = (const operation*)stmt;
+        const int opType = op->VpiOpType();
+        const bool increment =
+            (opType == vpiPostIncOp) || (opType == vpiPreIncOp);
+        const bool decrement =
+            (opType == vpiPostDecOp) || (opType == vpiPreDecOp);
+        const VectorOfany* operands = op->Operands();
+        if ((!increment && !decrement) || (operands == nullptr) ||
+            (operands->size() != 1)) {
+          return false;
+        }
+        const int32_t slot = lvalueSlot(operands->front());
+        if (slot < 0) return false;
+        emit(OpCode::Load, slot);
+        pushConstant(1);
+        emit(increment ? OpCode::Add : OpCode::Sub);
+        emit(OpCode::Store, slot);
+        return true;
+      }
+      default:
+        return false;
+    }
+  }
+
+  bool compileExpr(const any* object) {
+    if (object == nullptr) return false;
+    switch (object->UhdmType()) {
+      case uhdmconstant: {
+        int64_t value = 0;
+        if (!constantValue(object, value)) return false;
+        pushConstant(value);
+        return true;
+      }
+      case uhdmref_obj: {
+        const std::string& name = ((const ref_obj*)object)->VpiName();
+        if (name.empty()) return false;
+        const int32_t slot = findSlot(name);
+        if (slot >= 0) {
+          emit(OpCode::Load, slot);
+          return true;
+        }
+        auto [found, inserted] =
+            m_externalIndex.emplace(name, m_program->m_externals.size());
+        if (inserted) m_program->m_externals.push_back(name);
+        emit(OpCode::LoadExternal, found->second);
+        return true;
+      }
+      case uhdmsys_func_call: {
+        const sys_func_call* call = (const sys_func_call*)object;
+        const VectorOfany* args = call->Tf_call_args();
+        if ((call->VpiName() != "$clog2") || (args == nullptr) ||
+            (args->size() != 1)) {
+          return false;
+        }
+        if (!compileExpr(args->front())) return false;
+        emit(OpCode::Clog2);
+        return true;
+      }
+      case uhdmoperation:
+        break;
+      default:
+        return false;
+    }
+    const operation* op = (const operation*)object;
+    const VectorOfany* operands = op->Operands();
+    if (operands == nullptr) return false;
+    const int opType = op->VpiOpType();
+    if (operands->size() == 1) {
+      if (!compileExpr(operands->front())) return false;
+      switch (opType) {
+        case vpiMinusOp:
+          emit(OpCode::Neg);
+          return true;
+        case vpiPlusOp:
+          return true;
+        case vpiNotOp:
+          emit(OpCode::LogNot);
+          return true;
+        default:
+          return false;
+      }
+    }
+    if ((operands->size() == 3) && (opType == vpiConditionOp)) {
+      if (!compileExpr(operands->at(0))) return false;
+      const size_t toFalse = emit(OpCode::JumpIfZero);
+      if (!compileExpr(operands->at(1))) return false;
+      const size_t toEnd = emit(OpCode::Jump);
+      patch(toFalse, here());
+      if (!compileExpr(operands->at(2))) return false;
+      patch(toEnd, here());
+      return true;
+    }
+    OpCode code;
+    if ((operands->size() != 2) || !binaryOpCode(opType, code)) return false;
+    if (!compileExpr(operands->at(0)) || !compileExpr(operands->at(1))) {
+      return false;
+    }
+    emit(code);
+    return true;
+  }
+
+  EvalFuncVM::Program* const m_program;
+  // Names visible at the point being compiled: the function (inputs, return
+  // value, locals), then one scope per enclosing block and for loop.
+  std::vector<std::unordered_map<std::string, int32_t>> m_scopes;
+  std::unordered_map<std::string, int32_t> m_externalIndex;
+  std::vector<Loop> m_loops;
+};
+}  // namespace
+
+std::unique_ptr<EvalFuncVM::Program> EvalFuncVM::compile(
+    const function* func) {
+  if (func == nullptr) return nullptr;
+  auto program = std::make_unique<Program>();
+  ProgramBuilder builder(program.get());
+  if (!builder.build(func)) return nullptr;
+  return program;
+}
+
+bool EvalFuncVM::run(const Program& program, const std::vector<any*>* args,
+                     const ValueLookup& lookup, int64_t& result) {
+  const size_t argCount = (args == nullptr) ? 0 : args->size();
+  if (argCount != program.m_inputCount) return false;
+  const size_t slotCount = program.m_slots.size();
+  std::vector<int64_t> frame(slotCount, 0);
+  std::vector<uint8_t> assigned(slotCount, 0);
+  for (size_t i = 0; i < argCount; i++) {
+    if (!constantValue(args->at(i), frame[i]) ||
+        !fits(program.m_slots[i], frame[i])) {
+      return false;
+    }
+    assigned[i] = 1;
+  }
+  std::vector<int64_t> externals(program.m_externals.size(), 0);
+  std::vector<uint8_t> looked(program.m_externals.size(), 0);
+  std::vector<int64_t> stack;
+  stack.reserve(16);
+  const Instruction* const code = program.m_code.data();
+  uint64_t jumps = 0;
+  size_t pc = 0;
+  while (true) {
+    const Instruction& ins = code[pc++];
+    switch (ins.m_op) {
+      case OpCode::PushConst:
+        stack.push_back(program.m_constants[ins.m_arg]);
+        break;
+      case OpCode::Reset:
+        assigned[ins.m_arg] = 0;
+        break;
+      case OpCode::Load:
+        if (!assigned[ins.m_arg]) return false;
+        stack.push_back(frame[ins.m_arg]);
+        break;
+      case OpCode::Store: {
+        const int64_t value = stack.back();
+        stack.pop_back();
+        if (!fits(program.m_slots[ins.m_arg], value)) return false;
+        frame[ins.m_arg] = value;
+        assigned[ins.m_arg] = 1;
+        break;
+      }
+      case OpCode::LoadExternal:
+        if (!looked[ins.m_arg]) {
+          if (!constantValue(lookup(program.m_externals[ins.m_arg]),
+                             externals[ins.m_arg])) {
+            return false;
+          }
+          looked[ins.m_arg] = 1;
+        }
+        stack.push_back(externals[ins.m_arg]);
+        break;
+      case OpCode::Neg:
+        if (stack.back() == std::numeric_limits<int64_t>::min()) return false;
+        stack.back() = -stack.back();
+        break;
+      case OpCode::LogNot:
+        stack.back() = (stack.back() == 0);
+        break;
+      case OpCode::Clog2: {
+        int64_t value = stack.back();
+        if (value <= 0) return false;
+        int64_t bits = 0;
+        for (value = value - 1; value > 0; value >>= 1) bits++;
+        stack.back() = bits;
+        break;
+      }
+      case OpCode::Jump:
+        if (++jumps > kMaxJumps) return false;
+        pc = ins.m_arg;
+        break;
+      case OpCode::JumpIfZero: {
+        const int64_t value = stack.back();
+        stack.pop_back();
+        if (value == 0) {
+          if (++jumps > kMaxJumps) return false;
+          pc = ins.m_arg;
+        }
+        break;
+      }
+      case OpCode::Return:
+        if (!assigned[program.m_returnSlot]) return false;
+        result = frame[program.m_returnSlot];
+        return true;
+      default: {
+        const int64_t b = stack.back();
+        stack.pop_back();
+        if (!binary(ins.m_op, stack.back(), b, stack.back())) return false;
+        break;
+      }
+    }
+  }
+}
+
+constant* EvalFuncVM::evaluate(const function* func,
+                              const std::vector<any*>* args,
+                              const ValueLookup& lookup, Serializer& s) {
+  m_calls++;
+  if (func == nullptr) return nullptr;
+  auto [it, inserted] = m_programs.try_emplace(func);
+  // References to the elements survive the rehash of a nested call.
+  std::unique_ptr<Program>& program = it->second;
+  if (inserted) program = compile(func);
+  if (!program) return nullptr;
+  int64_t value = 0;
+  if (!run(*program, args, lookup, value)) return nullptr;
+  m_vmCalls++;
+  return makeResult(*program, value, s);
+}
+
+constant* EvalFuncVM::makeResult(const Program& program, int64_t value,
+                                 Serializer& s) {
+  // The return slot has the width and sign of the return type, and run()
+  // keeps its value in their range.
+  const Slot& ret = program.m_slots[program.m_returnSlot];
+  const std::string number = std::to_string(value);
+  constant* c = s.MakeConstant();
+  c->VpiValue((ret.m_signed ? "INT:" : "UINT:") + number);
+  c->VpiDecompile(number);
+  c->VpiSize(ret.m_width);
+  c->VpiConstType(ret.m_signed ? vpiIntConst : vpiUIntConst);
+  if (program.m_returnTypespec != nullptr) {
+    c->Typespec((typespec*)program.m_returnTypespec);
+  }
+  return c;
+}
+
+std::string EvalFuncVM::reportProfile() const {
+  uint64_t compiled = 0;
+  for (const auto& [func, program] : m_programs) {
+    if (program) compiled++;
+  }
+  return "Constant function calls: " + std::to_string(m_calls) +
+         ", on the bytecode VM: " + std::to_string(m_vmCalls) +
+         ", functions compiled: " + std::to_string(compiled) + "/" +
+         std::to_string(m_programs.size()) + "\n";
+}
+
+}  // namespace SURELOG
@@ -0,0 +1,101 @@
+/*
+ Copyright 2022 The Surelog Team.
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+/*
+ * File:   ReduceExprMemo.cpp
+ * Author: surelog
+ */
+
+#include <Surelog/DesignCompile/ReduceExprMemo.h>
+
+// UHDM
+#include <uhdm/constant.h>
+#include <uhdm/logic_typespec.h>
+#include <uhdm/range.h>
+
+namespace SURELOG {
+
+bool ReduceExprMemo::isMemoizable(const UHDM::any* expr) {
+  if (expr == nullptr) return false;
+  switch (expr->UhdmType()) {
+    case UHDM::uhdmoperation:
+    case UHDM::uhdmfunc_call:
+    case UHDM::uhdmsys_func_call:
+      return true;
+    default:
+      return false;
+  }
+}
+
+static std::string objectId(const UHDM::any* object) {
+  return "@" + std::to_string(object->UhdmId());
+}
+
+std::string ReduceExprMemo::fingerprint(const UHDM::any* object) {
+  if (object == nullptr) return "";
+  if (object->UhdmType() != UHDM::uhdmconstant) return objectId(object);
+  const UHDM::constant* c = (const UHDM::constant*)object;
+  std::string result = c->VpiValue();
+  result.append("/")
+      .append(std::to_string(c->VpiSize()))
+      .append("/")
+      .append(std::to_string(c->VpiConstType()));
+  const UHDM::typespec* ts = c->Typespec();
+  if (ts == nullptr) return result;
+  if (ts->UhdmType() != UHDM::uhdmlogic_typespec) {
+    return result.append("/").append(objectId(ts));
+  }
+  // The ranged typespecs built with each looked up value (setRange).
+  const UHDM::logic_typespec* lts = (const UHDM::logic_typespec*)ts;
+  result.append(lts->VpiSigned() ? "/signed" : "/logic");
+  if (const UHDM::VectorOfrange* ranges = lts->Ranges()) {
+    for (const UHDM::range* r : *ranges) {
+      result.append("[")
+          .append(fingerprint(r->Left_expr()))
+          .append(":")
+          .append(fingerprint(r->Right_expr()))
+          .append("]");
+    }
+  }
+  return result;
+}
+
+ReduceExprMemo::Key ReduceExprMemo::key(const UHDM::any* expr,
+                                        const UHDM::any* pexpr) {
+  // Ids start at 0
+  return Key(expr->UhdmId() + 1, pexpr ? pexpr->UhdmId() + 1 : 0);
+}
+
+const std::vector<ReduceExprMemo::Entry>* ReduceExprMemo::find(
+    const UHDM::any* expr, const UHDM::any* pexpr) const {
+  auto found = m_entries.find(key(expr, pexpr));
+  return (found == m_entries.end()) ? nullptr : &found->second;
+}
+
+void ReduceExprMemo::add(const UHDM::any* expr, const UHDM::any* pexpr,
+                         Entry entry) {
+  std::vector<Entry>& variants = m_entries[key(expr, pexpr)];
+  if (variants.size() < kMaxVariants) variants.push_back(std::move(entry));
+}
+
+std::string ReduceExprMemo::reportProfile() const {
+  const uint64_t rate = m_lookups ? (m_hits * 100) / m_lookups : 0;
+  return "Expression reductions memoized: " + std::to_string(m_lookups) +
+         ", hits: " + std::to_string(m_hits) + " (" + std::to_string(rate) +
+         "%)\n";
+}
+
+}  // namespace SURELOG
@@ -0,0 +1,145 @@
+/*
+ Copyright 2022 The Surelog Team.
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+*/
+
+#include <Surelog/DesignCompile/ReduceExprMemo.h>
+#include <gtest/gtest.h>
+#include <uhdm/Serializer.h>
+#include <uhdm/constant.h>
+#include <uhdm/logic_typespec.h>
+#include <uhdm/operation.h>
+#include <uhdm/range.h>
+#include <uhdm/ref_obj.h>
+
+namespace SURELOG {
+
+namespace {
+UHDM::constant* makeConstant(UHDM::Serializer& s, const std::string& value) {
+  UHDM::constant* c = s.MakeConstant();
+  c->VpiValue(value);
+  c->VpiSize(32);
+  c->VpiConstType(vpiUIntConst);
+  return c;
+}
+
+TEST(ReduceExprMemoTest, Memoizable) {
+  UHDM::Serializer s;
+  EXPECT_FALSE(ReduceExprMemo::isMemoizable(nullptr));
+  EXPECT_FALSE(ReduceExprMemo::isMemoizable(makeConstant(s, "UINT:1")));
+  EXPECT_FALSE(ReduceExprMemo::isMemoizable(s.MakeRef_obj()));
+  EXPECT_TRUE(ReduceExprMemo::isMemoizable(s.MakeOperation()));
+  EXPECT_TRUE(ReduceExprMemo::isMemoizable(s.MakeFunc_call()));
+  EXPECT_TRUE(ReduceExprMemo::isMemoizable(s.MakeSys_func_call()));
+}
+
+TEST(ReduceExprMemoTest, Fingerprint) {
+  UHDM::Serializer s;
+  UHDM::constant* eight = makeConstant(s, "UINT:8");
+  EXPECT_EQ(ReduceExprMemo::fingerprint(nullptr), "");
+  // Values, not objects.
+  EXPECT_EQ(ReduceExprMemo::fingerprint(eight),
+            ReduceExprMemo::fingerprint(makeConstant(s, "UINT:8")));
+  EXPECT_NE(ReduceExprMemo::fingerprint(eight),
+            ReduceExprMemo::fingerprint(makeConstant(s, "UINT:9")));
+  UHDM::constant* small = makeConstant(s, "UINT:8");
+  small->VpiSize(4);
+  EXPECT_NE(ReduceExprMemo::fingerprint(eight),
+            ReduceExprMemo::fingerprint(small));
+
+  // Same range, built twice.
+  auto ranged = [&s](const std::string& left) {
+    UHDM::constant* c = makeConstant(s, "UINT:8");
+    UHDM::logic_typespec* tps = s.MakeLogic_typespec();
+    UHDM::range* r = s.MakeRange();
+    r->Left_expr(makeConstant(s, left));
+    r->Right_expr(makeConstant(s, "UINT:0"));
+    UHDM::VectorOfrange* ranges = s.MakeRangeVec();
+    ranges->push_back(r);
+    tps->Ranges(ranges);
+    c->Typespec(tps);
+    return c;
+  };
+  EXPECT_EQ(ReduceExprMemo::fingerprint(ranged("UINT:7")),
+            ReduceExprMemo::fingerprint(ranged("UINT:7")));
+  EXPECT_NE(ReduceExprMemo::fingerprint(ranged("UINT:7")),
+            ReduceExprMemo::fingerprint(ranged("UINT:3")));
+  EXPECT_NE(ReduceExprMemo::fingerprint(ranged("UINT:7")),
+            ReduceExprMemo::fingerprint(eight));
+
+  // Other objects by identity.
+  UHDM::operation* op = s.MakeOperation();
+  EXPECT_EQ(ReduceExprMemo::fingerprint(op), ReduceExprMemo::fingerprint(op));
+  EXPECT_NE(ReduceExprMemo::fingerprint(op),
+            ReduceExprMemo::fingerprint(s.MakeOperation()));
+}
+
+TEST(ReduceExprMemoTest, Entries) {
+  UHDM::Serializer s;
+  UHDM::operation* op = s.MakeOperation();
+  UHDM::operation* parent = s.MakeOperation();
+  ReduceExprMemo memo;
+  EXPECT_EQ(memo.find(op, nullptr), nullptr);
+  for (size_t i = 0; i < ReduceExprMemo::kMaxVariants + 2; i++) {
+    ReduceExprMemo::Entry entry;
+    entry.m_dependencies.push_back({ReduceExprMemo::Dependency::Kind::Value,
+                                    "WIDTH", nullptr,
+                                    "UINT:" + std::to_string(i)});
+    entry.m_result = makeConstant(s, "UINT:" + std::to_string(i));
+    memo.add(op, nullptr, std::move(entry));
+  }
+  const auto* entries = memo.find(op, nullptr);
+  ASSERT_NE(entries, nullptr);
+  ASSERT_EQ(entries->size(), ReduceExprMemo::kMaxVariants);
+  EXPECT_EQ(entries->front().m_dependencies[0].m_fingerprint, "UINT:0");
+  EXPECT_EQ(memo.find(op, parent), nullptr);
+
+  memo.countLookup(false);
+  memo.countLookup(true);
+  memo.countLookup(true);
+  memo.countLookup(true);
+  EXPECT_EQ(memo.getLookupCount(), 4);
+  EXPECT_EQ(memo.getHitCount(), 3);
+  EXPECT_EQ(memo.reportProfile(),
+            "Expression reductions memoized: 4, hits: 3 (75%)\n");
+}
+
+TEST(ReduceExprMemoTest, Clear) {
+  UHDM::Serializer s;
+  UHDM::operation* op = s.MakeOperation();
+  ReduceExprMemo memo;
+  ReduceExprMemo::Entry entry;
+  entry.m_result = makeConstant(s, "UINT:1");
+  memo.add(op, nullptr, std::move(entry));
+  memo.countLookup(true);
+  ASSERT_NE(memo.find(op, nullptr), nullptr);
+  memo.clear();
+  EXPECT_EQ(memo.find(op, nullptr), nullptr);
+  EXPECT_EQ(memo.getHitCount(), 1);
+}
+
+TEST(ReduceExprMemoTest, ErasedExpression) {
+  UHDM::Serializer s;
+  UHDM::operation* op = s.MakeOperation();
+  ReduceExprMemo memo;
+  ReduceExprMemo::Entry entry;
+  entry.m_result = makeConstant(s, "UINT:1");
+  memo.add(op, nullptr, std::move(entry));
+  // Another operation, possibly at the same address, is not the erased one.
+  s.operationMaker.Erase(op);
+  UHDM::operation* other = s.MakeOperation();
+  EXPECT_EQ(memo.find(other, nullptr), nullptr);
+}
+}  // namespace
+}  // namespace SURELOG
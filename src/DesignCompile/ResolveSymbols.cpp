@@ -21,6 +21,7 @@
  * Created on July 1, 2017, 12:38 PM
  */
 
+#include <Surelog/CommandLine/CommandLineParser.h>
 #include <Surelog/Design/FileContent.h>
 #include <Surelog/Design/ModuleDefinition.h>
 #include <Surelog/DesignCompile/CompileDesign.h>
@@ -65,18 +66,26 @@ void ResolveSymbols::createFastLookup() {
   // std::string fileName =  "FILE: " + m_fileData->getFileName() + " " +
   // m_fileData->getChunkFileName () + "\n"; std::cout << fileName;
 
-  VObjectTypeUnorderedSet types = {
+  static const VObjectTypeBitset types = {
       VObjectType::slModule_declaration,    VObjectType::slPackage_declaration,
       VObjectType::slConfig_declaration,    VObjectType::slUdp_declaration,
       VObjectType::slInterface_declaration, VObjectType::slProgram_declaration,
       VObjectType::slClass_declaration};
 
-  VObjectTypeUnorderedSet stopPoints = {
+  static const VObjectTypeBitset stopPoints = {
       VObjectType::slModule_declaration, VObjectType::slPackage_declaration,
       VObjectType::slProgram_declaration, VObjectType::slClass_declaration};
 
-  std::vector<NodeId> objects =
-      m_fileData->sl_collect_all(m_fileData->getRootNode(), types, stopPoints);
+  static const VObjectTypeBitset classTypes = {
+      VObjectType::slClass_declaration};
+
+  static const VObjectTypeBitset classAndModuleTypes = {
+      VObjectType::slClass_declaration, VObjectType::slModule_declaration};
+
+  std::vector<NodeId> objects;
+  m_fileData->sl_collect_all(m_fileData->getRootNode(), types, stopPoints,
+                             objects);
+  std::vector<NodeId> subobjects;
 
   for (auto object : objects) {
     VObjectType type = m_fileData->Type(object);
@@ -98,9 +107,9 @@ void ResolveSymbols::createFastLookup() {
 
           m_fileData->addPackageDefinition(pkgname, pdef);
 
-          VObjectTypeUnorderedSet subtypes = {VObjectType::slClass_declaration};
-          std::vector<NodeId> subobjects =
-              m_fileData->sl_collect_all(object, subtypes, subtypes);
+          subobjects.clear();
+          m_fileData->sl_collect_all(object, classTypes, classTypes,
+                                     subobjects);
           for (auto subobject : subobjects) {
             NodeId stId =
                 m_fileData->sl_collect(subobject, VObjectType::slStringConst,
@@ -124,9 +133,9 @@ void ResolveSymbols::createFastLookup() {
           Program* mdef = new Program(fullName, lib, m_fileData, object);
           m_fileData->addProgramDefinition(fullName, mdef);
 
-          VObjectTypeUnorderedSet subtypes = {VObjectType::slClass_declaration};
-          std::vector<NodeId> subobjects =
-              m_fileData->sl_collect_all(object, subtypes, subtypes);
+          subobjects.clear();
+          m_fileData->sl_collect_all(object, classTypes, classTypes,
+                                     subobjects);
           for (auto subobject : subobjects) {
             NodeId stId =
                 m_fileData->sl_collect(subobject, VObjectType::slStringConst,
@@ -157,11 +166,9 @@ void ResolveSymbols::createFastLookup() {
               new ModuleDefinition(m_fileData, object, fullName);
           m_fileData->addModuleDefinition(fullName, mdef);
 
-          VObjectTypeUnorderedSet subtypes = {
-              VObjectType::slClass_declaration,
-              VObjectType::slModule_declaration};
-          std::vector<NodeId> subobjects =
-              m_fileData->sl_collect_all(object, subtypes, subtypes);
+          subobjects.clear();
+          m_fileData->sl_collect_all(object, classAndModuleTypes,
+                                     classAndModuleTypes, subobjects);
           for (auto subobject : subobjects) {
             NodeId stId =
                 m_fileData->sl_collect(subobject, VObjectType::slStringConst,
@@ -206,10 +213,6 @@ VObject ResolveSymbols::Object(NodeId index) const {
   return m_fileData->Object(index);
 }
 
-VObject* ResolveSymbols::MutableObject(NodeId index) {
-  return m_fileData->MutableObject(index);
-}
-
 NodeId ResolveSymbols::UniqueId(NodeId index) const {
   return m_fileData->UniqueId(index);
 }
@@ -232,7 +235,7 @@ NodeId ResolveSymbols::Definition(NodeId index) const {
 
 bool ResolveSymbols::SetDefinition(NodeId index, NodeId def) {
   if (!index) return false;
-  MutableObject(index)->m_definition = def;
+  m_fileData->SetDefinition(index, def);
   return true;
 }
 
@@ -246,7 +249,7 @@ VObjectType ResolveSymbols::Type(NodeId index) const {
 
 bool ResolveSymbols::SetType(NodeId index, VObjectType type) {
   if (!index) return false;
-  MutableObject(index)->m_type = type;
+  m_fileData->SetType(index, type);
   return true;
 }
 
@@ -339,7 +342,7 @@ bool ResolveSymbols::bindDefinition_(NodeId objIndex,
 }
 
 bool ResolveSymbols::resolve() {
-  unsigned int size = m_fileData->getVObjects().size();
+  unsigned int size = m_fileData->getSize();
   for (NodeId objIndex(0); objIndex < size; ++objIndex) {
     // ErrorDefinition::ErrorType errorType;
     bool bind = false;
@@ -374,6 +377,11 @@ bool ResolveSymbols::resolve() {
     }
   }
 
+  // The tree of the file is final, the compile and elaboration queries can
+  // go through the type index.
+  if (getCompiler()->getCommandLineParser()->typeIndex()) {
+    m_fileData->buildTypeIndex();
+  }
   return true;
 }
 
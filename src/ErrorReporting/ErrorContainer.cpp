@@ -111,16 +111,20 @@ Error& ErrorContainer::addError(Error& error, bool showDuplicates,
 }
 
 void ErrorContainer::appendErrors(ErrorContainer& rhs) {
+  // Errors recorded against the same table need no translation.
+  const bool sameTable = (rhs.m_symbolTable == m_symbolTable);
   for (unsigned int i = 0; i < rhs.m_errors.size(); i++) {
     Error err = rhs.m_errors[i];
-    // Translate IDs to master symbol table
-    for (auto& loc : err.m_locations) {
-      if (loc.m_fileId)
-        loc.m_fileId = m_symbolTable->registerSymbol(
-            rhs.m_symbolTable->getSymbol(loc.m_fileId));
-      if (loc.m_object) {
-        loc.m_object = m_symbolTable->registerSymbol(
-            rhs.m_symbolTable->getSymbol(loc.m_object));
+    if (!sameTable) {
+      // Translate IDs to master symbol table
+      for (auto& loc : err.m_locations) {
+        if (loc.m_fileId)
+          loc.m_fileId = m_symbolTable->registerSymbol(
+              rhs.m_symbolTable->getSymbol(loc.m_fileId));
+        if (loc.m_object) {
+          loc.m_object = m_symbolTable->registerSymbol(
+              rhs.m_symbolTable->getSymbol(loc.m_object));
+        }
       }
     }
     if (!err.m_reported) addError(err);
@@ -307,7 +311,7 @@ std::pair<std::string, bool> ErrorContainer::createReport_(
   return std::make_pair(report, reportFatalError);
 }
 
-bool ErrorContainer::printStats(ErrorContainer::Stats stats, bool muteStdout) {
+std::string ErrorContainer::createStatsReport(const Stats& stats) {
   std::string report;
   report += "[  FATAL] : " + std::to_string(stats.nbFatal) + "\n";
   report += "[ SYNTAX] : " + std::to_string(stats.nbSyntax) + "\n";
@@ -316,6 +320,11 @@ bool ErrorContainer::printStats(ErrorContainer::Stats stats, bool muteStdout) {
   // BOGUS NUMBER IN CACHED MODE  report += "[   INFO] : " +
   // std::to_string(stats.nbInfo) + "\n";
   report += "[   NOTE] : " + std::to_string(stats.nbNote) + "\n";
+  return report;
+}
+
+bool ErrorContainer::printStats(ErrorContainer::Stats stats, bool muteStdout) {
+  const std::string report = createStatsReport(stats);
   if (!muteStdout) {
     std::cout << report << std::flush;
   }
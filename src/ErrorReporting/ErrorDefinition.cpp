@@ -196,6 +196,9 @@ bool ErrorDefinition::init() {
   rec(CMD_USING_GLOBAL_TIMESCALE, INFO, CMD, "Using global timescale: \"%s\"");
   rec(CMD_CACHE_CAPACITY_EXCEEDED, WARNING, CMD,
       "Cache capacity exceeded, turning off cache");
+  rec(CMD_DFA_CACHE_MISSING_SIZE, ERROR, CMD,
+      "Option -dfacachemax is missing the number of states");
+  rec(CMD_CACHE_NOT_SAVED, WARNING, CMD, "Cannot save cache file \"%s\"");
   rec(PP_CANNOT_OPEN_FILE, ERROR, PP, "Cannot open file \"%s\"");
   rec(PP_CANNOT_OPEN_INCLUDE_FILE, ERROR, PP,
       "Cannot open include file \"%s\"");
@@ -53,9 +53,11 @@ static void saveContent(const fs::path& fileName, const std::string& content) {
   }
 }
 
-void AnalyzeFile::checkSLlineDirective_(const std::string& line,
+void AnalyzeFile::checkSLlineDirective_(std::string_view line,
                                         unsigned int lineNb) {
-  std::stringstream ss(line); /* Storing the whole string into string stream */
+  if (line.find("SLline") == std::string_view::npos) return;
+  /* Storing the whole string into string stream */
+  std::stringstream ss{std::string(line)};
   std::string keyword;
   ss >> keyword;
   if (keyword == "SLline") {
@@ -108,24 +110,28 @@ std::string AnalyzeFile::setSLlineDirective_(unsigned int lineNb,
 }
 
 void AnalyzeFile::analyze() {
-  std::string line;
-  std::vector<std::string> allLines;
-  allLines.emplace_back("FILLER LINE");
-  if (m_text.empty()) {
+  // The lines are views of the content, read from the .pp file only when
+  // not given in memory.
+  std::string fileContent;
+  std::string_view content = m_content;
+  if (content.empty()) {
     std::ifstream ifs;
     ifs.open(m_ppFileName);
     if (!ifs.good()) {
       return;
     }
-    while (std::getline(ifs, line)) {
-      allLines.push_back(line);
-    }
+    fileContent.assign(std::istreambuf_iterator<char>(ifs),
+                       std::istreambuf_iterator<char>());
     ifs.close();
-  } else {
-    std::stringstream ss(m_text);
-    while (std::getline(ss, line)) {
-      allLines.push_back(line);
-    }
+    content = fileContent;
+  }
+  std::vector<std::string_view> allLines;
+  allLines.emplace_back("FILLER LINE");
+  for (size_t start = 0; start < content.size();) {
+    size_t end = content.find('\n', start);
+    if (end == std::string_view::npos) end = content.size();
+    allLines.push_back(content.substr(start, end - start));
+    start = end + 1;
   }
   unsigned int minNbLineForPartitioning = m_clp->getNbLinesForFileSpliting();
   std::vector<FileChunk> fileChunks;
@@ -153,7 +159,7 @@ void AnalyzeFile::analyze() {
   std::string prev_keyword;
   std::string prev_prev_keyword;
   const std::regex import_regex("import[ ]+[a-zA-Z_0-9:\\*]+[ ]*;");
-  std::smatch pieces_match;
+  std::match_results<std::string_view::const_iterator> pieces_match;
   std::string fileLevelImportSection;
   // Parse the file
   for (auto& line : allLines) {
@@ -375,7 +381,8 @@ void AnalyzeFile::analyze() {
     if ((!inPackage) && (!inClass) && (!inModule) && (!inProgram) &&
         (!inInterface) && (!inConfig) && (!inChecker) && (!inPrimitive) &&
         (!inComment) && (!inString)) {
-      if (std::regex_search(line, pieces_match, import_regex)) {
+      if (std::regex_search(line.begin(), line.end(), pieces_match,
+                            import_regex)) {
         fileLevelImportSection += line;
       }
     }
@@ -435,8 +442,9 @@ void AnalyzeFile::analyze() {
       packageDeclaration = allLines[fileChunks[i].m_fromLine];
       for (unsigned hi = fileChunks[i].m_fromLine; hi < fileChunks[i].m_toLine;
            hi++) {
-        std::string header = allLines[hi];
-        if (std::regex_search(header, pieces_match, import_regex)) {
+        std::string_view header = allLines[hi];
+        if (std::regex_search(header.begin(), header.end(), pieces_match,
+                              import_regex)) {
           importSection += header;
         }
       }
@@ -499,7 +507,7 @@ void AnalyzeFile::analyze() {
 
           // Detect end of package or end of module
           for (unsigned int l = fromLine; l < toLine; l++) {
-            const std::string& line = allLines[l];
+            std::string_view line = allLines[l];
             checkSLlineDirective_(line, l);
 
             bool inLineComment = false;
@@ -57,10 +57,10 @@ bool CheckCompile::mergeSymbolTables_() {
     m_compiler->getSymbolTable()->registerSymbol(
         fileContent->getFileName().string());
     for (NodeId id : fileContent->getNodeIds()) {
-      *fileContent->getMutableFileId(id) =
-          m_compiler->getSymbolTable()->registerSymbol(
-              fileContent->getSymbolTable()->getSymbol(
-                  fileContent->getFileId(id)));
+      fileContent->setFileId(
+          id, m_compiler->getSymbolTable()->registerSymbol(
+                  fileContent->getSymbolTable()->getSymbol(
+                      fileContent->getFileId(id))));
     }
     for (DesignElement* elem : fileContent->getDesignElements()) {
       elem->m_name = m_compiler->getSymbolTable()->registerSymbol(
@@ -42,7 +42,7 @@ NodeId CommonListenerHelper::NodeIdFromContext(
   return (found == m_contextToObjectMap.end()) ? InvalidNodeId : found->second;
 }
 
-const VObject& CommonListenerHelper::Object(NodeId index) {
+VObject CommonListenerHelper::Object(NodeId index) {
   return m_fileContent->Object(index);
 }
 
@@ -55,16 +55,10 @@ SymbolId CommonListenerHelper::Name(NodeId index) const {
 NodeId CommonListenerHelper::Child(NodeId index) const {
   return m_fileContent->Child(index);
 }
-NodeId& CommonListenerHelper::MutableChild(NodeId index) {
-  return m_fileContent->MutableObject(index)->m_child;
-}
 
 NodeId CommonListenerHelper::Sibling(NodeId index) const {
   return m_fileContent->Sibling(index);
 }
-NodeId& CommonListenerHelper::MutableSibling(NodeId index) {
-  return m_fileContent->MutableObject(index)->m_sibling;
-}
 
 NodeId CommonListenerHelper::Definition(NodeId index) const {
   return m_fileContent->Definition(index);
@@ -73,9 +67,6 @@ NodeId CommonListenerHelper::Definition(NodeId index) const {
 NodeId CommonListenerHelper::Parent(NodeId index) const {
   return m_fileContent->Parent(index);
 }
-NodeId& CommonListenerHelper::MutableParent(NodeId index) {
-  return m_fileContent->MutableObject(index)->m_parent;
-}
 
 VObjectType CommonListenerHelper::Type(NodeId index) const {
   return m_fileContent->Type(index);
@@ -96,20 +87,16 @@ int CommonListenerHelper::addVObject(ParserRuleContext* ctx, SymbolId sym,
 
   NodeId objectIndex = m_fileContent->addObject(sym, fileId, objtype, line,
                                                 column, endLine, endColumn);
-  VObject* inserted = m_fileContent->MutableObject(objectIndex);
   m_contextToObjectMap.insert(std::make_pair(ctx, objectIndex));
   addParentChildRelations(objectIndex, ctx);
-  std::vector<SURELOG::DesignElement*>& delements =
-      m_fileContent->getDesignElements();
-  for (auto it = delements.rbegin(); it != delements.rend(); ++it) {
-    if ((*it)->m_context == ctx) {
-      // Use the file and line number of the design object (package, module),
-      // true file/line when splitting
-      inserted->m_fileId = (*it)->m_fileId;
-      inserted->m_line = (*it)->m_line;
-      (*it)->m_node = NodeId(objectIndex);
-      break;
-    }
+  auto found = m_contextToDesignElementMap.find(ctx);
+  if (found != m_contextToDesignElementMap.end()) {
+    DesignElement* elem = found->second;
+    // Use the file and line number of the design object (package, module),
+    // true file/line when splitting
+    m_fileContent->setFileId(objectIndex, elem->m_fileId);
+    m_fileContent->SetLine(objectIndex, elem->m_line);
+    elem->m_node = NodeId(objectIndex);
   }
   return objectIndex;
 }
@@ -131,11 +118,11 @@ void CommonListenerHelper::addParentChildRelations(NodeId indexParent,
   for (tree::ParseTree* child : ctx->children) {
     NodeId childIndex = NodeIdFromContext(child);
     if (childIndex) {
-      MutableParent(childIndex) = UniqueId(indexParent);
+      m_fileContent->SetParent(childIndex, UniqueId(indexParent));
       if (indexParent == currentIndex) {
-        MutableChild(indexParent) = UniqueId(childIndex);
+        m_fileContent->SetChild(indexParent, UniqueId(childIndex));
       } else {
-        MutableSibling(currentIndex) = UniqueId(childIndex);
+        m_fileContent->SetSibling(currentIndex, UniqueId(childIndex));
       }
       currentIndex = childIndex;
     }
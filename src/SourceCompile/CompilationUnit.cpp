@@ -27,63 +27,75 @@ namespace SURELOG {
 CompilationUnit::CompilationUnit(bool fileunit)
     : m_fileunit(fileunit), m_inDesignElement(false) {}
 
-MacroInfo* CompilationUnit::getMacroInfo(const std::string& macroName) {
-  MacroStorageRef::iterator itr = m_macros.find(macroName);
-  if (itr != m_macros.end()) {
-    return (*itr).second;
+MacroInfo* CompilationUnit::getMacroInfo(SymbolId macroId) {
+  MacroStorageRef::iterator itr = m_macros.find(macroId);
+  MacroInfo* info = (itr != m_macros.end()) ? (*itr).second : nullptr;
+  for (IncludeMemo::Recording* recording : m_macroRecordings) {
+    recording->read(macroId, info);
   }
-  return nullptr;
+  return info;
 }
 
-void CompilationUnit::registerMacroInfo(const std::string& macroName,
-                                        MacroInfo* macro) {
-  m_macros.insert(MacroStorageRef::value_type(macroName, macro));
+void CompilationUnit::registerMacroInfo(SymbolId macroId, MacroInfo* macro) {
+  m_macros.insert(MacroStorageRef::value_type(macroId, macro));
+  for (IncludeMemo::Recording* recording : m_macroRecordings) {
+    recording->define(macroId, macro);
+  }
 }
 
-void CompilationUnit::deleteMacro(const std::string& macroName) {
-  MacroStorageRef::iterator itr = m_macros.find(macroName);
+void CompilationUnit::deleteMacro(SymbolId macroId) {
+  MacroStorageRef::iterator itr = m_macros.find(macroId);
+  for (IncludeMemo::Recording* recording : m_macroRecordings) {
+    recording->undefine(macroId,
+                        (itr != m_macros.end()) ? (*itr).second : nullptr);
+  }
   if (itr != m_macros.end()) {
     m_macros.erase(itr);
   }
 }
 
+void CompilationUnit::deleteAllMacros() {
+  m_macros.clear();
+  abortMacroRecordings();
+}
+
+void CompilationUnit::abortMacroRecordings() {
+  for (IncludeMemo::Recording* recording : m_macroRecordings) {
+    recording->abort();
+  }
+}
+
+void CompilationUnit::recordInclude(const std::string& fileName) {
+  for (IncludeMemo::Recording* recording : m_macroRecordings) {
+    recording->include(fileName);
+  }
+}
+
 void CompilationUnit::recordTimeInfo(TimeInfo& info) {
   m_timeInfo.push_back(info);
+  m_timeInfoIndex.add(info.m_fileId, info.m_line);
 }
 
 TimeInfo& CompilationUnit::getTimeInfo(SymbolId fileId, unsigned int line) {
-  if (m_timeInfo.empty()) {
+  const int32_t index = m_timeInfoIndex.find(fileId, line);
+  if (index == FileLineIndex::kNotFound) {
     return m_noTimeInfo;
   }
-  for (int i = (int)m_timeInfo.size() - 1; i >= 0; i--) {
-    TimeInfo& info = m_timeInfo[i];
-    if (info.m_fileId == fileId) {
-      if (line >= info.m_line) {
-        return info;
-      }
-    }
-  }
-  return m_noTimeInfo;
+  return m_timeInfo[index];
 }
 
 void CompilationUnit::recordDefaultNetType(NetTypeInfo& info) {
   m_defaultNetTypes.push_back(info);
+  m_defaultNetTypeIndex.add(info.m_fileId, info.m_line);
 }
 
 VObjectType CompilationUnit::getDefaultNetType(SymbolId fileId,
                                                unsigned int line) {
-  if (m_defaultNetTypes.empty()) {
+  const int32_t index = m_defaultNetTypeIndex.find(fileId, line);
+  if (index == FileLineIndex::kNotFound) {
     return slNetType_Wire;
   }
-  for (int i = (int)m_defaultNetTypes.size() - 1; i >= 0; i--) {
-    NetTypeInfo& info = m_defaultNetTypes[i];
-    if (info.m_fileId == fileId) {
-      if (line >= info.m_line) {
-        return info.m_type;
-      }
-    }
-  }
-  return slNetType_Wire;
+  return m_defaultNetTypes[index].m_type;
 }
 
 void CompilationUnit::setCurrentTimeInfo(SymbolId fileId) {
@@ -93,7 +105,7 @@ void CompilationUnit::setCurrentTimeInfo(SymbolId fileId) {
   TimeInfo info = m_timeInfo[m_timeInfo.size() - 1];
   info.m_fileId = fileId;
   info.m_line = 1;
-  m_timeInfo.push_back(info);
+  recordTimeInfo(info);
 }
 
 }  // namespace SURELOG
@@ -250,7 +250,7 @@ bool CompileSourceFile::postPreprocess_() {
         m_symbolTable->registerSymbol(symbolTable->getSymbol(m_fileId));
     return true;
   }
-  std::string m_pp_result = m_pp->getPreProcessedFileContent();
+  const std::string& m_pp_result = m_pp->getPreProcessedFileContent();
   if (!m_text.empty()) {
     m_parser = new ParseFile(m_pp_result, this, m_compilationUnit,
                              m_library);  // unit test
@@ -22,6 +22,7 @@
  */
 
 #include <Surelog/API/PythonAPI.h>
+#include <Surelog/Cache/DFACache.h>
 #include <Surelog/CommandLine/CommandLineParser.h>
 #include <Surelog/Config/ConfigSet.h>
 #include <Surelog/Design/Design.h>
@@ -41,12 +42,12 @@
 #include <Surelog/SourceCompile/SymbolTable.h>
 #include <Surelog/Utils/ContainerUtils.h>
 #include <Surelog/Utils/FileUtils.h>
+#include <Surelog/Utils/ProcessPool.h>
 #include <Surelog/Utils/StringUtils.h>
+#include <Surelog/Utils/ThreadPool.h>
 #include <Surelog/Utils/Timer.h>
 #include <antlr4-runtime.h>
 
-#include <thread>
-
 #if defined(_MSC_VER)
 #include <direct.h>
 #else
@@ -54,6 +55,8 @@
 #include <unistd.h>
 #endif
 
+#include <algorithm>
+
 namespace SURELOG {
 
 namespace fs = std::filesystem;
@@ -68,7 +71,8 @@ Compiler::Compiler(CommandLineParser* commandLineParser, ErrorContainer* errors,
       m_configSet(new ConfigSet()),
       m_design(new Design(getErrorContainer(), m_librarySet, m_configSet)),
       m_uhdmDesign(0),
-      m_compileDesign(nullptr) {
+      m_compileDesign(nullptr),
+      m_threadPool(nullptr) {
 #ifdef USETBB
   if (getCommandLineParser()->useTbb() &&
       (getCommandLineParser()->getNbMaxTreads() > 0))
@@ -87,7 +91,8 @@ Compiler::Compiler(CommandLineParser* commandLineParser, ErrorContainer* errors,
       m_design(new Design(getErrorContainer(), m_librarySet, m_configSet)),
       m_uhdmDesign(0),
       m_text(text),
-      m_compileDesign(nullptr) {}
+      m_compileDesign(nullptr),
+      m_threadPool(nullptr) {}
 
 Compiler::~Compiler() {
   for (auto& entry : m_antlrPpMap) {
@@ -99,6 +104,7 @@ Compiler::~Compiler() {
   delete m_configSet;
   delete m_librarySet;
   delete m_commonCompilationUnit;
+  delete m_threadPool;
 
   cleanup_();
 }
@@ -131,6 +137,13 @@ bool Compiler::compileOneFile_(CompileSourceFile* compiler,
   return status;
 }
 
+ThreadPool* Compiler::getThreadPool() {
+  if (m_threadPool == nullptr) {
+    m_threadPool = new ThreadPool(m_commandLineParser->getNbMaxTreads());
+  }
+  return m_threadPool;
+}
+
 bool Compiler::isLibraryFile(SymbolId id) const {
   return (m_libraryFiles.find(id) != m_libraryFiles.end());
 }
@@ -140,7 +153,7 @@ bool Compiler::ppinit_() {
     m_commonCompilationUnit = new CompilationUnit(false);
     if (m_commandLineParser->parseBuiltIn()) {
       Builtin* builtin = new Builtin(nullptr, nullptr);
-      builtin->addBuiltinMacros(m_commonCompilationUnit);
+      builtin->addBuiltinMacros(m_commonCompilationUnit, m_symbolTable);
     }
   }
 
@@ -153,13 +166,11 @@ bool Compiler::ppinit_() {
     SymbolTable* symbols = m_symbolTable;
     if (m_commandLineParser->fileunit()) {
       comp_unit = new CompilationUnit(true);
+      m_compilationUnits.push_back(comp_unit);
       if (m_commandLineParser->parseBuiltIn()) {
         Builtin* builtin = new Builtin(nullptr, nullptr);
-        builtin->addBuiltinMacros(comp_unit);
+        builtin->addBuiltinMacros(comp_unit, symbols);
       }
-      m_compilationUnits.push_back(comp_unit);
-      symbols = m_commandLineParser->getSymbolTable().CreateSnapshot();
-      m_symbolTables.push_back(symbols);
     }
     ErrorContainer* errors = new ErrorContainer(symbols);
     m_errorContainers.push_back(errors);
@@ -220,8 +231,6 @@ bool Compiler::ppinit_() {
     if (m_commandLineParser->fileunit()) {
       comp_unit = new CompilationUnit(true);
       m_compilationUnits.push_back(comp_unit);
-      symbols = m_commandLineParser->getSymbolTable().CreateSnapshot();
-      m_symbolTables.push_back(symbols);
     }
     ErrorContainer* errors = new ErrorContainer(symbols);
     m_errorContainers.push_back(errors);
@@ -264,8 +273,6 @@ bool Compiler::ppinit_() {
       if (m_commandLineParser->fileunit()) {
         comp_unit = new CompilationUnit(true);
         m_compilationUnits.push_back(comp_unit);
-        symbols = m_commandLineParser->getSymbolTable().CreateSnapshot();
-        m_symbolTables.push_back(symbols);
       }
       ErrorContainer* errors = new ErrorContainer(symbols);
       m_errorContainers.push_back(errors);
@@ -359,6 +366,33 @@ bool Compiler::createFileList_() {
   return true;
 }
 
+bool Compiler::runChildProcesses_(ProcessPool& pool, std::string_view stage) {
+  const bool muted = m_commandLineParser->muteStdout();
+  if (!muted)
+    std::cout << "Running " << stage << " in "
+              << m_commandLineParser->getNbMaxProcesses()
+              << " child processes" << std::endl
+              << std::flush;
+  const bool success = pool.run();
+  for (const auto& result : pool.getResults()) {
+    if (result.m_returnCode != 0) {
+      std::cerr << "Surelog " << stage << " child failed ("
+                << result.m_returnCode << "): " << result.m_commandLine
+                << std::endl
+                << result.m_output << std::flush;
+    } else if (result.m_retried) {
+      std::cerr << "Surelog " << stage
+                << " child died, job run again: " << result.m_commandLine
+                << std::endl
+                << result.m_output << std::flush;
+    }
+  }
+  if (!muted)
+    std::cout << "Surelog " << stage << " status: " << (success ? 0 : 1)
+              << std::endl;
+  return success;
+}
+
 bool Compiler::createMultiProcessParser_() {
   unsigned int nbProcesses = m_commandLineParser->getNbMaxProcesses();
   if (nbProcesses == 0) return true;
@@ -368,182 +402,101 @@ bool Compiler::createMultiProcessParser_() {
     return true;
   }
 
-  // Create CMakeLists.txt
-  bool muted = m_commandLineParser->muteStdout();
   SymbolTable* symbolTable = getSymbolTable();
-  const fs::path outputDir =
-      symbolTable->getSymbol(m_commandLineParser->getOutputDir());
+  const fs::path outputDir = fs::absolute(
+      symbolTable->getSymbol(m_commandLineParser->getOutputDir()));
   const fs::path directory =
       symbolTable->getSymbol(m_commandLineParser->getFullCompileDir());
-  std::ofstream ofs;
-  fs::path fileList = directory / "CMakeLists.txt";
-  ofs.open(fileList);
-  std::vector<std::string> batchProcessCommands;
-  if (ofs.good()) {
-    ofs << "cmake_minimum_required (VERSION 3.0)" << std::endl;
-    ofs << "# Auto generated by Surelog" << std::endl;
-    ofs << "project(SurelogParsing NONE)" << std::endl;
-    // Optimize the load balance, try to even out the work in each thread by
-    // the size of the files
-    std::vector<std::vector<CompileSourceFile*>> jobArray(nbProcesses);
-    std::vector<unsigned long> jobSize(nbProcesses, 0);
-    size_t largestJob = 0;
-    for (const auto& compiler : m_compilers) {
-      size_t size = compiler->getJobSize(CompileSourceFile::Action::Parse);
-      if (size > largestJob) {
-        largestJob = size;
-      }
-    }
-    std::string_view sverilog =
-        m_commandLineParser->fullSVMode() ? " -sverilog " : " ";
-    std::string_view fileUnit =
-        m_commandLineParser->fileunit() ? " -fileunit " : " ";
-    std::string_view synth =
-        m_commandLineParser->reportNonSynthesizable() ? " -synth " : " ";
-    std::string_view noHash =
-        m_commandLineParser->noCacheHash() ? " -nohash " : " ";
-
-    unsigned int bigJobThreashold = (largestJob / nbProcesses) * 3;
-    std::vector<CompileSourceFile*> bigJobs;
-    Precompiled* prec = Precompiled::getSingleton();
-
-    fs::path cwd = fs::current_path();
-    for (const auto& compiler : m_compilers) {
-      fs::path root =
-          compiler->getSymbolTable()->getSymbol(compiler->getFileId());
-      root = FileUtils::basename(root);
-      if (prec->isFilePrecompiled(root)) {
-        continue;
-      }
-      unsigned int size =
-          compiler->getJobSize(CompileSourceFile::Action::Parse);
-      if (size > bigJobThreashold) {
-        bigJobs.push_back(compiler);
-        continue;
-      }
-      unsigned int newJobIndex = 0;
-      uint64_t minJobQueue = ULLONG_MAX;
-      for (size_t ii = 0; ii < nbProcesses; ii++) {
-        if (jobSize[ii] < minJobQueue) {
-          newJobIndex = ii;
-          minJobQueue = jobSize[ii];
-        }
-      }
-      jobSize[newJobIndex] += size;
-      jobArray[newJobIndex].push_back(compiler);
-    }
-
-    fs::path full_exe_path = m_commandLineParser->getExePath();
-    if (m_commandLineParser->profile()) {
-      full_exe_path += " -profile";
-    }
-
-    std::vector<std::string> targets;
-    int absoluteIndex = 0;
-
-    // Big jobs
-    for (CompileSourceFile* compiler : bigJobs) {
-      absoluteIndex++;
-      fs::path fileName =
-          compiler->getSymbolTable()->getSymbol(compiler->getPpOutputFileId());
-      fileName = fileName.lexically_relative(directory);
-      std::string targetname = std::to_string(absoluteIndex) + "_" +
-                               FileUtils::basename(fileName).string();
-      targets.push_back(targetname);
-      fs::path baseFileName = FileUtils::basename(fileName);
-      std::string_view svFile =
-          m_commandLineParser->isSVFile(baseFileName) ? " -sv " : " ";
-      std::string batchCmd = StrCat(
-          fileUnit, sverilog, synth, noHash,
-          " -parseonly -nostdout -nobuiltin -mt 0 -mp 0 -l ",
-          FileUtils::basename(targetname).string() + ".log ", svFile, fileName);
-      if (nbProcesses > 1) {
-        StrAppend(&batchCmd, " -o ", outputDir);
-      }
-
-      ofs << "add_custom_command(OUTPUT " << targetname << std::endl;
-      ofs << "  COMMAND " << full_exe_path << batchCmd << std::endl;
-      ofs << ")" << std::endl;
-      batchProcessCommands.push_back(batchCmd);
-    }
-
-    // Small jobs batch in clump processes
-    for (size_t i = 0; i < nbProcesses; i++) {
-      std::string fileList;
-      fs::path lastFile;
-      absoluteIndex++;
-      for (const auto compiler : jobArray[i]) {
-        fs::path fileName = compiler->getSymbolTable()->getSymbol(
-            compiler->getPpOutputFileId());
-        fs::path baseFileName = FileUtils::basename(fileName);
-        std::string_view svFile =
-            m_commandLineParser->isSVFile(baseFileName) ? " -sv " : " ";
-        fileName = fileName.lexically_relative(directory);
-        StrAppend(&fileList, svFile, fileName);
-        lastFile = fileName;
-      }
-      if (!fileList.empty()) {
-        std::string targetname = std::to_string(absoluteIndex) + "_" +
-                                 FileUtils::basename(lastFile).string();
-        targets.push_back(targetname);
-
-        std::string batchCmd = StrCat(
-            fileUnit, sverilog, synth, noHash,
-            " -parseonly -nostdout -nobuiltin -mt 0 -mp 0 -l ",
-            FileUtils::basename(targetname).string() + ".log ", fileList);
-        if (nbProcesses > 1) {
-          StrAppend(&batchCmd, " -o ", outputDir);
-        }
-
-        ofs << "add_custom_command(OUTPUT " << targetname << std::endl;
-        ofs << "  COMMAND " << full_exe_path << batchCmd << std::endl;
-        ofs << "  WORKING_DIRECTORY " << cwd << std::endl;
-        ofs << ")" << std::endl;
-        batchProcessCommands.push_back(batchCmd);
-      }
-    }
 
-    ofs << "add_custom_target(Parse ALL DEPENDS" << std::endl;
-    for (const auto& target : targets) {
-      ofs << target << std::endl;
+  std::string_view sverilog =
+      m_commandLineParser->fullSVMode() ? " -sverilog " : " ";
+  std::string_view fileUnit =
+      m_commandLineParser->fileunit() ? " -fileunit " : " ";
+  std::string_view synth =
+      m_commandLineParser->reportNonSynthesizable() ? " -synth " : " ";
+  std::string_view noHash =
+      m_commandLineParser->noCacheHash() ? " -nohash " : " ";
+  std::string_view cachePack =
+      m_commandLineParser->cachePack() ? " -cachepack " : " ";
+  const std::string dfaCache =
+      m_commandLineParser->dfaCache()
+          ? StrCat(" -dfacachemax ", m_commandLineParser->dfaCacheMaxStates(),
+                   " ")
+          : " ";
+  std::string_view profile =
+      m_commandLineParser->profile() ? " -profile " : " ";
+
+  Precompiled* prec = Precompiled::getSingleton();
+  std::vector<CompileSourceFile*> compilers;
+  uint64_t totalSize = 0;
+  for (const auto& compiler : m_compilers) {
+    fs::path root =
+        compiler->getSymbolTable()->getSymbol(compiler->getFileId());
+    root = FileUtils::basename(root);
+    if (prec->isFilePrecompiled(root)) {
+      continue;
     }
-    ofs << ")" << std::endl;
-    ofs << std::flush;
-    ofs.close();
+    compilers.push_back(compiler);
+    totalSize += compiler->getJobSize(CompileSourceFile::Action::Parse);
+  }
 
-    if (nbProcesses == 1) {
-      // Single child process
-      fs::path fileList = directory / "parser_batch.txt";
-      ofs.open(fileList);
-      for (const auto& line : batchProcessCommands) {
-        ofs << line << std::endl;
-      }
-      ofs.close();
-      std::string command = StrCat("cd ", cwd, "; ", full_exe_path, " -o ",
-                                   outputDir, " -nostdout -batch ", fileList);
-      if (!muted)
-        std::cout << "Running: " << command << std::endl << std::flush;
-      int result = system(command.c_str());
-      if (!muted)
-        std::cout << "Surelog parsing status: " << result << std::endl;
-      if (!result) return false;
-    } else {
-      // Multiple child processes managed by cmake
-      std::string command =
-          StrCat("cd ", directory, "; cmake -G \"Unix Makefiles\" .; make -j ",
-                 nbProcesses);
-      if (!muted)
-        std::cout << "Running: " << command << std::endl << std::flush;
-      int result = system(command.c_str());
-      if (!muted)
-        std::cout << "Surelog parsing status: " << result << std::endl;
-      if (!result) return false;
+  // The pool hands the jobs out largest first to whichever child is idle,
+  // so the load balances itself as long as the jobs are small compared to
+  // the work of a child. Each file is a job, except the small ones batched
+  // together up to a bounded size and count, to pay the job overhead once.
+  constexpr size_t kMaxFilesPerJob = 16;
+  const uint64_t batchSize =
+      std::max<uint64_t>(totalSize / (nbProcesses * 8), 1);
+
+  // File names are relative to the compile directory the jobs run in
+  ProcessPool pool({m_commandLineParser->getExePath().string(), "-server"},
+                   nbProcesses);
+  int absoluteIndex = 0;
+  auto addJob = [&](uint64_t size, const std::string& fileList,
+                    const fs::path& lastFile) {
+    absoluteIndex++;
+    std::string targetname = std::to_string(absoluteIndex) + "_" +
+                             FileUtils::basename(lastFile).string();
+    std::string batchCmd = StrCat(
+        "-cd ", directory, profile, fileUnit, sverilog, synth, noHash,
+        cachePack, dfaCache,
+        " -parseonly -nostdout -nobuiltin -mt 0 -mp 0 -l ",
+        FileUtils::basename(targetname).string() + ".log ", fileList, " -o ",
+        outputDir);
+    pool.addJob(size, batchCmd);
+  };
+
+  std::string batchList;
+  fs::path batchLastFile;
+  uint64_t batchJobSize = 0;
+  size_t batchFileCount = 0;
+  for (CompileSourceFile* compiler : compilers) {
+    fs::path fileName =
+        compiler->getSymbolTable()->getSymbol(compiler->getPpOutputFileId());
+    fs::path baseFileName = FileUtils::basename(fileName);
+    std::string_view svFile =
+        m_commandLineParser->isSVFile(baseFileName) ? " -sv " : " ";
+    fileName = fileName.lexically_relative(directory);
+    const uint64_t size =
+        compiler->getJobSize(CompileSourceFile::Action::Parse);
+    if (size >= batchSize) {
+      addJob(size, StrCat(svFile, fileName), fileName);
+      continue;
+    }
+    StrAppend(&batchList, svFile, fileName);
+    batchLastFile = fileName;
+    batchJobSize += size;
+    batchFileCount++;
+    if ((batchJobSize >= batchSize) || (batchFileCount == kMaxFilesPerJob)) {
+      addJob(batchJobSize, batchList, batchLastFile);
+      batchList.clear();
+      batchJobSize = 0;
+      batchFileCount = 0;
     }
-  } else {
-    std::cerr << "FATAL: Could not create CMakeLists.txt: " << fileList
-              << std::endl;
   }
-  return true;
+  if (!batchList.empty()) addJob(batchJobSize, batchList, batchLastFile);
+
+  return runChildProcesses_(pool, "parsing");
 }
 
 bool Compiler::createMultiProcessPreProcessor_() {
@@ -555,133 +508,88 @@ bool Compiler::createMultiProcessPreProcessor_() {
     return true;
   }
 
-  // Create CMakeLists.txt
-  bool muted = m_commandLineParser->muteStdout();
   SymbolTable* symbolTable = getSymbolTable();
-  const fs::path outputDir =
-      symbolTable->getSymbol(m_commandLineParser->getOutputDir());
-  const fs::path directory =
-      symbolTable->getSymbol(m_commandLineParser->getFullCompileDir());
-  std::ofstream ofs;
-  fs::path fileList = directory / "CMakeLists.txt";
-  ofs.open(fileList);
-  if (ofs.good()) {
-    ofs << "cmake_minimum_required (VERSION 3.0)" << std::endl;
-    ofs << "# Auto generated by Surelog" << std::endl;
-    ofs << "project(SurelogPreprocessing NONE)" << std::endl;
-
-    fs::path cwd = fs::current_path();
-    fs::path full_exe_path = m_commandLineParser->getExePath();
-    if (m_commandLineParser->profile()) {
-      full_exe_path += " -profile";
-    }
-
-    std::string fileList;
-    // +define+
-    for (const auto& id_value : m_commandLineParser->getDefineList()) {
-      const std::string defName =
-          m_commandLineParser->getSymbolTable().getSymbol(id_value.first);
-      std::string val;
-      for (char c : id_value.second) {
-        if (c == '#') {
-          val += '\\';
-        }
-        val += c;
+  const fs::path outputDir = fs::absolute(
+      symbolTable->getSymbol(m_commandLineParser->getOutputDir()));
+  fs::path cwd = fs::current_path();
+  std::string fileList;
+  // +define+
+  for (const auto& id_value : m_commandLineParser->getDefineList()) {
+    const std::string defName =
+        m_commandLineParser->getSymbolTable().getSymbol(id_value.first);
+    std::string val;
+    for (char c : id_value.second) {
+      if (c == '#') {
+        val += '\\';
       }
-
-      fileList += " -D" + defName + "=" + val;
+      val += c;
     }
 
-    // Source files (.v, .sv on the command line)
-    for (const SymbolId& id : m_commandLineParser->getSourceFiles()) {
-      const fs::path fileName =
-          m_commandLineParser->getSymbolTable().getSymbol(id);
-
-      fs::path baseFileName = FileUtils::basename(fileName);
-      std::string_view svFile =
-          m_commandLineParser->isSVFile(baseFileName) ? " -sv " : " ";
-      StrAppend(&fileList, svFile, fileName);
-    }
-    // Library files
-    // (-v <file>)
-    for (const SymbolId& id : m_commandLineParser->getLibraryFiles()) {
-      const std::string& fileName =
-          m_commandLineParser->getSymbolTable().getSymbol(id);
-      fileList += " -v " + fileName;
-    }
-    // (-y <path> +libext+<ext>)
-    for (const auto& id : m_commandLineParser->getLibraryPaths()) {
-      const std::string& fileName =
-          m_commandLineParser->getSymbolTable().getSymbol(id);
-      fileList += " -y " + fileName;
-    }
-    // +libext+
-    for (const auto& id : m_commandLineParser->getLibraryExtensions()) {
-      const std::string& extName =
-          m_commandLineParser->getSymbolTable().getSymbol(id);
-      fileList += " +libext+" + extName;
-    }
-    // Include dirs
-    for (const SymbolId& id : m_commandLineParser->getIncludePaths()) {
-      const std::string& fileName =
-          m_commandLineParser->getSymbolTable().getSymbol(id);
-      fileList += " -I" + fileName;
-    }
+    fileList += " -D" + defName + "=" + val;
+  }
 
-    std::string_view sverilog =
-        m_commandLineParser->fullSVMode() ? " -sverilog " : " ";
-    std::string_view fileUnit =
-        m_commandLineParser->fileunit() ? " -fileunit " : " ";
-    std::string_view synth =
-        m_commandLineParser->reportNonSynthesizable() ? " -synth " : " ";
-    std::string_view noHash =
-        m_commandLineParser->noCacheHash() ? " -nohash " : " ";
-    std::string batchCmd = StrCat(fileUnit, sverilog, synth, noHash,
-                                  " -writepp -mt 0 -mp 0 -nobuiltin -noparse "
-                                  "-nostdout -l preprocessing.log -cd ",
-                                  cwd, fileList);
-    if (nbProcesses > 1) {
-      StrAppend(&batchCmd, " -o ", outputDir);
-    }
+  // Source files (.v, .sv on the command line)
+  for (const SymbolId& id : m_commandLineParser->getSourceFiles()) {
+    const fs::path fileName =
+        m_commandLineParser->getSymbolTable().getSymbol(id);
 
-    ofs << "add_custom_command(OUTPUT preprocessing" << std::endl;
-    ofs << "  COMMAND " << full_exe_path << batchCmd << std::endl;
-    ofs << "  WORKING_DIRECTORY " << cwd << std::endl;
-    ofs << ")" << std::endl;
-
-    ofs << "add_custom_target(Parse ALL DEPENDS preprocessing)" << std::endl;
-    ofs << std::flush;
-    ofs.close();
-    if (nbProcesses == 1) {
-      // Single child process
-      fs::path fileList = directory / "pp_batch.txt";
-      ofs.open(fileList);
-      ofs << batchCmd << std::endl;
-      ofs.close();
-      std::string command = StrCat("cd ", cwd, "; ", full_exe_path, " -o ",
-                                   outputDir, " -nostdout -batch ", fileList);
-      if (!muted)
-        std::cout << "Running: " << command << std::endl << std::flush;
-      int result = system(command.c_str());
-      if (!muted)
-        std::cout << "Surelog preproc status: " << result << std::endl;
-      if (!result) return false;
-    } else {
-      std::string command =
-          StrCat("cd ", directory, "; cmake -G \"Unix Makefiles\" .; make -j ",
-                 nbProcesses);
-      if (!muted)
-        std::cout << "Running: " << command << std::endl << std::flush;
-      int result = system(command.c_str());
-      if (!muted)
-        std::cout << "Surelog preproc status: " << result << std::endl;
-      if (!result) return false;
-    }
-  } else {
-    std::cerr << "FATAL: Could not create CMakeLists.txt: " << fileList
-              << std::endl;
+    fs::path baseFileName = FileUtils::basename(fileName);
+    std::string_view svFile =
+        m_commandLineParser->isSVFile(baseFileName) ? " -sv " : " ";
+    StrAppend(&fileList, svFile, fileName);
   }
-  return true;
+  // Library files
+  // (-v <file>)
+  for (const SymbolId& id : m_commandLineParser->getLibraryFiles()) {
+    const std::string& fileName =
+        m_commandLineParser->getSymbolTable().getSymbol(id);
+    fileList += " -v " + fileName;
+  }
+  // (-y <path> +libext+<ext>)
+  for (const auto& id : m_commandLineParser->getLibraryPaths()) {
+    const std::string& fileName =
+        m_commandLineParser->getSymbolTable().getSymbol(id);
+    fileList += " -y " + fileName;
+  }
+  // +libext+
+  for (const auto& id : m_commandLineParser->getLibraryExtensions()) {
+    const std::string& extName =
+        m_commandLineParser->getSymbolTable().getSymbol(id);
+    fileList += " +libext+" + extName;
+  }
+  // Include dirs
+  for (const SymbolId& id : m_commandLineParser->getIncludePaths()) {
+    const std::string& fileName =
+        m_commandLineParser->getSymbolTable().getSymbol(id);
+    fileList += " -I" + fileName;
+  }
+
+  std::string_view sverilog =
+      m_commandLineParser->fullSVMode() ? " -sverilog " : " ";
+  std::string_view fileUnit =
+      m_commandLineParser->fileunit() ? " -fileunit " : " ";
+  std::string_view synth =
+      m_commandLineParser->reportNonSynthesizable() ? " -synth " : " ";
+  std::string_view noHash =
+      m_commandLineParser->noCacheHash() ? " -nohash " : " ";
+  std::string_view cachePack =
+      m_commandLineParser->cachePack() ? " -cachepack " : " ";
+  const std::string dfaCache =
+      m_commandLineParser->dfaCache()
+          ? StrCat(" -dfacachemax ", m_commandLineParser->dfaCacheMaxStates(),
+                   " ")
+          : " ";
+  std::string_view profile =
+      m_commandLineParser->profile() ? " -profile " : " ";
+  std::string batchCmd =
+      StrCat(profile, fileUnit, sverilog, synth, noHash, cachePack, dfaCache,
+             " -writepp -mt 0 -mp 0 -nobuiltin -noparse "
+             "-nostdout -l preprocessing.log -cd ",
+             cwd, fileList, " -o ", outputDir);
+
+  ProcessPool pool({m_commandLineParser->getExePath().string(), "-server"}, 1);
+  pool.addJob(0, batchCmd);
+  return runChildProcesses_(pool, "preprocessing");
 }
 
 static int calculateEffectiveThreads(int nbThreads) {
@@ -697,7 +605,6 @@ bool Compiler::parseinit_() {
   // Large files are going to be compiled in a different batch in multithread
 
   if (!m_commandLineParser->fileunit()) {
-    DeleteContainerPointersAndClear(&m_symbolTables);
     DeleteContainerPointersAndClear(&m_errorContainers);
   }
 
@@ -714,9 +621,15 @@ bool Compiler::parseinit_() {
 
     const int effectiveNbThreads = calculateEffectiveThreads(nbThreads);
 
+    // Analyzed in memory unless the file comes preprocessed (-parseonly)
+    std::string_view content = m_text;
+    if (content.empty() && !m_commandLineParser->parseOnly() &&
+        compiler->getPreprocessor()) {
+      content = compiler->getPreprocessor()->getPreProcessedFileContent();
+    }
     AnalyzeFile* const fileAnalyzer =
         new AnalyzeFile(m_commandLineParser, m_design, fileName, origFile,
-                        effectiveNbThreads, m_text);
+                        effectiveNbThreads, content);
     fileAnalyzer->analyze();
     compiler->setFileAnalyzer(fileAnalyzer);
     if (fileAnalyzer->getSplitFiles().size() > 1) {
@@ -725,12 +638,7 @@ bool Compiler::parseinit_() {
       compiler->initParser();
 
       if (!m_commandLineParser->fileunit()) {
-        SymbolTable* symbols =
-            m_commandLineParser->getSymbolTable().CreateSnapshot();
-        m_symbolTables.push_back(symbols);
-        compiler->setSymbolTable(symbols);
-        // fileContent->setSymbolTable(symbols);
-        ErrorContainer* errors = new ErrorContainer(symbols);
+        ErrorContainer* errors = new ErrorContainer(m_symbolTable);
         m_errorContainers.push_back(errors);
         errors->registerCmdLine(m_commandLineParser);
         compiler->setErrorContainer(errors);
@@ -743,9 +651,8 @@ bool Compiler::parseinit_() {
 
       int j = 0;
       for (auto& chunk : fileAnalyzer->getSplitFiles()) {
-        SymbolTable* symbols =
-            m_commandLineParser->getSymbolTable().CreateSnapshot();
-        m_symbolTables.push_back(symbols);
+        // The jobs all intern into the shared table
+        SymbolTable* symbols = compiler->getSymbolTable();
         SymbolId ppId = symbols->registerSymbol(chunk.string());
         symbols->registerSymbol(
             compiler->getParser()->getFileName(LINE1).string());
@@ -773,11 +680,7 @@ bool Compiler::parseinit_() {
       }
     } else {
       if ((!m_commandLineParser->fileunit()) && m_text.empty()) {
-        SymbolTable* symbols =
-            m_commandLineParser->getSymbolTable().CreateSnapshot();
-        m_symbolTables.push_back(symbols);
-        compiler->setSymbolTable(symbols);
-        ErrorContainer* errors = new ErrorContainer(symbols);
+        ErrorContainer* errors = new ErrorContainer(m_symbolTable);
         m_errorContainers.push_back(errors);
         errors->registerCmdLine(m_commandLineParser);
         compiler->setErrorContainer(errors);
@@ -805,7 +708,6 @@ ErrorContainer::Stats Compiler::getErrorStats() const {
 bool Compiler::cleanup_() {
   DeleteContainerPointersAndClear(&m_compilers);
   DeleteContainerPointersAndClear(&m_compilationUnits);
-  DeleteContainerPointersAndClear(&m_symbolTables);
   DeleteContainerPointersAndClear(&m_errorContainers);
   return true;
 }
@@ -862,81 +764,27 @@ bool Compiler::compileFileSet_(CompileSourceFile::Action action,
     }
 #endif
   } else {
-    // Custom Thread management
-
-    // Optimize the load balance, try to even out the work in each thread by the
-    // size of the files
-    std::vector<std::vector<CompileSourceFile*>> jobArray(maxThreadCount);
-    std::vector<unsigned long> jobSize(maxThreadCount, 0);
-
-    for (CompileSourceFile* const source : container) {
-      const unsigned int size = source->getJobSize(action);
-      unsigned int newJobIndex = 0;
-      uint64_t minJobQueue = ULLONG_MAX;
-      for (unsigned short ii = 0; ii < maxThreadCount; ii++) {
-        if (jobSize[ii] < minJobQueue) {
-          newJobIndex = ii;
-          minJobQueue = jobSize[ii];
-        }
-      }
-
-      jobSize[newJobIndex] += size;
-      jobArray[newJobIndex].push_back(source);
-    }
-
-    if (getCommandLineParser()->profile()) {
-      if (action == CompileSourceFile::Preprocess)
-        std::cout << "Preprocessing task" << std::endl;
-      else if (action == CompileSourceFile::Parse)
-        std::cout << "Parsing task" << std::endl;
-      else
-        std::cout << "Misc Task" << std::endl;
-      for (unsigned short i = 0; i < maxThreadCount; i++) {
-        std::cout << "Thread " << i << " : " << std::endl;
-        int sum = 0;
-        for (const CompileSourceFile* job : jobArray[i]) {
-          fs::path fileName;
-          if (job->getPreprocessor())
-            fileName = job->getPreprocessor()->getFileName(0);
-          if (job->getParser()) fileName = job->getParser()->getFileName(0);
-          sum += job->getJobSize(action);
-          std::cout << job->getJobSize(action) << " " << fileName << std::endl;
-        }
-        std::cout << ", Total: " << sum << std::endl << std::flush;
-      }
-    }
-
-    // Create the threads with their respective workloads
-    std::vector<std::thread*> threads;
-    for (unsigned short i = 0; i < maxThreadCount; i++) {
-      std::thread* th = new std::thread([=] {
-        for (CompileSourceFile* job : jobArray[i]) {
+    // Work-stealing thread pool shared by all the stages
+    ThreadPool* pool = getThreadPool();
+    for (CompileSourceFile* const job : container) {
+      pool->addJob(job->getJobSize(action), [=](unsigned int) {
 #ifdef SURELOG_WITH_PYTHON
-          if (getCommandLineParser()->pythonListener() ||
-              getCommandLineParser()->pythonEvalScriptPerFile()) {
-            PyThreadState* interpState = PythonAPI::initNewInterp();
-            job->setPythonInterp(interpState);
-          }
+        if (getCommandLineParser()->pythonListener() ||
+            getCommandLineParser()->pythonEvalScriptPerFile()) {
+          PyThreadState* interpState = PythonAPI::initNewInterp();
+          job->setPythonInterp(interpState);
+        }
 #endif
-          job->compile(action);
+        job->compile(action);
 #ifdef SURELOG_WITH_PYTHON
-          if (getCommandLineParser()->pythonListener() ||
-              getCommandLineParser()->pythonEvalScriptPerFile()) {
-            job->shutdownPythonInterp();
-          }
-#endif
+        if (getCommandLineParser()->pythonListener() ||
+            getCommandLineParser()->pythonEvalScriptPerFile()) {
+          job->shutdownPythonInterp();
         }
+#endif
       });
-      threads.push_back(th);
     }
-
-    // Wait for all of them to finish
-    for (auto& t : threads) {
-      t->join();
-    }
-
-    // Delete the threads
-    DeleteContainerPointersAndClear(&threads);
+    pool->run();
 
     // Promote report to master error container
     bool fatalErrors = false;
@@ -966,6 +814,21 @@ bool Compiler::compile() {
     tmr.reset();
   }
 
+  // Warm start of the parsers
+  if (m_commandLineParser->dfaCache()) {
+    DFACache dfaCache(DFACache::getCacheFileName(m_commandLineParser),
+                      m_commandLineParser->dfaCacheMaxStates());
+    dfaCache.restore();
+    if (m_commandLineParser->profile()) {
+      std::string msg = StrCat(
+          "Loading ", DFACache::getNbStates(), " DFA states took ",
+          StringUtils::to_string(tmr.elapsed_rounded()), "s\n");
+      std::cout << msg << std::endl;
+      profile += msg;
+      tmr.reset();
+    }
+  }
+
   // Preprocess
   ppinit_();
   createMultiProcessPreProcessor_();
@@ -983,6 +846,8 @@ bool Compiler::compile() {
     for (const CompileSourceFile* compiler : m_compilers) {
       msg += compiler->getPreprocessor()->getProfileInfo();
     }
+    msg += m_includeMemo.reportProfile();
+    msg += m_includeResolver.reportProfile();
     std::cout << msg << std::endl;
     profile += msg;
     tmr.reset();
@@ -1006,6 +871,12 @@ bool Compiler::compile() {
     createFileList_();
   }
 
+  if (m_commandLineParser->dfaCache()) {
+    DFACache dfaCache(DFACache::getCacheFileName(m_commandLineParser),
+                      m_commandLineParser->dfaCacheMaxStates());
+    dfaCache.save();
+  }
+
   if (m_commandLineParser->profile()) {
     std::string msg =
         "Parsing took " + StringUtils::to_string(tmr.elapsed_rounded()) + "s\n";
@@ -1067,6 +938,9 @@ bool Compiler::compile() {
       if (m_commandLineParser->profile()) {
         std::string msg = "Elaboration took " +
                           StringUtils::to_string(tmr.elapsed_rounded()) + "s\n";
+        msg += m_compileDesign->getProfileInfo();
+        msg += m_compileDesign->getReduceExprMemo()->reportProfile();
+        msg += m_compileDesign->getEvalFuncVM()->reportProfile();
         std::cout << msg << std::endl;
         profile += msg;
         tmr.reset();
@@ -1096,6 +970,11 @@ bool Compiler::compile() {
     // Do not delete as now UHDM has to live past the compilation step
     // delete compileDesign;
   }
+  if (m_commandLineParser->profile() && (m_threadPool != nullptr)) {
+    std::string msg = "Thread pool usage:\n" + m_threadPool->getProfileInfo();
+    std::cout << msg << std::endl;
+    profile += msg;
+  }
   if (m_commandLineParser->profile()) {
     std::string msg = "Total time " +
                       StringUtils::to_string(tmrTotal.elapsed_rounded()) +
@@ -0,0 +1,59 @@
+/*
+ Copyright 2022 The Surelog Team.
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+/*
+ * File:   FileLineIndex.cpp
+ * Author: surelog
+ */
+
+#include <Surelog/SourceCompile/FileLineIndex.h>
+
+#include <algorithm>
+
+namespace SURELOG {
+
+void FileLineIndex::clear() {
+  m_files.clear();
+  m_size = 0;
+}
+
+void FileLineIndex::add(SymbolId fileId, unsigned int line) {
+  FileRecords& records = m_files[(RawSymbolId)fileId];
+  if (!records.m_lines.empty() && (line < records.m_lines.back())) {
+    records.m_sorted = false;
+  }
+  records.m_lines.push_back(line);
+  records.m_records.push_back(m_size++);
+}
+
+int32_t FileLineIndex::find(SymbolId fileId, unsigned int line) const {
+  auto found = m_files.find((RawSymbolId)fileId);
+  if (found == m_files.end()) return kNotFound;
+  const FileRecords& records = found->second;
+  if (records.m_sorted) {
+    // Equal lines keep their record order, the last one wins.
+    auto it = std::upper_bound(records.m_lines.begin(), records.m_lines.end(),
+                               line);
+    if (it == records.m_lines.begin()) return kNotFound;
+    return records.m_records[it - records.m_lines.begin() - 1];
+  }
+  for (size_t i = records.m_lines.size(); i-- > 0;) {
+    if (line >= records.m_lines[i]) return records.m_records[i];
+  }
+  return kNotFound;
+}
+
+}  // namespace SURELOG
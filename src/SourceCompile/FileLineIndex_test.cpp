@@ -0,0 +1,60 @@
+/*
+ Copyright 2022 The Surelog Team.
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+*/
+
+#include <Surelog/SourceCompile/FileLineIndex.h>
+#include <gtest/gtest.h>
+
+namespace SURELOG {
+
+namespace {
+TEST(FileLineIndexTest, InOrder) {
+  const SymbolId a(1, "a.sv");
+  const SymbolId b(2, "b.sv");
+  FileLineIndex index;
+  index.add(a, 10);  // 0
+  index.add(b, 5);   // 1
+  index.add(a, 20);  // 2
+  index.add(a, 20);  // 3
+  EXPECT_EQ(index.size(), 4);
+
+  EXPECT_EQ(index.find(a, 9), FileLineIndex::kNotFound);
+  EXPECT_EQ(index.find(a, 10), 0);
+  EXPECT_EQ(index.find(a, 19), 0);
+  EXPECT_EQ(index.find(a, 20), 3);
+  EXPECT_EQ(index.find(a, 1000), 3);
+  EXPECT_EQ(index.find(b, 4), FileLineIndex::kNotFound);
+  EXPECT_EQ(index.find(b, 5), 1);
+  EXPECT_EQ(index.find(SymbolId(3, "c.sv"), 5), FileLineIndex::kNotFound);
+
+  index.clear();
+  EXPECT_EQ(index.size(), 0);
+  EXPECT_EQ(index.find(a, 10), FileLineIndex::kNotFound);
+}
+
+TEST(FileLineIndexTest, OutOfOrder) {
+  const SymbolId a(1, "a.sv");
+  FileLineIndex index;
+  index.add(a, 30);  // 0
+  index.add(a, 10);  // 1
+  index.add(a, 20);  // 2
+  // The last record added at or before the line, as a backward scan would.
+  EXPECT_EQ(index.find(a, 5), FileLineIndex::kNotFound);
+  EXPECT_EQ(index.find(a, 15), 1);
+  EXPECT_EQ(index.find(a, 25), 2);
+  EXPECT_EQ(index.find(a, 35), 2);
+}
+}  // namespace
+}  // namespace SURELOG
@@ -0,0 +1,108 @@
+/*
+ Copyright 2022 The Surelog Team.
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+/*
+ * File:   IncludeMemo.cpp
+ * Author: surelog
+ */
+
+#include <Surelog/SourceCompile/IncludeMemo.h>
+#include <Surelog/SourceCompile/MacroInfo.h>
+#include <Surelog/SourceCompile/SymbolTable.h>
+
+namespace SURELOG {
+
+std::string IncludeMemo::macroValue(const MacroInfo* info,
+                                    const SymbolTable& symbols) {
+  if (info == nullptr) return "";
+  // Fields separated by a character that cannot be in a token.
+  std::string value = symbols.getSymbol(info->m_file);
+  value += '\0' + std::to_string(info->m_startLine) + ':' +
+           std::to_string(info->m_startColumn) + '\0' +
+           std::to_string(info->m_type);
+  for (const auto& argument : info->m_arguments) value += '\0' + argument;
+  value += '\0';
+  for (const auto& token : info->m_tokens) value += '\0' + token;
+  return value;
+}
+
+void IncludeMemo::Recording::read(SymbolId name, const MacroInfo* info) {
+  if (!m_seen.insert(name).second) return;
+  m_entry.m_reads.emplace_back(m_symbols->getSymbol(name),
+                               macroValue(info, *m_symbols));
+}
+
+void IncludeMemo::Recording::define(SymbolId name, const MacroInfo* info) {
+  m_seen.insert(name);
+  MacroDefinition definition;
+  definition.m_name = info->m_name;
+  definition.m_type = info->m_type;
+  definition.m_file = m_symbols->getSymbol(info->m_file);
+  definition.m_startLine = info->m_startLine;
+  definition.m_startColumn = info->m_startColumn;
+  definition.m_endLine = info->m_endLine;
+  definition.m_endColumn = info->m_endColumn;
+  definition.m_arguments = info->m_arguments;
+  definition.m_tokens = info->m_tokens;
+  m_entry.m_macroChanges.emplace_back(true, std::move(definition));
+}
+
+void IncludeMemo::Recording::undefine(SymbolId name, const MacroInfo* info) {
+  // Whether there was something to undefine depends on the includer.
+  read(name, info);
+  MacroDefinition definition;
+  definition.m_name = m_symbols->getSymbol(name);
+  m_entry.m_macroChanges.emplace_back(false, std::move(definition));
+}
+
+void IncludeMemo::Recording::include(const std::string& fileName) {
+  m_entry.m_includedFiles.push_back(fileName);
+}
+
+void IncludeMemo::setGuard(const std::string& fileName,
+                           const std::string& macroName) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_guards.emplace(fileName, macroName);
+}
+
+std::string IncludeMemo::getGuard(const std::string& fileName) const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  auto found = m_guards.find(fileName);
+  return (found == m_guards.end()) ? std::string() : found->second;
+}
+
+void IncludeMemo::add(const std::string& key,
+                      std::shared_ptr<const Entry> entry) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  auto& variants = m_entries[key];
+  if (variants.size() < kMaxVariants) variants.push_back(std::move(entry));
+}
+
+std::vector<std::shared_ptr<const IncludeMemo::Entry>> IncludeMemo::find(
+    const std::string& key) const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  auto found = m_entries.find(key);
+  if (found == m_entries.end()) return {};
+  return found->second;
+}
+
+std::string IncludeMemo::reportProfile() const {
+  return "Includes skipped by their guard: " + std::to_string(m_skipped) +
+         ", replayed from the include memo: " + std::to_string(m_replayed) +
+         "\n";
+}
+
+}  // namespace SURELOG
@@ -0,0 +1,108 @@
+/*
+ Copyright 2022 The Surelog Team.
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+*/
+
+#include <Surelog/SourceCompile/IncludeMemo.h>
+#include <Surelog/SourceCompile/MacroInfo.h>
+#include <Surelog/SourceCompile/SymbolTable.h>
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <string>
+
+namespace SURELOG {
+
+namespace {
+TEST(IncludeMemoTest, Guards) {
+  IncludeMemo memo;
+  EXPECT_EQ(memo.getGuard("a.svh"), "");
+  memo.setGuard("a.svh", "A_SVH");
+  EXPECT_EQ(memo.getGuard("a.svh"), "A_SVH");
+  EXPECT_EQ(memo.getGuard("b.svh"), "");
+}
+
+TEST(IncludeMemoTest, Variants) {
+  IncludeMemo memo;
+  EXPECT_TRUE(memo.find("a.svh").empty());
+  for (size_t i = 0; i < IncludeMemo::kMaxVariants + 2; i++) {
+    auto entry = std::make_shared<IncludeMemo::Entry>();
+    entry->m_content = std::to_string(i);
+    memo.add("a.svh", entry);
+  }
+  const auto variants = memo.find("a.svh");
+  ASSERT_EQ(variants.size(), IncludeMemo::kMaxVariants);
+  EXPECT_EQ(variants.front()->m_content, "0");
+  EXPECT_TRUE(memo.find("b.svh").empty());
+}
+
+TEST(IncludeMemoTest, MacroValue) {
+  SymbolTable symbols;
+  const SymbolId file = symbols.registerSymbol("a.svh");
+  MacroInfo one("M", MacroInfo::NO_ARGS, file, 1, 9, 1, 12, {}, {"1"});
+  MacroInfo two("M", MacroInfo::NO_ARGS, file, 1, 9, 1, 12, {}, {"2"});
+  MacroInfo moved("M", MacroInfo::NO_ARGS, file, 2, 9, 2, 12, {}, {"1"});
+  EXPECT_EQ(IncludeMemo::macroValue(nullptr, symbols), "");
+  EXPECT_NE(IncludeMemo::macroValue(&one, symbols), "");
+  EXPECT_EQ(IncludeMemo::macroValue(&one, symbols),
+            IncludeMemo::macroValue(&one, symbols));
+  EXPECT_NE(IncludeMemo::macroValue(&one, symbols),
+            IncludeMemo::macroValue(&two, symbols));
+  EXPECT_NE(IncludeMemo::macroValue(&one, symbols),
+            IncludeMemo::macroValue(&moved, symbols));
+}
+
+TEST(IncludeMemoTest, Recording) {
+  SymbolTable symbols;
+  const SymbolId file = symbols.registerSymbol("a.svh");
+  MacroInfo width("WIDTH", MacroInfo::NO_ARGS, file, 1, 9, 1, 15, {}, {"8"});
+  MacroInfo local("LOCAL", MacroInfo::NO_ARGS, file, 2, 9, 2, 15, {}, {"1"});
+
+  const SymbolId widthId = symbols.registerSymbol("WIDTH");
+  const SymbolId localId = symbols.registerSymbol("LOCAL");
+  const SymbolId debugId = symbols.registerSymbol("DEBUG");
+
+  IncludeMemo::Recording recording(&symbols);
+  recording.read(widthId, &width);
+  recording.read(widthId, nullptr);  // Already known
+  recording.define(localId, &local);
+  recording.read(localId, &local);  // Defined by the file itself
+  recording.undefine(debugId, nullptr);
+  recording.include("b.svh");
+  EXPECT_FALSE(recording.aborted());
+
+  const IncludeMemo::Entry& entry = recording.entry();
+  ASSERT_EQ(entry.m_reads.size(), 2);
+  EXPECT_EQ(entry.m_reads[0].first, "WIDTH");
+  EXPECT_EQ(entry.m_reads[0].second, IncludeMemo::macroValue(&width, symbols));
+  EXPECT_EQ(entry.m_reads[1].first, "DEBUG");
+  EXPECT_EQ(entry.m_reads[1].second, "");
+
+  ASSERT_EQ(entry.m_macroChanges.size(), 2);
+  EXPECT_TRUE(entry.m_macroChanges[0].first);
+  EXPECT_EQ(entry.m_macroChanges[0].second.m_name, "LOCAL");
+  EXPECT_EQ(entry.m_macroChanges[0].second.m_file, "a.svh");
+  EXPECT_EQ(entry.m_macroChanges[0].second.m_startLine, 2);
+  EXPECT_EQ(entry.m_macroChanges[0].second.m_tokens.size(), 1);
+  EXPECT_FALSE(entry.m_macroChanges[1].first);
+  EXPECT_EQ(entry.m_macroChanges[1].second.m_name, "DEBUG");
+
+  ASSERT_EQ(entry.m_includedFiles.size(), 1);
+  EXPECT_EQ(entry.m_includedFiles[0], "b.svh");
+
+  recording.abort();
+  EXPECT_TRUE(recording.aborted());
+}
+}  // namespace
+}  // namespace SURELOG
@@ -0,0 +1,139 @@
+/*
+ Copyright 2022 The Surelog Team.
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+/*
+ * File:   IncludeResolver.cpp
+ * Author: surelog
+ */
+
+#include <Surelog/SourceCompile/IncludeResolver.h>
+#include <Surelog/SourceCompile/SymbolTable.h>
+
+#include <algorithm>
+#include <cctype>
+
+namespace SURELOG {
+
+namespace fs = std::filesystem;
+
+// Key of a directory entry, file names being case insensitive there.
+static std::string entryKey(const fs::path& name) {
+#if defined(_WIN32) || defined(__APPLE__)
+  std::string key = name.string();
+  std::transform(key.begin(), key.end(), key.begin(),
+                 [](unsigned char c) { return std::tolower(c); });
+  return key;
+#else
+  return name.string();
+#endif
+}
+
+SymbolId IncludeResolver::locateFile(SymbolId file, SymbolTable* symbols,
+                                     const std::vector<SymbolId>& paths) {
+  m_lookups++;
+  const std::string& fileName = symbols->getSymbol(file);
+  std::string resolved;
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (paths != m_pathIds) {
+      m_pathIds = paths;
+      m_directories.clear();
+      m_resolved.clear();
+      for (const auto& id : paths) {
+        Directory directory;
+        directory.m_path = symbols->getSymbol(id);
+        m_directories.push_back(std::move(directory));
+      }
+    }
+    resolved = resolve_(fileName);
+  }
+  if (resolved.empty()) return BadSymbolId;
+  if (resolved == fileName) return file;
+  return symbols->registerSymbol(resolved);
+}
+
+std::string IncludeResolver::resolve_(const std::string& fileName) {
+  auto found = m_resolved.find(fileName);
+  if (found != m_resolved.end()) return found->second;
+
+  std::string resolved;
+  const fs::path name = fileName;
+  if (exists_(name)) {
+    resolved = fileName;
+  } else if (name.is_relative()) {
+    for (Directory& directory : m_directories) {
+      if (contains_(directory, name)) {
+        resolved = (directory.m_path / name).string();
+        break;
+      }
+    }
+  }
+  m_resolved.emplace(fileName, resolved);
+  return resolved;
+}
+
+bool IncludeResolver::contains_(Directory& directory, const fs::path& name) {
+  if (directory.m_state == Directory::State::NotListed) {
+    m_probes++;
+    std::error_code ec;
+    fs::directory_iterator it(directory.m_path, ec);
+    if (ec) {
+      directory.m_state = exists_(directory.m_path)
+                              ? Directory::State::Unreadable
+                              : Directory::State::Missing;
+    } else {
+      for (const fs::directory_iterator end; it != end; it.increment(ec)) {
+        if (ec) break;
+        directory.m_entries.insert(entryKey(it->path().filename()));
+      }
+      directory.m_state = ec ? Directory::State::Unreadable
+                             : Directory::State::Listed;
+    }
+  }
+  switch (directory.m_state) {
+    case Directory::State::Missing:
+      return false;
+    case Directory::State::Listed: {
+      if (name.empty()) break;
+      const fs::path first = *name.begin();
+      if ((first != ".") && (first != "..")) {
+        if (directory.m_entries.find(entryKey(first)) ==
+            directory.m_entries.end()) {
+          return false;
+        }
+        // "name" is an entry of the directory, no need to check.
+        if (++name.begin() == name.end()) return true;
+      }
+      break;
+    }
+    default:
+      break;
+  }
+  return exists_(directory.m_path / name);
+}
+
+bool IncludeResolver::exists_(const fs::path& path) {
+  m_probes++;
+  std::error_code ec;
+  return fs::exists(path, ec);
+}
+
+std::string IncludeResolver::reportProfile() const {
+  return "Include lookups: " + std::to_string(m_lookups) +
+         ", file system probes: " + std::to_string(m_probes) + "\n";
+}
+
+}  // namespace SURELOG
@@ -0,0 +1,104 @@
+/*
+ Copyright 2022 The Surelog Team.
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+/*
+ * File:   IncludeResolver_bench.cpp
+ * Author: surelog
+ *
+ * Include lookups against many include directories, each header being in
+ * one of them: file system calls and time of FileUtils::locateFile, which
+ * probes every directory in order for every include, versus the
+ * IncludeResolver.
+ *
+ * Usage: includeresolver-bench [include dirs, default 50]
+ *                              [lookups, default 20000]
+ */
+
+#include <Surelog/SourceCompile/IncludeResolver.h>
+#include <Surelog/SourceCompile/SymbolTable.h>
+#include <Surelog/Utils/FileUtils.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+using namespace SURELOG;
+namespace fs = std::filesystem;
+
+int main(int argc, char** argv) {
+  const int nbDirs = (argc > 1) ? std::atoi(argv[1]) : 50;
+  const int nbLookups = (argc > 2) ? std::atoi(argv[2]) : 20000;
+  if ((nbDirs <= 0) || (nbLookups <= 0)) {
+    fprintf(stderr, "Usage: %s [include dirs] [lookups]\n", argv[0]);
+    return 1;
+  }
+
+  // 4 headers per directory.
+  const fs::path basedir =
+      fs::temp_directory_path() / "surelog-includeresolver-bench";
+  FileUtils::rmDirRecursively(basedir);
+  SymbolTable symbols;
+  std::vector<SymbolId> paths;
+  std::vector<SymbolId> headers;
+  for (int d = 0; d < nbDirs; d++) {
+    const fs::path dir = basedir / ("inc" + std::to_string(d));
+    FileUtils::mkDirs(dir);
+    paths.push_back(symbols.registerSymbol(dir.string()));
+    for (int h = 0; h < 4; h++) {
+      const std::string name =
+          "h" + std::to_string(d) + "_" + std::to_string(h) + ".svh";
+      std::ofstream(dir / name).close();
+      headers.push_back(symbols.registerSymbol(name));
+    }
+  }
+
+  // Same as FileUtils::locateFile: the name as is, then each directory
+  // until found.
+  uint64_t locateProbes = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < nbLookups; i++) {
+    const SymbolId header = headers[i % headers.size()];
+    if (!FileUtils::locateFile(header, &symbols, paths)) return 1;
+    locateProbes += 2 + (i % headers.size()) / 4;
+  }
+  const double locateSeconds =
+      std::chrono::duration<double>(std::chrono::steady_clock::now() - start)
+          .count();
+
+  IncludeResolver resolver;
+  start = std::chrono::steady_clock::now();
+  for (int i = 0; i < nbLookups; i++) {
+    const SymbolId header = headers[i % headers.size()];
+    if (!resolver.locateFile(header, &symbols, paths)) return 1;
+  }
+  const double resolverSeconds =
+      std::chrono::duration<double>(std::chrono::steady_clock::now() - start)
+          .count();
+
+  printf("%d include dirs, %d lookups\n", nbDirs, nbLookups);
+  printf("%-22s %14s %12s\n", "", "fs probes", "time (s)");
+  printf("%-22s %14llu %12.3f\n", "FileUtils::locateFile",
+         (unsigned long long)locateProbes, locateSeconds);
+  printf("%-22s %14llu %12.3f\n", "IncludeResolver",
+         (unsigned long long)resolver.getProbeCount(), resolverSeconds);
+
+  FileUtils::rmDirRecursively(basedir);
+  return 0;
+}
@@ -0,0 +1,111 @@
+/*
+ Copyright 2022 The Surelog Team.
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+*/
+
+#include <Surelog/SourceCompile/IncludeResolver.h>
+#include <Surelog/SourceCompile/SymbolTable.h>
+#include <Surelog/Utils/FileUtils.h>
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace SURELOG {
+
+namespace fs = std::filesystem;
+
+namespace {
+TEST(IncludeResolverTest, SameAsLocateFile) {
+  SymbolTable sym;
+  const fs::path basedir =
+      fs::path(testing::TempDir()) / "include-resolver-test";
+  const fs::path dir1 = basedir / "dir1";
+  const fs::path dir2 = basedir / "dir2/";
+  const fs::path missing = basedir / "missing";
+  FileUtils::rmDirRecursively(basedir);
+  FileUtils::mkDirs(dir1 / "sub");
+  FileUtils::mkDirs(dir2);
+  std::ofstream(dir1 / "a.svh").close();
+  std::ofstream(dir1 / "sub" / "c.svh").close();
+  std::ofstream(dir2 / "a.svh").close();
+  std::ofstream(dir2 / "b.svh").close();
+
+  const std::vector<SymbolId> paths = {
+      sym.registerSymbol(missing.string()),
+      sym.registerSymbol(dir1.string()),
+      sym.registerSymbol(dir2.string()),
+  };
+  const std::vector<std::string> names = {"a.svh",
+                                          "b.svh",
+                                          "sub/c.svh",
+                                          "sub",
+                                          "sub/missing.svh",
+                                          "missing.svh",
+                                          "../dir2/b.svh",
+                                          (dir2 / "b.svh").string(),
+                                          (basedir / "x.svh").string()};
+
+  IncludeResolver resolver;
+  for (int pass = 0; pass < 2; pass++) {
+    for (const auto& name : names) {
+      const SymbolId id = sym.registerSymbol(name);
+      EXPECT_EQ(resolver.locateFile(id, &sym, paths),
+                FileUtils::locateFile(id, &sym, paths))
+          << name;
+    }
+  }
+
+  FileUtils::rmDirRecursively(basedir);
+}
+
+TEST(IncludeResolverTest, ProbesOnce) {
+  SymbolTable sym;
+  const fs::path basedir =
+      fs::path(testing::TempDir()) / "include-resolver-probes";
+  FileUtils::rmDirRecursively(basedir);
+  std::vector<SymbolId> paths;
+  for (int i = 0; i < 10; i++) {
+    const fs::path dir = basedir / ("dir" + std::to_string(i));
+    FileUtils::mkDirs(dir);
+    std::ofstream(dir / ("f" + std::to_string(i) + ".svh")).close();
+    paths.push_back(sym.registerSymbol(dir.string()));
+  }
+
+  IncludeResolver resolver;
+  const SymbolId last = sym.registerSymbol("f9.svh");
+  const SymbolId found = resolver.locateFile(last, &sym, paths);
+  EXPECT_EQ(sym.getSymbol(found), (basedir / "dir9" / "f9.svh").string());
+  // The name relative to the current directory, then one listing per
+  // directory.
+  const uint64_t probes = resolver.getProbeCount();
+  EXPECT_EQ(probes, 11);
+
+  for (int i = 0; i < 100; i++) {
+    EXPECT_EQ(resolver.locateFile(last, &sym, paths), found);
+  }
+  EXPECT_EQ(resolver.getProbeCount(), probes);
+
+  // The directories are listed already.
+  const SymbolId first = sym.registerSymbol("f0.svh");
+  EXPECT_EQ(sym.getSymbol(resolver.locateFile(first, &sym, paths)),
+            (basedir / "dir0" / "f0.svh").string());
+  EXPECT_EQ(resolver.getProbeCount(), probes + 1);
+
+  FileUtils::rmDirRecursively(basedir);
+}
+}  // namespace
+}  // namespace SURELOG
@@ -0,0 +1,80 @@
+/*
+ Copyright 2022 The Surelog Team.
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+/*
+ * File:   ListenerWalk_bench.cpp
+ * Author: surelog
+ *
+ * Parse time of a synthetic file of many small modules, as in gate level
+ * netlists, for a growing number of modules. The time per module should
+ * stay flat: the listener binds each design element to its node by a hash
+ * lookup, not by scanning the elements already created.
+ *
+ * Usage: listenerwalk-bench [max number of modules, default 10000]
+ */
+
+#include <Surelog/Design/FileContent.h>
+#include <Surelog/SourceCompile/ParserHarness.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+
+using namespace SURELOG;
+
+static std::string makeNetlist(int nbModules) {
+  std::string content;
+  for (int i = 0; i < nbModules; i++) {
+    const std::string name = "cell" + std::to_string(i);
+    content += "module " + name + "(input a, input b, output y);\n";
+    content += "  wire n;\n";
+    content += "  and g0(n, a, b);\n";
+    content += "  not g1(y, n);\n";
+    content += "endmodule\n";
+  }
+  return content;
+}
+
+int main(int argc, char** argv) {
+  const int maxModules = (argc > 1) ? std::atoi(argv[1]) : 10000;
+  if (maxModules <= 0) {
+    fprintf(stderr, "Usage: %s [max number of modules]\n", argv[0]);
+    return 1;
+  }
+  printf("%10s %10s %12s %14s\n", "modules", "elements", "parse (s)",
+         "us/module");
+  for (int nbModules = std::max(1, maxModules / 8); nbModules <= maxModules;
+       nbModules *= 2) {
+    const std::string content = makeNetlist(nbModules);
+    ParserHarness harness;
+    auto start = std::chrono::steady_clock::now();
+    std::unique_ptr<FileContent> fC = harness.parse(content);
+    const double seconds = std::chrono::duration<double>(
+                               std::chrono::steady_clock::now() - start)
+                               .count();
+    if (fC == nullptr) {
+      fprintf(stderr, "Cannot parse the %d modules\n", nbModules);
+      return 1;
+    }
+    printf("%10d %10zu %12.3f %14.2f\n", nbModules,
+           fC->getDesignElements().size(), seconds,
+           seconds * 1e6 / nbModules);
+  }
+  return 0;
+}
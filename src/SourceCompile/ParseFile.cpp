@@ -39,13 +39,32 @@
 #include <parser/SV3_1aLexer.h>
 #include <parser/SV3_1aParser.h>
 
+#include <algorithm>
 #include <fstream>
 #include <sstream>
+#include <string_view>
 
 namespace SURELOG {
 
 namespace fs = std::filesystem;
 
+namespace {
+// BailErrorStrategy remembering the rule the SLL parse failed in.
+class SllErrorStrategy final : public antlr4::BailErrorStrategy {
+ public:
+  void recover(antlr4::Parser* recognizer, std::exception_ptr e) override {
+    if (m_failed == nullptr) m_failed = recognizer->getContext();
+    antlr4::BailErrorStrategy::recover(recognizer, e);
+  }
+  antlr4::Token* recoverInline(antlr4::Parser* recognizer) override {
+    if (m_failed == nullptr) m_failed = recognizer->getContext();
+    return antlr4::BailErrorStrategy::recoverInline(recognizer);
+  }
+
+  antlr4::ParserRuleContext* m_failed = nullptr;
+};
+}  // namespace
+
 ParseFile::ParseFile(SymbolId fileId, SymbolTable* symbolTable,
                      ErrorContainer* errors)
     : m_fileId(fileId),
@@ -168,10 +187,68 @@ void ParseFile::buildLineInfoCache_() {
   if (!pp) return;
   auto const& infos = pp->getIncludeFileInfo();
   if (!infos.empty()) {
-    fileInfoCache.resize(pp->getSumLineCount() + 10);
-    lineInfoCache.resize(pp->getSumLineCount() + 10);
+    const unsigned int nbLines = pp->getSumLineCount() + 10;
+    fileInfoCache.resize(nbLines);
+    lineInfoCache.resize(nbLines);
     lineInfoCache[0] = 1;
     fileInfoCache[0] = m_fileId;
+    // A line belongs to the section of the last record at or before it that
+    // opens one: a return from an include or macro, or the start of an
+    // include or macro that is closed later. When the records come in line
+    // order with their closing records after them, one sweep over the lines
+    // finds it.
+    bool ordered = true;
+    for (unsigned int index = 0; index < infos.size(); index++) {
+      const IncludeFileInfo& info = infos[index];
+      if ((index > 0) &&
+          (info.m_originalStartLine < infos[index - 1].m_originalStartLine)) {
+        ordered = false;
+        break;
+      }
+      if ((info.m_action == IncludeFileInfo::Action::PUSH) &&
+          (info.m_indexClosing > -1) &&
+          (((unsigned int)info.m_indexClosing <= index) ||
+           ((unsigned int)info.m_indexClosing >= infos.size()) ||
+           (infos[info.m_indexClosing].m_action !=
+            IncludeFileInfo::Action::POP))) {
+        ordered = false;
+        break;
+      }
+    }
+    if (!ordered) {
+      buildLineInfoCacheScan_();
+      return;
+    }
+    int section = -1;
+    unsigned int next = 0;
+    for (unsigned int lineItr = 1; lineItr < nbLines; lineItr++) {
+      while ((next < infos.size()) &&
+             (infos[next].m_originalStartLine <= lineItr)) {
+        const IncludeFileInfo& info = infos[next];
+        if ((info.m_action == IncludeFileInfo::Action::POP) ||
+            ((info.m_action == IncludeFileInfo::Action::PUSH) &&
+             (info.m_indexClosing > -1))) {
+          section = next;
+        }
+        next++;
+      }
+      if (section == -1) {
+        fileInfoCache[lineItr] = m_fileId;
+        lineInfoCache[lineItr] = lineItr;
+      } else {
+        const IncludeFileInfo& info = infos[section];
+        fileInfoCache[lineItr] = info.m_sectionFile;
+        lineInfoCache[lineItr] =
+            info.m_sectionStartLine + (lineItr - info.m_originalStartLine);
+      }
+    }
+  }
+}
+
+void ParseFile::buildLineInfoCacheScan_() {
+  PreprocessFile* pp = getCompileSourceFile()->getPreprocessor();
+  auto const& infos = pp->getIncludeFileInfo();
+  {
     for (unsigned int lineItr = 1; lineItr < pp->getSumLineCount() + 10;
          lineItr++) {
       fileInfoCache[lineItr] = m_fileId;
@@ -276,6 +353,49 @@ unsigned int ParseFile::getLineNb(unsigned int line) {
   }
 }
 
+uint64_t ParseFile::getLineMapSignature(unsigned int nbLines,
+                                        unsigned int* firstLine) {
+  *firstLine = 0;
+  PreprocessFile* pp = getCompileSourceFile()->getPreprocessor();
+  if (pp && !pp->getIncludeFileInfo().empty()) {
+    if (lineInfoCache.empty()) buildLineInfoCache_();
+    const unsigned int maxLines =
+        (lineInfoCache.size() > m_offsetLine + 1)
+            ? lineInfoCache.size() - m_offsetLine - 1
+            : 0;
+    nbLines = std::min(nbLines, maxLines);
+  }
+  // Lines are grouped in runs of consecutive lines of the same file. Runs
+  // in the parsed file are recorded relative to the first one.
+  std::string runs;
+  SymbolId runFile = BadSymbolId;
+  unsigned int runLine = 0;
+  unsigned int runLength = 0;
+  auto flushRun = [&]() {
+    if (runLength == 0) return;
+    const bool inParsedFile = (runFile == m_fileId);
+    if (inParsedFile && (*firstLine == 0)) *firstLine = runLine;
+    runs += StrCat(inParsedFile ? "" : getSymbol(runFile), ":",
+                   inParsedFile ? runLine - *firstLine : runLine, ":",
+                   runLength, "\n");
+  };
+  for (unsigned int i = 1; i <= nbLines; i++) {
+    const SymbolId fileId = getFileId(m_offsetLine + i);
+    const unsigned int line = getLineNb(m_offsetLine + i);
+    if ((runLength > 0) && (fileId == runFile) &&
+        (line == runLine + runLength)) {
+      runLength++;
+      continue;
+    }
+    flushRun();
+    runFile = fileId;
+    runLine = line;
+    runLength = 1;
+  }
+  flushRun();
+  return StringUtils::hash64(runs);
+}
+
 bool ParseFile::parseOneFile_(const std::string& fileName,
                               unsigned int lineOffset) {
   CommandLineParser* clp = getCompileSourceFile()->getCommandLineParser();
@@ -285,7 +405,15 @@ bool ParseFile::parseOneFile_(const std::string& fileName,
   m_antlrParserHandler = antlrParserHandler;
   std::ifstream stream;
   std::stringstream ss(m_sourceText);
-  if (m_sourceText.empty()) {
+  // The whole preprocessed file is still in memory when preprocessed by this
+  // process: parse it from there, the .pp file being only a side output.
+  // Chunks and -parseonly jobs read their file.
+  const bool inMemory = m_sourceText.empty() && !isChunk() && (pp != nullptr) &&
+                        !clp->parseOnly() && (pp->getRawFileId() == m_fileId);
+  if (inMemory) {
+    antlrParserHandler->m_inputStream = new antlr4::ANTLRInputStream(
+        std::string_view(pp->getPreProcessedFileContent()));
+  } else if (m_sourceText.empty()) {
     stream.open(fileName);
     if (!stream.good()) {
       SymbolId fileId = registerSymbol(fileName);
@@ -376,21 +504,11 @@ bool ParseFile::parseOneFile_(const std::string& fileName,
       ->getInterpreter<antlr4::atn::ParserATNSimulator>()
       ->setPredictionMode(antlr4::atn::PredictionMode::SLL);
   m_antlrParserHandler->m_parser->removeErrorListeners();
-  m_antlrParserHandler->m_parser->setErrorHandler(
-      std::make_shared<antlr4::BailErrorStrategy>());
+  auto sllErrorStrategy = std::make_shared<SllErrorStrategy>();
+  m_antlrParserHandler->m_parser->setErrorHandler(sllErrorStrategy);
 
-  try {
-    m_antlrParserHandler->m_tree =
-        m_antlrParserHandler->m_parser->top_level_rule();
-
-    if (getCompileSourceFile()->getCommandLineParser()->profile()) {
-      m_profileInfo +=
-          "SLL Parsing: " + StringUtils::to_string(tmr.elapsed_rounded()) +
-          "s " + fileName + "\n";
-      tmr.reset();
-      profileParser();
-    }
-  } catch (antlr4::ParseCancellationException& pex) {
+  // Whole file in LL, with the usual error recovery and reporting.
+  auto parseFileLL = [&]() {
     m_antlrParserHandler->m_tokens->reset();
     m_antlrParserHandler->m_parser->reset();
     m_antlrParserHandler->m_parser->removeErrorListeners();
@@ -409,10 +527,48 @@ bool ParseFile::parseOneFile_(const std::string& fileName,
     if (getCompileSourceFile()->getCommandLineParser()->profile()) {
       m_profileInfo +=
           "LL  Parsing: " + StringUtils::to_string(tmr.elapsed_rounded()) +
-          "s " + fileName + "\n";
+          "s " + fileName + ", LL fallback on the whole file\n";
       tmr.reset();
       profileParser();
     }
+  };
+
+  if (m_llOnly) {
+    parseFileLL();
+  } else {
+    try {
+      m_antlrParserHandler->m_tree =
+          m_antlrParserHandler->m_parser->top_level_rule();
+      if (m_sllFailureLine != 0) failSll_(sllErrorStrategy.get());
+
+      if (getCompileSourceFile()->getCommandLineParser()->profile()) {
+        m_profileInfo +=
+            "SLL Parsing: " + StringUtils::to_string(tmr.elapsed_rounded()) +
+            "s " + fileName + "\n";
+        tmr.reset();
+        profileParser();
+      }
+    } catch (antlr4::ParseCancellationException& pex) {
+      std::vector<unsigned int> llLines;
+      if (parseDescriptionsLL_(sllErrorStrategy->m_failed, &llLines)) {
+        if (getCompileSourceFile()->getCommandLineParser()->profile()) {
+          StrAppend(&m_profileInfo, "SLL Parsing: ",
+                    StringUtils::to_string(tmr.elapsed_rounded()), "s ",
+                    fileName, ", LL fallback on ", llLines.size(),
+                    " design element(s) at");
+          for (unsigned int line : llLines) {
+            StrAppend(&m_profileInfo, " ",
+                      getFileName(line + lineOffset).string(), ":",
+                      getLineNb(line + lineOffset));
+          }
+          m_profileInfo += "\n";
+          tmr.reset();
+          profileParser();
+        }
+      } else {
+        parseFileLL();
+      }
+    }
   }
   /* Failed attempt to minimize memory usage:
      m_antlrParserHandler->m_parser->getInterpreter<antlr4::atn::ParserATNSimulator>()->clearDFA();
@@ -424,6 +580,94 @@ bool ParseFile::parseOneFile_(const std::string& fileName,
   return true;
 }
 
+void ParseFile::failSll_(antlr4::BailErrorStrategy* strategy) {
+  auto top = dynamic_cast<SV3_1aParser::Top_level_ruleContext*>(
+      m_antlrParserHandler->m_tree);
+  if ((top == nullptr) || (top->source_text() == nullptr)) return;
+  std::vector<antlr4::tree::ParseTree*>& elements =
+      top->source_text()->children;
+  for (size_t i = 0; i < elements.size(); ++i) {
+    auto element = dynamic_cast<SV3_1aParser::DescriptionContext*>(elements[i]);
+    if ((element == nullptr) ||
+        (element->getStart()->getLine() != m_sllFailureLine)) {
+      continue;
+    }
+    // The tree an SLL bail out in that element leaves behind.
+    elements.resize(i + 1);
+    static_cast<SllErrorStrategy*>(strategy)->m_failed = element;
+    throw antlr4::ParseCancellationException();
+  }
+}
+
+bool ParseFile::parseDescriptionsLL_(antlr4::ParserRuleContext* failed,
+                                     std::vector<unsigned int>* llLines) {
+  if (failed == nullptr) return false;
+  SV3_1aParser* parser = m_antlrParserHandler->m_parser;
+  antlr4::CommonTokenStream* tokens = m_antlrParserHandler->m_tokens;
+
+  // The partial tree of the SLL parse is kept up to the design element that
+  // failed, which has to be the last one parsed.
+  antlr4::tree::ParseTree* root = failed;
+  while (root->parent != nullptr) root = root->parent;
+  auto top = dynamic_cast<SV3_1aParser::Top_level_ruleContext*>(root);
+  if (top == nullptr) return false;
+  SV3_1aParser::Source_textContext* source = top->source_text();
+  if ((source == nullptr) || source->children.empty()) return false;
+  antlr4::tree::ParseTree* element = failed;
+  while ((element != nullptr) && (element->parent != source)) {
+    element = element->parent;
+  }
+  if ((element == nullptr) || (element != source->children.back()) ||
+      (dynamic_cast<SV3_1aParser::DescriptionContext*>(element) == nullptr)) {
+    return false;
+  }
+  size_t start = static_cast<antlr4::ParserRuleContext*>(element)
+                     ->getStart()
+                     ->getTokenIndex();
+  source->children.pop_back();
+
+  auto* simulator = parser->getInterpreter<antlr4::atn::ParserATNSimulator>();
+  const size_t nbSyntaxErrors = parser->getNumberOfSyntaxErrors();
+  bool ll = true;
+  while (true) {
+    tokens->seek(start);
+    if (tokens->LA(1) == antlr4::Token::EOF) break;
+    SV3_1aParser::DescriptionContext* description = nullptr;
+    if (ll) {
+      // Errors are not reported from here, a syntax error sends the whole
+      // file to LL so that errors and recovery are the usual ones.
+      llLines->push_back(tokens->LT(1)->getLine());
+      parser->setErrorHandler(std::make_shared<antlr4::DefaultErrorStrategy>());
+      simulator->setPredictionMode(antlr4::atn::PredictionMode::LL);
+      description = parser->description();
+      if (parser->getNumberOfSyntaxErrors() != nbSyntaxErrors) return false;
+      parser->setErrorHandler(std::make_shared<antlr4::BailErrorStrategy>());
+      simulator->setPredictionMode(antlr4::atn::PredictionMode::SLL);
+      ll = false;
+    } else {
+      try {
+        description = parser->description();
+      } catch (antlr4::ParseCancellationException&) {
+        ll = true;
+        continue;
+      }
+    }
+    if (tokens->index() == start) return false;
+    description->parent = source;
+    source->children.push_back(description);
+    start = tokens->index();
+  }
+
+  // What the SLL parse would have set. The EOF terminal node of the top rule
+  // is not recreated, nothing visits it.
+  source->stop = tokens->LT(-1);
+  top->stop = tokens->LT(1);
+  source->exception = nullptr;
+  top->exception = nullptr;
+  m_antlrParserHandler->m_tree = top;
+  return true;
+}
+
 void ParseFile::profileParser() {
   // Core dumps
   /*
@@ -488,6 +732,17 @@ bool ParseFile::parse() {
   } else {
     bool ok = true;
     for (ParseFile* child : m_children) {
+      if (child->m_usingCachedVersion) {
+        // Already restored by its own chunk job
+        child->m_fileContent->setParent(m_fileContent);
+        m_usingCachedVersion = true;
+        continue;
+      }
+      if (child->m_antlrParserHandler) {
+        // Changed chunk, re-parsed by its own job, walked below
+        ok = false;
+        continue;
+      }
       ParseCache cache(child);
 
       if (cache.restore()) {
@@ -544,9 +799,8 @@ bool ParseFile::parse() {
 
       ParseCache cache(this);
       if (clp->link()) return true;
-      if (!cache.save()) {
-        return false;
-      }
+      // A failure is reported as a warning by save()
+      cache.save();
 
       if (clp->profile()) {
         m_profileInfo +=
@@ -561,8 +815,8 @@ bool ParseFile::parse() {
     if (!m_children.empty()) {
       for (ParseFile* child : m_children) {
         if (child->m_antlrParserHandler) {
-          // Only visit the chunks that got re-parsed
-          // TODO: Incrementally regenerate the FileContent
+          // Only visit the chunks that got re-parsed, the others were
+          // restored from their cache (see ParseCache)
           child->m_fileContent->setParent(m_fileContent);
           child->m_listener = new SV3_1aTreeShapeListener(
               child, child->m_antlrParserHandler->m_tokens,
@@ -584,9 +838,7 @@ bool ParseFile::parse() {
 
           ParseCache cache(child);
           if (clp->link()) return true;
-          if (!cache.save()) {
-            return false;
-          }
+          cache.save();
         }
       }
     }
@@ -15,6 +15,7 @@
 */
 
 #include <Surelog/Design/FileContent.h>
+#include <Surelog/ErrorReporting/ErrorContainer.h>
 #include <Surelog/SourceCompile/ParseFile.h>
 #include <Surelog/SourceCompile/ParserHarness.h>
 #include <Surelog/SourceCompile/SymbolTable.h>
@@ -25,6 +26,40 @@ namespace SURELOG {
 using ::testing::ElementsAre;
 
 namespace {
+// Same tree, node by node, with names compared as strings as each parse has
+// its own symbol table.
+void ExpectSameTree(const FileContent* expected, const FileContent* actual) {
+  const VObjectStore& e = expected->getVObjects();
+  const VObjectStore& a = actual->getVObjects();
+  ASSERT_EQ(e.size(), a.size());
+  for (NodeId id(0); id < NodeId(e.size()); ++id) {
+    EXPECT_EQ(e.type(id), a.type(id)) << id;
+    EXPECT_EQ(expected->SymName(id), actual->SymName(id)) << id;
+    EXPECT_EQ(e.line(id), a.line(id)) << id;
+    EXPECT_EQ(e.column(id), a.column(id)) << id;
+    EXPECT_EQ(e.endLine(id), a.endLine(id)) << id;
+    EXPECT_EQ(e.endColumn(id), a.endColumn(id)) << id;
+    EXPECT_EQ(e.parent(id), a.parent(id)) << id;
+    EXPECT_EQ(e.child(id), a.child(id)) << id;
+    EXPECT_EQ(e.sibling(id), a.sibling(id)) << id;
+  }
+}
+
+void ExpectSameErrors(const ErrorContainer* expected,
+                      const ErrorContainer* actual) {
+  const std::vector<Error>& e = expected->getErrors();
+  const std::vector<Error>& a = actual->getErrors();
+  ASSERT_EQ(e.size(), a.size());
+  for (size_t i = 0; i < e.size(); ++i) {
+    EXPECT_EQ(e[i].getType(), a[i].getType()) << i;
+    ASSERT_FALSE(e[i].getLocations().empty());
+    ASSERT_FALSE(a[i].getLocations().empty());
+    EXPECT_EQ(e[i].getLocations()[0].m_line, a[i].getLocations()[0].m_line);
+    EXPECT_EQ(e[i].getLocations()[0].m_column,
+              a[i].getLocations()[0].m_column);
+  }
+}
+
 TEST(ParserTest, BasicParse) {
   ParserHarness harness;
   {
@@ -57,5 +92,58 @@ TEST(ParserTest, BasicParse) {
     EXPECT_EQ(fC->Type(Unary_Not), slUnary_Not);
   }
 }
+
+TEST(ParserTest, SllFailureFallsBackOnTheDesignElement) {
+  const std::string content =
+      "module a(); assign x = y; endmodule\n"
+      "module b(); wire w; assign w = !x; endmodule\n"
+      "module c(input i, output o); assign o = i; endmodule\n";
+  ParserHarness llHarness;
+  auto llFC = llHarness.parseLL(content);
+  ASSERT_NE(llFC, nullptr);
+  EXPECT_TRUE(llHarness.getErrorContainer()->getErrors().empty());
+
+  // One element in the middle, then the first and the last one.
+  for (unsigned int line : {2u, 1u, 3u}) {
+    ParserHarness harness;
+    auto fC = harness.parseWithSllFailure(content, line);
+    ASSERT_NE(fC, nullptr);
+    EXPECT_TRUE(harness.getErrorContainer()->getErrors().empty());
+    ExpectSameTree(llFC.get(), fC.get());
+  }
+}
+
+TEST(ParserTest, SyntaxErrorInReparsedDesignElement) {
+  const std::string content =
+      "module a(); assign x = y; endmodule\n"
+      "module b(); assign w = ; endmodule\n"
+      "module c(); endmodule\n";
+  ParserHarness llHarness;
+  auto llFC = llHarness.parseLL(content);
+  ASSERT_NE(llFC, nullptr);
+  const std::vector<Error>& errors = llHarness.getErrorContainer()->getErrors();
+  ASSERT_FALSE(errors.empty());
+  EXPECT_EQ(errors[0].getType(), ErrorDefinition::PA_SYNTAX_ERROR);
+  EXPECT_EQ(errors[0].getLocations()[0].m_line, 2u);
+
+  // The element with the error is reached through the SLL parse, and after
+  // the one reparsed in LL.
+  {
+    ParserHarness harness;
+    auto fC = harness.parse(content);
+    ASSERT_NE(fC, nullptr);
+    ExpectSameErrors(llHarness.getErrorContainer(),
+                     harness.getErrorContainer());
+    ExpectSameTree(llFC.get(), fC.get());
+  }
+  {
+    ParserHarness harness;
+    auto fC = harness.parseWithSllFailure(content, 1);
+    ASSERT_NE(fC, nullptr);
+    ExpectSameErrors(llHarness.getErrorContainer(),
+                     harness.getErrorContainer());
+    ExpectSameTree(llFC.get(), fC.get());
+  }
+}
 }  // namespace
 }  // namespace SURELOG
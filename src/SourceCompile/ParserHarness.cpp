@@ -45,6 +45,25 @@ struct ParserHarness::Holder {
 };
 
 std::unique_ptr<FileContent> ParserHarness::parse(const std::string& content) {
+  return parse_(content, false, 0);
+}
+
+std::unique_ptr<FileContent> ParserHarness::parseLL(
+    const std::string& content) {
+  return parse_(content, true, 0);
+}
+
+std::unique_ptr<FileContent> ParserHarness::parseWithSllFailure(
+    const std::string& content, unsigned int sllFailureLine) {
+  return parse_(content, false, sllFailureLine);
+}
+
+ErrorContainer* ParserHarness::getErrorContainer() const {
+  return (m_h == nullptr) ? nullptr : m_h->errors.get();
+}
+
+std::unique_ptr<FileContent> ParserHarness::parse_(
+    const std::string& content, bool llOnly, unsigned int sllFailureLine) {
   delete m_h;
   m_h = new Holder();
 
@@ -66,6 +85,8 @@ std::unique_ptr<FileContent> ParserHarness::parse(const std::string& content) {
       new FileContent(BadSymbolId, m_h->lib.get(), m_h->symbols.get(),
                       m_h->errors.get(), nullptr, BadSymbolId));
   m_h->pf->setFileContent(file_content_result.get());
+  if (llOnly) m_h->pf->setLLOnly();
+  m_h->pf->setSllFailureLine(sllFailureLine);
   if (!m_h->pf->parse()) file_content_result.reset(nullptr);
   return file_content_result;
 }
@@ -41,8 +41,10 @@
 #include <parser/SV3_1aPpLexer.h>
 #include <parser/SV3_1aPpParser.h>
 
+#include <algorithm>
+#include <cctype>
 #include <iostream>
-#include <regex>
+#include <set>
 #include <string_view>
 
 namespace SURELOG {
@@ -521,6 +523,54 @@ bool PreprocessFile::preprocess() {
   return true;
 }
 
+std::string PreprocessFile::findIncludeGuard() const {
+  if ((m_antlrParserHandler == nullptr) || !m_macroBody.empty()) return "";
+  auto top = dynamic_cast<SV3_1aPpParser::Top_level_ruleContext*>(
+      m_antlrParserHandler->m_pptree);
+  if ((top == nullptr) || (top->source_text() == nullptr)) return "";
+  auto blank = [](SV3_1aPpParser::DescriptionContext* description) {
+    if (description->comments()) return true;
+    SV3_1aPpParser::Text_blobContext* blob = description->text_blob();
+    return (blob != nullptr) && (blob->CR() || blob->Spaces());
+  };
+  // `ifndef X, then anything with balanced conditionals and no `else or
+  // `elsif of the `ifndef, then the matching `endif, with only comments
+  // and white spaces around.
+  std::string guard;
+  int depth = 0;
+  bool closed = false;
+  for (SV3_1aPpParser::DescriptionContext* description :
+       top->source_text()->description()) {
+    if (blank(description)) continue;
+    if (closed) return "";
+    if (guard.empty()) {
+      SV3_1aPpParser::Ifndef_directiveContext* ifndef =
+          description->ifndef_directive();
+      if ((ifndef == nullptr) || (ifndef->Simple_identifier() == nullptr)) {
+        return "";
+      }
+      guard = ifndef->Simple_identifier()->getText();
+      depth = 1;
+    } else if (description->ifdef_directive() ||
+               description->ifndef_directive()) {
+      depth++;
+    } else if (description->else_directive() ||
+               description->elsif_directive() ||
+               description->elseif_directive()) {
+      if (depth == 1) return "";
+    } else if (description->endif_directive()) {
+      if (--depth == 0) closed = true;
+    }
+  }
+  return closed ? guard : "";
+}
+
+void PreprocessFile::recordMacro(MacroInfo* macroInfo) {
+  const SymbolId macroId = registerSymbol(macroInfo->m_name);
+  m_macros.insert(std::make_pair(macroId, macroInfo));
+  m_compilationUnit->registerMacroInfo(macroId, macroInfo);
+}
+
 unsigned int PreprocessFile::getSumLineCount() {
   unsigned int total = m_lineCount;
   if (m_includer) total += m_includer->getSumLineCount();
@@ -587,8 +637,9 @@ void PreprocessFile::recordMacro(const std::string& name,
       name, arguments.empty() ? MacroInfo::NO_ARGS : MacroInfo::WITH_ARGS,
       getFileId(startLine), startLine, startColumn, endLine, endColumn, args,
       tokens);
-  m_macros.insert(std::make_pair(name, macroInfo));
-  m_compilationUnit->registerMacroInfo(name, macroInfo);
+  const SymbolId macroId = registerSymbol(name);
+  m_macros.insert(std::make_pair(macroId, macroInfo));
+  m_compilationUnit->registerMacroInfo(macroId, macroInfo);
   checkMacroArguments_(name, startLine, startColumn, args, tokens);
 }
 
@@ -618,8 +669,9 @@ void PreprocessFile::recordMacro(const std::string& name,
       name, arguments.empty() ? MacroInfo::NO_ARGS : MacroInfo::WITH_ARGS,
       getFileId(startLine), startLine, startColumn, endLine, endColumn,
       arguments, tokens);
-  m_macros.insert(std::make_pair(name, macroInfo));
-  m_compilationUnit->registerMacroInfo(name, macroInfo);
+  const SymbolId macroId = registerSymbol(name);
+  m_macros.insert(std::make_pair(macroId, macroInfo));
+  m_compilationUnit->registerMacroInfo(macroId, macroInfo);
 }
 
 void PreprocessFile::checkMacroArguments_(
@@ -651,7 +703,7 @@ void PreprocessFile::checkMacroArguments_(
     bool check = false;
     if ((s1.find("``") != std::string::npos) && (s1 != "``"))  // ``a``
     {
-      s1 = std::regex_replace(s1, std::regex("``"), "");
+      s1 = StringUtils::replaceAll(s1, "``", "");
       s2 = s1;
       check = true;
     } else if (s1 == "``") {
@@ -741,6 +793,236 @@ std::string PreprocessFile::evaluateMacroInstance(
   return result;
 }
 
+static std::string removeBlanks(std::string_view text) {
+  std::string result;
+  result.reserve(text.size());
+  for (char c : text) {
+    if ((c != ' ') && (c != '\t')) result.push_back(c);
+  }
+  return result;
+}
+
+static bool isIdentifierChar(char c) {
+  return std::isalnum(static_cast<unsigned char>(c)) || (c == '_') ||
+         (c == '$');
+}
+
+// Splits a macro body for its expansion without the ANTLR preprocessor.
+// Only bodies whose preprocessing is a plain copy, apart from the macro
+// instances in them, are handled: token pasting ``, `__FILE__, `__LINE__
+// and macro instances without arguments. Anything else the preprocessor
+// listener would transform or record (macro instances with arguments,
+// directives, strings, comments, escaped identifiers, numbers with blanks,
+// design element keywords) makes it return false, and the caller falls
+// back to the ANTLR path.
+bool PreprocessFile::scanPlainMacroBody_(std::string_view body,
+                                         PlainMacroBody& result) {
+  static const std::set<std::string_view, std::less<>> keywords = {
+      "module",    "endmodule",  "interface", "endinterface",
+      "program",   "endprogram", "primivite", "endprimitive",
+      "package",   "endpackage", "checker",   "endchecker",
+      "config",    "endconfig"};
+  // Tokens of the preprocessor lexer, not macro instances.
+  static const std::set<std::string_view, std::less<>> directives = {
+      "accelerate",
+      "autoexpand_vectornets",
+      "begin_keywords",
+      "celldefine",
+      "default_decay_time",
+      "default_nettype",
+      "default_trireg_strength",
+      "define",
+      "delay_mode_distributed",
+      "delay_mode_path",
+      "delay_mode_unit",
+      "delay_mode_zero",
+      "disable_portfaults",
+      "else",
+      "elseif",
+      "elsif",
+      "enable_portfaults",
+      "end_keywords",
+      "endcelldefine",
+      "endif",
+      "endprotect",
+      "endprotected",
+      "expand_vectornets",
+      "ifdef",
+      "ifndef",
+      "include",
+      "line",
+      "noaccelerate",
+      "noexpand_vectornets",
+      "noremove_gatenames",
+      "noremove_netnames",
+      "nosuppress_faults",
+      "nounconnected_drive",
+      "pragma",
+      "protect",
+      "protected",
+      "remove_gatename",
+      "remove_netname",
+      "resetall",
+      "signed",
+      "suppress_faults",
+      "timescale",
+      "unconnected_drive",
+      "undef",
+      "undefineall",
+      "unsigned",
+      "uselib"};
+  static constexpr std::string_view kFile = "`__FILE__";
+  static constexpr std::string_view kLine = "`__LINE__";
+  std::string& text = result.m_text;
+  text.clear();
+  text.reserve(body.size());
+  result.m_references.clear();
+  const size_t size = body.size();
+  size_t i = 0;
+  while (i < size) {
+    const char c = body[i];
+    if ((c == '"') || (c == '\\') || (c == '\'')) return false;
+    if ((c == '/') && (i + 1 < size) &&
+        ((body[i + 1] == '/') || (body[i + 1] == '*'))) {
+      return false;
+    }
+    if (c == '`') {
+      if ((i + 1 < size) && (body[i + 1] == '`')) {
+        text.append("``");
+        i += 2;
+        continue;
+      }
+      for (std::string_view directive : {kFile, kLine}) {
+        if ((body.compare(i, directive.size(), directive) == 0) &&
+            ((i + directive.size() == size) ||
+             !isIdentifierChar(body[i + directive.size()]))) {
+          text.append((directive == kFile) ? PP__File__Marking
+                                           : PP__Line__Marking);
+          i += directive.size();
+          break;
+        }
+      }
+      if ((i == size) || (body[i] != '`')) continue;
+      // Macro_identifier of the preprocessor lexer
+      if ((i + 1 == size) ||
+          !(std::isalpha(static_cast<unsigned char>(body[i + 1])) ||
+            (body[i + 1] == '_'))) {
+        return false;
+      }
+      size_t end = i + 2;
+      while ((end < size) && isIdentifierChar(body[end])) end++;
+      std::string_view name = body.substr(i + 1, end - i - 1);
+      if (directives.find(name) != directives.end()) return false;
+      size_t next = end;
+      while ((next < size) && ((body[next] == ' ') || (body[next] == '\t'))) {
+        next++;
+      }
+      if ((next < size) && (body[next] == '(')) return false;
+      const size_t lineStart = body.rfind('\n', i);
+      PlainMacroBody::Reference reference;
+      reference.m_offset = text.size();
+      reference.m_name = std::string(name);
+      reference.m_line = 1 + std::count(body.begin(), body.begin() + i, '\n');
+      reference.m_column =
+          (lineStart == std::string_view::npos) ? i + 1 : i - lineStart;
+      result.m_references.push_back(std::move(reference));
+      i = end;
+      continue;
+    }
+    if (std::isalpha(static_cast<unsigned char>(c)) || (c == '_')) {
+      size_t end = i + 1;
+      while ((end < size) && isIdentifierChar(body[end])) end++;
+      std::string_view word = body.substr(i, end - i);
+      if (keywords.find(word) != keywords.end()) return false;
+      text.append(word);
+      i = end;
+      continue;
+    }
+    if (std::isdigit(static_cast<unsigned char>(c))) {
+      size_t end = i + 1;
+      while ((end < size) &&
+             (std::isdigit(static_cast<unsigned char>(body[end])) ||
+              (body[end] == '_'))) {
+        end++;
+      }
+      // The preprocessor lexer squeezes blanks inside numbers
+      if ((end < size) && (body[end] == ' ')) return false;
+      text.append(body.substr(i, end - i));
+      i = end;
+      continue;
+    }
+    text.push_back(c);
+    i++;
+  }
+  // Same as getPreProcessedFileContent on an empty result
+  if (result.m_references.empty() &&
+      (text.find_first_not_of("\n ") == std::string::npos)) {
+    text.clear();
+  }
+  return true;
+}
+
+void PreprocessFile::appendPlainMacroBody_(const PlainMacroBody& body) {
+  // What SV3_1aPpTreeShapeListener::enterMacroInstanceNoArgs does for each
+  // reference, the caller checked they are all defined without arguments.
+  size_t offset = 0;
+  for (const PlainMacroBody::Reference& reference : body.m_references) {
+    append(body.m_text.substr(offset, reference.m_offset - offset));
+    offset = reference.m_offset;
+    const std::string& macroName = reference.m_name;
+    const unsigned int line = reference.m_line;
+    const unsigned int column = reference.m_column;
+    const unsigned int endColumn = column + macroName.size() + 1;
+    MacroInfo* macroInf = getMacro(macroName);
+    std::vector<std::string> args;
+    unsigned int lineSum = getSumLineCount() + 1;
+    const int openingIndex = getSourceFile()->addIncludeFileInfo(
+        IncludeFileInfo::Context::MACRO, macroInf->m_startLine,
+        macroInf->m_file, lineSum, column, lineSum, endColumn,
+        IncludeFileInfo::Action::PUSH);
+    std::string macroBody =
+        getMacro(macroName, args, this, line, getSourceFile()->m_loopChecker,
+                 m_instructions, macroInf->m_startLine, macroInf->m_file);
+    if (m_debugMacro)
+      std::cout << "FIND MACRO: " << macroName << ", BODY: |" << macroBody
+                << "|" << std::endl;
+    if (macroBody.empty() && m_instructions.m_mark_empty_macro) {
+      macroBody = SymbolTable::getEmptyMacroMarker();
+    }
+    if (macroBody == MacroNotDefined) {
+      macroBody += ":" + macroName + "!!! ";
+      if (!m_instructions.m_mute) {
+        Location loc(m_macroInfo->m_file, m_macroInfo->m_startLine + line - 1,
+                     column, registerSymbol(macroName));
+        Location extraLoc(getIncluderFileId(getIncluderLine()),
+                          getIncluderLine(), 0);
+        Error err(ErrorDefinition::PP_UNKOWN_MACRO, loc, extraLoc);
+        addError(err);
+      }
+    }
+    append(macroBody);
+
+    SymbolId fileId;
+    unsigned int callLine = 0;
+    if (getEmbeddedMacroCallFile()) {
+      fileId = getEmbeddedMacroCallFile();
+      callLine = getEmbeddedMacroCallLine() + line;
+    } else {
+      fileId = getFileId(line);
+      callLine = line;
+    }
+    if (std::count(macroBody.begin(), macroBody.end(), '\n')) {
+      lineSum = getSumLineCount() + 1;
+      const int closingIndex = getSourceFile()->addIncludeFileInfo(
+          IncludeFileInfo::Context::MACRO, callLine, fileId, lineSum, line,
+          lineSum, endColumn, IncludeFileInfo::Action::POP, openingIndex, 0);
+      getSourceFile()->getIncludeFileInfo(openingIndex).m_indexClosing =
+          closingIndex;
+    }
+  }
+  append(body.m_text.substr(offset));
+}
+
 static bool isKeyword(const std::vector<std::string>& body_tokens) {
   if (body_tokens.empty()) return false;
   std::string first = body_tokens[0];
@@ -769,7 +1051,7 @@ std::pair<bool, std::string> PreprocessFile::evaluateMacro_(
     if (loop) {
       std::vector<SymbolId> loop = loopChecker.reportLoop();
       for (const auto& id : loop) {
-        MacroInfo* macroInfo2 = m_compilationUnit->getMacroInfo(getSymbol(id));
+        MacroInfo* macroInfo2 = m_compilationUnit->getMacroInfo(id);
         if (macroInfo2) {
           Location loc(macroInfo2->m_file, macroInfo2->m_startLine,
                        macroInfo2->m_startColumn, id);
@@ -845,12 +1127,10 @@ std::pair<bool, std::string> PreprocessFile::evaluateMacro_(
     }
   }
   bool incorrectArgNb = false;
-  static const std::regex ws_re("[ \t]+");
   for (unsigned int i = 0; i < formal_args.size(); i++) {
     std::vector<std::string> formal_arg_default;
     StringUtils::tokenize(formal_args[i], "=", formal_arg_default);
-    const std::string formal =
-        std::regex_replace(formal_arg_default[0], ws_re, "");
+    const std::string formal = removeBlanks(formal_arg_default[0]);
     bool empty_actual = true;
     if (i < actual_args.size()) {
       for (char c : actual_args[i]) {
@@ -883,8 +1163,7 @@ std::pair<bool, std::string> PreprocessFile::evaluateMacro_(
       StringUtils::replaceInTokenVector(body_tokens, formal, actual_args[i]);
     } else {
       if (formal_arg_default.size() == 2) {
-        const std::string default_val =
-            std::regex_replace(formal_arg_default[1], ws_re, "");
+        const std::string default_val = removeBlanks(formal_arg_default[1]);
         StringUtils::replaceInTokenVector(body_tokens, {"``", formal, "``"},
                                           default_val);
         StringUtils::replaceInTokenVector(body_tokens, "``" + formal + "``",
@@ -974,63 +1253,92 @@ std::pair<bool, std::string> PreprocessFile::evaluateMacro_(
     body_short.push_back('\n');
   }
 
+  bool expanded = false;
   if (body_short.find('`') != std::string::npos) {
     // Recursively resolve macro instantiation within the macro
-    if (m_debugMacro) {
-      const fs::path fileName = getSymbol(m_fileId);
-      std::cout << "PP BODY EXPANSION FOR " << name << " in : " << fileName
-                << std::endl;
-      for (const auto& arg : actual_args) {
-        std::cout << "PP ARG: " << arg << "\n";
-      }
+    PlainMacroBody plain;
+    bool plainBody =
+        getCompileSourceFile()->getCommandLineParser()->plainMacros() &&
+        scanPlainMacroBody_(body_short, plain);
+    CompilationUnit* unit = callingFile ? callingFile->m_compilationUnit
+                                        : m_includer->m_compilationUnit;
+    const auto& defines =
+        m_compileSourceFile->m_commandLineParser->getDefineList();
+    for (const PlainMacroBody::Reference& reference : plain.m_references) {
+      if (!plainBody) break;
+      // Command line defines, undefined macros and missing arguments keep
+      // the listener for their substitution and error reporting
+      const SymbolId referenceId = registerSymbol(reference.m_name);
+      const MacroInfo* info = unit->getMacroInfo(referenceId);
+      plainBody = (defines.find(referenceId) == defines.end()) &&
+                  (info != nullptr) && (info->m_type != MacroInfo::WITH_ARGS);
     }
-    SymbolId macroId = registerSymbol(name);
-    SpecialInstructions instructions(
-        m_instructions.m_mute, SpecialInstructions::DontMark,
-        SpecialInstructions::Filter, m_instructions.m_check_macro_loop,
-        m_instructions.m_as_is_undefined_macro);
-    PreprocessFile* pp = new PreprocessFile(
-        macroId, callingFile ? callingFile : m_includer, callingLine,
-        m_compileSourceFile, instructions,
-        callingFile ? callingFile->m_compilationUnit
-                    : m_includer->m_compilationUnit,
-        callingFile ? callingFile->m_library : m_includer->m_library,
-        body_short, macroInfo, embeddedMacroCallLine - 1,
-        embeddedMacroCallFile);
-    getCompileSourceFile()->registerPP(pp);
-    if (!pp->preprocess()) {
-      result = MacroNotDefined;
+    if (plainBody && plain.m_references.empty()) {
+      result = plain.m_text;
+      found = true;
+      expanded = true;
     } else {
-      std::string pp_result = pp->getPreProcessedFileContent();
-
-      if (callingLine && callingFile && !callingFile->isMacroBody()) {
-        pp_result = std::regex_replace(
-            pp_result, std::regex(PP__File__Marking),
-            "\"" +
-                FileUtils::getFullPath(callingFile->getFileName(callingLine))
-                    .string() +
-                "\"");
-        pp_result = std::regex_replace(pp_result, std::regex(PP__Line__Marking),
-                                       std::to_string(callingLine));
+      if (m_debugMacro) {
+        const fs::path fileName = getSymbol(m_fileId);
+        std::cout << "PP BODY EXPANSION FOR " << name << " in : " << fileName
+                  << std::endl;
+        for (const auto& arg : actual_args) {
+          std::cout << "PP ARG: " << arg << "\n";
+        }
+      }
+      SymbolId macroId = registerSymbol(name);
+      SpecialInstructions instructions(
+          m_instructions.m_mute, SpecialInstructions::DontMark,
+          SpecialInstructions::Filter, m_instructions.m_check_macro_loop,
+          m_instructions.m_as_is_undefined_macro);
+      PreprocessFile* pp = new PreprocessFile(
+          macroId, callingFile ? callingFile : m_includer, callingLine,
+          m_compileSourceFile, instructions, unit,
+          callingFile ? callingFile->m_library : m_includer->m_library,
+          body_short, macroInfo, embeddedMacroCallLine - 1,
+          embeddedMacroCallFile);
+      getCompileSourceFile()->registerPP(pp);
+      if (plainBody) {
+        pp->appendPlainMacroBody_(plain);
+        result = pp->getPreProcessedFileContent();
+        found = true;
+        expanded = true;
+      } else if (!pp->preprocess()) {
+        result = MacroNotDefined;
+      } else {
+        result = pp->getPreProcessedFileContent();
+        found = true;
+        expanded = true;
       }
-      result = pp_result;
-      found = true;
     }
   } else {
     result = body_short;
     found = true;
   }
+  if (expanded && callingLine && callingFile && !callingFile->isMacroBody()) {
+    if (result.find(PP__File__Marking) != std::string::npos) {
+      result = StringUtils::replaceAll(
+          result, PP__File__Marking,
+          "\"" +
+              FileUtils::getFullPath(callingFile->getFileName(callingLine))
+                  .string() +
+              "\"");
+    }
+    if (result.find(PP__Line__Marking) != std::string::npos) {
+      result = StringUtils::replaceAll(result, PP__Line__Marking,
+                                       std::to_string(callingLine));
+    }
+  }
   return std::make_pair(found, result);
 }
 
 MacroInfo* PreprocessFile::getMacro(const std::string& name) {
-  registerSymbol(name);
-  return m_compilationUnit->getMacroInfo(name);
+  return m_compilationUnit->getMacroInfo(registerSymbol(name));
 }
 
 bool PreprocessFile::deleteMacro(const std::string& name,
                                  std::set<PreprocessFile*>& visited) {
-  /*SymbolId macroId = */ registerSymbol(name);
+  const SymbolId macroId = registerSymbol(name);
   if (m_debugMacro)
     std::cout << "PP CALL TO deleteMacro for " << name << std::endl;
   bool found = false;
@@ -1047,10 +1355,10 @@ bool PreprocessFile::deleteMacro(const std::string& name,
 
   // Try local file scope
   if (found == false) {
-    MacroStorage::iterator itr = m_macros.find(name);
+    MacroStorage::iterator itr = m_macros.find(macroId);
     if (itr != m_macros.end()) {
       m_macros.erase(itr);
-      m_compilationUnit->deleteMacro(name);
+      m_compilationUnit->deleteMacro(macroId);
       found = true;
     }
   }
@@ -1128,7 +1436,7 @@ std::string PreprocessFile::getMacro(
 
   // Try local file scope
   if (found == false) {
-    MacroInfo* info = m_compilationUnit->getMacroInfo(name);
+    MacroInfo* info = m_compilationUnit->getMacroInfo(macroId);
     if (instructions.m_evaluate == SpecialInstructions::Evaluate) {
       if (info) {
         std::pair<bool, std::string> evalResult = evaluateMacro_(
@@ -1136,7 +1444,7 @@ std::string PreprocessFile::getMacro(
             instructions, embeddedMacroCallLine, embeddedMacroCallFile);
         found = evalResult.first;
         result = evalResult.second;
-        result = std::regex_replace(result, std::regex("``"), "");
+        result = StringUtils::replaceAll(result, "``", "");
       }
     } else {
       if (info) {
@@ -1158,50 +1466,29 @@ std::string PreprocessFile::getMacro(
 }
 
 SymbolId PreprocessFile::getFileId(unsigned int line) const {
-  const unsigned int size = m_lineTranslationVec.size();
   if (isMacroBody() && m_macroInfo) {
     return m_macroInfo->m_file;
-  } else {
-    if (size) {
-      if (size == 1) {
-        if (line >= m_lineTranslationVec[0].m_originalLine) {
-          return (m_lineTranslationVec[0].m_pretendFileId);
-        }
-      } else {
-        unsigned int index = size - 1;
-        while (1) {
-          if (line >= m_lineTranslationVec[index].m_originalLine) {
-            return (m_lineTranslationVec[index].m_pretendFileId);
-          }
-          if (index == 0) break;
-          index--;
-        }
-      }
-      return m_fileId;
-    } else {
-      return m_fileId;
-    }
   }
+  const int32_t index = m_lineTranslationIndex.find(BadSymbolId, line);
+  if (index == FileLineIndex::kNotFound) {
+    return m_fileId;
+  }
+  return m_lineTranslationVec[index].m_pretendFileId;
 }
 
 unsigned int PreprocessFile::getLineNb(unsigned int line) {
   if (isMacroBody() && m_macroInfo) {
     return (m_macroInfo->m_startLine + line - 1);
-  } else if (!m_lineTranslationVec.empty()) {
-    unsigned int index = m_lineTranslationVec.size() - 1;
-    while (1) {
-      if (line >= m_lineTranslationVec[index].m_originalLine) {
-        return (m_lineTranslationVec[index].m_pretendLine +
-                (line - m_lineTranslationVec[index].m_originalLine));
-      }
-      if (index == 0) break;
-      index--;
-    }
   }
-  return line;
+  const int32_t index = m_lineTranslationIndex.find(BadSymbolId, line);
+  if (index == FileLineIndex::kNotFound) {
+    return line;
+  }
+  const LineTranslationInfo& info = m_lineTranslationVec[index];
+  return info.m_pretendLine + (line - info.m_originalLine);
 }
 
-std::string PreprocessFile::getPreProcessedFileContent() {
+const std::string& PreprocessFile::getPreProcessedFileContent() {
   // If File is empty (Only CR) return an empty string
   bool nonEmpty = false;
   unsigned int pp_result_size = m_result.size();
@@ -14,10 +14,15 @@
  limitations under the License.
 */
 
+#include <Surelog/DesignCompile/Builtin.h>
+#include <Surelog/SourceCompile/CompilationUnit.h>
 #include <Surelog/SourceCompile/PreprocessHarness.h>
+#include <Surelog/SourceCompile/SymbolTable.h>
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
+#include <filesystem>
+#include <fstream>
 #include <string>
 #include <string_view>
 #include <vector>
@@ -34,6 +39,52 @@ bool ContainsError(const ErrorContainer &errors,
       [etype](const Error &e) { return e.getType() == etype; });
 }
 
+// Preprocesses "content" with the plain macro bodies copied as is, and
+// again with all the bodies expanded by the preprocessor grammar. Both must
+// give the same text and messages.
+std::string PreprocessBothWays(std::string_view content) {
+  PreprocessHarness plain;
+  const std::string res = plain.preprocess(content);
+  PreprocessHarness grammar;
+  grammar.getCommandLineParser()->setPlainMacros(false);
+  EXPECT_EQ(grammar.preprocess(content), res);
+  EXPECT_EQ(grammar.collected_errors().getErrors().size(),
+            plain.collected_errors().getErrors().size());
+  return res;
+}
+
+// Preprocesses "content" with and without the include memo, they must agree.
+std::string PreprocessWithAndWithoutMemo(std::string_view content) {
+  PreprocessHarness memo;
+  const std::string res = memo.preprocess(content);
+  PreprocessHarness noMemo;
+  noMemo.getCommandLineParser()->setIncludeMemo(false);
+  EXPECT_EQ(noMemo.preprocess(content), res);
+  EXPECT_EQ(noMemo.collected_errors().getErrors().size(),
+            memo.collected_errors().getErrors().size());
+  return res;
+}
+
+// Writes "content" in a temporary header, returns its absolute path.
+std::string WriteHeader(std::string_view name, std::string_view content) {
+  const std::filesystem::path dir =
+      std::filesystem::temp_directory_path() / "surelog-includememo-test";
+  std::filesystem::create_directories(dir);
+  const std::filesystem::path fileName = dir / name;
+  std::ofstream ofs(fileName);
+  ofs << content;
+  return fileName.string();
+}
+
+int CountOccurrences(std::string_view text, std::string_view pattern) {
+  int count = 0;
+  for (size_t pos = text.find(pattern); pos != std::string_view::npos;
+       pos = text.find(pattern, pos + 1)) {
+    count++;
+  }
+  return count;
+}
+
 TEST(PreprocessTest, PreprocessWithoutPPTokens) {
   PreprocessHarness harness;
   const std::string res = harness.preprocess("module top(); endmodule");
@@ -176,5 +227,198 @@ module top();
 endmodule)");
 }
 
+TEST(PreprocessTest, BuiltinMacrosExpand) {
+  // The builtin macros are registered by the ids of the table the
+  // compilation unit is then preprocessed with.
+  SymbolTable symbols;
+  CompilationUnit unit(false);
+  Builtin builtin(nullptr, nullptr);
+  builtin.addBuiltinMacros(&unit, &symbols);
+
+  PreprocessHarness harness(&symbols);
+  const std::string res = harness.preprocess(R"(
+module top();
+  assign a = `SV_COV_OK;
+  assign b = `SV_COV_ERROR;
+endmodule)",
+                                             &unit);
+  EXPECT_EQ(res, R"(
+module top();
+  assign a = 1;
+  assign b = -1;
+endmodule)");
+  EXPECT_FALSE(ContainsError(harness.collected_errors(),
+                             ErrorDefinition::PP_UNKOWN_MACRO));
+}
+
+TEST(PreprocessTest, PlainMacroTokenPasting) {
+  const std::string res = PreprocessBothWays(R"(
+`define CAT(a, b) a``b
+`define REG(n) reg_``n``_q
+module top();
+  wire `CAT(foo, bar);
+  logic `REG(state);
+endmodule)");
+  EXPECT_NE(res.find("wire foobar;"), std::string::npos);
+  EXPECT_NE(res.find("logic reg_state_q;"), std::string::npos);
+}
+
+TEST(PreprocessTest, PlainMacroFileAndLine) {
+  const std::string res = PreprocessBothWays(R"(
+`define WHERE(x) x = `__LINE__;
+`define HERE `__FILE__
+module top();
+  initial begin
+    `WHERE(a)
+    $display(`HERE);
+  end
+endmodule)");
+  EXPECT_EQ(res.find("__LINE__"), std::string::npos);
+  EXPECT_EQ(res.find("__FILE__"), std::string::npos);
+}
+
+TEST(PreprocessTest, PlainMacroLineContinuation) {
+  const std::string res = PreprocessBothWays(R"(
+`define SUM(a, b) \
+  a``_x + \
+  b``_y
+module top();
+  assign s = `SUM(p, q);
+endmodule)");
+  EXPECT_NE(res.find("p_x"), std::string::npos);
+  EXPECT_NE(res.find("q_y"), std::string::npos);
+}
+
+TEST(PreprocessTest, PlainMacroEmptyAndBlankBodies) {
+  const std::string res = PreprocessBothWays(
+      "\n`define EMPTY\n"
+      "`define BLANK  \t \n"
+      "`define PASTE_ONLY(a) ``a``\n"
+      "`define BLANK_PASTE(a)  ``  a\n"
+      "module top();\n"
+      "  `EMPTY wire w1;\n"
+      "  `BLANK wire w2;\n"
+      "  wire `PASTE_ONLY(w3);\n"
+      "  wire `BLANK_PASTE(w4);\n"
+      "endmodule");
+  EXPECT_NE(res.find("wire w1;"), std::string::npos);
+  EXPECT_NE(res.find("wire w2;"), std::string::npos);
+}
+
+TEST(PreprocessTest, PlainMacroNestedReferences) {
+  const std::string res = PreprocessBothWays(R"(
+`define WIDTH 8
+`define MSB (`WIDTH - 1)
+`define BUS(n) logic [`MSB:0] n``_bus
+module top();
+  `BUS(data);
+  wire [`MSB:0] w;
+endmodule)");
+  EXPECT_NE(res.find("logic [(8 - 1):0] data_bus;"), std::string::npos);
+  EXPECT_NE(res.find("wire [(8 - 1):0] w;"), std::string::npos);
+}
+
+TEST(PreprocessTest, PlainMacroNestedMultiLineBody) {
+  const std::string res = PreprocessBothWays(R"(
+`define DECL(n) \
+  logic n; \
+  logic n``_q;
+`define REGS `DECL(a) `DECL(b)
+`define TWO \
+  `ONE \
+  `ONE
+`define ONE wire w;
+module top();
+  `TWO
+  `REGS
+endmodule)");
+  EXPECT_EQ(CountOccurrences(res, "wire w;"), 2);
+  EXPECT_NE(res.find("logic a_q;"), std::string::npos);
+}
+
+TEST(PreprocessTest, PlainMacroNestedUndefined) {
+  const std::string res = PreprocessBothWays(R"(
+`define USE `MISSING + 1
+module top();
+  assign a = `USE;
+endmodule)");
+  EXPECT_NE(res.find("MISSING"), std::string::npos);
+}
+
+TEST(PreprocessTest, PlainMacroNestedRecursion) {
+  constexpr std::string_view kContent = R"(
+`define A `B
+`define B `A
+module top();
+  assign a = `A;
+endmodule)";
+  PreprocessHarness harness;
+  harness.preprocess(kContent);
+  EXPECT_TRUE(ContainsError(harness.collected_errors(),
+                            ErrorDefinition::PP_RECURSIVE_MACRO_DEFINITION));
+  PreprocessBothWays(kContent);
+}
+
+TEST(PreprocessTest, IncludeMemoGuardedHeader) {
+  const std::string header = WriteHeader("guarded.svh",
+                                         "`ifndef GUARDED_SVH\n"
+                                         "`define GUARDED_SVH\n"
+                                         "wire guarded_w;\n"
+                                         "`endif\n");
+  const std::string res = PreprocessWithAndWithoutMemo(
+      "module top();\n"
+      "`include \"" + header + "\"\n"
+      "`include \"" + header + "\"\n"
+      "`ifdef GUARDED_SVH\n"
+      "wire defined_w;\n"
+      "`endif\n"
+      "endmodule\n");
+  EXPECT_EQ(CountOccurrences(res, "wire guarded_w;"), 1);
+  EXPECT_EQ(CountOccurrences(res, "wire defined_w;"), 1);
+}
+
+TEST(PreprocessTest, IncludeMemoMacroDependentHeader) {
+  const std::string header = WriteHeader("dependent.svh",
+                                         "`ifdef WIDE\n"
+                                         "wire [7:0] `NAME;\n"
+                                         "`else\n"
+                                         "wire `NAME;\n"
+                                         "`endif\n");
+  const std::string res = PreprocessWithAndWithoutMemo(
+      "module top();\n"
+      "`define NAME a\n"
+      "`include \"" + header + "\"\n"
+      "`include \"" + header + "\"\n"
+      "`undef NAME\n"
+      "`define NAME b\n"
+      "`include \"" + header + "\"\n"
+      "`define WIDE\n"
+      "`include \"" + header + "\"\n"
+      "endmodule\n");
+  EXPECT_EQ(CountOccurrences(res, "wire a;"), 2);
+  EXPECT_EQ(CountOccurrences(res, "wire b;"), 1);
+  EXPECT_EQ(CountOccurrences(res, "wire [7:0] b;"), 1);
+}
+
+TEST(PreprocessTest, IncludeMemoUndefBetweenIncludes) {
+  const std::string header = WriteHeader("reincluded.svh",
+                                         "`ifndef REINCLUDED_SVH\n"
+                                         "`define REINCLUDED_SVH\n"
+                                         "`define VALUE 1\n"
+                                         "wire reincluded_w;\n"
+                                         "`endif\n");
+  const std::string res = PreprocessWithAndWithoutMemo(
+      "module top();\n"
+      "`include \"" + header + "\"\n"
+      "`undef REINCLUDED_SVH\n"
+      "`undef VALUE\n"
+      "`include \"" + header + "\"\n"
+      "assign x = `VALUE;\n"
+      "`include \"" + header + "\"\n"
+      "endmodule\n");
+  EXPECT_EQ(CountOccurrences(res, "wire reincluded_w;"), 2);
+  EXPECT_NE(res.find("assign x = 1;"), std::string::npos);
+}
+
 }  // namespace
 }  // namespace SURELOG
@@ -30,7 +30,15 @@
 
 namespace SURELOG {
 
-PreprocessHarness::PreprocessHarness() : m_errors(&m_symbols) {}
+PreprocessHarness::PreprocessHarness()
+    : m_symbols(&m_ownSymbols),
+      m_errors(m_symbols),
+      m_clp(&m_errors, m_symbols, false, false) {}
+
+PreprocessHarness::PreprocessHarness(SymbolTable* symbols)
+    : m_symbols(symbols),
+      m_errors(m_symbols),
+      m_clp(&m_errors, m_symbols, false, false) {}
 
 std::string PreprocessHarness::preprocess(std::string_view content,
                                           CompilationUnit* compUnit) {
@@ -45,10 +53,9 @@ std::string PreprocessHarness::preprocess(std::string_view content,
       compUnit ? PreprocessFile::SpecialInstructions::Persist
                : PreprocessFile::SpecialInstructions::DontPersist);
   CompilationUnit unit(false);
-  CommandLineParser clp(&m_errors, &m_symbols, false, false);
-  Library lib("work", &m_symbols);
-  Compiler compiler(&clp, &m_errors, &m_symbols);
-  CompileSourceFile csf(BadSymbolId, &clp, &m_errors, &compiler, &m_symbols,
+  Library lib("work", m_symbols);
+  Compiler compiler(&m_clp, &m_errors, m_symbols);
+  CompileSourceFile csf(BadSymbolId, &m_clp, &m_errors, &compiler, m_symbols,
                         compUnit ? compUnit : &unit, &lib);
   PreprocessFile pp(BadSymbolId, nullptr, 0, &csf, instructions,
                     compUnit ? compUnit : &unit, &lib, content, nullptr, 0,
@@ -79,9 +79,7 @@ bool PythonListen::listen() {
     }
   }
 
-  if (!cache.save()) {
-    return false;
-  }
+  cache.save();
 
   return true;
 }
@@ -17,6 +17,7 @@
 #include <Surelog/CommandLine/CommandLineParser.h>
 #include <Surelog/Design/Design.h>
 #include <Surelog/Design/FileContent.h>
+#include <Surelog/ErrorReporting/ErrorContainer.h>
 #include <Surelog/SourceCompile/CompilationUnit.h>
 #include <Surelog/SourceCompile/CompileSourceFile.h>
 #include <Surelog/SourceCompile/Compiler.h>
@@ -24,14 +25,150 @@
 #include <Surelog/SourceCompile/PreprocessFile.h>
 #include <Surelog/SourceCompile/SV3_1aPpTreeShapeListener.h>
 #include <Surelog/SourceCompile/SymbolTable.h>
-#include <Surelog/Utils/FileUtils.h>
 #include <Surelog/Utils/ParseUtils.h>
 #include <Surelog/Utils/StringUtils.h>
 
+#include <memory>
 #include <regex>
+#include <set>
 
 namespace SURELOG {
 
+// Memo key of an include: the file and the instructions its preprocessing
+// follows.
+static std::string includeMemoKey(
+    const std::string &fileName,
+    const PreprocessFile::SpecialInstructions &instructions) {
+  std::string key = fileName;
+  key += '\0';
+  for (bool instruction :
+       {(bool)instructions.m_mute, (bool)instructions.m_mark_empty_macro,
+        (bool)instructions.m_filterFileLine,
+        (bool)instructions.m_check_macro_loop,
+        (bool)instructions.m_as_is_undefined_macro,
+        (bool)instructions.m_evaluate, (bool)instructions.m_persist}) {
+    key += instruction ? '1' : '0';
+  }
+  return key;
+}
+
+// True if "guard" is defined, so that the file it guards produces nothing.
+static bool isIncludeGuarded(PreprocessFile *pp, const std::string &guard) {
+  if (guard.empty()) return false;
+  std::vector<std::string> args;
+  PreprocessFile::SpecialInstructions instr = pp->m_instructions;
+  instr.m_evaluate = PreprocessFile::SpecialInstructions::DontEvaluate;
+  return pp->getMacro(guard, args, pp, 0, pp->getSourceFile()->m_loopChecker,
+                      instr) != PreprocessFile::MacroNotDefined;
+}
+
+// The memoized variant of an include whose macros read have the same value
+// here, if any.
+static const IncludeMemo::Entry *findIncludeMemo(
+    PreprocessFile *pp,
+    const std::vector<std::shared_ptr<const IncludeMemo::Entry>> &entries) {
+  if (entries.empty()) return nullptr;
+  const SymbolTable &symbols = *pp->getCompileSourceFile()->getSymbolTable();
+  std::set<std::string> includers;
+  for (PreprocessFile *tmp = pp; tmp; tmp = tmp->getIncluder()) {
+    includers.insert(symbols.getSymbol(tmp->getRawFileId()));
+  }
+  for (const auto &entry : entries) {
+    bool match = true;
+    for (const auto &[name, value] : entry->m_reads) {
+      if (IncludeMemo::macroValue(pp->getMacro(name), symbols) != value) {
+        match = false;
+        break;
+      }
+    }
+    // Here an include loop, to be reported by preprocessing the file.
+    for (const auto &fileName : entry->m_includedFiles) {
+      if (!match) break;
+      if (includers.find(fileName) != includers.end()) match = false;
+    }
+    if (match) return entry.get();
+  }
+  return nullptr;
+}
+
+// Applies to "pp" the macro changes and the include infos of a memoized
+// include opened at "openingIndex", after line "lineBase".
+static void replayIncludeMemo(PreprocessFile *pp,
+                              const IncludeMemo::Entry &entry,
+                              int openingIndex, unsigned int lineBase) {
+  SymbolTable *symbols = pp->getCompileSourceFile()->getSymbolTable();
+  PreprocessFile *sourceFile = pp->getSourceFile();
+  for (const IncludeMemo::IncludeRecord &record : entry.m_includeInfo) {
+    const bool push = (record.m_action == IncludeFileInfo::Action::PUSH);
+    sourceFile->addIncludeFileInfo(
+        record.m_context, record.m_sectionStartLine,
+        symbols->registerSymbol(record.m_sectionFile),
+        lineBase + record.m_originalStartLine, record.m_originalStartColumn,
+        lineBase + record.m_originalEndLine, record.m_originalEndColumn,
+        record.m_action,
+        push ? record.m_indexOpening : openingIndex + record.m_indexOpening,
+        push ? openingIndex + record.m_indexClosing : record.m_indexClosing);
+  }
+  for (const auto &[defined, definition] : entry.m_macroChanges) {
+    if (defined) {
+      pp->recordMacro(new MacroInfo(
+          definition.m_name, definition.m_type,
+          symbols->registerSymbol(definition.m_file), definition.m_startLine,
+          definition.m_startColumn, definition.m_endLine,
+          definition.m_endColumn, definition.m_arguments,
+          definition.m_tokens));
+    } else {
+      std::set<PreprocessFile *> visited;
+      pp->deleteMacro(definition.m_name, visited);
+    }
+  }
+  for (const auto &fileName : entry.m_includedFiles) {
+    pp->addMemoizedInclude(symbols->registerSymbol(fileName));
+    pp->getCompilationUnit()->recordInclude(fileName);
+  }
+}
+
+// Copies into "entry" the include infos made while preprocessing the
+// include opened at "openingIndex", after line "lineBase". False if they
+// refer to records outside of the include.
+static bool recordIncludeInfo(PreprocessFile *pp, int openingIndex,
+                              unsigned int lineBase,
+                              IncludeMemo::Entry &entry) {
+  const SymbolTable &symbols = *pp->getCompileSourceFile()->getSymbolTable();
+  const std::vector<IncludeFileInfo> &infos =
+      pp->getSourceFile()->getIncludeFileInfo();
+  const int size = infos.size();
+  auto inside = [openingIndex, size](int index) {
+    return (index > openingIndex) && (index < size);
+  };
+  for (int index = openingIndex + 1; index < size; index++) {
+    const IncludeFileInfo &info = infos[index];
+    IncludeMemo::IncludeRecord record;
+    record.m_context = info.m_context;
+    record.m_sectionStartLine = info.m_sectionStartLine;
+    if (!info.m_sectionFile) return false;
+    record.m_sectionFile = symbols.getSymbol(info.m_sectionFile);
+    record.m_originalStartLine = (int)info.m_originalStartLine - (int)lineBase;
+    record.m_originalStartColumn = info.m_originalStartColumn;
+    record.m_originalEndLine = (int)info.m_originalEndLine - (int)lineBase;
+    record.m_originalEndColumn = info.m_originalEndColumn;
+    record.m_action = info.m_action;
+    record.m_indexOpening = info.m_indexOpening;
+    record.m_indexClosing = info.m_indexClosing;
+    if (info.m_action == IncludeFileInfo::Action::PUSH) {
+      if (!inside(info.m_indexClosing)) return false;
+      record.m_indexClosing -= openingIndex;
+    } else if (info.m_action == IncludeFileInfo::Action::POP) {
+      if (!inside(info.m_indexOpening)) return false;
+      record.m_indexOpening -= openingIndex;
+    } else {
+      return false;
+    }
+    entry.m_includeInfo.push_back(std::move(record));
+  }
+  return true;
+}
+
 SV3_1aPpTreeShapeListener::SV3_1aPpTreeShapeListener(
     PreprocessFile *pp, antlr4::CommonTokenStream *tokens,
     PreprocessFile::SpecialInstructions &instructions)
@@ -248,10 +385,13 @@ void SV3_1aPpTreeShapeListener::enterInclude_directive(
 
     SymbolId fileId = getSymbolTable()->registerSymbol(fileName);
     const SymbolId locfileId =
-        FileUtils::locateFile(fileId, getSymbolTable(),
-                              m_pp->getCompileSourceFile()
-                                  ->getCommandLineParser()
-                                  ->getIncludePaths());
+        m_pp->getCompileSourceFile()
+            ->getCompiler()
+            ->getIncludeResolver()
+            ->locateFile(fileId, getSymbolTable(),
+                         m_pp->getCompileSourceFile()
+                             ->getCommandLineParser()
+                             ->getIncludePaths());
     if (locfileId) {
       fileName = getSymbolTable()->getSymbol(locfileId);
       fileId = locfileId;
@@ -284,14 +424,72 @@ void SV3_1aPpTreeShapeListener::enterInclude_directive(
         /* originalEndColumn */ endLineCol.second,
         /* action */ IncludeFileInfo::Action::PUSH);
 
-    PreprocessFile *pp = new PreprocessFile(
-        fileId, m_pp, startLineCol.first, m_pp->getCompileSourceFile(),
-        m_instructions, m_pp->getCompilationUnit(), m_pp->getLibrary());
-    m_pp->getCompileSourceFile()->registerPP(pp);
-    if (!pp->preprocess()) {
-      return;
-    }
+    IncludeMemo *memo =
+        m_pp->getCompileSourceFile()->getCompiler()->getIncludeMemo();
+    CompilationUnit *compUnit = m_pp->getCompilationUnit();
+    const std::string memoKey = includeMemoKey(fileName, m_instructions);
+    const bool useMemo =
+        m_pp->getCompileSourceFile()->getCommandLineParser()->includeMemo();
+    const IncludeMemo::Entry *entry = nullptr;
+    std::string pp_result;
+    if (useMemo && isIncludeGuarded(m_pp, memo->getGuard(fileName))) {
+      // The whole file is in an inactive `ifndef
+      memo->countSkipped();
+      m_pp->addMemoizedInclude(fileId);
+      compUnit->recordInclude(fileName);
+    } else if (useMemo &&
+               (entry = findIncludeMemo(m_pp, memo->find(memoKey)))) {
+      memo->countReplayed();
+      m_pp->addMemoizedInclude(fileId);
+      compUnit->recordInclude(fileName);
+      replayIncludeMemo(m_pp, *entry, openingIndex, lineSum - 1);
+      pp_result = entry->m_content;
+    } else {
+      PreprocessFile *pp = new PreprocessFile(
+          fileId, m_pp, startLineCol.first, m_pp->getCompileSourceFile(),
+          m_instructions, compUnit, m_pp->getLibrary());
+      m_pp->getCompileSourceFile()->registerPP(pp);
+      compUnit->recordInclude(fileName);
+
+      IncludeMemo::Recording recording(getSymbolTable());
+      ErrorContainer *errors =
+          m_pp->getCompileSourceFile()->getErrorContainer();
+      const size_t nbErrors = errors->getErrors().size();
+      const size_t nbTimeInfos = compUnit->getTimeInfo().size();
+      const size_t nbNetTypes = compUnit->getDefaultNetType().size();
+      const bool inDesignElement = compUnit->isInDesignElement();
+      const size_t stackSize = m_pp->getStack().size();
+      compUnit->startMacroRecording(&recording);
+      const bool preprocessed = pp->preprocess();
+      compUnit->stopMacroRecording();
+      if (!preprocessed) {
+        compUnit->abortMacroRecordings();
+        return;
+      }
+      pp_result = pp->getPreProcessedFileContent();
 
+      if (useMemo && !pp->usingCachedVersion()) {
+        const std::string guard = pp->findIncludeGuard();
+        if (!guard.empty()) memo->setGuard(fileName, guard);
+      }
+      // Only the macros and the content of the file can be replayed
+      IncludeMemo::Entry &recorded = recording.entry();
+      if (!useMemo || recording.aborted() || pp->usingCachedVersion() ||
+          !pp->getLineTranslationInfo().empty() ||
+          (pp->getVerilogVersion() != VerilogVersion::NoVersion) ||
+          (errors->getErrors().size() != nbErrors) ||
+          (compUnit->getTimeInfo().size() != nbTimeInfos) ||
+          (compUnit->getDefaultNetType().size() != nbNetTypes) ||
+          (compUnit->isInDesignElement() != inDesignElement) ||
+          (m_pp->getStack().size() != stackSize) ||
+          !recordIncludeInfo(m_pp, openingIndex, lineSum - 1, recorded)) {
+        compUnit->abortMacroRecordings();
+      } else {
+        recorded.m_content = pp_result;
+        memo->add(memoKey,
+                  std::make_shared<IncludeMemo::Entry>(std::move(recorded)));
+      }
+    }
     std::string pre;
     std::string post;
 
@@ -330,7 +528,6 @@ void SV3_1aPpTreeShapeListener::enterInclude_directive(
         }
       }
     }
-    std::string pp_result = pp->getPreProcessedFileContent();
     if (!pp_result.empty()) m_pp->append(pre + pp_result + post);
     if (ctx->macro_instance()) {
       m_append_paused_context = ctx;
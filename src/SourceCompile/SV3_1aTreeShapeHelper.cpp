@@ -115,7 +115,7 @@ void SV3_1aTreeShapeHelper::addNestedDesignElement(
   DesignElement* elem = new DesignElement(
       registerSymbol(name), fileId, elemtype, generateDesignElemId(), line,
       column, endLine, endColumn, InvalidNodeId);
-  elem->m_context = ctx;
+  m_contextToDesignElementMap[ctx] = elem;
   elem->m_timeInfo = m_pf->getCompilationUnit()->getTimeInfo(fileId, line);
   elem->m_defaultNetType =
       m_pf->getCompilationUnit()->getDefaultNetType(fileId, line);
@@ -139,7 +139,7 @@ void SV3_1aTreeShapeHelper::addDesignElement(antlr4::ParserRuleContext* ctx,
   DesignElement* elem = new DesignElement(
       registerSymbol(name), fileId, elemtype, generateDesignElemId(), line,
       column, endLine, endColumn, InvalidNodeId);
-  elem->m_context = ctx;
+  m_contextToDesignElementMap[ctx] = elem;
   elem->m_timeInfo =
       m_pf->getCompilationUnit()->getTimeInfo(m_pf->getFileId(line), line);
   elem->m_defaultNetType =
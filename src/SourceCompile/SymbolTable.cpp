@@ -24,14 +24,33 @@
 #include <Surelog/SourceCompile/SymbolTable.h>
 
 #include <cassert>
+#include <functional>
 
 namespace SURELOG {
 
-SymbolTable::SymbolTable() : m_parent(nullptr), m_idOffset(0) {
+static constexpr unsigned int kNbShards = 32;
+
+SymbolTable::SymbolTable()
+    : m_parent(nullptr),
+      m_idOffset(0),
+      m_nbShards(kNbShards),
+      m_shards(new Shard[kNbShards]) {
   registerSymbol(getBadSymbol());
 }
 
-SymbolTable::~SymbolTable() {}
+SymbolTable::SymbolTable(const SymbolTable& parent)
+    : m_parent(&parent),
+      m_idOffset(parent.m_idCounter + parent.m_idOffset),
+      m_nbShards(1),
+      m_shards(new Shard[1]) {}
+
+SymbolTable::~SymbolTable() {
+  if (Directory* directory = m_directory.load()) {
+    for (size_t i = 0; i < directory->m_capacity; i++) {
+      delete[] directory->m_chunks[i].load();
+    }
+  }
+}
 
 SymbolTable* SymbolTable::CreateSnapshot() const {
   return new SymbolTable(*this);
@@ -47,6 +66,41 @@ const std::string& SymbolTable::getEmptyMacroMarker() {
   return k_emptyMacroMarker;
 }
 
+SymbolTable::Shard& SymbolTable::getShard_(std::string_view symbol) const {
+  if (m_nbShards == 1) return m_shards[0];
+  return m_shards[std::hash<std::string_view>{}(symbol) % m_nbShards];
+}
+
+std::string* SymbolTable::getSlot_(RawSymbolId localId) {
+  const RawSymbolId chunkIndex = localId >> kChunkBits;
+  Directory* directory = m_directory.load(std::memory_order_acquire);
+  if ((directory == nullptr) || (chunkIndex >= directory->m_capacity) ||
+      (directory->m_chunks[chunkIndex].load(std::memory_order_acquire) ==
+       nullptr)) {
+    std::lock_guard<std::mutex> guard(m_growMutex);
+    directory = m_directory.load(std::memory_order_acquire);
+    if ((directory == nullptr) || (chunkIndex >= directory->m_capacity)) {
+      size_t capacity = (directory == nullptr) ? 16 : directory->m_capacity;
+      while (capacity <= chunkIndex) capacity *= 2;
+      Directory* grown = new Directory(capacity);
+      if (directory != nullptr) {
+        for (size_t i = 0; i < directory->m_capacity; i++) {
+          grown->m_chunks[i] = directory->m_chunks[i].load();
+        }
+      }
+      m_directories.emplace_back(grown);
+      m_directory.store(grown, std::memory_order_release);
+      directory = grown;
+    }
+    if (directory->m_chunks[chunkIndex].load() == nullptr) {
+      directory->m_chunks[chunkIndex].store(new std::string[kChunkSize],
+                                            std::memory_order_release);
+    }
+  }
+  return directory->m_chunks[chunkIndex].load(std::memory_order_acquire) +
+         (localId & (kChunkSize - 1));
+}
+
 SymbolId SymbolTable::registerSymbol(std::string_view symbol) {
   if (m_parent) {
     if (SymbolId id = m_parent->getId(symbol);
@@ -56,15 +110,26 @@ SymbolId SymbolTable::registerSymbol(std::string_view symbol) {
     }
   }
   assert(symbol.data());
-  auto found = m_symbol2IdMap.find(symbol);
-  if (found != m_symbol2IdMap.end()) {
+  Shard& shard = getShard_(symbol);
+  {
+    std::shared_lock<std::shared_mutex> lock(shard.m_mutex);
+    auto found = shard.m_symbol2IdMap.find(symbol);
+    if (found != shard.m_symbol2IdMap.end()) {
+      return SymbolId(found->second + m_idOffset, found->first);
+    }
+  }
+  std::unique_lock<std::shared_mutex> lock(shard.m_mutex);
+  auto found = shard.m_symbol2IdMap.find(symbol);
+  if (found != shard.m_symbol2IdMap.end()) {
     return SymbolId(found->second + m_idOffset, found->first);
   }
-  m_id2SymbolMap.emplace_back(symbol);
-  const std::string_view normalized_symbol = m_id2SymbolMap.back();
-  const auto inserted = m_symbol2IdMap.insert({normalized_symbol, m_idCounter});
+  const RawSymbolId localId = m_idCounter.fetch_add(1);
+  std::string* slot = getSlot_(localId);
+  slot->assign(symbol.data(), symbol.size());
+  const std::string_view normalized_symbol = *slot;
+  const auto inserted =
+      shard.m_symbol2IdMap.insert({normalized_symbol, localId});
   assert(inserted.second);  // This new insert must succeed.
-  m_idCounter++;
   return SymbolId(inserted.first->second + m_idOffset, inserted.first->first);
 }
 
@@ -76,8 +141,10 @@ SymbolId SymbolTable::getId(std::string_view symbol) const {
     }
   }
 
-  auto found = m_symbol2IdMap.find(symbol);
-  return (found == m_symbol2IdMap.end())
+  const Shard& shard = getShard_(symbol);
+  std::shared_lock<std::shared_mutex> lock(shard.m_mutex);
+  auto found = shard.m_symbol2IdMap.find(symbol);
+  return (found == shard.m_symbol2IdMap.end())
              ? getBadId()
              : SymbolId(found->second + m_idOffset, found->first);
 }
@@ -89,8 +156,13 @@ const std::string& SymbolTable::getSymbol(SymbolId id) const {
     return m_parent->getSymbol(id);
   }
   rid -= m_idOffset;
-  if (rid >= m_id2SymbolMap.size()) return getBadSymbol();
-  return m_id2SymbolMap[rid];
+  if (rid >= m_idCounter.load(std::memory_order_acquire)) {
+    return getBadSymbol();
+  }
+  const Directory* directory = m_directory.load(std::memory_order_acquire);
+  const std::string* chunk =
+      directory->m_chunks[rid >> kChunkBits].load(std::memory_order_acquire);
+  return chunk[rid & (kChunkSize - 1)];
 }
 
 void SymbolTable::AppendSymbols(int64_t up_to,
@@ -98,16 +170,26 @@ void SymbolTable::AppendSymbols(int64_t up_to,
   if (m_parent) m_parent->AppendSymbols(m_idOffset, dest);
   up_to -= m_idOffset;
   assert(up_to >= 0);
-  for (const auto& s : m_id2SymbolMap) {
-    if (up_to-- <= 0) return;
-    dest->push_back(s);
+  // Holding all the shards guarantees no symbol is half registered.
+  std::vector<std::shared_lock<std::shared_mutex>> locks;
+  locks.reserve(m_nbShards);
+  for (unsigned int i = 0; i < m_nbShards; i++) {
+    locks.emplace_back(m_shards[i].m_mutex);
+  }
+  const int64_t count = m_idCounter.load(std::memory_order_acquire);
+  const Directory* directory = m_directory.load(std::memory_order_acquire);
+  for (int64_t i = 0; (i < count) && (i < up_to); i++) {
+    const std::string* chunk =
+        directory->m_chunks[i >> kChunkBits].load(std::memory_order_acquire);
+    dest->push_back(chunk[i & (kChunkSize - 1)]);
   }
 }
 
 std::vector<std::string_view> SymbolTable::getSymbols() const {
+  const RawSymbolId count = m_idCounter.load(std::memory_order_acquire);
   std::vector<std::string_view> result;
-  result.reserve(m_idOffset + m_id2SymbolMap.size());
-  AppendSymbols(m_idOffset + m_id2SymbolMap.size(), &result);
+  result.reserve(m_idOffset + count);
+  AppendSymbols(m_idOffset + count, &result);
   return result;
 }
 
@@ -0,0 +1,120 @@
+/*
+ Copyright 2022 The Surelog Team.
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+/*
+ * File:   SymbolTable_bench.cpp
+ * Author: surelog
+ *
+ * Interning throughput of the SymbolTable: all threads registering into the
+ * shared table, versus one snapshot per thread as the Compiler does, and
+ * versus snapshots whose every symbol is then remapped into the master
+ * table (worst case, the Compiler only remaps the symbols of the errors).
+ *
+ * Usage: symboltable-bench [symbols per thread]
+ */
+
+#include <Surelog/SourceCompile/SymbolTable.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace SURELOG;
+
+// Each thread sees half names common to all threads (keywords, std
+// packages) and half names of its own (local signals).
+static std::vector<std::string> makeNames(unsigned int thread,
+                                          unsigned int count) {
+  std::vector<std::string> names;
+  names.reserve(count);
+  for (unsigned int i = 0; i < count; i++) {
+    if (i % 2)
+      names.emplace_back("common_" + std::to_string(i % 4096));
+    else
+      names.emplace_back("t" + std::to_string(thread) + "_sig_" +
+                         std::to_string(i));
+  }
+  return names;
+}
+
+template <typename Function>
+static double timeIt(unsigned int nbThreads, Function function) {
+  auto start = std::chrono::steady_clock::now();
+  std::vector<std::thread> threads;
+  for (unsigned int t = 0; t < nbThreads; t++)
+    threads.emplace_back(function, t);
+  for (auto& thread : threads) thread.join();
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                       start)
+      .count();
+}
+
+static double benchShared(
+    const std::vector<std::vector<std::string>>& names) {
+  SymbolTable table;
+  for (unsigned int i = 0; i < 4096; i += 2)
+    table.registerSymbol("common_" + std::to_string(i + 1));
+  return timeIt(names.size(), [&](unsigned int t) {
+    for (const auto& name : names[t]) table.registerSymbol(name);
+  });
+}
+
+static double benchSnapshot(const std::vector<std::vector<std::string>>& names,
+                            bool remap) {
+  SymbolTable table;
+  // Symbols registered before the parallel stage (keywords, file names)
+  for (unsigned int i = 0; i < 4096; i += 2)
+    table.registerSymbol("common_" + std::to_string(i + 1));
+  std::vector<std::unique_ptr<SymbolTable>> snapshots;
+  std::vector<std::vector<SymbolId>> ids(names.size());
+  auto start = std::chrono::steady_clock::now();
+  for (unsigned int t = 0; t < names.size(); t++)
+    snapshots.emplace_back(table.CreateSnapshot());
+  timeIt(names.size(), [&](unsigned int t) {
+    for (const auto& name : names[t])
+      ids[t].push_back(snapshots[t]->registerSymbol(name));
+  });
+  // Sequential remap into the master table, one string at a time.
+  for (unsigned int t = 0; remap && (t < names.size()); t++) {
+    for (SymbolId id : ids[t])
+      table.registerSymbol(snapshots[t]->getSymbol(id));
+  }
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                       start)
+      .count();
+}
+
+int main(int argc, const char** argv) {
+  unsigned int count = (argc > 1) ? std::atoi(argv[1]) : 200000;
+  printf("%8s %16s %18s %18s\n", "threads", "shared (Msym/s)",
+         "snapshot (Msym/s)", "+remap (Msym/s)");
+  for (unsigned int nbThreads : {1, 8, 32, 64}) {
+    std::vector<std::vector<std::string>> names;
+    for (unsigned int t = 0; t < nbThreads; t++)
+      names.emplace_back(makeNames(t, count));
+    const double total = double(count) * nbThreads / 1e6;
+    const double shared = benchShared(names);
+    const double snapshot = benchSnapshot(names, false);
+    const double remapped = benchSnapshot(names, true);
+    printf("%8u %16.2f %18.2f %18.2f\n", nbThreads, total / shared,
+           total / snapshot, total / remapped);
+  }
+  return 0;
+}
@@ -20,6 +20,7 @@
 
 #include <string>
 #include <string_view>
+#include <thread>
 #include <vector>
 
 namespace SURELOG {
@@ -183,5 +184,33 @@ TEST(SymbolTableTest, SequenceOfStackedSymbolTablesPreserved) {
       "@@BAD_SYMBOL@@", "foo", "bar", "baz", "quux", "foobar", "flip", "hello"};
   EXPECT_EQ(grandchild->getSymbols(), expected_grandchild);
 }
+
+TEST(SymbolTableTest, ConcurrentRegistration) {
+  SymbolTable table;
+  constexpr int kThreads = 8;
+  constexpr int kSymbols = 5000;
+  std::vector<std::vector<SymbolId>> ids(kThreads);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kThreads; ++t) {
+    threads.emplace_back([&table, &ids, t]() {
+      // All the threads intern the same names, in different orders.
+      for (int i = 0; i < kSymbols; ++i) {
+        const int n = (t % 2) ? i : kSymbols - 1 - i;
+        ids[t].push_back(table.registerSymbol("sym" + std::to_string(n)));
+      }
+    });
+  }
+  for (auto& thread : threads) thread.join();
+
+  EXPECT_EQ(table.getSymbols().size(), kSymbols + 1);  // +1 for bad symbol
+  for (int t = 0; t < kThreads; ++t) {
+    for (int i = 0; i < kSymbols; ++i) {
+      const int n = (t % 2) ? i : kSymbols - 1 - i;
+      const std::string name = "sym" + std::to_string(n);
+      EXPECT_EQ(ids[t][i], table.getId(name));
+      EXPECT_EQ(table.getSymbol(ids[t][i]), name);
+    }
+  }
+}
 }  // namespace
 }  // namespace SURELOG
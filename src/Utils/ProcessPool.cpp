@@ -0,0 +1,327 @@
+/*
+ Copyright 2022 The Surelog Team.
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+/*
+ * File:   ProcessPool.cpp
+ * Author: surelog
+ */
+
+#include <Surelog/Utils/ProcessPool.h>
+
+#if !defined(_MSC_VER)
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+
+namespace SURELOG {
+
+ProcessPool::ProcessPool(const std::vector<std::string>& workerCommand,
+                         unsigned int nbProcesses)
+    : m_workerCommand(workerCommand),
+      m_nbProcesses(std::max(nbProcesses, 1U)) {}
+
+void ProcessPool::addJob(uint64_t size, const std::string& commandLine) {
+  m_jobs.push_back(Job{size, m_results.size()});
+  JobResult result;
+  result.m_commandLine = commandLine;
+  m_results.push_back(std::move(result));
+}
+
+bool ProcessPool::runSequential_(const std::vector<Job>& jobs) {
+  // No fork, run each job as its own process.
+  std::string command;
+  for (const std::string& arg : m_workerCommand) {
+    if (arg == "-server") continue;
+    command += arg + " ";
+  }
+  bool success = true;
+  for (const Job& job : jobs) {
+    JobResult& result = m_results[job.m_index];
+    result.m_returnCode = system((command + result.m_commandLine).c_str());
+    if (result.m_returnCode != 0) success = false;
+  }
+  return success;
+}
+
+#if defined(_MSC_VER)
+
+bool ProcessPool::run() {
+  std::vector<Job> jobs;
+  jobs.swap(m_jobs);
+  std::stable_sort(
+      jobs.begin(), jobs.end(),
+      [](const Job& lhs, const Job& rhs) { return lhs.m_size > rhs.m_size; });
+  return runSequential_(jobs);
+}
+
+#else
+
+namespace {
+struct Child {
+  pid_t m_pid = -1;
+  int m_in = -1;          // child's stdin
+  int m_out = -1;         // child's stdout
+  std::string m_pending;  // partial output line
+  long m_job = -1;        // index in m_results of the running job
+};
+
+// The pipes of a child must not leak into the children started after it,
+// they would keep its stdin open after the pool closed it.
+bool makePipe(int fds[2]) {
+  if (pipe(fds) == -1) return false;
+  for (int i = 0; i < 2; i++) {
+    const int flags = fcntl(fds[i], F_GETFD);
+    if ((flags == -1) || (fcntl(fds[i], F_SETFD, flags | FD_CLOEXEC) == -1)) {
+      close(fds[0]);
+      close(fds[1]);
+      return false;
+    }
+  }
+  return true;
+}
+
+bool startChild(const std::vector<std::string>& command, Child* child) {
+  int in[2];
+  int out[2];
+  if (!makePipe(in)) return false;
+  if (!makePipe(out)) {
+    close(in[0]);
+    close(in[1]);
+    return false;
+  }
+  std::vector<char*> argv;
+  for (const std::string& arg : command) {
+    argv.push_back(const_cast<char*>(arg.c_str()));
+  }
+  argv.push_back(nullptr);
+  pid_t pid = fork();
+  if (pid == 0) {
+    dup2(in[0], STDIN_FILENO);
+    dup2(out[1], STDOUT_FILENO);
+    close(in[0]);
+    close(in[1]);
+    close(out[0]);
+    close(out[1]);
+    execvp(argv[0], argv.data());
+    _exit(127);
+  }
+  close(in[0]);
+  close(out[1]);
+  if (pid < 0) {
+    close(in[1]);
+    close(out[0]);
+    return false;
+  }
+  child->m_pid = pid;
+  child->m_in = in[1];
+  child->m_out = out[0];
+  return true;
+}
+
+bool writeLine(int fd, std::string_view line) {
+  std::string buffer(line);
+  buffer += '\n';
+  const char* data = buffer.data();
+  size_t remaining = buffer.size();
+  while (remaining > 0) {
+    ssize_t written = write(fd, data, remaining);
+    if (written < 0) {
+      if (errno == EINTR) continue;
+      return false;
+    }
+    data += written;
+    remaining -= written;
+  }
+  return true;
+}
+
+// Returns how the child exited, as reported by waitpid.
+std::string stopChild(Child* child) {
+  if (child->m_in != -1) close(child->m_in);
+  if (child->m_out != -1) close(child->m_out);
+  child->m_in = child->m_out = -1;
+  if (child->m_pid <= 0) return "";
+  std::string report = "child " + std::to_string(child->m_pid);
+  int status = 0;
+  if (waitpid(child->m_pid, &status, 0) == -1) {
+    report += " could not be waited for";
+  } else if (WIFEXITED(status)) {
+    report += " exited with status " + std::to_string(WEXITSTATUS(status));
+  } else if (WIFSIGNALED(status)) {
+    report += " killed by signal " + std::to_string(WTERMSIG(status));
+  }
+  child->m_pid = -1;
+  return report;
+}
+}  // namespace
+
+bool ProcessPool::run() {
+  std::vector<Job> jobs;
+  jobs.swap(m_jobs);
+  if (jobs.empty()) return true;
+  std::stable_sort(
+      jobs.begin(), jobs.end(),
+      [](const Job& lhs, const Job& rhs) { return lhs.m_size > rhs.m_size; });
+
+  // A child dying while we write its next job must not kill us.
+  struct sigaction ignore = {};
+  struct sigaction previous = {};
+  ignore.sa_handler = SIG_IGN;
+  sigaction(SIGPIPE, &ignore, &previous);
+
+  const unsigned int nbChildren = std::min<size_t>(m_nbProcesses, jobs.size());
+  std::vector<Child> children(nbChildren);
+  unsigned int nbAlive = 0;
+  for (Child& child : children) {
+    if (startChild(m_workerCommand, &child)) nbAlive++;
+  }
+  if (nbAlive == 0) {
+    sigaction(SIGPIPE, &previous, nullptr);
+    return runSequential_(jobs);
+  }
+
+  bool success = true;
+  size_t next = 0;
+  size_t done = 0;
+  // Jobs whose child died, run again before the next ones.
+  std::vector<size_t> retries;
+  auto dispatch = [&](Child& child) {
+    size_t index;
+    if (!retries.empty()) {
+      index = retries.back();
+      retries.pop_back();
+    } else if (next < jobs.size()) {
+      index = jobs[next++].m_index;
+    } else {
+      child.m_job = -1;
+      return;
+    }
+    if (writeLine(child.m_in, m_results[index].m_commandLine)) {
+      child.m_job = index;
+      return;
+    }
+    // The child is gone, the job goes back to the queue.
+    retries.push_back(index);
+    child.m_job = -1;
+    stopChild(&child);
+    nbAlive--;
+  };
+
+  std::vector<pollfd> fds;
+  std::vector<Child*> polled;
+  while (done < jobs.size()) {
+    for (Child& child : children) {
+      if ((child.m_pid > 0) && (child.m_job == -1)) dispatch(child);
+    }
+    fds.clear();
+    polled.clear();
+    for (Child& child : children) {
+      if ((child.m_pid > 0) && (child.m_job != -1)) {
+        fds.push_back(pollfd{child.m_out, POLLIN, 0});
+        polled.push_back(&child);
+      }
+    }
+    if (fds.empty()) {
+      // No child could be started again, run what is left without them.
+      std::vector<Job> left;
+      for (size_t index : retries) left.push_back(Job{0, index});
+      left.insert(left.end(), jobs.begin() + next, jobs.end());
+      if (!runSequential_(left)) success = false;
+      break;
+    }
+    if (poll(fds.data(), fds.size(), -1) < 0) {
+      if (errno == EINTR) continue;
+      success = false;
+      break;
+    }
+    for (size_t i = 0; i < fds.size(); i++) {
+      if (fds[i].revents == 0) continue;
+      Child& child = *polled[i];
+      char buffer[4096];
+      ssize_t size = read(child.m_out, buffer, sizeof(buffer));
+      if (size < 0 && errno == EINTR) continue;
+      if (size <= 0) {
+        // Died in the middle of a job: keep what it printed, replace the
+        // child and run the job once more.
+        JobResult& result = m_results[child.m_job];
+        result.m_output += child.m_pending;
+        child.m_pending.clear();
+        if (!result.m_output.empty() && (result.m_output.back() != '\n')) {
+          result.m_output += '\n';
+        }
+        result.m_output += "Surelog: " + stopChild(&child) + " running: " +
+                           result.m_commandLine + "\n";
+        nbAlive--;
+        if (result.m_retried) {
+          result.m_returnCode = -1;
+          success = false;
+          done++;
+        } else {
+          result.m_retried = true;
+          retries.push_back(child.m_job);
+        }
+        child.m_job = -1;
+        if ((!retries.empty() || (next < jobs.size())) &&
+            startChild(m_workerCommand, &child)) {
+          nbAlive++;
+        }
+        continue;
+      }
+      child.m_pending.append(buffer, size);
+      size_t start = 0;
+      size_t end;
+      while ((child.m_job != -1) &&
+             (end = child.m_pending.find('\n', start)) != std::string::npos) {
+        std::string_view line(child.m_pending.data() + start, end - start);
+        start = end + 1;
+        JobResult& result = m_results[child.m_job];
+        // The marker may follow output not terminated by a new line.
+        const size_t marker = line.rfind(kDoneMarker);
+        if (marker != std::string_view::npos) {
+          result.m_output.append(line.data(), marker);
+          result.m_returnCode = std::atoi(
+              std::string(line.substr(marker + kDoneMarker.size())).c_str());
+          if (result.m_returnCode != 0) success = false;
+          done++;
+          dispatch(child);
+        } else {
+          result.m_output.append(line.data(), line.size());
+          result.m_output += '\n';
+        }
+      }
+      child.m_pending.erase(0, start);
+    }
+  }
+
+  for (Child& child : children) {
+    if (child.m_pid > 0) writeLine(child.m_in, kQuitCommand);
+    stopChild(&child);
+  }
+  sigaction(SIGPIPE, &previous, nullptr);
+  return success;
+}
+
+#endif
+
+}  // namespace SURELOG
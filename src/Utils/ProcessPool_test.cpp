@@ -0,0 +1,139 @@
+/*
+ Copyright 2022 The Surelog Team.
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+*/
+
+#include <Surelog/Utils/ProcessPool.h>
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#if !defined(_MSC_VER)
+#include <unistd.h>
+#endif
+
+#include <string>
+#include <vector>
+
+namespace SURELOG {
+
+namespace {
+#if !defined(_MSC_VER)
+// Stand-in for "surelog -server": echoes the job, returns the number given
+// as the job's second word.
+const std::vector<std::string> kWorker = {
+    "/bin/sh", "-c",
+    "while read a b; do [ \"$a\" = quit ] && exit 0; echo \"ran $a\"; "
+    "echo \"@@SURELOG_DONE $b\"; done"};
+
+TEST(ProcessPoolTest, RunsAllJobs) {
+  ProcessPool pool(kWorker, 4);
+  for (int i = 0; i < 20; i++) {
+    pool.addJob(i, "job" + std::to_string(i) + " 0");
+  }
+  EXPECT_TRUE(pool.run());
+  const auto& results = pool.getResults();
+  ASSERT_EQ(results.size(), 20u);
+  for (int i = 0; i < 20; i++) {
+    EXPECT_EQ(results[i].m_returnCode, 0);
+    EXPECT_EQ(results[i].m_output, "ran job" + std::to_string(i) + "\n");
+  }
+}
+
+TEST(ProcessPoolTest, ReportsFailures) {
+  ProcessPool pool(kWorker, 2);
+  pool.addJob(1, "ok 0");
+  pool.addJob(2, "bad 4");
+  EXPECT_FALSE(pool.run());
+  EXPECT_EQ(pool.getResults()[0].m_returnCode, 0);
+  EXPECT_EQ(pool.getResults()[1].m_returnCode, 4);
+}
+
+TEST(ProcessPoolTest, MarkerAfterUnterminatedOutput) {
+  const std::vector<std::string> worker = {
+      "/bin/sh", "-c",
+      "while read a; do [ \"$a\" = quit ] && exit 0; printf partial; "
+      "echo \"@@SURELOG_DONE 0\"; done"};
+  ProcessPool pool(worker, 1);
+  pool.addJob(1, "job");
+  EXPECT_TRUE(pool.run());
+  EXPECT_EQ(pool.getResults()[0].m_output, "partial");
+}
+
+TEST(ProcessPoolTest, ChildDyingTwiceFailsItsJob) {
+  const std::vector<std::string> worker = {
+      "/bin/sh", "-c", "read a; printf partial; exit 3"};
+  ProcessPool pool(worker, 1);
+  pool.addJob(1, "first");
+  pool.addJob(1, "second");
+  EXPECT_FALSE(pool.run());
+  for (const auto& result : pool.getResults()) {
+    EXPECT_EQ(result.m_returnCode, -1);
+    EXPECT_TRUE(result.m_retried);
+    EXPECT_THAT(result.m_output,
+                ::testing::MatchesRegex("partial\nSurelog: child [0-9]+ "
+                                        "exited with status 3 running: .*\n"
+                                        "partial\nSurelog: child [0-9]+ "
+                                        "exited with status 3 running: .*\n"));
+  }
+}
+
+TEST(ProcessPoolTest, ChildDyingOnceRetriesItsJob) {
+  // The first child dies in the middle of its job, the next ones work.
+  const std::string marker =
+      ::testing::TempDir() + "surelog-processpool-died";
+  rmdir(marker.c_str());
+  const std::vector<std::string> worker = {
+      "/bin/sh", "-c",
+      "while read a; do [ \"$a\" = quit ] && exit 0; "
+      "mkdir " + marker + " 2>/dev/null && { echo partial; kill -9 $$; }; "
+      "echo \"ran $a\"; echo \"@@SURELOG_DONE 0\"; done"};
+  ProcessPool pool(worker, 2);
+  for (int i = 0; i < 4; i++) pool.addJob(i, "job" + std::to_string(i));
+  EXPECT_TRUE(pool.run());
+  int retried = 0;
+  for (int i = 0; i < 4; i++) {
+    const auto& result = pool.getResults()[i];
+    EXPECT_EQ(result.m_returnCode, 0);
+    if (!result.m_retried) {
+      EXPECT_EQ(result.m_output, "ran job" + std::to_string(i) + "\n");
+      continue;
+    }
+    retried++;
+    EXPECT_THAT(result.m_output,
+                ::testing::MatchesRegex("partial\nSurelog: child [0-9]+ "
+                                        "killed by signal 9 running: .*\n"
+                                        "ran job[0-9]\n"));
+  }
+  EXPECT_EQ(retried, 1);
+  rmdir(marker.c_str());
+}
+
+TEST(ProcessPoolTest, ChildrenDoNotInheritPipes) {
+  // Each job answers the number of descriptors open above stderr, the
+  // children started last would see the pipes of the first ones.
+  const std::vector<std::string> worker = {
+      "/bin/sh", "-c",
+      "while read a; do [ \"$a\" = quit ] && exit 0; n=0; "
+      "for fd in 3 4 5 6 7 8 9; do (: >&$fd) 2>/dev/null && n=$((n+1)); "
+      "done; echo $n; echo \"@@SURELOG_DONE 0\"; done"};
+  ProcessPool pool(worker, 4);
+  for (int i = 0; i < 4; i++) pool.addJob(1, "job");
+  EXPECT_TRUE(pool.run());
+  for (const auto& result : pool.getResults()) {
+    EXPECT_EQ(result.m_output, pool.getResults()[0].m_output);
+  }
+}
+#endif
+}  // namespace
+}  // namespace SURELOG
@@ -366,4 +366,89 @@ std::string StringUtils::unquoted(const std::string& text) {
   return text;
 }
 
+static constexpr uint64_t kPrime64_1 = 0x9E3779B185EBCA87ULL;
+static constexpr uint64_t kPrime64_2 = 0xC2B2AE3D27D4EB4FULL;
+static constexpr uint64_t kPrime64_3 = 0x165667B19E3779F9ULL;
+static constexpr uint64_t kPrime64_4 = 0x85EBCA77C2B2AE63ULL;
+static constexpr uint64_t kPrime64_5 = 0x27D4EB2F165667C5ULL;
+
+static inline uint64_t rotl64(uint64_t x, int r) {
+  return (x << r) | (x >> (64 - r));
+}
+
+// Reads are little-endian so the hash does not depend on the host.
+static inline uint64_t read64(const unsigned char* p) {
+  uint64_t v = 0;
+  for (int i = 7; i >= 0; i--) v = (v << 8) | p[i];
+  return v;
+}
+
+static inline uint32_t read32(const unsigned char* p) {
+  return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) |
+         ((uint32_t)p[3] << 24);
+}
+
+static inline uint64_t xxhRound(uint64_t acc, uint64_t input) {
+  acc += input * kPrime64_2;
+  acc = rotl64(acc, 31);
+  return acc * kPrime64_1;
+}
+
+static inline uint64_t xxhMergeRound(uint64_t acc, uint64_t val) {
+  acc ^= xxhRound(0, val);
+  return acc * kPrime64_1 + kPrime64_4;
+}
+
+uint64_t StringUtils::hash64(std::string_view text, uint64_t seed) {
+  const unsigned char* p = (const unsigned char*)text.data();
+  const unsigned char* const end = p + text.size();
+  uint64_t h;
+
+  if (text.size() >= 32) {
+    const unsigned char* const limit = end - 32;
+    uint64_t v1 = seed + kPrime64_1 + kPrime64_2;
+    uint64_t v2 = seed + kPrime64_2;
+    uint64_t v3 = seed;
+    uint64_t v4 = seed - kPrime64_1;
+    do {
+      v1 = xxhRound(v1, read64(p));
+      v2 = xxhRound(v2, read64(p + 8));
+      v3 = xxhRound(v3, read64(p + 16));
+      v4 = xxhRound(v4, read64(p + 24));
+      p += 32;
+    } while (p <= limit);
+    h = rotl64(v1, 1) + rotl64(v2, 7) + rotl64(v3, 12) + rotl64(v4, 18);
+    h = xxhMergeRound(h, v1);
+    h = xxhMergeRound(h, v2);
+    h = xxhMergeRound(h, v3);
+    h = xxhMergeRound(h, v4);
+  } else {
+    h = seed + kPrime64_5;
+  }
+  h += (uint64_t)text.size();
+
+  while (p + 8 <= end) {
+    h ^= xxhRound(0, read64(p));
+    h = rotl64(h, 27) * kPrime64_1 + kPrime64_4;
+    p += 8;
+  }
+  if (p + 4 <= end) {
+    h ^= (uint64_t)read32(p) * kPrime64_1;
+    h = rotl64(h, 23) * kPrime64_2 + kPrime64_3;
+    p += 4;
+  }
+  while (p < end) {
+    h ^= (*p) * kPrime64_5;
+    h = rotl64(h, 11) * kPrime64_1;
+    p++;
+  }
+
+  h ^= h >> 33;
+  h *= kPrime64_2;
+  h ^= h >> 29;
+  h *= kPrime64_3;
+  h ^= h >> 32;
+  return h;
+}
+
 }  // namespace SURELOG
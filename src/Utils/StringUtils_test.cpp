@@ -293,5 +293,18 @@ TEST(StringUtilsTest, StrAppend) {
   EXPECT_EQ("Base string hello world 42", target);
 }
 
+TEST(StringUtilsTest, Hash64) {
+  // Reference XXH64 values.
+  EXPECT_EQ(0xEF46DB3751D8E999ULL, StringUtils::hash64(""));
+  EXPECT_EQ(0xD24EC4F1A98C6E5BULL, StringUtils::hash64("a"));
+  EXPECT_EQ(0x44BC2CF5AD770999ULL, StringUtils::hash64("abc"));
+
+  const std::string text(1000, 'x');
+  EXPECT_EQ(StringUtils::hash64(text), StringUtils::hash64(text));
+  EXPECT_NE(StringUtils::hash64(text), StringUtils::hash64(text, 1));
+  EXPECT_NE(StringUtils::hash64(text),
+            StringUtils::hash64(std::string_view(text).substr(1)));
+}
+
 }  // namespace
 }  // namespace SURELOG
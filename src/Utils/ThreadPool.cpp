@@ -0,0 +1,175 @@
+/*
+ Copyright 2022 The Surelog Team.
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+/*
+ * File:   ThreadPool.cpp
+ * Author: surelog
+ */
+
+#include <Surelog/Utils/StringUtils.h>
+#include <Surelog/Utils/ThreadPool.h>
+#include <Surelog/Utils/Timer.h>
+
+#include <algorithm>
+
+namespace SURELOG {
+
+ThreadPool::ThreadPool(unsigned int nbWorkers)
+    : m_queues(nbWorkers), m_stats(nbWorkers) {
+  m_workers.reserve(nbWorkers);
+  for (unsigned int i = 0; i < nbWorkers; i++) {
+    m_workers.emplace_back(&ThreadPool::workerLoop_, this, i);
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_shutdown = true;
+  }
+  m_startCond.notify_all();
+  for (std::thread& worker : m_workers) {
+    worker.join();
+  }
+}
+
+void ThreadPool::addJob(uint64_t size, Job job) {
+  m_pending.push_back(Task{size, std::move(job)});
+}
+
+void ThreadPool::run() {
+  if (m_pending.empty()) return;
+
+  std::stable_sort(
+      m_pending.begin(), m_pending.end(),
+      [](const Task& lhs, const Task& rhs) { return lhs.m_size > rhs.m_size; });
+
+  const unsigned int nbWorkers = m_workers.size();
+  if (nbWorkers == 0) {
+    for (Task& task : m_pending) {
+      task.m_job(0);
+    }
+    m_pending.clear();
+    return;
+  }
+
+  // Initial placement: largest jobs first, each on the least loaded worker.
+  // This is the former static split, stealing can only improve on it.
+  std::vector<uint64_t> load(nbWorkers, 0);
+  for (Task& task : m_pending) {
+    unsigned int target = std::min_element(load.begin(), load.end()) -
+                          load.begin();
+    load[target] += (task.m_size == 0) ? 1 : task.m_size;
+    m_queues[target].m_tasks.push_back(std::move(task));
+  }
+  m_remaining = m_pending.size();
+  m_pending.clear();
+
+  std::vector<double> busyBefore(nbWorkers);
+  for (unsigned int i = 0; i < nbWorkers; i++) {
+    busyBefore[i] = m_stats[i].m_busy;
+  }
+
+  Timer wallClock;
+  {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_running = nbWorkers;
+    m_batch++;
+  }
+  m_startCond.notify_all();
+  {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_doneCond.wait(lock, [this] { return m_running == 0; });
+  }
+  const double wall = wallClock.elapsed();
+  for (unsigned int i = 0; i < nbWorkers; i++) {
+    const double busy = m_stats[i].m_busy - busyBefore[i];
+    m_stats[i].m_idle += std::max(0.0, wall - busy);
+  }
+}
+
+bool ThreadPool::popTask_(unsigned int index, Task& task, bool& stolen) {
+  {
+    Queue& own = m_queues[index];
+    std::unique_lock<std::mutex> lock(own.m_mutex);
+    if (!own.m_tasks.empty()) {
+      task = std::move(own.m_tasks.front());
+      own.m_tasks.pop_front();
+      stolen = false;
+      return true;
+    }
+  }
+  // Steal the smallest pending job of another worker, leaving its large jobs
+  // to itself.
+  const unsigned int nbWorkers = m_queues.size();
+  for (unsigned int i = 1; i < nbWorkers; i++) {
+    Queue& victim = m_queues[(index + i) % nbWorkers];
+    std::unique_lock<std::mutex> lock(victim.m_mutex);
+    if (!victim.m_tasks.empty()) {
+      task = std::move(victim.m_tasks.back());
+      victim.m_tasks.pop_back();
+      stolen = true;
+      return true;
+    }
+  }
+  return false;
+}
+
+void ThreadPool::workerLoop_(unsigned int index) {
+  uint64_t seenBatch = 0;
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      m_startCond.wait(lock,
+                       [&] { return m_shutdown || (m_batch != seenBatch); });
+      if (m_shutdown) return;
+      seenBatch = m_batch;
+    }
+
+    WorkerStats& stats = m_stats[index];
+    Task task;
+    bool stolen = false;
+    while ((m_remaining > 0) && popTask_(index, task, stolen)) {
+      Timer tmr;
+      task.m_job(index);
+      stats.m_busy += tmr.elapsed();
+      stats.m_jobs++;
+      if (stolen) stats.m_steals++;
+      task.m_job = nullptr;
+      m_remaining--;
+    }
+
+    {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      if (--m_running == 0) m_doneCond.notify_all();
+    }
+  }
+}
+
+std::string ThreadPool::getProfileInfo() const {
+  std::string profile;
+  for (unsigned int i = 0; i < m_stats.size(); i++) {
+    const WorkerStats& stats = m_stats[i];
+    profile += "Worker " + std::to_string(i) +
+               ": jobs: " + std::to_string(stats.m_jobs) +
+               ", stolen: " + std::to_string(stats.m_steals) +
+               ", busy: " + StringUtils::to_string(stats.m_busy) +
+               "s, idle: " + StringUtils::to_string(stats.m_idle) + "s\n";
+  }
+  return profile;
+}
+
+}  // namespace SURELOG
@@ -0,0 +1,69 @@
+/*
+ Copyright 2022 The Surelog Team.
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+*/
+
+#include <Surelog/Utils/ThreadPool.h>
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <vector>
+
+namespace SURELOG {
+
+namespace {
+TEST(ThreadPoolTest, RunsAllJobs) {
+  ThreadPool pool(4);
+  std::vector<std::atomic<int>> hits(100);
+  for (int i = 0; i < 100; i++) {
+    pool.addJob(i, [&hits, i](unsigned int worker) {
+      EXPECT_LT(worker, 4u);
+      hits[i]++;
+    });
+  }
+  pool.run();
+  for (const auto& hit : hits) {
+    EXPECT_EQ(hit.load(), 1);
+  }
+  uint64_t jobs = 0;
+  for (const auto& stats : pool.getStats()) {
+    jobs += stats.m_jobs;
+  }
+  EXPECT_EQ(jobs, 100u);
+}
+
+TEST(ThreadPoolTest, ReusedAcrossBatches) {
+  ThreadPool pool(3);
+  std::atomic<int> count(0);
+  for (int batch = 0; batch < 5; batch++) {
+    for (int i = 0; i < 10; i++) {
+      pool.addJob(1, [&count](unsigned int) { count++; });
+    }
+    pool.run();
+    EXPECT_EQ(count.load(), (batch + 1) * 10);
+  }
+}
+
+TEST(ThreadPoolTest, NoWorkersRunsInline) {
+  ThreadPool pool(0);
+  std::vector<int> order;
+  pool.addJob(1, [&order](unsigned int) { order.push_back(1); });
+  pool.addJob(3, [&order](unsigned int) { order.push_back(3); });
+  pool.addJob(2, [&order](unsigned int) { order.push_back(2); });
+  pool.run();
+  EXPECT_THAT(order, ::testing::ElementsAre(3, 2, 1));
+}
+}  // namespace
+}  // namespace SURELOG
@@ -30,7 +30,12 @@
 #endif
 
 #include <Surelog/API/PythonAPI.h>
+#include <Surelog/Cache/PPCache.h>
 #include <Surelog/ErrorReporting/Report.h>
+#include <Surelog/SourceCompile/CompileSourceFile.h>
+#include <Surelog/SourceCompile/Compiler.h>
+#include <Surelog/SourceCompile/PreprocessFile.h>
+#include <Surelog/Utils/ProcessPool.h>
 #include <Surelog/Utils/StringUtils.h>
 #include <Surelog/surelog.h>
 #include <string.h>
@@ -38,6 +43,8 @@
 
 #include <fstream>
 #include <iostream>
+#include <map>
+#include <set>
 #include <string>
 #include <vector>
 
@@ -50,10 +57,185 @@ constexpr std::string_view parseonly_opt = "-parseonly";
 constexpr std::string_view batch_opt = "-batch";
 constexpr std::string_view nostdout_opt = "-nostdout";
 constexpr std::string_view output_folder_opt = "-o";
+constexpr std::string_view server_opt = "-server";
+
+// Compilation of the last request kept alive by the compile server
+// (-server), with the files it depends on. The same request is answered
+// from it again as long as none of these files changed. Otherwise only the
+// sources affected by the changes are preprocessed again.
+class KeptCompilation {
+ public:
+  KeptCompilation() = default;
+  KeptCompilation(const KeptCompilation&) = delete;
+  KeptCompilation& operator=(const KeptCompilation&) = delete;
+  ~KeptCompilation() { release(); }
+
+  void release() {
+    SURELOG::shutdown_compiler(m_compiler);
+    delete m_clp;
+    delete m_symbolTable;
+    delete m_errors;
+    m_compiler = nullptr;
+    m_clp = nullptr;
+    m_symbolTable = nullptr;
+    m_errors = nullptr;
+    m_inputs.clear();
+    m_sources.clear();
+  }
+
+  bool isCompiled() const { return m_compiler != nullptr; }
+  bool isKept() const { return m_errors != nullptr; }
+
+  // Files and directories of the command line (-f, -v, -y, -I, +incdir+,
+  // -map, ...), and each source with the files it includes as listed in
+  // its preprocessor cache.
+  void collectInputs(SURELOG::scompiler* compiler, int argc,
+                     const char** argv) {
+    m_compiler = compiler;
+    SURELOG::Compiler* the_compiler = (SURELOG::Compiler*)compiler;
+    const SURELOG::CommandLineParser* clp =
+        the_compiler->getCommandLineParser();
+    const SURELOG::SymbolTable& clpSymbols = clp->getSymbolTable();
+    for (int i = 1; i < argc - 1; i++) {
+      if (std::string_view(argv[i]) == "-f") addInput(argv[++i], &m_inputs);
+    }
+    for (const std::vector<SURELOG::SymbolId>* ids :
+         {&clp->getLibraryFiles(), &clp->getLibraryPaths(),
+          &clp->getIncludePaths(), &clp->getLibraryMapFiles(),
+          &clp->getConfigFiles()}) {
+      for (SURELOG::SymbolId id : *ids) {
+        addInput(clpSymbols.getSymbol(id), &m_inputs);
+      }
+    }
+    for (SURELOG::CompileSourceFile* csf :
+         the_compiler->getCompileSourceFiles()) {
+      SURELOG::SymbolTable* symbols = csf->getSymbolTable();
+      const std::string source = symbols->getSymbol(csf->getFileId());
+      if (!isFile(source)) continue;
+      Inputs& inputs = m_sources[absolutePath(source)];
+      addInput(source, &inputs);
+      SURELOG::PreprocessFile* pp = csf->getPreprocessor();
+      if (pp == nullptr) continue;
+      std::vector<fs::path> includes;
+      SURELOG::PPCache cache(pp);
+      if (!cache.getIncludedFiles(includes)) {
+        for (const SURELOG::IncludeFileInfo& info : pp->getIncludeFileInfo()) {
+          if (info.m_context == SURELOG::IncludeFileInfo::Context::INCLUDE) {
+            includes.emplace_back(symbols->getSymbol(info.m_sectionFile));
+          }
+        }
+      }
+      for (const fs::path& include : includes) {
+        addInput(include.string(), &inputs);
+      }
+    }
+  }
+
+  void keep(const std::string& request, SURELOG::SymbolTable* symbolTable,
+            SURELOG::ErrorContainer* errors, SURELOG::CommandLineParser* clp,
+            unsigned int returnCode) {
+    m_request = request;
+    m_symbolTable = symbolTable;
+    m_errors = errors;
+    m_clp = clp;
+    m_returnCode = returnCode;
+  }
+
+  // True if "request" is the kept one and none of its inputs changed.
+  // Otherwise "unchanged" gets the sources of the kept request which, with
+  // their includes, did not change while its command line inputs did not.
+  bool isUpToDate(const std::string& request,
+                  std::set<fs::path>* unchanged) const {
+    unchanged->clear();
+    if (!isKept() || (request != m_request)) return false;
+    if (!isUpToDate(m_inputs)) return false;
+    bool upToDate = true;
+    for (const auto& [source, inputs] : m_sources) {
+      if (isUpToDate(inputs)) {
+        unchanged->insert(source);
+      } else {
+        upToDate = false;
+      }
+    }
+    return upToDate;
+  }
+
+  // Prints the messages and statistics of the kept compilation again, its
+  // log file is left as it was written.
+  unsigned int replay() const {
+    if (!m_clp->muteStdout()) {
+      for (const SURELOG::Error& error : m_errors->getErrors()) {
+        auto [text, fatal, filtered] = m_errors->createErrorMessage(error);
+        if (!filtered) std::cout << text;
+      }
+      std::cout << SURELOG::ErrorContainer::createStatsReport(
+                       m_errors->getErrorStats())
+                << std::flush;
+    }
+    return m_returnCode;
+  }
+
+ private:
+  struct Stamp {
+    fs::file_time_type m_mtime;
+    uintmax_t m_size = 0;
+    bool operator!=(const Stamp& r) const {
+      return (m_mtime != r.m_mtime) || (m_size != r.m_size);
+    }
+  };
+  using Inputs = std::map<fs::path, Stamp>;
+
+  static bool getStamp(const fs::path& path, Stamp* stamp) {
+    std::error_code ec;
+    stamp->m_mtime = fs::last_write_time(path, ec);
+    if (ec) return false;
+    // Directories only have a modification time (files added or removed)
+    stamp->m_size =
+        fs::is_regular_file(path, ec) ? fs::file_size(path, ec) : 0;
+    return !ec;
+  }
+
+  static bool isUpToDate(const Inputs& inputs) {
+    for (const auto& [path, stamp] : inputs) {
+      Stamp current;
+      if (!getStamp(path, &current) || (current != stamp)) return false;
+    }
+    return true;
+  }
+
+  static bool isFile(const std::string& name) {
+    return !name.empty() && (name != SURELOG::SymbolTable::getBadSymbol());
+  }
+
+  static fs::path absolutePath(const fs::path& name) {
+    std::error_code ec;
+    const fs::path path = fs::absolute(name, ec);
+    return ec ? name.lexically_normal() : path.lexically_normal();
+  }
+
+  static void addInput(const std::string& name, Inputs* inputs) {
+    if (!isFile(name)) return;
+    const fs::path path =
+        absolutePath(SURELOG::StringUtils::unquoted(name));
+    Stamp stamp;
+    if (getStamp(path, &stamp)) inputs->emplace(path, stamp);
+  }
+
+  std::string m_request;
+  SURELOG::SymbolTable* m_symbolTable = nullptr;
+  SURELOG::ErrorContainer* m_errors = nullptr;
+  SURELOG::CommandLineParser* m_clp = nullptr;
+  SURELOG::scompiler* m_compiler = nullptr;
+  unsigned int m_returnCode = 0;
+  // Inputs of the whole compilation, and of each source file
+  Inputs m_inputs;
+  std::map<fs::path, Inputs> m_sources;
+};
 
 unsigned int executeCompilation(
     int argc, const char** argv, bool diff_comp_mode, bool fileunit,
-    SURELOG::ErrorContainer::Stats* overallStats = nullptr) {
+    SURELOG::ErrorContainer::Stats* overallStats = nullptr,
+    KeptCompilation* kept = nullptr, const std::string& request = "") {
   bool success = true;
   bool noFatalErrors = true;
   unsigned int codedReturn = 0;
@@ -80,7 +262,11 @@ unsigned int executeCompilation(
 
     SURELOG::scompiler* compiler = SURELOG::start_compiler(clp);
     if (!compiler) codedReturn |= 1;
-    SURELOG::shutdown_compiler(compiler);
+    if ((kept != nullptr) && (compiler != nullptr)) {
+      kept->collectInputs(compiler, argc, argv);
+    } else {
+      SURELOG::shutdown_compiler(compiler);
+    }
   }
   SURELOG::ErrorContainer::Stats stats;
   if (!clp->help()) {
@@ -115,30 +301,83 @@ unsigned int executeCompilation(
     delete report;
   }
   clp->cleanCache();  // only if -nocache
-  delete clp;
-  delete symbolTable;
-  delete errors;
   if ((!noFatalErrors) || (!success)) codedReturn |= 1;
-  if (parseOnly)
-    return 0;
-  else
-    return codedReturn;
+  if (parseOnly) codedReturn = 0;
+  if ((kept != nullptr) && !ext_command.empty()) kept->release();
+  if ((kept != nullptr) && kept->isCompiled()) {
+    kept->keep(request, symbolTable, errors, clp, codedReturn);
+  } else {
+    delete clp;
+    delete symbolTable;
+    delete errors;
+  }
+  return codedReturn;
 }
 
 enum COMP_MODE {
   NORMAL,
   DIFF,
   BATCH,
+  SERVER,
 };
 
-int batchCompilation(const char* argv0, const fs::path& batchFile,
-                     const fs::path& outputDir, bool nostdout) {
-  int returnCode = 0;
+// Runs one full command line, as found in a batch file or a server request.
+unsigned int executeCommandLine(const char* argv0, const std::string& line,
+                                const fs::path& outputDir,
+                                SURELOG::ErrorContainer::Stats* overallStats,
+                                KeptCompilation* kept = nullptr) {
+  unsigned int returnCode = 0;
 
   char path[10000] = {'\0'};
   char* p = getcwd(path, sizeof(path));
   if (!p) returnCode |= 1;
 
+  std::vector<std::string> args;
+  SURELOG::StringUtils::tokenize(line, " \r\t", args);
+  if (args.empty()) return returnCode;
+
+  fs::path cwd;
+  for (size_t i = 0, n = args.size() - 1; i < n; i++) {
+    if (args[i] == cd_opt) {
+      cwd = SURELOG::StringUtils::unquoted(args[i + 1]);
+      break;
+    }
+  }
+
+  if (cwd.empty() || cwd.is_absolute()) {
+    if (!outputDir.empty()) {
+      args.push_back("-o");
+      args.push_back(outputDir.string());
+    }
+  } else if (!outputDir.empty()) {
+    args.push_back("-o");
+    args.push_back((outputDir / cwd).string());
+  }
+
+  std::vector<const char*> argv;
+  argv.reserve(args.size());
+  argv.push_back(argv0);
+  for (const std::string& arg : args) {
+    if (!arg.empty()) {
+      argv.push_back(arg.c_str());
+    }
+  }
+  if (argv.size() < 2) return returnCode;
+
+  returnCode |= executeCompilation(argv.size(), argv.data(), false, false,
+                                   overallStats, kept, line);
+  int ret = chdir(path);
+  if (ret < 0) {
+    std::cerr << "FATAL: Could not change directory to " << path << std::endl;
+    returnCode |= 1;
+  }
+  return returnCode;
+}
+
+int batchCompilation(const char* argv0, const fs::path& batchFile,
+                     const fs::path& outputDir, bool nostdout) {
+  int returnCode = 0;
+
   std::ifstream stream;
   stream.open(batchFile);
   if (!stream.good()) {
@@ -154,45 +393,8 @@ int batchCompilation(const char* argv0, const fs::path& batchFile,
     if (!nostdout)
       std::cout << "Processing: " << line << std::endl << std::flush;
 
-    std::vector<std::string> args;
-    SURELOG::StringUtils::tokenize(line, " \r\t", args);
-
-    fs::path cwd;
-    for (size_t i = 0, n = args.size() - 1; i < n; i++) {
-      if (args[i] == cd_opt) {
-        cwd = SURELOG::StringUtils::unquoted(args[i + 1]);
-        break;
-      }
-    }
-
-    if (cwd.empty() || cwd.is_absolute()) {
-      if (!outputDir.empty()) {
-        args.push_back("-o");
-        args.push_back(outputDir.string());
-      }
-    } else if (!outputDir.empty()) {
-      args.push_back("-o");
-      args.push_back((outputDir / cwd).string());
-    }
-
-    std::vector<const char*> argv;
-    argv.reserve(args.size());
-    argv.push_back(argv0);
-    for (const std::string& arg : args) {
-      if (!arg.empty()) {
-        argv.push_back(arg.c_str());
-      }
-    }
-    if (argv.size() < 2) continue;
-
-    returnCode |= executeCompilation(argv.size(), argv.data(), false, false,
-                                     &overallStats);
+    returnCode |= executeCommandLine(argv0, line, outputDir, &overallStats);
     count++;
-    int ret = chdir(path);
-    if (ret < 0) {
-      std::cerr << "FATAL: Could not change directory to " << path << std::endl;
-      returnCode |= 1;
-    }
   }
   if (!nostdout)
     std::cout << "Processed " << count << " tests." << std::endl << std::flush;
@@ -206,6 +408,41 @@ int batchCompilation(const char* argv0, const fs::path& batchFile,
   return returnCode;
 }
 
+// Compile server: reads one full command line per line on stdin and
+// answers each with the usual compilation output followed by a
+// "@@SURELOG_DONE <return code>" line. "quit" or end of input stops it.
+// The compilation of the last request is kept, the same request is answered
+// from it while none of the files it read changed. Otherwise preprocessor
+// and parser caches stay in memory between requests. When the same request
+// comes with changed files, the sources that do not include any of them are
+// restored from memory without validating their caches again, only the
+// affected ones are re-preprocessed and re-parsed.
+int serverCompilation(const char* argv0, const fs::path& outputDir) {
+  SURELOG::keep_caches_in_memory(true);
+  KeptCompilation kept;
+  std::string line;
+  while (std::getline(std::cin, line)) {
+    if (line == SURELOG::ProcessPool::kQuitCommand) break;
+    if (line.find_first_not_of(" \r\t") == std::string::npos) continue;
+    unsigned int returnCode = 0;
+    std::set<fs::path> unchanged;
+    if (kept.isUpToDate(line, &unchanged)) {
+      returnCode = kept.replay();
+    } else {
+      kept.release();
+      SURELOG::Cache::setUpToDateInMemory(unchanged);
+      returnCode = executeCommandLine(argv0, line, outputDir, nullptr, &kept);
+      SURELOG::Cache::setUpToDateInMemory({});
+    }
+    std::cout << SURELOG::ProcessPool::kDoneMarker << " " << returnCode
+              << std::endl
+              << std::flush;
+  }
+  kept.release();
+  SURELOG::keep_caches_in_memory(false);
+  return 0;
+}
+
 int main(int argc, const char** argv) {
   SURELOG::Waiver::initWaivers();
 
@@ -224,6 +461,8 @@ int main(int argc, const char** argv) {
     } else if (batch_opt == argv[i]) {
       batchFile = SURELOG::StringUtils::unquoted(argv[++i]);
       mode = BATCH;
+    } else if (server_opt == argv[i]) {
+      mode = SERVER;
     } else if (nostdout_opt == argv[i]) {
       nostdout = true;
     } else if (output_folder_opt == argv[i]) {
@@ -268,6 +507,9 @@ int main(int argc, const char** argv) {
     case BATCH:
       codedReturn = batchCompilation(argv[0], batchFile, outputDir, nostdout);
       break;
+    case SERVER:
+      codedReturn = serverCompilation(argv[0], outputDir);
+      break;
   }
 
   if (python_mode) SURELOG::PythonAPI::shutdown();